@@ -21,4 +21,28 @@
     } while (0)                                     
 
 
+/* Multiversioned kernels: the compiler emits an SSE2 (baseline), AVX2/FMA 
+ * (x86-64-v3) and AVX-512 (x86-64-v4) body for the annotated function and the 
+ * dynamic loader binds the best one for the host CPU once at load time. 
+ * Define ISA_NO_DISPATCH to build a single body (e.g. with -march=native).
+ * */ 
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(ISA_NO_DISPATCH)
+    #define ISA_DISPATCH
+    #define ISA_CLONES \
+        __attribute__((target_clones("arch=x86-64-v4","arch=x86-64-v3","default")))
+#else
+    #define ISA_CLONES
+#endif
+
+/* Evaluate floating-point expressions exactly as written: no reassociation and
+ * no contraction into FMA, so that a fixed summation order gives the same bits
+ * on every ISA path. 
+ * */ 
+#if defined(__GNUC__) && !defined(__clang__)
+    #define FP_STRICT \
+        __attribute__((optimize("no-fast-math","fp-contract=off")))
+#else
+    #define FP_STRICT
+#endif
+
 #endif
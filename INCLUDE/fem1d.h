@@ -4,6 +4,7 @@
 /*============================================================================+/
  | Include all the dependencies
 /+============================================================================*/
+#include <stdbool.h>
 #include "basic.h"
 #include "matlib.h"
 #include "debug.h"
@@ -23,6 +24,34 @@ typedef enum
 
 } FEM1D_OP_GMM; /* OPTIONS GMM */ 
 
+/* Plan for re-assembling a single global mass matrix in place: the CSR
+ * pattern is kept in the matrix, the plan keeps the workspace q and the
+ * scatter map of q into the non-zero elements */ 
+typedef struct
+{
+    matlib_index  p;
+    matlib_index  N;
+    matlib_index* map; /* q[k] is added to M.elem_p[map[k]] */ 
+    matlib_xv     xq;  /* workspace of real plans    */ 
+    matlib_zv     zq;  /* workspace of complex plans */ 
+
+} fem1d_GMM_plan_t;
+
+/* Instruction set used by the multiversioned kernels */ 
+typedef enum
+{
+    FEM1D_ISA_SSE2,
+    FEM1D_ISA_AVX2,
+    FEM1D_ISA_AVX512
+
+} FEM1D_ISA;
+
+
+/*============================================================================+/
+ | Runtime ISA dispatch
+/+============================================================================*/
+FEM1D_ISA fem1d_isa_path(void);
+const char* fem1d_isa_name(FEM1D_ISA isa);
 
 /*============================================================================*/
 
@@ -321,6 +350,119 @@ void fem1d_zprjLP2FEM_ShapeFunc_7 ( matlib_index N, matlib_complex *u, matlib_co
 void fem1d_zprjLP2FEM_ShapeFunc_8 ( matlib_index N, matlib_complex *u, matlib_complex *Pv, matlib_complex *Pb);
 void fem1d_zprjLP2FEM_ShapeFunc_9 ( matlib_index N, matlib_complex *u, matlib_complex *Pv, matlib_complex *Pb);
 void fem1d_zprjLP2FEM_ShapeFunc_10( matlib_index N, matlib_complex *u, matlib_complex *Pv, matlib_complex *Pb);
+
+/* 
+ * Batched conversions: k vectors are stored interleaved in a row-major 
+ * matrix, i.e. the j-th vector occupies the j-th column so that the 
+ * coefficient i of all vectors is contiguous.
+ *
+ * u  : N*(p+1)-by-k, Legendre basis
+ * vb : (N*p+1)-by-k, vertex rows first followed by the bubble rows
+ *
+ * */
+void fem1d_ZF2L2
+(
+    const matlib_index p, 
+    const matlib_zm    vb,
+          matlib_zm    u
+);
+void fem1d_ZL2F2
+(
+    const matlib_index p, 
+    const matlib_zm    u,
+          matlib_zm    vb
+);
+void fem1d_ZPrjL2F2
+(
+    const matlib_index p, 
+    const matlib_zm    u,
+          matlib_zm    Pvb
+);
+
+/* Kernels operating on the elements [start, end) out of N */ 
+void fem1d_zshapefunc2lp_nv
+(
+    matlib_index    p, 
+    matlib_index    N, 
+    matlib_index    k, 
+    matlib_index    start, 
+    matlib_index    end, 
+    matlib_complex* vb,
+    matlib_complex* u
+);
+void lp2fem1d_zshapefunc_nv
+(
+    matlib_index    p, 
+    matlib_index    N, 
+    matlib_index    k, 
+    matlib_index    start, 
+    matlib_index    end, 
+    matlib_complex* u,
+    matlib_complex* vb
+);
+void fem1d_zprjLP2FEM_ShapeFunc_nv
+(
+    matlib_index    p, 
+    matlib_index    N, 
+    matlib_index    k, 
+    matlib_index    start, 
+    matlib_index    end, 
+    matlib_complex* u,
+    matlib_complex* Pvb
+);
+
+/* 
+ * Evaluation of the Legendre series at arbitrary points x of the uniform 
+ * mesh of [x_l, x_r] (element lookup in O(1), Clenshaw recurrence).
+ *
+ * */ 
+#define FEM1D_EVAL_CHUNK 128
+
+void fem1d_XEval
+(
+    const matlib_index p,
+    const matlib_real  x_l,
+    const matlib_real  x_r,
+    const matlib_xv    U,
+    const matlib_xv    x,
+          matlib_xv    u
+);
+void fem1d_ZEval
+(
+    const matlib_index p,
+    const matlib_real  x_l,
+    const matlib_real  x_r,
+    const matlib_zv    U,
+    const matlib_xv    x,
+          matlib_zv    u
+);
+
+/* Kernels operating on the points [start, end) */ 
+void fem1d_xclenshaw
+(
+    matlib_index p,
+    matlib_index N,
+    matlib_real  x_l,
+    matlib_real  x_r,
+    matlib_real* U,
+    matlib_index start,
+    matlib_index end,
+    matlib_real* x,
+    matlib_real* u
+);
+void fem1d_zclenshaw
+(
+    matlib_index    p,
+    matlib_index    N,
+    matlib_real     x_l,
+    matlib_real     x_r,
+    matlib_complex* U,
+    matlib_index    start,
+    matlib_index    end,
+    matlib_real*    x,
+    matlib_complex* u
+);
+
 /* Squared L2 norm                                                      */ 
 /*======================================================================*/
 /* Printed with precision 0.20f.*/
@@ -349,28 +491,35 @@ matlib_real fem1d_ZNorm2
     matlib_zv u
 );
 
-matlib_real fem1d_xlp_snorm2_d(matlib_index p, matlib_index N, matlib_real *u);
-matlib_real fem1d_zlp_snorm2_d(matlib_index p, matlib_index N, matlib_complex *u);
-
-matlib_real fem1d_xlp_snorm2_d_2 ( matlib_index N, matlib_real *u);
-matlib_real fem1d_xlp_snorm2_d_3 ( matlib_index N, matlib_real *u);
-matlib_real fem1d_xlp_snorm2_d_4 ( matlib_index N, matlib_real *u);
-matlib_real fem1d_xlp_snorm2_d_5 ( matlib_index N, matlib_real *u);
-matlib_real fem1d_xlp_snorm2_d_6 ( matlib_index N, matlib_real *u);
-matlib_real fem1d_xlp_snorm2_d_7 ( matlib_index N, matlib_real *u);
-matlib_real fem1d_xlp_snorm2_d_8 ( matlib_index N, matlib_real *u);
-matlib_real fem1d_xlp_snorm2_d_9 ( matlib_index N, matlib_real *u);
-matlib_real fem1d_xlp_snorm2_d_10( matlib_index N, matlib_real *u);
-
-matlib_real fem1d_zlp_snorm2_d_2 ( matlib_index N, matlib_complex *u);
-matlib_real fem1d_zlp_snorm2_d_3 ( matlib_index N, matlib_complex *u);
-matlib_real fem1d_zlp_snorm2_d_4 ( matlib_index N, matlib_complex *u);
-matlib_real fem1d_zlp_snorm2_d_5 ( matlib_index N, matlib_complex *u);
-matlib_real fem1d_zlp_snorm2_d_6 ( matlib_index N, matlib_complex *u);
-matlib_real fem1d_zlp_snorm2_d_7 ( matlib_index N, matlib_complex *u);
-matlib_real fem1d_zlp_snorm2_d_8 ( matlib_index N, matlib_complex *u);
-matlib_real fem1d_zlp_snorm2_d_9 ( matlib_index N, matlib_complex *u);
-matlib_real fem1d_zlp_snorm2_d_10( matlib_index N, matlib_complex *u);
+/* 
+ * Deterministic reduction: the squared norms of the elements are summed 
+ * pairwise within fixed blocks of FEM1D_NORM_BLOCK elements and the block
+ * partials are summed pairwise (matlib_xsum_pairwise). The shape of the tree
+ * depends only on N, hence serial and threaded versions agree bitwise.
+ *
+ * fem1d_[xz]lp_snorm2_b writes the partials of the blocks [start, end).
+ * */ 
+#define FEM1D_NORM_BLOCK 64
+
+void fem1d_xlp_snorm2_b
+(
+    matlib_index p,
+    matlib_index N,
+    matlib_index start,
+    matlib_index end,
+    matlib_real* u,
+    matlib_real* snorm2
+);
+void fem1d_zlp_snorm2_b
+(
+    matlib_index    p,
+    matlib_index    N,
+    matlib_index    start,
+    matlib_index    end,
+    matlib_complex* u,
+    matlib_real*    snorm2
+);
+
 /*======================================================================*/
 
 matlib_real fem1d_xdot
@@ -431,6 +580,15 @@ void fem1d_MEMI
     matlib_index p,
     matlib_xv*   q
 );
+/* Dimension and number of non-zero elements of the global mass matrix,
+ * terminates if they do not fit into matlib_index (see MATLIB_INDEX_MAX) */ 
+void fem1d_GMMSize
+(
+    matlib_index  p,
+    matlib_index  N,
+    matlib_index* dim,
+    matlib_index* nnz
+);
 void fem1d_GMMSparsity
 /* Determine the sparsity structure in CSR format */ 
 (
@@ -440,6 +598,17 @@ void fem1d_GMMSparsity
     matlib_index* col                     
 );
 
+/* Renumbering that interleaves the vertex and the bubbles of each element,
+ * perm[i] is the row of the global matrix (fem1d_GMMSparsity) placed at i;
+ * the global matrices have p super-diagonals in this numbering (see
+ * matlib_zcsr2dia) */ 
+void fem1d_GMMBandPerm
+(
+    matlib_index  p,
+    matlib_index  N,
+    matlib_index* perm
+);
+
 void fem1d_XCSRGMM
 /* Double CSR - Assemble Global Mass Matrix*/ 
 (
@@ -502,6 +671,178 @@ void fem1d_zm_sparse_GMM
     matlib_zm_sparse* M
 );
 
+/* Plan/execute: the plan allocates M with its sparsity pattern once, each
+ * execution overwrites the non-zero elements of M in place without any
+ * allocation */ 
+void fem1d_xm_sparse_GMM_plan
+(
+    matlib_index      p,
+    matlib_index      N,
+    matlib_xm         Q,
+    matlib_xm_sparse* M,
+    fem1d_GMM_plan_t* plan
+);
+
+void fem1d_xm_sparse_GMM_exec
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_xv         phi,
+    matlib_xm_sparse* M
+);
+
+void fem1d_zm_sparse_GMM_plan
+(
+    matlib_index      p,
+    matlib_index      N,
+    matlib_xm         Q,
+    matlib_zm_sparse* M,
+    fem1d_GMM_plan_t* plan
+);
+
+void fem1d_zm_sparse_GMM_exec
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_zv         phi,
+    matlib_zm_sparse* M
+);
+
+/* Change tracking: re-integrates only the elements whose samples of phi
+ * differ from phi_ref (the samples M was assembled from) by more than tol,
+ * base (may be NULL) is the potential independent part of M */ 
+matlib_index fem1d_zm_sparse_GMM_update
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_zv         phi,
+    matlib_zv         phi_ref,
+    matlib_real       tol,
+    matlib_complex*   base,
+    matlib_zm_sparse* M,
+    bool*             row_changed
+);
+
+/* Inner products of the constant 1 with the products of basis functions,
+ * q1 has Q.lenc elements */ 
+void fem1d_GMM_rowsumQ
+(
+    matlib_xm    Q,
+    matlib_real* q1
+);
+
+/* Inner products of c[0]+c[1]*phi on the elements e0,...,e1-1 from those
+ * of the constant and of phi (xq: NULL if c[1] is zero) */ 
+void fem1d_GMM_combineq
+(
+    matlib_index       nr_combi,
+    const matlib_real* q1,
+    matlib_complex     c[2],
+    const matlib_real* xq,
+    matlib_index       e0,
+    matlib_index       e1,
+    matlib_complex*    zq
+);
+
+/* Complex mass matrix of the potential c[0]+c[1]*phi for a real phi with a
+ * complex plan: one real transform instead of a complex one */ 
+void fem1d_xzm_sparse_GMM_exec
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_xv         phi,
+    matlib_complex    c[2],
+    matlib_zm_sparse* M
+);
+
+void fem1d_GMM_plan_free(fem1d_GMM_plan_t* plan);
+
+/*============================================================================+/
+ | Exact assembly for piecewise polynomial potentials
+ |
+ | A potential given by Legendre coefficients of degree at most d on each
+ | element is assembled from the triple products of the basis functions with
+ | the Legendre polynomials, there is no sampling at the LGL points.
+/+============================================================================*/
+void fem1d_triple_table
+(
+    matlib_index p,
+    matlib_index d,
+    matlib_real  tol,
+    matlib_xm*   T
+);
+
+void fem1d_zpoly2leg
+(
+    matlib_zv    a,
+    matlib_index N,
+    matlib_real  x_l,
+    matlib_real  x_r,
+    matlib_zv    c
+);
+
+void fem1d_zm_sparse_GMM_exec_leg
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         T,
+    matlib_zv         c,
+    matlib_zm_sparse* M
+);
+
+/*============================================================================+/
+ | Matrix-free Stiffness-Mass operator
+ | v = (M + coeff*S)*u element by element: the element mass integrals are
+ | computed from Q and phi on the fly and the stiffness S is the one of
+ | pde1d_zm_sparse_GSM, so that only phi, u and v are streamed. The range
+ | variants write the rows owned by the elements e0,...,e1-1 (threaded
+ | versions are in pfem1d).
+/+============================================================================*/
+void fem1d_XGSMV
+(
+    matlib_index p,
+    matlib_xm    Q,
+    matlib_xv    phi,
+    matlib_real  coeff,
+    matlib_xv    u,
+    matlib_xv    v
+);
+
+void fem1d_ZGSMV
+(
+    matlib_index p,
+    matlib_xm    Q,
+    matlib_zv    phi,
+    matlib_complex  coeff,
+    matlib_zv    u,
+    matlib_zv    v
+);
+
+void fem1d_XGSMV_range
+(
+    matlib_index p,
+    matlib_index N,
+    matlib_xm    Q,
+    matlib_real* phi,
+    matlib_real  coeff,
+    matlib_real* u,
+    matlib_real* v,
+    matlib_index e0,
+    matlib_index e1
+);
+
+void fem1d_ZGSMV_range
+(
+    matlib_index p,
+    matlib_index N,
+    matlib_xm    Q,
+    matlib_complex* phi,
+    matlib_complex  coeff,
+    matlib_complex* u,
+    matlib_complex* v,
+    matlib_index e0,
+    matlib_index e1
+);
+
 void fem1d_xm_nsparse_GMM
 /* Real - Assemble Global Mass Matrix*/ 
 (
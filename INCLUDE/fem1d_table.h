@@ -0,0 +1,60 @@
+#ifndef FEM1D_TABLE_H
+#define FEM1D_TABLE_H
+
+/*============================================================================+/
+ | Include all the dependencies
+/+============================================================================*/
+#include <stddef.h>
+#include "basic.h"
+#include "matlib.h"
+#include "debug.h"
+#include "ehandler.h"
+
+/*============================================================================+/
+ | Precomputed LGL/transform tables
+ |
+ | The LGL nodes, quadrature weights, the transform matrices FM and IM and the
+ | quadrature matrix Q of fem1d_quadM depend only on (p, P, tol). They are
+ | cached on disk in a versioned binary file per key and mapped read-only
+ | (MAP_SHARED) so that concurrent runs share one copy of the pages.
+ |
+ | The cache directory is taken from the argument or, if that is NULL, from
+ | the environment variable FEM1D_TABLE_DIR. Without a directory the tables
+ | are computed in memory. A missing, stale or corrupted file is regenerated
+ | and replaced atomically (write to a temporary file, then rename).
+/+============================================================================*/
+
+#define FEM1D_TABLE_VERSION 1
+#define FEM1D_TABLE_ENV     "FEM1D_TABLE_DIR"
+
+typedef struct
+{
+    matlib_index p;     /* highest polynomial degree            */
+    matlib_index P;     /* nr. of LGL points minus one          */
+    matlib_real  tol;   /* tolerance used for the LGL points    */
+
+    matlib_xv xi;       /* LGL points, length P+1               */
+    matlib_xv quadW;    /* quadrature weights, length P+1       */
+    matlib_xm FM;       /* (p+1)-by-(P+1), row major            */
+    matlib_xm IM;       /* (P+1)-by-(p+1), col major            */
+    matlib_xm Q;        /* nr_combi-by-(P+1), row major         */
+
+    void*  map_p;       /* mapped cache file, NULL if in memory */
+    size_t map_len;
+
+} fem1d_table_t;
+
+/*============================================================================*/
+
+void fem1d_table_load
+(
+    matlib_index   p,
+    matlib_index   P,
+    matlib_real    tol,
+    const char*    cache_dir,
+    fem1d_table_t* table
+);
+
+void fem1d_table_free(fem1d_table_t* table);
+
+#endif
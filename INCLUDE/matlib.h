@@ -5,6 +5,7 @@
  | Include all the dependencies
 /+============================================================================*/
 #include "complex.h"
+#include <limits.h>
 #include "basic.h"
 #include "debug.h"
 #include "ehandler.h"
@@ -27,7 +28,18 @@
 
 /*============================================================================*/
 
-#define MATLIB_64
+/* The width of indices is a build-time choice: 64-bit indices with the ILP64
+ * interface of MKL (default) or, with -DMATLIB_32, 32-bit indices with the
+ * LP64 interface. The CSR arrays are handed to MKL as they are, therefore the
+ * two must agree.
+ * */ 
+#ifndef MATLIB_32
+    #define MATLIB_64
+#endif
+
+#if defined(MATLIB_32) && defined(MKL_ILP64)
+    #error "MATLIB_32 requires the LP64 interface of MKL (drop -DMKL_ILP64)"
+#endif
 
 #ifdef MATLIB_64
     /* Indexing types */ 
@@ -38,6 +50,8 @@
     typedef double complex matlib_complex;
     /* Integers */
     typedef long long int matlib_int;
+    /* Largest index that MKL (signed MKL_INT) can address */ 
+    #define MATLIB_INDEX_MAX ((matlib_index)LLONG_MAX)
 #else
     /* Indexing types */ 
     typedef unsigned int matlib_index;
@@ -47,6 +61,8 @@
     typedef double complex matlib_complex;
     /* Integers */
     typedef int matlib_int;
+    /* Largest index that MKL (signed MKL_INT) can address */ 
+    #define MATLIB_INDEX_MAX ((matlib_index)INT_MAX)
 
 #endif
 
@@ -220,6 +236,21 @@ typedef struct
 
 } matlib_zm_nsparse;
 
+/* DIA: banded symmetric matrix of order lenc with kd super-diagonals, only
+ * the upper part is stored diagonal by diagonal
+ * A(i,i+d): elem_p[d*lenc+i], 0<=d<=kd, i<lenc-d
+ * The last d entries of the d-th diagonal are not used.
+ * */ 
+typedef struct
+{
+    matlib_index    lenc; /* length of columns */ 
+    matlib_index    lenr; /* length of rows    */
+    matlib_index    kd;   /* nr. of super-diagonals */ 
+    MATLIB_SPARSE   format;
+    matlib_complex* elem_p;
+
+} matlib_zm_dia;
+
 
 /*============================================================================*/
 /* Define MACROS */ 
@@ -452,6 +483,9 @@ void matlib_zcopy
 matlib_real matlib_xnrm2(matlib_xv x);
 matlib_real matlib_znrm2(matlib_zv x);
 
+/* Pairwise summation with a tree whose shape depends only on n */ 
+matlib_real matlib_xsum_pairwise(matlib_index n, const matlib_real* x);
+
 void matlib_xaxpy
 (
     const matlib_real alpha,
@@ -494,6 +528,33 @@ void matlib_zgemv
           matlib_zv      v
 );
 
+/* Native symmetric SpMV on the triangle uplo_enum of A, entries of the other
+ * triangle are ignored as by mkl_cspblas_?csrsymv, see matlib_xcsrsymv_range;
+ * the *csrsymm variants multiply the columns of a column major matrix */ 
+void matlib_xcsrsymv_range
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_xm_sparse A, 
+          matlib_index     nrhs,
+    const matlib_real*     u,
+          matlib_real*     v,
+          matlib_real*     w,
+          matlib_index     r0,
+          matlib_index     r1
+);
+
+void matlib_zcsrsymv_range
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_zm_sparse A, 
+          matlib_index     nrhs,
+    const matlib_complex*  u,
+          matlib_complex*  v,
+          matlib_complex*  w,
+          matlib_index     r0,
+          matlib_index     r1
+);
+
 void matlib_xcsrsymv
 /* Double CSR Symmetric Matrix-Vector */ 
 (
@@ -504,13 +565,79 @@ void matlib_xcsrsymv
 );
 
 void matlib_zcsrsymv
-/* Double CSR Symmetric Matrix-Vector */ 
+/* Complex CSR Symmetric Matrix-Vector */ 
 (
     const MATLIB_UPLO      uplo_enum,
           matlib_zm_sparse A, 
     const matlib_zv        u,
           matlib_zv        v
 );
+
+void matlib_xcsrsymm
+/* Double CSR Symmetric Matrix-Matrix */ 
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_xm_sparse A, 
+    const matlib_xm        U,
+          matlib_xm        V
+);
+
+void matlib_zcsrsymm
+/* Complex CSR Symmetric Matrix-Matrix */ 
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_zm_sparse A, 
+    const matlib_zm        U,
+          matlib_zm        V
+);
+/*============================================================================+/
+ | Banded (DIA) complex symmetric matrices
+ | perm maps the rows of the band to the rows of the CSR matrix, i.e.
+ | B(i,j) = A(perm[i],perm[j]); NULL stands for the identity. Vectors passed
+ | to the DIA routines are in the numbering of the band (see matlib_zpermute).
+/+============================================================================*/
+void matlib_create_zm_dia
+(
+    matlib_index   lenc,
+    matlib_index   kd,
+    matlib_zm_dia* B
+);
+
+void matlib_zcsr2dia
+(
+    const matlib_zm_sparse A, 
+    const matlib_index*    perm,
+          matlib_index     kd,
+          matlib_zm_dia*   B
+);
+
+/* v <- B*u */ 
+void matlib_zdiasymv
+(
+    const matlib_zm_dia B, 
+    const matlib_zv     u,
+          matlib_zv     v
+);
+
+/* In place B = U^T*D*U, U unit upper triangular (no pivoting) */ 
+void matlib_zdiaLDLT(matlib_zm_dia B);
+
+/* Solves B*x = b in place with the factor of matlib_zdiaLDLT */ 
+void matlib_zdiaLDLT_solve
+(
+    const matlib_zm_dia B, 
+          matlib_zv     b
+);
+
+/* y[i] <- x[perm[i]] (PERMUTE) or y[perm[i]] <- x[i] (inverse) */ 
+void matlib_zpermute
+(
+    const matlib_index* perm,
+          bool          inverse,
+    const matlib_zv     x,
+          matlib_zv     y
+);
+
 /*============================================================================*/
 
 void matlib_xgemm
@@ -6,6 +6,8 @@
 /+============================================================================*/
 #include "legendre.h"
 #include "fem1d.h"
+#include "fem1d_table.h"
+#include "pfem1d.h"
 
 /*============================================================================+/
  | Linear Schroedinger Equation (LSE)
@@ -29,13 +31,42 @@ typedef enum
 } PDE1D_LSE_BC;
 
 
+/* PDE1D_LSE_STATIC_REAL: the potential function returns a real potential V
+ * and two complex scale factors c such that the potential is c[0]+c[1]*V,
+ * see pde1d_LSE_harmonic_rpotential; the mass matrix is then assembled from
+ * a real transform (see fem1d_xzm_sparse_GMM_exec).
+ *
+ * PDE1D_LSE_STATIC_POLY: the potential function returns the coefficients of
+ * a polynomial in x of degree at most PDE1D_LSE_POLY_DEG, see
+ * pde1d_LSE_harmonic_ppotential; the mass matrix is then assembled exactly
+ * from the triple products of the basis (see fem1d_zm_sparse_GMM_exec_leg).
+ * */ 
 typedef enum
 {
     PDE1D_LSE_STATIC,
-    PDE1D_LSE_DYNAMIC
+    PDE1D_LSE_DYNAMIC,
+    PDE1D_LSE_STATIC_REAL,
+    PDE1D_LSE_STATIC_POLY
 
 } PDE1D_LSE_POTENTIAL;
 
+#define PDE1D_LSE_POLY_DEG 2
+
+/* Storage of a batch of nsparse time levels of a dynamic potential 
+ * FULL      : nsparse complete matrices, assembled at once
+ * COMPRESSED: the potential of each level only, the matrix of a level is
+ *             re-assembled in place just before it is factored; only the
+ *             elements whose potential changed by more than phi_tol since
+ *             the matrix was last assembled are re-integrated and the
+ *             factorization is reused if none changed
+ * */ 
+typedef enum
+{
+    PDE1D_LSE_NSPARSE_FULL,
+    PDE1D_LSE_NSPARSE_COMPRESSED
+
+} PDE1D_LSE_NSPARSE;
+
 typedef enum
 {
     PDE1D_LSE_EVOLVE_ONLY,
@@ -53,6 +84,8 @@ typedef struct
     matlib_real  dt;        /* size of time-step */
     matlib_index Nt;        /* number of time-steps */
     matlib_index nsparse;   /* number of sparse matrices for dynamic problem */
+    PDE1D_LSE_NSPARSE nsparse_mode;
+    matlib_real  phi_tol;   /* change tracking of the compressed mode */
     void**       params;    /* Could be anything! */ 
     matlib_complex alpha;   /* Coeff of u_xx */
 
@@ -67,16 +100,26 @@ typedef struct
     void* phixt_p; /* potential x- and t-parts non-separable */
 
     matlib_real  tol;
+    const char*  table_dir; /* LGL/transform table cache, NULL: $FEM1D_TABLE_DIR */
 
     matlib_xv e_abs;
     matlib_xv e_rel;
 
     PDE1D_LSE_SOLVE sol_mode;
 
+    /* Pool for the assembly and the error analysis, NULL: serial. With a
+     * pool the mass matrices are assembled over the elements in parallel
+     * and the transform of the analytic solution overlaps with the linear
+     * solve; it must be set before pde1d_LSE_init_solverIVP.
+     * */ 
+    matlib_index    num_threads;
+    pthpool_data_t* mp;
+
 } pde1d_LSE_data_t;
 
 typedef struct
 {
+    fem1d_table_t table; /* owns xi, FM, IM, quadW and Q */ 
     matlib_xv xi;
     matlib_xm FM;
     matlib_xm IM;
@@ -87,10 +130,16 @@ typedef struct
     /* Sparse matrics 
      * */ 
     matlib_zm_sparse  M;  /* Stiffness + Mass excluding all time-dependent part */ 
+    fem1d_GMM_plan_t  GMM_plan; /* pattern and workspace of M, reused by re-solves */ 
+    matlib_xm         T;        /* triple products, PDE1D_LSE_STATIC_POLY */ 
+    matlib_zv         phi_leg;  /* Legendre coefficients of the potential */ 
 
     /* Sparse Matrics - Global Mass Matrices
      * */ 
     matlib_zm_nsparse nM; /* mixed potentials */ 
+    /* PDE1D_LSE_NSPARSE_COMPRESSED uses M and GMM_plan for each level */ 
+    matlib_zv         phi_ref; /* potential M was assembled from */ 
+    matlib_complex*   S_base;  /* stiffness part of M on its pattern */ 
 
     matlib_real rho;
     matlib_real irho;
@@ -179,6 +228,24 @@ void pde1d_LSE_solve_IVP2_error
     pde1d_LSE_data_t*   input,
     pde1d_LSE_solver_t* data
 );
+/* Time step as a task graph on the pool (see pthpool_graph_add) over blocks
+ * of PDE1D_LSE_BLOCK elements: the projection, the transform back to the
+ * Legendre basis and the update of each block follow the linear solve, while
+ * the analytic solution and the error norms of a block start as soon as the
+ * blocks they read from are done. The norms are summed per block of
+ * FEM1D_NORM_BLOCK elements as in fem1d_ZNorm2. A dynamic potential is
+ * solved by pde1d_LSE_solve_IVP.
+ * */ 
+#define PDE1D_LSE_BLOCK FEM1D_NORM_BLOCK
+
+void pde1d_LSE_solve_IVP_graph
+(
+    pde1d_LSE_data_t*   input,
+    pde1d_LSE_solver_t* data,
+    matlib_index        num_threads,
+    pthpool_data_t*     mp
+);
+
 void pde1d_LSE_destroy_solverIVP
 (
     pde1d_LSE_data_t*   input,
@@ -209,6 +276,22 @@ void pde1d_LSE_constant_potential
     matlib_xv      x, 
     matlib_zv      y
 );
+
+void pde1d_LSE_constant_rpotential
+( 
+    void**         params,
+    matlib_complex m_coeff[2], 
+    matlib_xv      x, 
+    matlib_xv      y,
+    matlib_complex c[2]
+);
+
+void pde1d_LSE_constant_ppotential
+( 
+    void**         params,
+    matlib_complex m_coeff[2], 
+    matlib_zv      a
+);
 /*============================================================================*/
 
 void pde1d_LSE_HermiteGaussian_WP_harmonic_potential
@@ -226,6 +309,22 @@ void pde1d_LSE_harmonic_potential
     matlib_xv      x, 
     matlib_zv      y
 );
+
+void pde1d_LSE_harmonic_rpotential
+( 
+    void**         params,
+    matlib_complex m_coeff[2], 
+    matlib_xv      x, 
+    matlib_xv      y,
+    matlib_complex c[2]
+);
+
+void pde1d_LSE_harmonic_ppotential
+( 
+    void**         params,
+    matlib_complex m_coeff[2], 
+    matlib_zv      a
+);
 /*============================================================================*/
 
 void pde1d_LSE_Gaussian_WP_timedependent_linear_potential
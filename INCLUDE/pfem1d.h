@@ -12,6 +12,100 @@
 /*============================================================================+/
  |DATA STRUCTURES AND ENUMS
 /+============================================================================*/
+/* Arguments of a phase of a persistent region, see pfem1d_ZPrjL2F_phase;
+ * they are referenced by the phase and must outlive the region.
+ * */ 
+typedef struct
+{
+    void*          kernel;          /* range kernel of the transform */ 
+    matlib_index   p;
+    matlib_index   N;
+    matlib_xm      M;               /* transform matrix */ 
+    matlib_real    A[4];
+    matlib_xv      B;
+    matlib_xv      C;
+    matlib_complex coeff[2];
+    matlib_zv      x;
+    matlib_zv      y;
+    void*          shared_data[7];  /* of the kernel */ 
+    void*          phase_data[1];   /* of the phase */ 
+
+} pfem1d_phase_args_t;
+
+/* Asynchronous call of a pfem1d_* routine, see pfem1d_ZFLT_async */ 
+typedef struct
+{
+    pfem1d_phase_args_t args;
+    pthpool_phase_t     phase;
+    pthpool_partition_t part;
+    pthpool_arg_t*      arg;
+    pthpool_task_t*     task;
+    pthpool_handle_t    handle;
+    pthpool_data_t*     mp;
+
+} pfem1d_future_t;
+
+/* Vector partitioned over the threads of a pool by elements: the entries of
+ * the elements [part.start[i], part.start[i+1]), block entries each, were
+ * first touched by thread i and the entries past N*block by the last thread.
+ * The pfem1d_*_pv routines run every part of their output on its owner,
+ * hence vectors created with the N of the calls are accessed from their
+ * NUMA node only; the other routines schedule with work stealing.
+ * */ 
+typedef struct
+{
+    matlib_xv           v;
+    matlib_index        block;
+    pthpool_partition_t part;
+
+} pfem1d_xpv_t;
+
+typedef struct
+{
+    matlib_zv           v;
+    matlib_index        block;
+    pthpool_partition_t part;
+
+} pfem1d_zpv_t;
+
+/* Plan of the parallel symmetric CSR product for the pattern of a matrix and
+ * a number of right-hand sides: thread t owns the rows [part.start[t],
+ * part.start[t+1]), their transposed products reach the columns
+ * [range[2*t], range[2*t+1]) and are collected in the buffer of thread t */ 
+typedef struct
+{
+    matlib_index        dim;
+    matlib_index        nrhs;
+    pthpool_partition_t part;
+    matlib_index*       range;
+    matlib_real*        xw;     /* buffers of real plans    */ 
+    matlib_complex*     zw;     /* buffers of complex plans */ 
+
+} pfem1d_csrsym_plan_t;
+
+void pfem1d_create_xpv
+(
+    matlib_index    N,
+    matlib_index    block,
+    matlib_index    len,
+    matlib_index    num_threads,
+    pthpool_data_t* mp,
+    pfem1d_xpv_t*   pv
+);
+
+void pfem1d_create_zpv
+(
+    matlib_index    N,
+    matlib_index    block,
+    matlib_index    len,
+    matlib_index    num_threads,
+    pthpool_data_t* mp,
+    pfem1d_zpv_t*   pv
+);
+
+void pfem1d_free_xpv(pfem1d_xpv_t* pv);
+void pfem1d_free_zpv(pfem1d_zpv_t* pv);
+
 void pfem1d_XFLT
 (
     const matlib_index    N,
@@ -22,6 +116,15 @@ void pfem1d_XFLT
           pthpool_data_t* mp
 );
 
+void pfem1d_XFLT_pv
+(
+    const matlib_index    N,
+    const matlib_xm       FM,
+    const pfem1d_xpv_t*   u,
+          pfem1d_xpv_t*   U,
+          pthpool_data_t* mp
+);
+
 void pfem1d_ZFLT
 (
     const matlib_index    N,
@@ -32,6 +135,15 @@ void pfem1d_ZFLT
           pthpool_data_t* mp
 );
 
+void pfem1d_ZFLT_pv
+(
+    const matlib_index    N,
+    const matlib_xm       FM,
+    const pfem1d_zpv_t*   u,
+          pfem1d_zpv_t*   U,
+          pthpool_data_t* mp
+);
+
 void pfem1d_XILT
 (
     const matlib_index    N,
@@ -42,6 +154,15 @@ void pfem1d_XILT
           pthpool_data_t* mp
 );
 
+void pfem1d_XILT_pv
+(
+    const matlib_index    N,
+    const matlib_xm       IM,
+    const pfem1d_xpv_t*   U,
+          pfem1d_xpv_t*   u,
+          pthpool_data_t* mp
+);
+
 void pfem1d_ZILT
 (
     const matlib_index    N,
@@ -52,6 +173,15 @@ void pfem1d_ZILT
           pthpool_data_t* mp
 );
 
+void pfem1d_ZILT_pv
+(
+    const matlib_index    N,
+    const matlib_xm       IM,
+    const pfem1d_zpv_t*   U,
+          pfem1d_zpv_t*   u,
+          pthpool_data_t* mp
+);
+
 void pfem1d_XFLT2
 (
     const matlib_index    N,
@@ -106,6 +236,58 @@ void pfem1d_ZPrjL2F
     pthpool_data_t* mp
 );
 
+/* Batched versions, see fem1d_ZF2L2 for the layout of the matrices */ 
+void pfem1d_ZF2L2
+(
+    const matlib_index    p, 
+    const matlib_zm       vb,
+          matlib_zm       u,
+          matlib_index    num_threads,
+          pthpool_data_t* mp
+);
+
+void pfem1d_ZL2F2
+(
+    const matlib_index    p, 
+    const matlib_zm       u,
+          matlib_zm       vb,
+          matlib_index    num_threads,
+          pthpool_data_t* mp
+);
+
+void pfem1d_ZPrjL2F2
+(
+    const matlib_index    p, 
+    const matlib_zm       u,
+          matlib_zm       Pvb,
+          matlib_index    num_threads,
+          pthpool_data_t* mp
+);
+
+void pfem1d_XEval
+(
+    const matlib_index    p,
+    const matlib_real     x_l,
+    const matlib_real     x_r,
+    const matlib_xv       U,
+    const matlib_xv       x,
+          matlib_xv       u,
+          matlib_index    num_threads,
+          pthpool_data_t* mp
+);
+
+void pfem1d_ZEval
+(
+    const matlib_index    p,
+    const matlib_real     x_l,
+    const matlib_real     x_r,
+    const matlib_zv       U,
+    const matlib_xv       x,
+          matlib_zv       u,
+          matlib_index    num_threads,
+          pthpool_data_t* mp
+);
+
 matlib_real pfem1d_XNorm2
 (
     matlib_index    p,
@@ -125,6 +307,172 @@ matlib_real pfem1d_ZNorm2
 );
 
 
+/* Single matrix assembly split over the elements: every thread writes the
+ * rows of the vertices and bubbles of its elements (owner computes), the
+ * result is identical to fem1d_xm_sparse_GMM/fem1d_zm_sparse_GMM */ 
+void pfem1d_xm_sparse_GMM
+(
+    matlib_index      p,
+    matlib_xm         Q,
+    matlib_xv         phi,
+    matlib_xm_sparse* M,
+    matlib_index      num_threads,
+    pthpool_data_t*   mp
+);
+
+void pfem1d_zm_sparse_GMM
+(
+    matlib_index      p,
+    matlib_xm         Q,
+    matlib_zv         phi,
+    matlib_zm_sparse* M,
+    matlib_index      num_threads,
+    pthpool_data_t*   mp
+);
+
+/* In place re-assembly with a plan of fem1d_*m_sparse_GMM_plan */ 
+void pfem1d_xm_sparse_GMM_exec
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_xv         phi,
+    matlib_xm_sparse* M,
+    matlib_index      num_threads,
+    pthpool_data_t*   mp
+);
+
+void pfem1d_zm_sparse_GMM_exec
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_zv         phi,
+    matlib_zm_sparse* M,
+    matlib_index      num_threads,
+    pthpool_data_t*   mp
+);
+
+/* Real potential with complex scale factors, see fem1d_xzm_sparse_GMM_exec */ 
+void pfem1d_xzm_sparse_GMM_exec
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_xv         phi,
+    matlib_complex    c[2],
+    matlib_zm_sparse* M,
+    matlib_index      num_threads,
+    pthpool_data_t*   mp
+);
+
+/* Matrix-free (M + coeff*S)*u split over the elements, see fem1d_XGSMV */ 
+void pfem1d_XGSMV
+(
+    matlib_index    p,
+    matlib_xm       Q,
+    matlib_xv       phi,
+    matlib_real     coeff,
+    matlib_xv       u,
+    matlib_xv       v,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+);
+
+void pfem1d_ZGSMV
+(
+    matlib_index    p,
+    matlib_xm       Q,
+    matlib_zv       phi,
+    matlib_complex  coeff,
+    matlib_zv       u,
+    matlib_zv       v,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+);
+
+/* Symmetric CSR product V = A*U on one triangle of A split over the rows,
+ * the transposed products of other threads' rows go through private buffers;
+ * see matlib_xcsrsymv_range. The plan holds the split and the buffers and is
+ * reused by every product with the same pattern; pfem1d_[xz]csrsymm create
+ * a plan for a single product. */ 
+void pfem1d_xcsrsym_plan
+(
+    matlib_xm_sparse      A, 
+    matlib_index          nrhs,
+    matlib_index          num_threads,
+    pfem1d_csrsym_plan_t* plan
+);
+
+void pfem1d_zcsrsym_plan
+(
+    matlib_zm_sparse      A, 
+    matlib_index          nrhs,
+    matlib_index          num_threads,
+    pfem1d_csrsym_plan_t* plan
+);
+
+void pfem1d_csrsym_plan_free(pfem1d_csrsym_plan_t* plan);
+
+void pfem1d_xcsrsymm_exec
+(
+    pfem1d_csrsym_plan_t*  plan,
+    const MATLIB_UPLO      uplo_enum,
+          matlib_xm_sparse A, 
+    const matlib_xm        U,
+          matlib_xm        V,
+          pthpool_data_t*  mp
+);
+
+void pfem1d_zcsrsymm_exec
+(
+    pfem1d_csrsym_plan_t*  plan,
+    const MATLIB_UPLO      uplo_enum,
+          matlib_zm_sparse A, 
+    const matlib_zm        U,
+          matlib_zm        V,
+          pthpool_data_t*  mp
+);
+
+void pfem1d_xcsrsymm
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_xm_sparse A, 
+    const matlib_xm        U,
+          matlib_xm        V,
+          matlib_index     num_threads,
+          pthpool_data_t*  mp
+);
+
+void pfem1d_zcsrsymm
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_zm_sparse A, 
+    const matlib_zm        U,
+          matlib_zm        V,
+          matlib_index     num_threads,
+          pthpool_data_t*  mp
+);
+
+void pfem1d_xcsrsymv
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_xm_sparse A, 
+    const matlib_xv        u,
+          matlib_xv        v,
+          matlib_index     num_threads,
+          pthpool_data_t*  mp
+);
+
+void pfem1d_zcsrsymv
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_zm_sparse A, 
+    const matlib_zv        u,
+          matlib_zv        v,
+          matlib_index     num_threads,
+          pthpool_data_t*  mp
+);
+
+/* Assembly of nsparse matrices, split over the matrices or, if there are
+ * fewer matrices than threads, over the elements of each matrix */ 
 void pfem1d_xm_nsparse_GMM
 /* Double - Assemble Global Mass Matrix*/ 
 (
@@ -153,10 +501,115 @@ void pfem1d_zm_nsparse_GMM
     
 );
 
+/*============================================================================+/
+ | Phases of persistent regions over the elements (see pthpool_region_exec)
+ | Each function fills phase with the kernel of the corresponding pfem1d_*
+ | function restricted to the elements of a participant; the region must be
+ | initialized with N elements. The arguments are released with
+ | pfem1d_phase_free.
+/+============================================================================*/
+void pfem1d_ZFLT_phase
+(
+    matlib_index         N,
+    matlib_xm            FM,
+    matlib_zv            u,
+    matlib_zv            U,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
+);
 
+void pfem1d_ZILT_phase
+(
+    matlib_index         N,
+    matlib_xm            IM,
+    matlib_zv            U,
+    matlib_zv            u,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
+);
 
+void pfem1d_ZPrjL2F_phase
+(
+    matlib_index         p,
+    matlib_zv            u,
+    matlib_zv            Pvb,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
+);
 
+void pfem1d_ZF2L_phase
+(
+    matlib_index         p,
+    matlib_zv            vb,
+    matlib_zv            u,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
+);
+
+/* y <- alpha*x + beta*y for vectors in the Legendre basis, length N*(p+1) */ 
+void pfem1d_zaxpby_phase
+(
+    matlib_index         p,
+    matlib_complex       alpha,
+    matlib_zv            x,
+    matlib_complex       beta,
+    matlib_zv            y,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
+);
 
+void pfem1d_phase_free(pfem1d_phase_args_t* args);
+
+/*============================================================================+/
+ | Asynchronous calls
+ | Each function launches the corresponding pfem1d_* routine on the pool and
+ | returns right away, so that the caller can overlap other work with it,
+ | e.g. a sparse solve. The result is available once pfem1d_wait has
+ | returned; until then the inputs must not be written, the output must not
+ | be accessed and the future, which holds the arguments, must not be moved.
+/+============================================================================*/
+void pfem1d_ZFLT_async
+(
+    matlib_index     N,
+    matlib_xm        FM,
+    matlib_zv        u,
+    matlib_zv        U,
+    matlib_index     num_threads,
+    pthpool_data_t*  mp,
+    pfem1d_future_t* future
+);
+
+void pfem1d_ZILT_async
+(
+    matlib_index     N,
+    matlib_xm        IM,
+    matlib_zv        U,
+    matlib_zv        u,
+    matlib_index     num_threads,
+    pthpool_data_t*  mp,
+    pfem1d_future_t* future
+);
+
+void pfem1d_ZPrjL2F_async
+(
+    matlib_index     p,
+    matlib_zv        u,
+    matlib_zv        Pvb,
+    matlib_index     num_threads,
+    pthpool_data_t*  mp,
+    pfem1d_future_t* future
+);
+
+void pfem1d_ZF2L_async
+(
+    matlib_index     p,
+    matlib_zv        vb,
+    matlib_zv        u,
+    matlib_index     num_threads,
+    pthpool_data_t*  mp,
+    pfem1d_future_t* future
+);
 
+void pfem1d_wait(pfem1d_future_t* future);
 
 #endif
@@ -4,6 +4,7 @@
 /*============================================================================+/
  | Include all the dependencies
 /+============================================================================*/
+#include <stdint.h>
 #include "basic.h"
 #include "matlib.h"
 #include "debug.h"
@@ -11,8 +12,6 @@
 /*============================================================================+/
  |DATA STRUCTURES AND ENUMS
 /+============================================================================*/
-#define MAX_NUM_CPU 8
-
 typedef enum
 {
     PTHPOOL_WAIT,
@@ -22,6 +21,82 @@ typedef enum
 
 } PTHPOOL_ACTION;
 
+/* How idle threads wait for work and how waiters wait for completion:
+ * MUTEX: condition variables,
+ * SPIN : atomics with a bounded spin and backoff, then a futex park.
+ * */ 
+typedef enum
+{
+    PTHPOOL_DISPATCH_MUTEX,
+    PTHPOOL_DISPATCH_SPIN
+
+} PTHPOOL_DISPATCH;
+
+/* Placement of the threads on the CPUs the process may run on:
+ * NONE   : no pinning,
+ * COMPACT: fill a NUMA node (or socket) core by core, SMT siblings adjacent,
+ * SCATTER: round-robin over NUMA nodes (or sockets), cores before siblings,
+ * CORE   : one thread per physical core, siblings only after all cores.
+ * The default is taken from the environment variable PTHPOOL_PLACE
+ * (none|compact|scatter|core), otherwise CORE.
+ * */ 
+typedef enum
+{
+    PTHPOOL_PLACE_NONE,
+    PTHPOOL_PLACE_COMPACT,
+    PTHPOOL_PLACE_SCATTER,
+    PTHPOOL_PLACE_CORE
+
+} PTHPOOL_PLACE;
+
+#define PTHPOOL_PLACE_ENV "PTHPOOL_PLACE"
+
+/* CPUs of the affinity mask of the process with their location from sysfs;
+ * all arrays have length nr_cpu.
+ * */ 
+typedef struct
+{
+    matlib_index nr_cpu;
+    matlib_index nr_core;
+    matlib_index nr_package;
+    matlib_index nr_node;
+    int*         cpu;
+    int*         core;      /* dense index of the physical core */ 
+    int*         package;
+    int*         node;
+
+} pthpool_topology_t;
+
+/* Nr. of polls before a spinning thread parks on a futex; no spinning when
+ * there are more threads than CPUs available to the process.
+ * */ 
+#define PTHPOOL_SPIN_LIMIT 4096
+
+/* Scheduling of the iterations of pthpool_for; the range is cut into chunks
+ * of grain iterations (grain 0 is taken as 1):
+ * STATIC : each thread receives one contiguous run of chunks,
+ * DYNAMIC: threads take one chunk at a time from a shared counter,
+ * GUIDED : threads take runs of chunks proportional to the chunks left
+ *          divided by twice the number of threads, at least one chunk.
+ * */ 
+typedef enum
+{
+    PTHPOOL_SCHED_STATIC,
+    PTHPOOL_SCHED_DYNAMIC,
+    PTHPOOL_SCHED_GUIDED
+
+} PTHPOOL_SCHED;
+
+typedef enum
+{
+    PTHPOOL_REDUCE_SUM,
+    PTHPOOL_REDUCE_MAX
+
+} PTHPOOL_REDUCE;
+
+/* Chunk size of the reductions when the grain is 0 */ 
+#define PTHPOOL_REDUCE_GRAIN 64
+
 /* Argument of the function to be executed in any thread */ 
 typedef struct
 {
@@ -41,17 +116,225 @@ typedef struct
 
 } pthpool_task_t;
 
+/* Completion handle: counts the submitted tasks which have not finished yet.
+ * A handle can be shared by any number of tasks and waited upon once all of
+ * them have been submitted.
+ * */ 
+typedef struct
+{
+    matlib_index    pending;
+    uint32_t        state;   /* futex word: running, parked or done */ 
+    pthread_mutex_t lock;
+    pthread_cond_t  done;
+
+} pthpool_handle_t;
+
+/* Sense-reversing barrier for a fixed number of participants; waiters spin
+ * with backoff and then park on the sense word.
+ * */ 
+typedef struct
+{
+    uint32_t count;
+    uint32_t sense;
+    uint32_t parked;
+    uint32_t nr_threads;
+    uint32_t spin_limit;
+
+} pthpool_barrier_t;
+
+/* Static partition of [0, N) over the threads of a pool: thread i owns
+ * [start[i], start[i+1]). This is the split of pthpool_for with
+ * PTHPOOL_SCHED_STATIC and grain 0 (for N of at least num_threads) and of
+ * the persistent regions.
+ * */ 
+typedef struct
+{
+    matlib_index  N;
+    matlib_index  num_threads;
+    matlib_index* start;       /* length num_threads+1 */ 
+
+} pthpool_partition_t;
+
+/* Phase of a persistent region: a range kernel as for pthpool_for, executed
+ * by every participant over its part of the range, or by participant 0 over
+ * the whole range if serial.
+ * */ 
+typedef struct
+{
+    void*  thfunc;
+    void** shared_data;
+    bool   serial;
+
+} pthpool_phase_t;
+
+/* Persistent region over [0, N): participant i runs on thread i of the pool
+ * and always processes [partition[i], partition[i+1]).
+ * */ 
+typedef struct
+{
+    matlib_index      N;
+    matlib_index      num_threads;
+    matlib_index*     partition;   /* length num_threads+1 */ 
+    pthpool_barrier_t barrier;
+
+} pthpool_region_t;
+
+/* Telemetry of a thread of the pool, see pthpool_stats_snapshot. The
+ * counters are updated unless the library is compiled with PTHPOOL_NSTATS.
+ * The wake latency is the time from the submission of a task until a thread
+ * starts it: bin k of the histogram counts latencies in [2^k, 2^(k+1)) ns,
+ * the last bin all the longer ones.
+ * */ 
+#define PTHPOOL_STATS_BINS 32
+
+typedef struct
+{
+    matlib_index nr_tasks;
+    uint64_t     busy_ns;      /* executing tasks */ 
+    uint64_t     wait_ns;      /* idle: spinning, parked or asleep */ 
+    uint64_t     task_min_ns;
+    uint64_t     task_max_ns;
+    matlib_index wake_hist[PTHPOOL_STATS_BINS];
+
+} pthpool_stats_t;
+
+/* Entry of the work queue of a thread */ 
+typedef struct
+{
+    pthpool_task_t    task;
+    pthpool_handle_t* handle;
+    uint64_t          submit_ns;
+
+} pthpool_job_t;
+
+/* Capacity of the work queue of each thread; a task submitted to a full
+ * queue is executed by the submitting thread.
+ * */ 
+#define PTHPOOL_DEQUE_SIZE 256
+
+/* Capacity of the queue of pinned tasks of each thread */ 
+#define PTHPOOL_PINNED_SIZE 64
+
+/* Capacity of the shared queue of tasks submitted from outside the pool;
+ * when it is full, tasks are queued round-robin on the threads instead.
+ * */ 
+#define PTHPOOL_INJECT_SIZE 256
+
+/* Slot of the shared queue: seq tells producers and consumers whether the
+ * slot is free or holds a job for the current lap. The positions are 64-bit
+ * whatever the width of matlib_index so that their differences can be taken
+ * as signed values.
+ * */ 
 typedef struct
+{
+    uint64_t      seq;
+    pthpool_job_t job;
+
+} pthpool_slot_t;
+
+/* State shared by all threads of a pool, allocated by
+ * pthpool_create_threads and freed by pthpool_destroy_threads.
+ * */ 
+typedef struct
+{
+    matlib_index     queued;       /* jobs in any deque or in the shared queue */ 
+    matlib_index     next;         /* round-robin target for external submits */ 
+    PTHPOOL_DISPATCH dispatch;
+    matlib_index     spin_limit;
+
+    /* multi-producer multi-consumer queue of external submits */ 
+    uint64_t        inject_head;
+    uint64_t        inject_tail;
+    pthpool_slot_t  inject[PTHPOOL_INJECT_SIZE];
+    pthread_mutex_t region_lock;   /* one persistent region at a time */ 
+
+} pthpool_shared_t;
+
+/* Each thread owns a double-ended queue: the owner pushes and pops at the
+ * bottom (LIFO) while idle threads steal from the top (FIFO). The pool is
+ * the array of pthpool_data_t; every element refers to the same
+ * pthpool_shared_t.
+ * */ 
+typedef struct pthpool_data_s
 {
     pthread_t       thread;
     cpu_set_t       cpu;
+    int             cpu_id;        /* -1 if not pinned */ 
+    int             numa_node;
     pthread_mutex_t lock;
     pthread_cond_t  notify;
-    pthpool_task_t* task;
     matlib_index    thread_index;
     PTHPOOL_ACTION  action;
 
+    matlib_index           num_threads;
+    struct pthpool_data_s* pool;   /* first thread of the pool */ 
+    pthpool_shared_t*      shared;
+    bool                   idle;   /* sleeping on notify or parked */ 
+    uint32_t               wake;   /* futex word for SPIN dispatch */ 
+
+    pthread_mutex_t qlock;         /* protects the deque */ 
+    matlib_index    top;
+    matlib_index    bottom;
+    pthpool_job_t   deque[PTHPOOL_DEQUE_SIZE];
+
+    /* FIFO of tasks which only this thread may execute */ 
+    matlib_index    pin_top;
+    matlib_index    pin_bottom;
+    matlib_index    npinned;
+    pthpool_job_t   pinned[PTHPOOL_PINNED_SIZE];
+
+    pthpool_handle_t nosync;       /* task of pthpool_exec_task_nosync */ 
+    pthpool_stats_t  stats;        /* written by this thread only */ 
+
 } pthpool_data_t;
+
+/* Stage of a task graph: the range [start, end) cut into blocks of block
+ * iterations (one node per block), or a single node over the whole range if
+ * block is 0.
+ * */ 
+typedef struct
+{
+    matlib_index start;
+    matlib_index end;
+    matlib_index block;
+    matlib_index first;     /* index of the first node */ 
+    matlib_index nr_nodes;
+
+} pthpool_stage_t;
+
+/* Node of a task graph: a range kernel over [bounds[0], bounds[1]) */ 
+typedef struct
+{
+    void*          thfunc;
+    void**         shared_data;
+    matlib_index   bounds[2];
+    matlib_index   nr_deps;
+    matlib_index   pending;   /* dependencies left during an execution */ 
+    matlib_index   nr_succ;
+    matlib_index   cap_succ;
+    matlib_index*  succ;      /* nodes depending on this one */ 
+    void*          link[2];   /* graph and node for the task */ 
+    pthpool_arg_t  arg;       /* argument of thfunc */ 
+    pthpool_arg_t  self;      /* argument of the task */ 
+    pthpool_task_t task;
+
+} pthpool_node_t;
+
+typedef struct
+{
+    matlib_index     nr_stages;
+    matlib_index     cap_stages;
+    pthpool_stage_t* stage;
+    matlib_index     nr_nodes;
+    matlib_index     cap_nodes;
+    pthpool_node_t*  node;
+
+    /* pool of the execution in progress */ 
+    matlib_index     num_threads;
+    pthpool_data_t*  mp;
+    pthpool_handle_t handle;
+
+} pthpool_graph_t;
 /*============================================================================*/
 
 void pthpool_create_threads
@@ -60,6 +343,13 @@ void pthpool_create_threads
     pthpool_data_t* mp
 );
 
+void pthpool_create_threads_placed
+( 
+    matlib_index    num_threads, 
+    pthpool_data_t* mp,
+    PTHPOOL_PLACE   place
+);
+
 void pthpool_exec_task
 ( 
     matlib_index    num_threads, 
@@ -67,6 +357,14 @@ void pthpool_exec_task
     pthpool_task_t* task
 );
 
+void pthpool_exec_task_async
+( 
+    matlib_index      num_threads, 
+    pthpool_data_t*   mp, 
+    pthpool_task_t*   task,
+    pthpool_handle_t* handle
+);
+
 void pthpool_exec_task_nosync
 ( 
     matlib_index    num_threads, 
@@ -85,6 +383,155 @@ void pthpool_destroy_threads
     matlib_index    num_threads, 
     pthpool_data_t* mp 
 );
+
+void pthpool_set_dispatch
+( 
+    matlib_index     num_threads, 
+    pthpool_data_t*  mp, 
+    PTHPOOL_DISPATCH dispatch
+);
+/*============================================================================+/
+ | Task submission with completion handles
+ |
+ | Any number of client threads may submit to one pool concurrently; each
+ | submission is tracked by the handle it names. Tasks submitted from outside
+ | the pool go through a shared queue which all threads drain, tasks of the
+ | threads of the pool go to their own deques. pthpool_exec_task_nosync and
+ | pthpool_sync_threads share one handle per thread and therefore serve a
+ | single client; concurrent clients use pthpool_exec_task_async instead.
+/+============================================================================*/
+void pthpool_handle_init(pthpool_handle_t* handle);
+void pthpool_handle_destroy(pthpool_handle_t* handle);
+
+void pthpool_submit
+( 
+    matlib_index      num_threads, 
+    pthpool_data_t*   mp, 
+    pthpool_task_t*   task,
+    pthpool_handle_t* handle
+);
+
+void pthpool_submit_to
+( 
+    matlib_index      thread_index, 
+    pthpool_data_t*   mp, 
+    pthpool_task_t*   task,
+    pthpool_handle_t* handle
+);
+
+void pthpool_submit_pinned
+( 
+    matlib_index      thread_index, 
+    pthpool_data_t*   mp, 
+    pthpool_task_t*   task,
+    pthpool_handle_t* handle
+);
+
+void pthpool_wait
+( 
+    pthpool_data_t*   mp, 
+    pthpool_handle_t* handle
+);
+
+void pthpool_barrier_init
+(
+    pthpool_barrier_t* barrier,
+    matlib_index       nr_threads
+);
+
+void pthpool_barrier_wait(pthpool_barrier_t* barrier);
+
+/*============================================================================+/
+ | Telemetry
+ |
+ | pthpool_stats_snapshot copies the counters of each thread into stats (an
+ | array of num_threads entries) and may be called at any time. Resetting
+ | while tasks run may lose the updates in flight, hence reset between
+ | dispatches, e.g. to obtain the minimum and maximum task time of one
+ | pfem1d_* call. pthpool_stats_imbalance returns the ratio of the largest to
+ | the mean busy time (1 for a perfect balance, 0 if nothing ran).
+/+============================================================================*/
+void pthpool_stats_snapshot
+(
+    matlib_index     num_threads,
+    pthpool_data_t*  mp,
+    pthpool_stats_t* stats
+);
+
+void pthpool_stats_reset
+(
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+);
+
+matlib_real pthpool_stats_imbalance
+(
+    matlib_index           num_threads,
+    const pthpool_stats_t* stats
+);
+
+/*============================================================================+/
+ | Topology and placement
+/+============================================================================*/
+void pthpool_get_topology(pthpool_topology_t* topo);
+void pthpool_free_topology(pthpool_topology_t* topo);
+
+void pthpool_place_threads
+(
+    matlib_index              num_threads,
+    PTHPOOL_PLACE             place,
+    const pthpool_topology_t* topo,
+    int*                      cpu_id
+);
+
+void pthpool_first_touch
+(
+    matlib_index*   Np,
+    size_t          block_size,
+    void*           ptr,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+);
+
+/* Ownership of memory by partition: memory touched with
+ * pthpool_partition_touch is placed on the NUMA nodes of the owners and
+ * pthpool_for_partition runs every range on its owner.
+ * */ 
+void pthpool_partition_split
+(
+    matlib_index         N,
+    matlib_index         num_threads,
+    pthpool_partition_t* part
+);
+
+void pthpool_partition_touch
+(
+    const pthpool_partition_t* part,
+    size_t                     block_size,
+    size_t                     size,
+    void*                      ptr,
+    pthpool_data_t*            mp
+);
+
+void pthpool_for_partition
+(
+    const pthpool_partition_t* part,
+    void**                     shared_data,
+    void*                      thfunc,
+    pthpool_data_t*            mp
+);
+
+void pthpool_for_partition_async
+(
+    const pthpool_partition_t* part,
+    void**                     shared_data,
+    void*                      thfunc,
+    pthpool_data_t*            mp,
+    pthpool_arg_t*             arg,
+    pthpool_task_t*            task,
+    pthpool_handle_t*          handle
+);
+
 /* Parallelize evaluation of functions defined for vectors */ 
 void pthpool_func
 (
@@ -95,5 +542,116 @@ void pthpool_func
     pthpool_data_t* mp
 
 );
-#endif
 
+/*============================================================================+/
+ | Parallel loops
+ |
+ | thfunc is called with a pthpool_arg_t whose nonshared_data points to the
+ | bounds [start_index, end_index) of the iterations it has to process, the
+ | same convention as pthpool_func. For the reductions thfunc returns the
+ | partial (matlib_real or matlib_complex) of its range; it is called once per
+ | chunk and the partials are combined in chunk order with a pairwise sum, so
+ | that the result depends on the grain but not on the schedule or on the
+ | number of threads.
+/+============================================================================*/
+void pthpool_for
+(
+    matlib_index    start,
+    matlib_index    end,
+    PTHPOOL_SCHED   sched,
+    matlib_index    grain,
+    void**          shared_data,
+    void*           thfunc,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+);
+
+matlib_real pthpool_for_xreduce
+(
+    matlib_index    start,
+    matlib_index    end,
+    PTHPOOL_SCHED   sched,
+    matlib_index    grain,
+    PTHPOOL_REDUCE  op,
+    void**          shared_data,
+    void*           thfunc,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+);
+
+matlib_complex pthpool_for_zreduce
+(
+    matlib_index    start,
+    matlib_index    end,
+    PTHPOOL_SCHED   sched,
+    matlib_index    grain,
+    void**          shared_data,
+    void*           thfunc,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+);
+/*============================================================================+/
+ | Persistent parallel regions
+ |
+ | The participants enter the region once and run the sequence of phases
+ | nr_repeat times (e.g. once per time step) with a barrier after each phase,
+ | instead of one dispatch per kernel. Since a participant is pinned to its
+ | thread and keeps its part of the range, the data it touches stays in the
+ | caches of that thread across phases and repetitions. A region must be
+ | executed from outside the pool; regions of concurrent clients run one after
+ | the other since their participants would block each other at the barriers.
+/+============================================================================*/
+void pthpool_region_init
+(
+    matlib_index      N,
+    matlib_index      num_threads,
+    pthpool_region_t* region
+);
+
+void pthpool_region_destroy(pthpool_region_t* region);
+
+void pthpool_region_exec
+(
+    pthpool_region_t* region,
+    matlib_index      nr_phases,
+    pthpool_phase_t*  phase,
+    matlib_index      nr_repeat,
+    pthpool_data_t*   mp
+);
+/*============================================================================+/
+ | Task graphs
+ |
+ | A graph is built once as a sequence of stages and executed any number of
+ | times. pthpool_graph_add appends a stage and returns its index; the nodes of
+ | a stage call thfunc as in pthpool_for with thread_index set to the index of
+ | the block within the stage. A node depends on the nodes of the upstream
+ | stages whose range intersects its own range widened by halo iterations on
+ | both sides; if either stage consists of a single node (block 0), it depends
+ | on all of them. Hence, a node starts as soon as the blocks it reads from are
+ | done, without waiting for the whole upstream stage. Upstream stages must
+ | have been added before.
+/+============================================================================*/
+void pthpool_graph_init(pthpool_graph_t* graph);
+
+matlib_index pthpool_graph_add
+(
+    pthpool_graph_t*    graph,
+    matlib_index        start,
+    matlib_index        end,
+    matlib_index        block,
+    void**              shared_data,
+    void*               thfunc,
+    matlib_index        nr_upstream,
+    const matlib_index* upstream,
+    matlib_index        halo
+);
+
+void pthpool_graph_exec
+(
+    pthpool_graph_t* graph,
+    matlib_index     num_threads,
+    pthpool_data_t*  mp
+);
+
+void pthpool_graph_destroy(pthpool_graph_t* graph);
+#endif
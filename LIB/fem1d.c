@@ -15,14 +15,55 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include "mkl.h"
 
 #define NDEBUG
 #define MATLIB_NTRACE_DATA
 
+#include "legendre.h"
 #include "fem1d.h"
 #include "assert.h"
 
+/*============================================================================+/
+ | Runtime ISA dispatch
+/+============================================================================*/
+static FEM1D_ISA fem1d_isa = FEM1D_ISA_SSE2;
+
+static void __attribute__((constructor)) fem1d_isa_init(void)
+/* 
+ * Mirrors the order in which the loader resolves the kernels annotated with
+ * ISA_CLONES so that the reported path is the one actually executed.
+ * */ 
+{
+#ifdef ISA_DISPATCH
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("x86-64-v4"))
+    {
+        fem1d_isa = FEM1D_ISA_AVX512;
+    }
+    else if(__builtin_cpu_supports("x86-64-v3"))
+    {
+        fem1d_isa = FEM1D_ISA_AVX2;
+    }
+#endif
+}
+
+FEM1D_ISA fem1d_isa_path(void)
+{
+    return fem1d_isa;
+}
+
+const char* fem1d_isa_name(FEM1D_ISA isa)
+{
+    switch(isa)
+    {
+        case FEM1D_ISA_AVX512: return "avx512";
+        case FEM1D_ISA_AVX2:   return "avx2";
+        default:               return "sse2";
+    }
+}
+
 /*============================================================================*/
 void fem1d_ref2mesh
 (
@@ -1120,6 +1161,7 @@ void fem1d_ZL2F
 /*============================================================================*/
 
 
+ISA_CLONES
 void fem1d_xshapefunc2lp
 (
     matlib_index p, 
@@ -1174,6 +1216,7 @@ void fem1d_xshapefunc2lp
         *u = A[3]**b, u++, b++; 
     }
 }
+ISA_CLONES
 void fem1d_zshapefunc2lp
 (
     matlib_index    p, 
@@ -1229,6 +1272,7 @@ void fem1d_zshapefunc2lp
     }
 }
 /*============================================================================*/
+ISA_CLONES
 void lp2fem1d_xshapefunc
 (
     matlib_index p,
@@ -1314,6 +1358,7 @@ void lp2fem1d_xshapefunc
         *v = *(v+1) - *pA**(b+1) - 2.0**u;
     }     
 }
+ISA_CLONES
 void lp2fem1d_zshapefunc
 (
     matlib_index p,
@@ -1405,6 +1450,7 @@ void lp2fem1d_zshapefunc
 
  
 
+ISA_CLONES
 void fem1d_xshapefunc2lp_2
 (
     matlib_index N, 
@@ -1428,6 +1474,7 @@ void fem1d_xshapefunc2lp_2
 
  
 
+ISA_CLONES
 void fem1d_xshapefunc2lp_3
 (
     matlib_index N, 
@@ -1452,6 +1499,7 @@ void fem1d_xshapefunc2lp_3
 
  
 
+ISA_CLONES
 void fem1d_xshapefunc2lp_4
 (
     matlib_index N, 
@@ -1477,6 +1525,7 @@ void fem1d_xshapefunc2lp_4
 
  
 
+ISA_CLONES
 void fem1d_xshapefunc2lp_5
 (
     matlib_index N, 
@@ -1503,6 +1552,7 @@ void fem1d_xshapefunc2lp_5
 
  
 
+ISA_CLONES
 void fem1d_xshapefunc2lp_6
 (
     matlib_index N, 
@@ -1530,6 +1580,7 @@ void fem1d_xshapefunc2lp_6
 
  
 
+ISA_CLONES
 void fem1d_xshapefunc2lp_7
 (
     matlib_index N, 
@@ -1558,6 +1609,7 @@ void fem1d_xshapefunc2lp_7
 
  
 
+ISA_CLONES
 void fem1d_xshapefunc2lp_8
 (
     matlib_index N, 
@@ -1587,6 +1639,7 @@ void fem1d_xshapefunc2lp_8
 
  
 
+ISA_CLONES
 void fem1d_xshapefunc2lp_9
 (
     matlib_index N, 
@@ -1617,6 +1670,7 @@ void fem1d_xshapefunc2lp_9
 
  
 
+ISA_CLONES
 void fem1d_xshapefunc2lp_10
 (
     matlib_index N, 
@@ -1650,6 +1704,7 @@ void fem1d_xshapefunc2lp_10
 
  
 
+ISA_CLONES
 void fem1d_zshapefunc2lp_2
 (
     matlib_index N, 
@@ -1673,6 +1728,7 @@ void fem1d_zshapefunc2lp_2
 
  
 
+ISA_CLONES
 void fem1d_zshapefunc2lp_3
 (
     matlib_index N, 
@@ -1697,6 +1753,7 @@ void fem1d_zshapefunc2lp_3
 
  
 
+ISA_CLONES
 void fem1d_zshapefunc2lp_4
 (
     matlib_index N, 
@@ -1722,6 +1779,7 @@ void fem1d_zshapefunc2lp_4
 
  
 
+ISA_CLONES
 void fem1d_zshapefunc2lp_5
 (
     matlib_index N, 
@@ -1748,6 +1806,7 @@ void fem1d_zshapefunc2lp_5
 
  
 
+ISA_CLONES
 void fem1d_zshapefunc2lp_6
 (
     matlib_index N, 
@@ -1775,6 +1834,7 @@ void fem1d_zshapefunc2lp_6
 
  
 
+ISA_CLONES
 void fem1d_zshapefunc2lp_7
 (
     matlib_index N, 
@@ -1803,6 +1863,7 @@ void fem1d_zshapefunc2lp_7
 
  
 
+ISA_CLONES
 void fem1d_zshapefunc2lp_8
 (
     matlib_index N, 
@@ -1832,6 +1893,7 @@ void fem1d_zshapefunc2lp_8
 
  
 
+ISA_CLONES
 void fem1d_zshapefunc2lp_9
 (
     matlib_index N, 
@@ -1862,6 +1924,7 @@ void fem1d_zshapefunc2lp_9
 
  
 
+ISA_CLONES
 void fem1d_zshapefunc2lp_10
 (
     matlib_index N, 
@@ -1894,6 +1957,7 @@ void fem1d_zshapefunc2lp_10
 /*======================================================================*/
  
 
+ISA_CLONES
 void lp2fem1d_xshapefunc_2
 (
     matlib_index N,
@@ -1921,6 +1985,7 @@ void lp2fem1d_xshapefunc_2
  
  
 
+ISA_CLONES
 void lp2fem1d_xshapefunc_3
 (
     matlib_index N,
@@ -1953,6 +2018,7 @@ void lp2fem1d_xshapefunc_3
 
  
 
+ISA_CLONES
 void lp2fem1d_xshapefunc_4
 (
     matlib_index N,
@@ -1987,6 +2053,7 @@ void lp2fem1d_xshapefunc_4
 
  
 
+ISA_CLONES
 void lp2fem1d_xshapefunc_5
 (
     matlib_index N,
@@ -2023,6 +2090,7 @@ void lp2fem1d_xshapefunc_5
 
  
 
+ISA_CLONES
 void lp2fem1d_xshapefunc_6
 (
     matlib_index N,
@@ -2061,6 +2129,7 @@ void lp2fem1d_xshapefunc_6
 
  
 
+ISA_CLONES
 void lp2fem1d_xshapefunc_7
 (
     matlib_index N,
@@ -2101,6 +2170,7 @@ void lp2fem1d_xshapefunc_7
 
  
 
+ISA_CLONES
 void lp2fem1d_xshapefunc_8
 (
     matlib_index N,
@@ -2143,6 +2213,7 @@ void lp2fem1d_xshapefunc_8
 
  
 
+ISA_CLONES
 void lp2fem1d_xshapefunc_9
 (
     matlib_index N,
@@ -2187,6 +2258,7 @@ void lp2fem1d_xshapefunc_9
 
  
 
+ISA_CLONES
 void lp2fem1d_xshapefunc_10
 (
     matlib_index N,
@@ -2236,6 +2308,7 @@ void lp2fem1d_xshapefunc_10
 
  
 
+ISA_CLONES
 void lp2fem1d_zshapefunc_2
 (
     matlib_index   N,
@@ -2263,6 +2336,7 @@ void lp2fem1d_zshapefunc_2
  
  
 
+ISA_CLONES
 void lp2fem1d_zshapefunc_3
 (
     matlib_index   N,
@@ -2295,6 +2369,7 @@ void lp2fem1d_zshapefunc_3
 
  
 
+ISA_CLONES
 void lp2fem1d_zshapefunc_4
 (
     matlib_index   N,
@@ -2329,6 +2404,7 @@ void lp2fem1d_zshapefunc_4
 
  
 
+ISA_CLONES
 void lp2fem1d_zshapefunc_5
 (
     matlib_index   N,
@@ -2365,6 +2441,7 @@ void lp2fem1d_zshapefunc_5
 
  
 
+ISA_CLONES
 void lp2fem1d_zshapefunc_6
 (
     matlib_index   N,
@@ -2403,6 +2480,7 @@ void lp2fem1d_zshapefunc_6
 
  
 
+ISA_CLONES
 void lp2fem1d_zshapefunc_7
 (
     matlib_index    N,
@@ -2443,6 +2521,7 @@ void lp2fem1d_zshapefunc_7
 
  
 
+ISA_CLONES
 void lp2fem1d_zshapefunc_8
 (
     matlib_index   N,
@@ -2485,6 +2564,7 @@ void lp2fem1d_zshapefunc_8
 
  
 
+ISA_CLONES
 void lp2fem1d_zshapefunc_9
 (
     matlib_index   N,
@@ -2529,6 +2609,7 @@ void lp2fem1d_zshapefunc_9
 
  
 
+ISA_CLONES
 void lp2fem1d_zshapefunc_10
 (
     matlib_index   N,
@@ -2682,6 +2763,7 @@ void fem1d_ZPrjL2F
 }
 /*============================================================================*/
 
+ISA_CLONES
 void fem1d_xprjLP2FEM_ShapeFunc
 (
     matlib_index p, 
@@ -2726,6 +2808,7 @@ void fem1d_xprjLP2FEM_ShapeFunc
 
 }
 
+ISA_CLONES
 void fem1d_zprjLP2FEM_ShapeFunc
 (
     matlib_index    p, 
@@ -2776,6 +2859,7 @@ void fem1d_zprjLP2FEM_ShapeFunc
 }
 /*============================================================================*/
 
+ISA_CLONES
 void fem1d_xprjLP2FEM_ShapeFunc_2
 (
     matlib_index N,
@@ -2800,6 +2884,7 @@ void fem1d_xprjLP2FEM_ShapeFunc_2
 
  
 
+ISA_CLONES
 void fem1d_xprjLP2FEM_ShapeFunc_3
 (
     matlib_index N,
@@ -2825,6 +2910,7 @@ void fem1d_xprjLP2FEM_ShapeFunc_3
 
  
 
+ISA_CLONES
 void fem1d_xprjLP2FEM_ShapeFunc_4
 (
     matlib_index N,
@@ -2851,6 +2937,7 @@ void fem1d_xprjLP2FEM_ShapeFunc_4
 
  
 
+ISA_CLONES
 void fem1d_xprjLP2FEM_ShapeFunc_5
 (
     matlib_index N,
@@ -2878,6 +2965,7 @@ void fem1d_xprjLP2FEM_ShapeFunc_5
 
  
 
+ISA_CLONES
 void fem1d_xprjLP2FEM_ShapeFunc_6
 (
     matlib_index N,
@@ -2906,6 +2994,7 @@ void fem1d_xprjLP2FEM_ShapeFunc_6
 
  
 
+ISA_CLONES
 void fem1d_xprjLP2FEM_ShapeFunc_7
 (
     matlib_index N,
@@ -2935,6 +3024,7 @@ void fem1d_xprjLP2FEM_ShapeFunc_7
 
  
 
+ISA_CLONES
 void fem1d_xprjLP2FEM_ShapeFunc_8
 (
     matlib_index N,
@@ -2965,6 +3055,7 @@ void fem1d_xprjLP2FEM_ShapeFunc_8
 
  
 
+ISA_CLONES
 void fem1d_xprjLP2FEM_ShapeFunc_9
 (
     matlib_index N,
@@ -2996,6 +3087,7 @@ void fem1d_xprjLP2FEM_ShapeFunc_9
 
  
 
+ISA_CLONES
 void fem1d_xprjLP2FEM_ShapeFunc_10
 (
     matlib_index N,
@@ -3030,6 +3122,7 @@ void fem1d_xprjLP2FEM_ShapeFunc_10
 
  
 
+ISA_CLONES
 void fem1d_zprjLP2FEM_ShapeFunc_2
 (
     matlib_index           N,
@@ -3054,6 +3147,7 @@ void fem1d_zprjLP2FEM_ShapeFunc_2
 
  
 
+ISA_CLONES
 void fem1d_zprjLP2FEM_ShapeFunc_3
 (
     matlib_index           N,
@@ -3079,6 +3173,7 @@ void fem1d_zprjLP2FEM_ShapeFunc_3
 
  
 
+ISA_CLONES
 void fem1d_zprjLP2FEM_ShapeFunc_4
 (
     matlib_index           N,
@@ -3105,6 +3200,7 @@ void fem1d_zprjLP2FEM_ShapeFunc_4
 
  
 
+ISA_CLONES
 void fem1d_zprjLP2FEM_ShapeFunc_5
 (
     matlib_index           N,
@@ -3132,6 +3228,7 @@ void fem1d_zprjLP2FEM_ShapeFunc_5
 
  
 
+ISA_CLONES
 void fem1d_zprjLP2FEM_ShapeFunc_6
 (
     matlib_index           N,
@@ -3160,6 +3257,7 @@ void fem1d_zprjLP2FEM_ShapeFunc_6
 
  
 
+ISA_CLONES
 void fem1d_zprjLP2FEM_ShapeFunc_7
 (
     matlib_index           N,
@@ -3189,6 +3287,7 @@ void fem1d_zprjLP2FEM_ShapeFunc_7
 
  
 
+ISA_CLONES
 void fem1d_zprjLP2FEM_ShapeFunc_8
 (
     matlib_index           N,
@@ -3219,6 +3318,7 @@ void fem1d_zprjLP2FEM_ShapeFunc_8
 
  
 
+ISA_CLONES
 void fem1d_zprjLP2FEM_ShapeFunc_9
 (
     matlib_index           N,
@@ -3250,6 +3350,7 @@ void fem1d_zprjLP2FEM_ShapeFunc_9
 
  
 
+ISA_CLONES
 void fem1d_zprjLP2FEM_ShapeFunc_10
 (
     matlib_index           N,
@@ -3283,532 +3384,717 @@ void fem1d_zprjLP2FEM_ShapeFunc_10
 
 
 /*============================================================================+/
- | L2 Norm in Legendre Basis
+ | Batched transformations between Legendre basis and FEM-basis
 /+============================================================================*/
 
-matlib_real fem1d_XNorm2
+void fem1d_ZF2L2
 (
-    matlib_index p,
-    matlib_index N,
-    matlib_xv    u
+    const matlib_index p, 
+    const matlib_zm    vb,
+          matlib_zm    u
 )
+/* 
+ * vb: (N*p+1)-by-k, u: N*(p+1)-by-k, both stored in row-major order so that
+ * the k vectors are interleaved.
+ *
+ * */ 
 {
-    debug_enter( "Highest degree of polynomial: %d "
-                 "nr. fnite-elements : %d "
-                 "length of u: %d", p, N, u.len);
+    debug_enter( "highest polynomial degree: %d "
+                 "vb: %d-by-%d, u: %d-by-%d", 
+                 p, vb.lenc, vb.lenr, u.lenc, u.lenr );
 
-    matlib_real (*fp[9])( matlib_index, 
-                          matlib_real* ) = { fem1d_xlp_snorm2_d_2, 
-                                             fem1d_xlp_snorm2_d_3, 
-                                             fem1d_xlp_snorm2_d_4, 
-                                             fem1d_xlp_snorm2_d_5, 
-                                             fem1d_xlp_snorm2_d_6, 
-                                             fem1d_xlp_snorm2_d_7, 
-                                             fem1d_xlp_snorm2_d_8, 
-                                             fem1d_xlp_snorm2_d_9, 
-                                             fem1d_xlp_snorm2_d_10};
- 
-    matlib_real snorm2;
-    assert(u.elem_p!=NULL);
-    if(u.len == (p+1)*N)
+    matlib_index N = (vb.lenc-1)/p;
+    debug_body( "nr finite elements: %d ", N);
+
+    assert((vb.elem_p != NULL) && (u.elem_p != NULL));
+
+    bool order_OK = (vb.order == MATLIB_ROW_MAJOR) && 
+                    (u.order  == MATLIB_ROW_MAJOR);
+
+    if(!order_OK)
     {
-        if(p>10)
-        {
-            snorm2 = fem1d_xlp_snorm2_d( p, N, u.elem_p);
-        }
-        else
-        {
-            matlib_index func_index = p-2;
-            snorm2 = (*fp[func_index])( N, u.elem_p);
-        }
-    
+        term_exec( "Storage order of matrices incorrect: %s", "vb and u");
+    }
+
+    if((u.lenc == vb.lenc+(N-1)) && (u.lenr == vb.lenr))
+    {
+        fem1d_zshapefunc2lp_nv( p, N, u.lenr, 0, N, vb.elem_p, u.elem_p);
     }
     else
     {
-        term_execb( "length of vector incorrect: "
-                    "u: %d (degree : %d, nr. fem-elements: %d)",
-                    u.len, p, N);
+        term_execb( "size of matrices incorrect: "
+                    "vb: %d-by-%d, u: %d-by-%d",
+                    vb.lenc, vb.lenr, u.lenc, u.lenr );
     }
 
-    debug_exit("L2 norm: %0.16f", sqrt(snorm2));
-    return sqrt(snorm2);
-
+    debug_exit("%s", "");
 }
-matlib_real fem1d_ZNorm2
+
+void fem1d_ZL2F2
 (
-    matlib_index     p,
-    matlib_index     N,
-    matlib_zv u
+    const matlib_index p, 
+    const matlib_zm    u,
+          matlib_zm    vb
 )
 {
-    debug_enter( "Highest degree of polynomial: %d "
-                 "nr. fnite-elements : %d "
-                 "length of u: %d", p, N, u.len);
+    debug_enter( "highest polynomial degree: %d "
+                 "u: %d-by-%d, vb: %d-by-%d", 
+                 p, u.lenc, u.lenr, vb.lenc, vb.lenr );
 
-    matlib_real (*fp[9])(matlib_index, matlib_complex*) = { fem1d_zlp_snorm2_d_2, 
-                                                 fem1d_zlp_snorm2_d_3, 
-                                                 fem1d_zlp_snorm2_d_4, 
-                                                 fem1d_zlp_snorm2_d_5, 
-                                                 fem1d_zlp_snorm2_d_6, 
-                                                 fem1d_zlp_snorm2_d_7, 
-                                                 fem1d_zlp_snorm2_d_8, 
-                                                 fem1d_zlp_snorm2_d_9, 
-                                                 fem1d_zlp_snorm2_d_10};
- 
-    matlib_real snorm2;
-    assert(u.elem_p!=NULL);
-    if(u.len == (p+1)*N)
+    matlib_index N = u.lenc/(p+1);
+    debug_body( "nr finite elements: %d ", N);
+
+    assert((vb.elem_p != NULL) && (u.elem_p != NULL));
+
+    bool order_OK = (vb.order == MATLIB_ROW_MAJOR) && 
+                    (u.order  == MATLIB_ROW_MAJOR);
+
+    if(!order_OK)
     {
-        if(p>10)
-        {
-            snorm2 = fem1d_zlp_snorm2_d( p, N, u.elem_p);
-        }
-        else
-        {
-            matlib_index func_index = p-2;
-            snorm2 = (*fp[func_index])( N, u.elem_p);
-        }
-    
+        term_exec( "Storage order of matrices incorrect: %s", "u and vb");
+    }
+
+    if((u.lenc == vb.lenc+(N-1)) && (u.lenr == vb.lenr))
+    {
+        lp2fem1d_zshapefunc_nv( p, N, u.lenr, 0, N, u.elem_p, vb.elem_p);
     }
     else
     {
-        term_execb( "length of vector incorrect: "
-                    "u: %d (degree : %d, nr. fem-elements: %d)",
-                    u.len, p, N);
+        term_execb( "size of matrices incorrect: "
+                    "u: %d-by-%d, vb: %d-by-%d",
+                    u.lenc, u.lenr, vb.lenc, vb.lenr );
     }
 
-    debug_exit("L2 norm: %0.16f", sqrt(snorm2));
-    return sqrt(snorm2);
-
+    debug_exit("%s", "");
 }
 
-
-matlib_real fem1d_xlp_snorm2_d(matlib_index p, matlib_index N, matlib_real *u)
+void fem1d_ZPrjL2F2
+(
+    const matlib_index p, 
+    const matlib_zm    u,
+          matlib_zm    Pvb
+)
 {
-    matlib_real snorm = 0;
-    matlib_index i;
-    matlib_real coeff[p+1], *pcoeff;
+    debug_enter( "highest polynomial degree: %d "
+                 "u: %d-by-%d, Pvb: %d-by-%d", 
+                 p, u.lenc, u.lenr, Pvb.lenc, Pvb.lenr );
 
-    for 
-    ( 
-        pcoeff = &coeff[0], i=0; 
-        i<p+1; 
-        i++, pcoeff++
-    )
+    matlib_index N = u.lenc/(p+1);
+    debug_body( "nr finite elements: %d ", N);
+
+    assert((u.elem_p != NULL) && (Pvb.elem_p != NULL));
+
+    bool order_OK = (Pvb.order == MATLIB_ROW_MAJOR) && 
+                    (u.order   == MATLIB_ROW_MAJOR);
+
+    if(!order_OK)
     {
-        *pcoeff = 1.0/(i+0.5); 
+        term_exec( "Storage order of matrices incorrect: %s", "u and Pvb");
     }
 
-    for (i=0; i<N; i++)
-    { 
-        for 
-        ( 
-            pcoeff = &coeff[0]; 
-            pcoeff < &coeff[0]+p+1; 
-            u++, pcoeff++
-        )
-        {
-            snorm += *u**u**pcoeff;
-        }
+    if((u.lenc == Pvb.lenc+(N-1)) && (u.lenr == Pvb.lenr))
+    {
+        fem1d_zprjLP2FEM_ShapeFunc_nv( p, N, u.lenr, 0, N, 
+                                       u.elem_p, Pvb.elem_p);
+    }
+    else
+    {
+        term_execb( "size of matrices incorrect: "
+                    "u: %d-by-%d, Pvb: %d-by-%d",
+                    u.lenc, u.lenr, Pvb.lenc, Pvb.lenr );
     }
-    return snorm;
+
+    debug_exit("%s", "");
 }
 
-matlib_real fem1d_zlp_snorm2_d(matlib_index p, matlib_index N, matlib_complex *u)
+/*============================================================================*/
+ISA_CLONES
+void fem1d_zshapefunc2lp_nv
+(
+    matlib_index    p, 
+    matlib_index    N, 
+    matlib_index    k, 
+    matlib_index    start, 
+    matlib_index    end, 
+    matlib_complex* vb,
+    matlib_complex* u
+)
+/* 
+ * The bubble function of degree l+2 is s_l*(P_{l+2}-P_l) with 
+ * s_l = 1/sqrt(4l+6), hence every bubble coefficient contributes to two 
+ * Legendre coefficients of its element.
+ *
+ * */ 
 {
-    matlib_real snorm = 0;
-    matlib_index i;
-    matlib_real coeff[p+1], *pcoeff;
+    matlib_index i, j, l;
+    matlib_real s[p-1];
+    matlib_complex *vl, *b, *ul;
 
-    for 
-    ( 
-        pcoeff = &coeff[0], i=0; 
-        i<p+1; 
-        i++, pcoeff++
-    )
+    for(l=0; l<p-1; l++)
     {
-        *pcoeff = 1.0/(i+0.5); 
+        s[l] = 1.0/sqrt(4*l+6);
     }
 
-    for (i=0; i<N; i++)
+    for(i=start; i<end; i++)
     {
-        for 
-        ( 
-            pcoeff = &coeff[0]; 
-            pcoeff < &coeff[0]+p+1; 
-            u++, pcoeff++
-        )
+        vl = vb + i*k;
+        b  = vb + (N+1+i*(p-1))*k;
+        ul = u  + i*(p+1)*k;
+
+        for(j=0; j<k; j++)
+        {
+            ul[j]   = 0.5*(vl[k+j] + vl[j]);
+            ul[k+j] = 0.5*(vl[k+j] - vl[j]);
+        }
+        for(j=2*k; j<(p+1)*k; j++)
         {
-            snorm += *u*conj(*u)**pcoeff;
+            ul[j] = 0;
+        }
+        for(l=0; l<p-1; l++, b+=k)
+        {
+            for(j=0; j<k; j++)
+            {
+                ul[l*k+j]     -= s[l]*b[j];
+                ul[(l+2)*k+j] += s[l]*b[j];
+            }
         }
     }
-    return snorm;
 }
-/*============================================================================*/
 
- 
-matlib_real fem1d_xlp_snorm2_d_2(matlib_index N, matlib_real *u)
+ISA_CLONES
+void lp2fem1d_zshapefunc_nv
+(
+    matlib_index    p, 
+    matlib_index    N, 
+    matlib_index    k, 
+    matlib_index    start, 
+    matlib_index    end, 
+    matlib_complex* u,
+    matlib_complex* vb
+)
+/* 
+ * Inverse of fem1d_zshapefunc2lp_nv: the bubble coefficients are recovered 
+ * from the highest degree downwards and the vertex values from the first two 
+ * Legendre coefficients. Each element writes its left vertex, the last one 
+ * also writes the right boundary, so that disjoint element ranges can be 
+ * processed concurrently.
+ *
+ * */ 
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    matlib_index i, j, l;
+    matlib_real s[p-1], is[p-1];
+    matlib_complex *vl, *b, *ul, a0, a1;
+
+    for(l=0; l<p-1; l++)
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2);
-        u += 3;
-        snorm += tmp;
+        s[l]  = 1.0/sqrt(4*l+6);
+        is[l] = sqrt(4*l+6);
     }
-    return snorm;
-}
- 
- 
-matlib_real fem1d_xlp_snorm2_d_3(matlib_index N, matlib_real *u)
-{
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+
+    for(i=start; i<end; i++)
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3);
-        u += 4;
-        snorm += tmp;
+        vl = vb + i*k;
+        b  = vb + (N+1+i*(p-1))*k;
+        ul = u  + i*(p+1)*k;
+
+        for(l=p-1; l-->0; )
+        {
+            if(l+2<p-1)
+            {
+                for(j=0; j<k; j++)
+                {
+                    b[l*k+j] = is[l]*(ul[(l+2)*k+j] + s[l+2]*b[(l+2)*k+j]);
+                }
+            }
+            else
+            {
+                for(j=0; j<k; j++)
+                {
+                    b[l*k+j] = is[l]*ul[(l+2)*k+j];
+                }
+            }
+        }
+        for(j=0; j<k; j++)
+        {
+            a0 = ul[j] + s[0]*b[j];
+            a1 = (p>2) ? ul[k+j] + s[1]*b[k+j] : ul[k+j];
+            vl[j] = a0 - a1;
+            if(i==N-1)
+            {
+                vl[k+j] = a0 + a1;
+            }
+        }
     }
-    return snorm;
 }
- 
- 
-matlib_real fem1d_xlp_snorm2_d_4(matlib_index N, matlib_real *u)
+
+ISA_CLONES
+void fem1d_zprjLP2FEM_ShapeFunc_nv
+(
+    matlib_index    p, 
+    matlib_index    N, 
+    matlib_index    k, 
+    matlib_index    start, 
+    matlib_index    end, 
+    matlib_complex* u,
+    matlib_complex* Pvb
+)
+/* 
+ * The vertex i collects the contribution of the elements i-1 and i, the 
+ * former is read directly so that no carry is needed across element ranges.
+ *
+ * */ 
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    matlib_index i, j, l;
+    matlib_real B[p-1], C[p-1], tmp;
+    matlib_complex *Pv, *Pb, *ul, *up;
+
+    for(l=0; l<p-1; l++)
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4);
-        u += 5;
-        snorm += tmp;
+        tmp  =  1.0/sqrt(4*l+6);
+        B[l] =  tmp/(l+2.5);
+        C[l] = -tmp/(l+0.5);
     }
-    return snorm;
-}
- 
- 
-matlib_real fem1d_xlp_snorm2_d_5(matlib_index N, matlib_real *u)
-{
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+
+    for(i=start; i<end; i++)
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5);
-        u += 6;
-        snorm += tmp;
+        Pv = Pvb + i*k;
+        Pb = Pvb + (N+1+i*(p-1))*k;
+        ul = u   + i*(p+1)*k;
+
+        if(i>0)
+        {
+            up = ul - (p+1)*k;
+            for(j=0; j<k; j++)
+            {
+                Pv[j] = (ul[j] - ul[k+j]/3) + (up[j] + up[k+j]/3);
+            }
+        }
+        else
+        {
+            for(j=0; j<k; j++)
+            {
+                Pv[j] = ul[j] - ul[k+j]/3;
+            }
+        }
+        if(i==N-1)
+        {
+            for(j=0; j<k; j++)
+            {
+                Pv[k+j] = ul[j] + ul[k+j]/3;
+            }
+        }
+        for(l=0; l<p-1; l++, Pb+=k)
+        {
+            for(j=0; j<k; j++)
+            {
+                Pb[j] = B[l]*ul[(l+2)*k+j] + C[l]*ul[l*k+j];
+            }
+        }
     }
-    return snorm;
 }
- 
- 
-matlib_real fem1d_xlp_snorm2_d_6(matlib_index N, matlib_real *u)
+
+/*============================================================================+/
+ | Evaluation at arbitrary points
+/+============================================================================*/
+
+void fem1d_XEval
+(
+    const matlib_index p,
+    const matlib_real  x_l,
+    const matlib_real  x_r,
+    const matlib_xv    U,
+    const matlib_xv    x,
+          matlib_xv    u
+)
+/* 
+ * U : Legendre coefficients on the uniform mesh of [x_l, x_r], length N*(p+1)
+ * x : query points, any order 
+ * u : values of the series at x
+ *
+ * Points outside [x_l, x_r] are extrapolated with the boundary element.
+ * */ 
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    debug_enter( "highest polynomial degree: %d, "
+                 "length of vectors U: %d, x: %d, u: %d", 
+                 p, U.len, x.len, u.len );
+
+    matlib_index N = U.len/(p+1);
+    assert((U.elem_p!=NULL) && (x.elem_p!=NULL) && (u.elem_p!=NULL));
+
+    if((U.len == N*(p+1)) && (u.len == x.len) && (x_r>x_l))
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5)
-        	+ _N6 * *(u+6) * *(u+6);
-        u += 7;
-        snorm += tmp;
+        fem1d_xclenshaw( p, N, x_l, x_r, U.elem_p, 0, x.len, 
+                         x.elem_p, u.elem_p);
     }
-    return snorm;
-}
- 
- 
-matlib_real fem1d_xlp_snorm2_d_7(matlib_index N, matlib_real *u)
-{
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    else
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5)
-        	+ _N6 * *(u+6) * *(u+6)
-        	+ _N7 * *(u+7) * *(u+7);
-        u += 8;
-        snorm += tmp;
+        term_execb( "size of vectors or domain incorrect: "
+                    "U: %d, x: %d, u: %d, domain: [%0.16f, %0.16f]",
+                    U.len, x.len, u.len, x_l, x_r );
     }
-    return snorm;
+    debug_exit("%s", "");
 }
- 
- 
-matlib_real fem1d_xlp_snorm2_d_8(matlib_index N, matlib_real *u)
+
+void fem1d_ZEval
+(
+    const matlib_index p,
+    const matlib_real  x_l,
+    const matlib_real  x_r,
+    const matlib_zv    U,
+    const matlib_xv    x,
+          matlib_zv    u
+)
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    debug_enter( "highest polynomial degree: %d, "
+                 "length of vectors U: %d, x: %d, u: %d", 
+                 p, U.len, x.len, u.len );
+
+    matlib_index N = U.len/(p+1);
+    assert((U.elem_p!=NULL) && (x.elem_p!=NULL) && (u.elem_p!=NULL));
+
+    if((U.len == N*(p+1)) && (u.len == x.len) && (x_r>x_l))
+    {
+        fem1d_zclenshaw( p, N, x_l, x_r, U.elem_p, 0, x.len, 
+                         x.elem_p, u.elem_p);
+    }
+    else
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5)
-        	+ _N6 * *(u+6) * *(u+6)
-        	+ _N7 * *(u+7) * *(u+7)
-        	+ _N8 * *(u+8) * *(u+8);
-        u += 9;
-        snorm += tmp;
+        term_execb( "size of vectors or domain incorrect: "
+                    "U: %d, x: %d, u: %d, domain: [%0.16f, %0.16f]",
+                    U.len, x.len, u.len, x_l, x_r );
     }
-    return snorm;
+    debug_exit("%s", "");
 }
- 
- 
-matlib_real fem1d_xlp_snorm2_d_9(matlib_index N, matlib_real *u)
+
+/*============================================================================*/
+ISA_CLONES
+void fem1d_xclenshaw
+(
+    matlib_index p,
+    matlib_index N,
+    matlib_real  x_l,
+    matlib_real  x_r,
+    matlib_real* U,
+    matlib_index start,
+    matlib_index end,
+    matlib_real* x,
+    matlib_real* u
+)
+/* 
+ * Points [start, end) are processed in chunks of FEM1D_EVAL_CHUNK: the 
+ * element index and the reference coordinate are computed first, then the 
+ * Clenshaw recurrence 
+ *
+ *   b_k = U_k + (2k+1)/(k+1) xi b_{k+1} - (k+1)/(k+2) b_{k+2}, u = b_0
+ *
+ * runs over the chunk with the points as the inner (vectorized) loop.
+ * */ 
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    matlib_index i, k, n, c;
+    matlib_real A[p+1], C[p+2];
+    matlib_real xi[FEM1D_EVAL_CHUNK], b1[FEM1D_EVAL_CHUNK], b2[FEM1D_EVAL_CHUNK];
+    matlib_index e[FEM1D_EVAL_CHUNK];
+    matlib_real dx  = (x_r-x_l)/N;
+    matlib_real idx = 1.0/dx, t;
+
+    for(k=0; k<p+1; k++)
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5)
-        	+ _N6 * *(u+6) * *(u+6)
-        	+ _N7 * *(u+7) * *(u+7)
-        	+ _N8 * *(u+8) * *(u+8)
-        	+ _N9 * *(u+9) * *(u+9);
-        u += 10;
-        snorm += tmp;
+        A[k] = (2.0*k+1.0)/(k+1.0);
+        C[k] = k/(k+1.0);
     }
-    return snorm;
-}
- 
- 
-matlib_real fem1d_xlp_snorm2_d_10(matlib_index N, matlib_real *u)
-{
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    C[p+1] = (p+1.0)/(p+2.0);
+
+    for(c=start; c<end; c+=FEM1D_EVAL_CHUNK)
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5)
-        	+ _N6 * *(u+6) * *(u+6)
-        	+ _N7 * *(u+7) * *(u+7)
-        	+ _N8 * *(u+8) * *(u+8)
-        	+ _N9 * *(u+9) * *(u+9)
-        	+ _N10 * *(u+10) * *(u+10);
-        u += 11;
-        snorm += tmp;
+        n = ((end-c)<FEM1D_EVAL_CHUNK) ? (end-c) : FEM1D_EVAL_CHUNK;
+        for(i=0; i<n; i++)
+        {
+            /* points outside the domain fall in the boundary elements */ 
+            t     = (x[c+i]-x_l)*idx;
+            e[i]  = (t<0) ? 0 : ((t<N) ? (matlib_index)t : N-1);
+            xi[i] = 2.0*(t-e[i])-1.0;
+            e[i]  = e[i]*(p+1);
+            b1[i] = 0;
+            b2[i] = 0;
+        }
+        for(k=p+1; k-->0; )
+        {
+            for(i=0; i<n; i++)
+            {
+                t     = U[e[i]+k] + A[k]*xi[i]*b1[i] - C[k+1]*b2[i];
+                b2[i] = b1[i];
+                b1[i] = t;
+            }
+        }
+        for(i=0; i<n; i++)
+        {
+            u[c+i] = b1[i];
+        }
     }
-    return snorm;
 }
- 
 
-/* COMPLEX VERSION */ 
- 
-matlib_real fem1d_zlp_snorm2_d_2(matlib_index N, matlib_complex *u)
+ISA_CLONES
+void fem1d_zclenshaw
+(
+    matlib_index    p,
+    matlib_index    N,
+    matlib_real     x_l,
+    matlib_real     x_r,
+    matlib_complex* U,
+    matlib_index    start,
+    matlib_index    end,
+    matlib_real*    x,
+    matlib_complex* u
+)
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    matlib_index i, k, n, c;
+    matlib_real A[p+1], C[p+2];
+    matlib_real xi[FEM1D_EVAL_CHUNK];
+    matlib_complex b1[FEM1D_EVAL_CHUNK], b2[FEM1D_EVAL_CHUNK], s;
+    matlib_index e[FEM1D_EVAL_CHUNK];
+    matlib_real dx  = (x_r-x_l)/N;
+    matlib_real idx = 1.0/dx, t;
+
+    for(k=0; k<p+1; k++)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2));
-        u += 3;
-        snorm += tmp;
+        A[k] = (2.0*k+1.0)/(k+1.0);
+        C[k] = k/(k+1.0);
     }
-    return snorm;
-}
- 
- 
-matlib_real fem1d_zlp_snorm2_d_3(matlib_index N, matlib_complex *u)
-{
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    C[p+1] = (p+1.0)/(p+2.0);
+
+    for(c=start; c<end; c+=FEM1D_EVAL_CHUNK)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3));
-        u += 4;
-        snorm += tmp;
+        n = ((end-c)<FEM1D_EVAL_CHUNK) ? (end-c) : FEM1D_EVAL_CHUNK;
+        for(i=0; i<n; i++)
+        {
+            /* points outside the domain fall in the boundary elements */ 
+            t     = (x[c+i]-x_l)*idx;
+            e[i]  = (t<0) ? 0 : ((t<N) ? (matlib_index)t : N-1);
+            xi[i] = 2.0*(t-e[i])-1.0;
+            e[i]  = e[i]*(p+1);
+            b1[i] = 0;
+            b2[i] = 0;
+        }
+        for(k=p+1; k-->0; )
+        {
+            for(i=0; i<n; i++)
+            {
+                s     = U[e[i]+k] + A[k]*xi[i]*b1[i] - C[k+1]*b2[i];
+                b2[i] = b1[i];
+                b1[i] = s;
+            }
+        }
+        for(i=0; i<n; i++)
+        {
+            u[c+i] = b1[i];
+        }
     }
-    return snorm;
 }
- 
- 
-matlib_real fem1d_zlp_snorm2_d_4(matlib_index N, matlib_complex *u)
+
+/*============================================================================+/
+ | L2 Norm in Legendre Basis
+/+============================================================================*/
+
+/* Block partials computed at a time by fem1d_[xz]lp_snorm2_tree */ 
+#define FEM1D_NORM_NR_PARTIAL 256
+
+FP_STRICT
+static matlib_real fem1d_xlp_snorm2_tree
+(
+    matlib_index p,
+    matlib_index N,
+    matlib_index b0,
+    matlib_index nblk,
+    matlib_real* u
+)
+/* 
+ * Sum of the partials of the blocks [b0, b0+nblk) with the tree of
+ * matlib_xsum_pairwise: the halves are split as there, and a subtree which
+ * fits into the buffer on the stack is summed by matlib_xsum_pairwise
+ * itself, hence the result is the one of a single call over all partials.
+ * FP_STRICT keeps the combination of the halves from being reassociated.
+ *
+ * */ 
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    if(nblk<=FEM1D_NORM_NR_PARTIAL)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4));
-        u += 5;
-        snorm += tmp;
+        matlib_real partial[FEM1D_NORM_NR_PARTIAL];
+        fem1d_xlp_snorm2_b( p, N-b0*FEM1D_NORM_BLOCK, 0, nblk, 
+                            u+b0*FEM1D_NORM_BLOCK*(p+1), partial);
+        return matlib_xsum_pairwise(nblk, partial);
     }
-    return snorm;
+    matlib_index m = nblk/2;
+    return   fem1d_xlp_snorm2_tree(p, N, b0,   m,      u)
+           + fem1d_xlp_snorm2_tree(p, N, b0+m, nblk-m, u);
 }
- 
- 
-matlib_real fem1d_zlp_snorm2_d_5(matlib_index N, matlib_complex *u)
+
+FP_STRICT
+static matlib_real fem1d_zlp_snorm2_tree
+(
+    matlib_index    p,
+    matlib_index    N,
+    matlib_index    b0,
+    matlib_index    nblk,
+    matlib_complex* u
+)
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    if(nblk<=FEM1D_NORM_NR_PARTIAL)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5));
-        u += 6;
-        snorm += tmp;
+        matlib_real partial[FEM1D_NORM_NR_PARTIAL];
+        fem1d_zlp_snorm2_b( p, N-b0*FEM1D_NORM_BLOCK, 0, nblk, 
+                            u+b0*FEM1D_NORM_BLOCK*(p+1), partial);
+        return matlib_xsum_pairwise(nblk, partial);
     }
-    return snorm;
+    matlib_index m = nblk/2;
+    return   fem1d_zlp_snorm2_tree(p, N, b0,   m,      u)
+           + fem1d_zlp_snorm2_tree(p, N, b0+m, nblk-m, u);
 }
- 
- 
-matlib_real fem1d_zlp_snorm2_d_6(matlib_index N, matlib_complex *u)
+
+matlib_real fem1d_XNorm2
+(
+    matlib_index p,
+    matlib_index N,
+    matlib_xv    u
+)
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    debug_enter( "Highest degree of polynomial: %d "
+                 "nr. fnite-elements : %d "
+                 "length of u: %d", p, N, u.len);
+
+    matlib_real snorm2 = 0;
+    assert(u.elem_p!=NULL);
+    if(u.len == (p+1)*N)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5))
-        	+ _N6 * *(u+6) * conj(*(u+6));
-        u += 7;
-        snorm += tmp;
+        matlib_index nblk = (N+FEM1D_NORM_BLOCK-1)/FEM1D_NORM_BLOCK;
+        snorm2 = fem1d_xlp_snorm2_tree( p, N, 0, nblk, u.elem_p);
     }
-    return snorm;
-}
- 
- 
-matlib_real fem1d_zlp_snorm2_d_7(matlib_index N, matlib_complex *u)
-{
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    else
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5))
-        	+ _N6 * *(u+6) * conj(*(u+6))
-        	+ _N7 * *(u+7) * conj(*(u+7));
-        u += 8;
-        snorm += tmp;
+        term_execb( "length of vector incorrect: "
+                    "u: %d (degree : %d, nr. fem-elements: %d)",
+                    u.len, p, N);
     }
-    return snorm;
+
+    debug_exit("L2 norm: %0.16f", sqrt(snorm2));
+    return sqrt(snorm2);
+
 }
- 
- 
-matlib_real fem1d_zlp_snorm2_d_8(matlib_index N, matlib_complex *u)
+matlib_real fem1d_ZNorm2
+(
+    matlib_index     p,
+    matlib_index     N,
+    matlib_zv u
+)
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    debug_enter( "Highest degree of polynomial: %d "
+                 "nr. fnite-elements : %d "
+                 "length of u: %d", p, N, u.len);
+
+    matlib_real snorm2 = 0;
+    assert(u.elem_p!=NULL);
+    if(u.len == (p+1)*N)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5))
-        	+ _N6 * *(u+6) * conj(*(u+6))
-        	+ _N7 * *(u+7) * conj(*(u+7))
-        	+ _N8 * *(u+8) * conj(*(u+8));
-        u += 9;
-        snorm += tmp;
+        matlib_index nblk = (N+FEM1D_NORM_BLOCK-1)/FEM1D_NORM_BLOCK;
+        snorm2 = fem1d_zlp_snorm2_tree( p, N, 0, nblk, u.elem_p);
     }
-    return snorm;
+    else
+    {
+        term_execb( "length of vector incorrect: "
+                    "u: %d (degree : %d, nr. fem-elements: %d)",
+                    u.len, p, N);
+    }
+
+    debug_exit("L2 norm: %0.16f", sqrt(snorm2));
+    return sqrt(snorm2);
+
 }
- 
- 
-matlib_real fem1d_zlp_snorm2_d_9(matlib_index N, matlib_complex *u)
+
+FP_STRICT ISA_CLONES
+void fem1d_xlp_snorm2_b
+(
+    matlib_index p,
+    matlib_index N,
+    matlib_index start,
+    matlib_index end,
+    matlib_real* u,
+    matlib_real* snorm2
+)
+/* 
+ * The squared norm of each element is accumulated in the order of the 
+ * Legendre coefficients, the loop over the elements of a block is the one 
+ * that gets vectorized.
+ * */ 
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    matlib_index b, i, k, n;
+    matlib_real w[p+1], e[FEM1D_NORM_BLOCK], *ub;
+
+    for(k=0; k<p+1; k++)
+    {
+        w[k] = 1.0/(k+0.5);
+    }
+
+    for(b=start; b<end; b++)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5))
-        	+ _N6 * *(u+6) * conj(*(u+6))
-        	+ _N7 * *(u+7) * conj(*(u+7))
-        	+ _N8 * *(u+8) * conj(*(u+8))
-        	+ _N9 * *(u+9) * conj(*(u+9));
-        u += 10;
-        snorm += tmp;
+        n  = N-b*FEM1D_NORM_BLOCK;
+        n  = (n<FEM1D_NORM_BLOCK) ? n : FEM1D_NORM_BLOCK;
+        ub = u + b*FEM1D_NORM_BLOCK*(p+1);
+
+        for(i=0; i<n; i++)
+        {
+            e[i] = 0;
+        }
+        for(k=0; k<p+1; k++)
+        {
+            for(i=0; i<n; i++)
+            {
+                e[i] += w[k]*(ub[i*(p+1)+k]*ub[i*(p+1)+k]);
+            }
+        }
+        snorm2[b] = matlib_xsum_pairwise(n, e);
     }
-    return snorm;
 }
- 
- 
-matlib_real fem1d_zlp_snorm2_d_10(matlib_index N, matlib_complex *u)
+
+FP_STRICT ISA_CLONES
+void fem1d_zlp_snorm2_b
+(
+    matlib_index    p,
+    matlib_index    N,
+    matlib_index    start,
+    matlib_index    end,
+    matlib_complex* u,
+    matlib_real*    snorm2
+)
 {
-    matlib_real snorm = 0, tmp;
-    matlib_index i;
-    for (i=0; i<N; i++)
+    matlib_index b, i, k, n;
+    matlib_real w[p+1], e[FEM1D_NORM_BLOCK], *ub, re, im;
+
+    for(k=0; k<p+1; k++)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5))
-        	+ _N6 * *(u+6) * conj(*(u+6))
-        	+ _N7 * *(u+7) * conj(*(u+7))
-        	+ _N8 * *(u+8) * conj(*(u+8))
-        	+ _N9 * *(u+9) * conj(*(u+9))
-        	+ _N10 * *(u+10) * conj(*(u+10));
-        u += 11;
-        snorm += tmp;
+        w[k] = 1.0/(k+0.5);
     }
-    return snorm;
-}
- 
 
+    for(b=start; b<end; b++)
+    {
+        n  = N-b*FEM1D_NORM_BLOCK;
+        n  = (n<FEM1D_NORM_BLOCK) ? n : FEM1D_NORM_BLOCK;
+        ub = (matlib_real*)(u + b*FEM1D_NORM_BLOCK*(p+1));
+
+        for(i=0; i<n; i++)
+        {
+            e[i] = 0;
+        }
+        for(k=0; k<p+1; k++)
+        {
+            for(i=0; i<n; i++)
+            {
+                re = ub[2*(i*(p+1)+k)];
+                im = ub[2*(i*(p+1)+k)+1];
+                e[i] += w[k]*(re*re + im*im);
+            }
+        }
+        snorm2[b] = matlib_xsum_pairwise(n, e);
+    }
+}
 
 /*============================================================================+/
  | Dot product of two vectors
@@ -4575,6 +4861,37 @@ void fem1d_MEMI
 
 /*============================================================================*/
 
+void fem1d_GMMSize
+(
+    matlib_index  p,
+    matlib_index  N,
+    matlib_index* dim,
+    matlib_index* nnz
+)
+/* 
+ * dim: N*p+1, nnz: N*p*(p+3)/2+1 (upper-triangular part)
+ *
+ * The longest array that goes with the global mass matrix is the vector of
+ * inner products of length N*nr_combi, it is therefore sufficient to check
+ * that it is addressable. With 32-bit indices this limits N*p^2/2 to about
+ * 2^31.
+ *
+ * */ 
+{
+    matlib_index nr_combi = (p-1)*(p+4)/2+3;
+
+    if((p==0) || (p>MATLIB_INDEX_MAX/(p+4)) || (N>MATLIB_INDEX_MAX/nr_combi))
+    {
+        term_execb( "global mass matrix too large for the index type "
+                    "(degree of polynomial: %llu, nr. of finite-elements: %llu, "
+                    "largest index: %llu)", 
+                    (unsigned long long)p, (unsigned long long)N,
+                    (unsigned long long)MATLIB_INDEX_MAX);
+    }
+    *dim = N*p+1;
+    *nnz = N*(nr_combi-1)+1;
+}
+
 void fem1d_GMMSparsity
 (
     matlib_index            p,
@@ -4594,6 +4911,9 @@ void fem1d_GMMSparsity
 
     /* number of nonzero elements nnz = N*p*(p+3)/2+1;
      * */
+    matlib_index dim, nnz;
+    fem1d_GMMSize(p, N, &dim, &nnz);
+
     matlib_index nr_combi = (p-1)*(p+4)/2+3;
     debug_body("nr. of combinations of basis functions: %d", nr_combi);
 
@@ -4708,6 +5028,36 @@ void fem1d_GMMSparsity
 }/* fem1d_GMMSparsity */
 /*============================================================================*/
 
+void fem1d_GMMBandPerm
+(
+    matlib_index  p,
+    matlib_index  N,
+    matlib_index* perm
+)
+/* 
+ * v_0, b_{1,1},...,b_{1,p-1}, v_1, b_{2,1},..., v_N: the unknowns of an
+ * element occupy p+1 consecutive rows, hence the bandwidth is p.
+ *
+ * */ 
+{
+    debug_enter( "degree of polynomial: %d, "
+                 "Number of finite-elements: %d",
+                 p, N) ;
+
+    matlib_index e, k;
+    for(e=0; e<N; e++)
+    {
+        perm[e*p] = e;
+        for(k=0; k<p-1; k++)
+        {
+            perm[e*p+1+k] = N+1+e*(p-1)+k;
+        }
+    }
+    perm[N*p] = N;
+    debug_exit("%s", "");
+}
+/*============================================================================*/
+
 void fem1d_XCSRGMM
 /* Double CSR - Assemble Global Mass Matrix*/ 
 (
@@ -5325,13 +5675,13 @@ void fem1d_xm_sparse_GMM
                  p, Q.lenc, Q.lenr, phi.len);
 
     matlib_index N = (phi.len-1)/(Q.lenr-1);
-    matlib_index nnz = N*(Q.lenc-1)+1;
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
 
+    matlib_index dim, nnz;
+    fem1d_GMMSize(p, N, &dim, &nnz);
     debug_body( "nr. finite-elements: %d, "
                 "nr. of non-zero elements: %d", N, nnz);
-    assert(Q.lenc==(p-1)*(p+4)/2+3);
 
-    matlib_index dim = N*p+1;
     M->lenc   = dim;
     M->lenr   = dim;
     M->rowIn  = calloc( dim+1, sizeof(matlib_index));
@@ -5365,13 +5715,13 @@ void fem1d_zm_sparse_GMM
                  "length of phi: %d",
                  p, Q.lenc, Q.lenr, phi.len);
     matlib_index N = (phi.len-1)/(Q.lenr-1);
-    matlib_index nnz = N*(Q.lenc-1)+1;
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
 
+    matlib_index dim, nnz;
+    fem1d_GMMSize(p, N, &dim, &nnz);
     debug_body( "nr. finite-elements: %d, "
                 "nr. of non-zero elements: %d", N, nnz);
-    assert(Q.lenc==(p-1)*(p+4)/2+3);
 
-    matlib_index dim = N*p+1;
     M->lenc   = dim;
     M->lenr   = dim;
     M->rowIn  = calloc( dim+1, sizeof(matlib_index));
@@ -5392,42 +5742,1003 @@ void fem1d_zm_sparse_GMM
 }
 /*============================================================================*/
 
-void fem1d_xm_nsparse_GMM
-/* Double - Assemble Global Mass Matrix*/ 
+static void fem1d_GMM_plan_init
 (
-    matlib_index       p,
-    matlib_index       N,
-    matlib_index       nsparse,
-    matlib_xm          Q,
-    matlib_xm*         phi,
-    matlib_xm*         q,
-    matlib_xm_nsparse* M,
-    FEM1D_OP_GMM       op_enum /* option */ 
+    matlib_index      p,
+    matlib_index      N,
+    matlib_xm         Q,
+    fem1d_GMM_plan_t* plan
 )
+/* 
+ * Computes the scatter map by traversing the global mass matrix as
+ * fem1d_ZCSRGMM does: map[k] is the index of the non-zero element that
+ * receives q[k]. Every q[k] goes to exactly one element.
+ *
+ * */ 
 {
-    debug_enter( "poynomial degree: %d, "
-                 "nr. of fem-elements: %d, "
-                 "nr. of sparse matrices: %d, "
-                 "size of Q: %d-by-%d), ",
-                 p, N, nsparse, Q.lenc, Q.lenr);
+    matlib_index nr_combi = Q.lenc;
+    matlib_index s, i, k, l, st, shiftq;
 
+    plan->p   = p;
+    plan->N   = N;
+    plan->xq  = (matlib_xv){ .len = 0, .type = MATLIB_COL_VECT, .elem_p = NULL};
+    plan->zq  = (matlib_zv){ .len = 0, .type = MATLIB_COL_VECT, .elem_p = NULL};
+    plan->map = calloc(nr_combi*N, sizeof(matlib_index));
+    if(plan->map==NULL)
+    {
+        term_exec("%s", "memory allocation failed");
+    }
 
-    if(op_enum == FEM1D_GMM_INIT)
+    /* zero-th row */ 
+    s = 0;
+    plan->map[0] = s++;
+    plan->map[1] = s++;
+    for (k=0; k<p-1; k++)
     {
-        debug_body("%s", "Initializing data structures");
-        assert(Q.lenc==(p-1)*(p+4)/2+3);
-        matlib_create_xm( (Q.lenr-1)*N+1, nsparse, phi, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
-        matlib_create_xm( Q.lenc*N, nsparse, q, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
-        
-        matlib_index dim = N*p+1;
-        matlib_index nnz = N*(Q.lenc-1)+1;
-        debug_body( "nr. of non-zero elements of M: %d", nnz);
-        M->lenc    = dim;
-        M->lenr    = dim;
-        M->nsparse = nsparse;
-        M->rowIn   = calloc( dim+1, sizeof(matlib_index));
-        M->colIn   = calloc(   nnz, sizeof(matlib_index));
-        M->elem_p  = (matlib_real**)calloc( nsparse, sizeof(matlib_real *));
+        plan->map[3+k] = s++;
+    }
+
+    st = 0;
+    for( i=1; i<N; i++)
+    {
+        /* (v_i,v_i)_{K_i} + (v_i,v_i)_{K_{i+1}}, (v_i,v_{i+1})_{K_{i+1}} */ 
+        plan->map[st+2]          = s;
+        plan->map[st+nr_combi]   = s++;
+        plan->map[st+nr_combi+1] = s++;
+        for (k=0; k<p-1; k++)
+        {
+            plan->map[st+3+p-1+k] = s++;
+        }
+        for (k=0; k<p-1; k++)
+        {
+            plan->map[st+nr_combi+3+k] = s++;
+        }
+        st = st+nr_combi;
+    }
+    /* last row: (v_N,v_N)_{K_N} */ 
+    plan->map[st+2] = s++;
+    for (k=0; k<p-1; k++)
+    {
+        plan->map[st+3+p-1+k] = s++;
+    }
+
+    /* bubble-bubble combinations */ 
+    for( st=0; st<N*nr_combi; st +=nr_combi)
+    {
+        shiftq = 3+2*(p-1);
+        for( l=0; l<(p-1)*p/2; l++)
+        {
+            plan->map[st+shiftq] = s++;
+            shiftq++;
+        }
+    }
+    assert(s==N*p*(p+3)/2+1);
+}
+
+void fem1d_xm_sparse_GMM_plan
+/* Real - Plan the assembly of the Global Mass Matrix */ 
+(
+    matlib_index      p,
+    matlib_index      N,
+    matlib_xm         Q,
+    matlib_xm_sparse* M,
+    fem1d_GMM_plan_t* plan
+)
+{
+    debug_enter( "poynomial degree: %d, "
+                 "nr. of fem-elements: %d", p, N);
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
+
+    matlib_index dim, nnz;
+    fem1d_GMMSize(p, N, &dim, &nnz);
+
+    M->lenc   = dim;
+    M->lenr   = dim;
+    M->rowIn  = calloc( dim+1, sizeof(matlib_index));
+    M->colIn  = calloc(   nnz, sizeof(matlib_index));
+    M->elem_p = calloc(   nnz, sizeof(matlib_real));
+    fem1d_GMMSparsity(p, N, M->rowIn, M->colIn);
+
+    fem1d_GMM_plan_init(p, N, Q, plan);
+    matlib_create_xv( Q.lenc*N, &(plan->xq), MATLIB_COL_VECT);
+
+    debug_exit("nr. of non-zero elements: %d", nnz);
+}
+
+void fem1d_xm_sparse_GMM_exec
+/* Real - Assemble the Global Mass Matrix in place */ 
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_xv         phi,
+    matlib_xm_sparse* M
+)
+{
+    debug_enter( "size of Q: %d-by-%d), "
+                 "length of phi: %d",
+                 Q.lenc, Q.lenr, phi.len);
+
+    matlib_index k, nnz = M->rowIn[M->lenc];
+    matlib_xv q = plan->xq;
+    assert((phi.len-1)==plan->N*(Q.lenr-1));
+
+    fem1d_XFLT( plan->N, Q, phi, q);
+
+    /* The diagonal entries of the vertices receive two contributions, they
+     * are added in the order of fem1d_XCSRGMM */ 
+    memset(M->elem_p, 0, nnz*sizeof(matlib_real));
+    for(k=0; k<q.len; k++)
+    {
+        M->elem_p[plan->map[k]] += q.elem_p[k];
+    }
+
+    debug_exit("%s", "");
+}
+
+void fem1d_zm_sparse_GMM_plan
+/* Complex - Plan the assembly of the Global Mass Matrix */ 
+(
+    matlib_index      p,
+    matlib_index      N,
+    matlib_xm         Q,
+    matlib_zm_sparse* M,
+    fem1d_GMM_plan_t* plan
+)
+{
+    debug_enter( "poynomial degree: %d, "
+                 "nr. of fem-elements: %d", p, N);
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
+
+    matlib_index dim, nnz;
+    fem1d_GMMSize(p, N, &dim, &nnz);
+
+    M->lenc   = dim;
+    M->lenr   = dim;
+    M->rowIn  = calloc( dim+1, sizeof(matlib_index));
+    M->colIn  = calloc(   nnz, sizeof(matlib_index));
+    M->elem_p = calloc(   nnz, sizeof(matlib_complex));
+    fem1d_GMMSparsity(p, N, M->rowIn, M->colIn);
+
+    fem1d_GMM_plan_init(p, N, Q, plan);
+    matlib_create_zv( Q.lenc*N, &(plan->zq), MATLIB_COL_VECT);
+
+    debug_exit("nr. of non-zero elements: %d", nnz);
+}
+
+void fem1d_zm_sparse_GMM_exec
+/* Complex - Assemble the Global Mass Matrix in place */ 
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_zv         phi,
+    matlib_zm_sparse* M
+)
+{
+    debug_enter( "size of Q: %d-by-%d), "
+                 "length of phi: %d",
+                 Q.lenc, Q.lenr, phi.len);
+
+    matlib_index k, nnz = M->rowIn[M->lenc];
+    matlib_zv q = plan->zq;
+    assert((phi.len-1)==plan->N*(Q.lenr-1));
+
+    fem1d_ZFLT( plan->N, Q, phi, q);
+
+    /* The diagonal entries of the vertices receive two contributions, they
+     * are added in the order of fem1d_ZCSRGMM */ 
+    memset(M->elem_p, 0, nnz*sizeof(matlib_complex));
+    for(k=0; k<q.len; k++)
+    {
+        M->elem_p[plan->map[k]] += q.elem_p[k];
+    }
+
+    debug_exit("%s", "");
+}
+
+static bool fem1d_GMM_elem_changed
+(
+    matlib_zv    phi,
+    matlib_zv    phi_ref,
+    matlib_index e,
+    matlib_index P,
+    matlib_real  tol
+)
+{
+    for(matlib_index i=e*P; i<=(e+1)*P; i++)
+    {
+        if(cabs(phi.elem_p[i]-phi_ref.elem_p[i])>tol)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+matlib_index fem1d_zm_sparse_GMM_update
+/* Complex - Re-assemble the elements whose potential changed */ 
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_zv         phi,
+    matlib_zv         phi_ref,
+    matlib_real       tol,
+    matlib_complex*   base,
+    matlib_zm_sparse* M,
+    bool*             row_changed
+)
+/* 
+ * M and the workspace of the plan must hold the assembly of phi_ref (by
+ * fem1d_zm_sparse_GMM_exec or by this routine). An element is re-integrated
+ * if any of its samples of phi differs from phi_ref by more than tol, which
+ * includes the samples at its vertices, its samples are then copied to
+ * phi_ref once all the elements have been compared. Only the non-zero
+ * elements that receive a contribution of such an element are rewritten,
+ * the shared diagonal entries of the vertices are summed in the order of
+ * fem1d_zm_sparse_GMM_exec, therefore tol=0 reproduces a full re-assembly.
+ *
+ * base (length nnz, may be NULL): part of M that does not depend on the
+ *      potential (e.g. the stiffness matrix), added to every rewritten entry
+ * row_changed (length M->lenc, may be NULL): rows with a rewritten entry
+ * Returns the number of re-integrated elements.
+ *
+ * */ 
+{
+    debug_enter( "size of Q: %d-by-%d), "
+                 "length of phi: %d, tolerance: %0.4g",
+                 Q.lenc, Q.lenr, phi.len, tol);
+
+    matlib_index p = plan->p;
+    matlib_index N = plan->N;
+    matlib_index P = Q.lenr-1;
+    matlib_index nr_combi = Q.lenc;
+    matlib_index e, i, j, k, jl = 0, jr = 0, nr_changed = 0;
+    assert((phi.len-1)==N*P);
+    assert(phi_ref.len==phi.len);
+
+    if(row_changed!=NULL)
+    {
+        memset(row_changed, 0, M->lenc*sizeof(bool));
+    }
+
+    /* local positions of the contributions to the diagonal entries of the
+     * left and the right vertex, the same for every element */ 
+    for(j=0; j<nr_combi; j++)
+    {
+        if(plan->map[j]==M->rowIn[0])
+        {
+            jl = j;
+        }
+        if(plan->map[j]==M->rowIn[1])
+        {
+            jr = j;
+        }
+    }
+
+    /* Neighbouring elements share the sample at their vertex, hence phi_ref
+     * is left untouched until every element has been compared */ 
+    matlib_complex* q = plan->zq.elem_p;
+    for(e=0; e<N; e++)
+    {
+        if(!fem1d_GMM_elem_changed(phi, phi_ref, e, P, tol))
+        {
+            continue;
+        }
+        nr_changed++;
+
+        matlib_zv phi_e = { .len = P+1,      .elem_p = phi.elem_p+e*P};
+        matlib_zv q_e   = { .len = nr_combi, .elem_p = q+e*nr_combi};
+        fem1d_ZFLT( 1, Q, phi_e, q_e);
+
+        matlib_index s;
+        for(j=0, k=e*nr_combi; j<nr_combi; j++, k++)
+        {
+            if((j!=jl) && (j!=jr))
+            {
+                s = plan->map[k];
+                M->elem_p[s] = (base!=NULL)? base[s] + q[k]: q[k];
+            }
+        }
+        /* diagonal entries of the vertices e and e+1 */ 
+        matlib_complex d;
+        d = 0;
+        if(e>0)
+        {
+            d += q[(e-1)*nr_combi+jr];
+        }
+        d += q[e*nr_combi+jl];
+        s  = M->rowIn[e];
+        M->elem_p[s] = (base!=NULL)? base[s] + d: d;
+
+        d  = 0;
+        d += q[e*nr_combi+jr];
+        if(e<N-1)
+        {
+            d += q[(e+1)*nr_combi+jl];
+        }
+        s  = M->rowIn[e+1];
+        M->elem_p[s] = (base!=NULL)? base[s] + d: d;
+
+        if(row_changed!=NULL)
+        {
+            row_changed[e]   = true;
+            row_changed[e+1] = true;
+            for(i=0; i<p-1; i++)
+            {
+                row_changed[N+1+e*(p-1)+i] = true;
+            }
+        }
+    }
+
+    /* update phi_ref for the same elements, the left vertex of an element is
+     * compared with its sample before the previous element was copied */ 
+    matlib_complex left_ref = phi_ref.elem_p[0], right_ref;
+    for(e=0; e<N; e++)
+    {
+        right_ref = phi_ref.elem_p[(e+1)*P];
+        bool changed = (cabs(phi.elem_p[e*P]-left_ref)>tol);
+        for(i=e*P+1; (i<=(e+1)*P) && !changed; i++)
+        {
+            changed = (cabs(phi.elem_p[i]-phi_ref.elem_p[i])>tol);
+        }
+        if(changed)
+        {
+            for(i=e*P; i<=(e+1)*P; i++)
+            {
+                phi_ref.elem_p[i] = phi.elem_p[i];
+            }
+        }
+        left_ref = right_ref;
+    }
+
+    debug_exit("nr. of re-integrated elements: %d", nr_changed);
+    return nr_changed;
+}
+
+FP_STRICT
+void fem1d_GMM_rowsumQ
+(
+    matlib_xm    Q,
+    matlib_real* q1
+)
+/* 
+ * q1[j]: j-th row of Q applied to the constant 1, i.e. the inner products
+ * of fem1d_XFLT for phi=1, which are the same on every element. The rows
+ * are summed in order wherever this is inlined.
+ *
+ * */ 
+{
+    matlib_index j, l;
+    assert(Q.order==MATLIB_ROW_MAJOR);
+    for(j=0; j<Q.lenc; j++)
+    {
+        q1[j] = 0;
+        for(l=0; l<Q.lenr; l++)
+        {
+            q1[j] += Q.elem_p[j*Q.lenr+l];
+        }
+    }
+}
+
+FP_STRICT
+void fem1d_GMM_combineq
+(
+    matlib_index       nr_combi,
+    const matlib_real* q1,
+    matlib_complex     c[2],
+    const matlib_real* xq,
+    matlib_index       e0,
+    matlib_index       e1,
+    matlib_complex*    zq
+)
+/* 
+ * zq = c[0]*q1 + c[1]*xq on the elements e0,...,e1-1, xq: NULL if c[1] is
+ * zero. The serial and the threaded assembly share this kernel so that the
+ * complex inner products are rounded alike.
+ *
+ * */ 
+{
+    matlib_index e, j, k = e0*nr_combi;
+    for(e=e0; e<e1; e++)
+    {
+        for(j=0; j<nr_combi; j++, k++)
+        {
+            zq[k] = (xq==NULL)? c[0]*q1[j]: c[0]*q1[j] + c[1]*xq[k];
+        }
+    }
+}
+
+void fem1d_xzm_sparse_GMM_exec
+/* Complex - Assemble the Global Mass Matrix of a real potential in place */ 
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_xv         phi,
+    matlib_complex    c[2],
+    matlib_zm_sparse* M
+)
+/* 
+ * Assembles the mass matrix of the complex potential c[0]+c[1]*phi with a
+ * plan of fem1d_zm_sparse_GMM_plan: the inner products of phi are computed
+ * with the real transform, combined with those of the constant in the
+ * complex workspace of the plan by fem1d_GMM_combineq and scattered. The
+ * transform is skipped if c[1] is zero. The first execution allocates the
+ * real workspace of the plan.
+ *
+ * */ 
+{
+    debug_enter( "size of Q: %d-by-%d), "
+                 "length of phi: %d",
+                 Q.lenc, Q.lenr, phi.len);
+
+    matlib_index k, nnz = M->rowIn[M->lenc];
+    matlib_index nr_combi = Q.lenc;
+    assert((phi.len-1)==plan->N*(Q.lenr-1));
+
+    matlib_real q1[nr_combi];
+    fem1d_GMM_rowsumQ(Q, q1);
+
+    matlib_real* xq = NULL;
+    if(c[1]!=0)
+    {
+        if(plan->xq.elem_p==NULL)
+        {
+            matlib_create_xv( nr_combi*plan->N, &(plan->xq), MATLIB_COL_VECT);
+        }
+        fem1d_XFLT( plan->N, Q, phi, plan->xq);
+        xq = plan->xq.elem_p;
+    }
+    fem1d_GMM_combineq( nr_combi, q1, c, xq, 0, plan->N, plan->zq.elem_p);
+
+    memset(M->elem_p, 0, nnz*sizeof(matlib_complex));
+    for(k=0; k<nr_combi*plan->N; k++)
+    {
+        M->elem_p[plan->map[k]] += plan->zq.elem_p[k];
+    }
+
+    debug_exit("%s", "");
+}
+
+void fem1d_GMM_plan_free(fem1d_GMM_plan_t* plan)
+{
+    matlib_free(plan->map);
+    matlib_free(plan->xq.elem_p);
+    matlib_free(plan->zq.elem_p);
+    plan->map       = NULL;
+    plan->xq.elem_p = NULL;
+    plan->zq.elem_p = NULL;
+}
+/*============================================================================+/
+ | Exact assembly for piecewise polynomial potentials
+/+============================================================================*/
+void fem1d_triple_table
+(
+    matlib_index p,
+    matlib_index d,
+    matlib_real  tol,
+    matlib_xm*   T
+)
+/* 
+ * p: highest degree of the basis polynomials
+ * d: highest degree of the Legendre polynomials of the potential
+ *
+ * T (nr_combi-by-(d+1), row major) holds the triple products of the
+ * combinations of basis functions, in the order of the rows of Q (see
+ * fem1d_quadM), with the Legendre polynomials L_0,...,L_d, i.e. the rows
+ * of Q applied to the samples of L_k. The products have degree 2p+d, the
+ * LGL rule used here is exact for them so T carries no quadrature error.
+ *
+ * */ 
+{
+    debug_enter( "polynomial degree: %d, degree of potential: %d", p, d);
+
+    matlib_index i, k, l;
+    matlib_index P = p+d/2+1; /* 2P-1 >= 2p+d */ 
+
+    matlib_xv xi, quadW;
+    legendre_LGLdataLT1( P, tol, &xi, &quadW);
+
+    matlib_xm IM, Q;
+    matlib_create_xm( xi.len, p+1, &IM, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+    legendre_LGLdataIM( xi, IM);
+    fem1d_quadM( quadW, IM, &Q);
+
+    /* samples of L_0,...,L_d, column k holds L_k */ 
+    matlib_real* L = calloc(xi.len*(d+1), sizeof(matlib_real));
+    if(L==NULL)
+    {
+        term_exec("%s", "memory allocation failed");
+    }
+    for(l=0; l<xi.len; l++)
+    {
+        L[l] = 1.0;
+        if(d>0)
+        {
+            L[l+xi.len] = xi.elem_p[l];
+        }
+        for(k=2; k<=d; k++)
+        {
+            /* kL_k(x)=(2k-1)xL_{k-1}(x)-(k-1)L_{k-2}(x) */ 
+            L[l+k*xi.len] = ( (2*k-1)*xi.elem_p[l]*L[l+(k-1)*xi.len]
+                             -(k-1)*L[l+(k-2)*xi.len])/k;
+        }
+    }
+
+    matlib_create_xm( Q.lenc, d+1, T, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+    for(i=0; i<Q.lenc; i++)
+    {
+        for(k=0; k<=d; k++)
+        {
+            matlib_real s = 0;
+            for(l=0; l<Q.lenr; l++)
+            {
+                s += Q.elem_p[i*Q.lenr+l]*L[l+k*xi.len];
+            }
+            T->elem_p[i*(d+1)+k] = s;
+        }
+    }
+
+    matlib_free(L);
+    matlib_free(xi.elem_p);
+    matlib_free(quadW.elem_p);
+    matlib_free(IM.elem_p);
+    matlib_free(Q.elem_p);
+
+    debug_exit("size of T: %d-by-%d", T->lenc, T->lenr);
+}
+
+void fem1d_zpoly2leg
+(
+    matlib_zv    a,
+    matlib_index N,
+    matlib_real  x_l,
+    matlib_real  x_r,
+    matlib_zv    c
+)
+/* 
+ * a: coefficients of the potential a[0]+a[1]*x+...+a[d]*x^d, d = a.len-1
+ * c: Legendre coefficients of the potential on each element of the uniform
+ *    mesh of fem1d_ref2mesh, c.len = N*(d+1), element-wise contiguous.
+ *
+ * With x = x_m+J*xi on an element, the polynomial is evaluated by the Horner
+ * scheme directly in the Legendre basis, multiplication by xi being
+ *      xi*L_k = ((k+1)*L_{k+1}+k*L_{k-1})/(2k+1).
+ *
+ * */ 
+{
+    debug_enter( "degree of potential: %d, nr. of FEM-elements: %d", 
+                 a.len-1, N);
+
+    matlib_index d = a.len-1;
+    matlib_index e, k, n;
+    if(c.len!=N*(d+1))
+    {
+        term_exec( "size mismatch (c: %d, expected: %d)", c.len, N*(d+1));
+    }
+
+    matlib_real dx = (x_r-x_l)/N;
+    matlib_real J  = dx/2.0;
+    for(e=0; e<N; e++)
+    {
+        matlib_real x_m = x_l+J+e*dx;
+        matlib_complex* ce = c.elem_p+e*(d+1);
+        for(k=0; k<=d; k++)
+        {
+            ce[k] = 0;
+        }
+        ce[0] = a.elem_p[d];
+        for(n=d; n>0; n--)
+        {
+            /* ce <- (x_m+J*xi)*ce + a[n-1], the highest non-zero
+             * coefficient of ce is of degree d-n */ 
+            matlib_complex prev = 0, cur;
+            for(k=0; k<=d-n+1; k++)
+            {
+                cur = ce[k];
+                ce[k] = x_m*cur;
+                if(k>0)
+                {
+                    ce[k] += J*prev*k/(2*k-1.0);
+                }
+                if(k<d)
+                {
+                    ce[k] += J*ce[k+1]*(k+1)/(2*k+3.0);
+                }
+                prev = cur;
+            }
+            ce[0] += a.elem_p[n-1];
+        }
+    }
+    debug_exit("%s", "");
+}
+
+void fem1d_zm_sparse_GMM_exec_leg
+/* Complex - Assemble the Global Mass Matrix from Legendre coefficients */ 
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         T,
+    matlib_zv         c,
+    matlib_zm_sparse* M
+)
+/* 
+ * T: triple products of fem1d_triple_table
+ * c: element-wise Legendre coefficients of the potential (fem1d_zpoly2leg)
+ *
+ * The element vectors are T*c_e instead of samples of the potential through
+ * Q, they are scattered like in fem1d_zm_sparse_GMM_exec.
+ *
+ * */ 
+{
+    debug_enter( "size of T: %d-by-%d), "
+                 "length of c: %d",
+                 T.lenc, T.lenr, c.len);
+
+    matlib_index e, j, k, nnz = M->rowIn[M->lenc];
+    matlib_index nr_combi = T.lenc;
+    matlib_index nr_leg   = T.lenr;
+    matlib_zv q = plan->zq;
+    assert(T.order==MATLIB_ROW_MAJOR);
+    assert(c.len==plan->N*nr_leg);
+    assert(q.len==plan->N*nr_combi);
+
+    for(e=0; e<plan->N; e++)
+    {
+        matlib_complex* ce = c.elem_p+e*nr_leg;
+        matlib_complex* qe = q.elem_p+e*nr_combi;
+        for(j=0; j<nr_combi; j++)
+        {
+            qe[j] = 0;
+            for(k=0; k<nr_leg; k++)
+            {
+                qe[j] += T.elem_p[j*nr_leg+k]*ce[k];
+            }
+        }
+    }
+
+    memset(M->elem_p, 0, nnz*sizeof(matlib_complex));
+    for(k=0; k<q.len; k++)
+    {
+        M->elem_p[plan->map[k]] += q.elem_p[k];
+    }
+
+    debug_exit("%s", "");
+}
+
+/*============================================================================+/
+ | Matrix-free Stiffness-Mass operator
+/+============================================================================*/
+void fem1d_XGSMV_range
+/* Real - Global Stiffness-Mass Matrix-Vector product over elements */ 
+(
+    matlib_index p,
+    matlib_index N,
+    matlib_xm    Q,
+    matlib_real* phi,
+    matlib_real  coeff,
+    matlib_real* u,
+    matlib_real* v,
+    matlib_index e0,
+    matlib_index e1
+)
+/* 
+ * Writes the rows of v owned by the elements e0,...,e1-1: the left vertex
+ * and the bubbles of each element and the vertex N if e1==N (see
+ * pfem1d_xm_sparse_GMM). The element to the left of e0 is recomputed for
+ * the vertex e0 so that every row is written by one caller only and the
+ * contributions are always added in the order of the elements.
+ *
+ * */ 
+{
+    if(e0>=e1)
+    {
+        return;
+    }
+    matlib_index nr_combi = Q.lenc;
+    matlib_index P        = Q.lenr-1;
+    matlib_index nr_loc   = p+1;
+    matlib_index e, i, j, k, l, m, shiftq, b0;
+
+    matlib_real q[nr_combi];
+    matlib_real A[nr_loc][nr_loc];
+    matlib_real u_loc[nr_loc];
+    matlib_real v_loc[nr_loc];
+
+    for(e=e0; e<e1; e++)
+    {
+        v[e] = 0;
+        for(k=0; k<p-1; k++)
+        {
+            v[N+1+e*(p-1)+k] = 0;
+        }
+    }
+    if(e1==N)
+    {
+        v[N] = 0;
+    }
+
+    for(e=((e0>0)? e0-1: e0); e<e1; e++)
+    {
+        /* element mass integrals: Q against phi sampled on K_{e+1} */ 
+        for(i=0; i<nr_combi; i++)
+        {
+            q[i] = 0;
+            for(j=0; j<=P; j++)
+            {
+                q[i] += Q.elem_p[i*(P+1)+j] * phi[e*P+j];
+            }
+        }
+
+        /* local matrix: the mass entries in the order of fem1d_XCSRGMM
+         * and the stiffness of pde1d_zm_sparse_GSM
+         * */ 
+        A[0][0] = q[0] + coeff/2.0;
+        A[0][1] = q[1] - coeff/2.0;
+        A[1][1] = q[2] + coeff/2.0;
+        for(k=0; k<p-1; k++)
+        {
+            A[0][2+k] = q[3+k];
+            A[1][2+k] = q[3+p-1+k];
+        }
+        shiftq = 3+2*(p-1);
+        for(l=0; l<p-1; l++)
+        {
+            for(m=l; m<p-1; m++)
+            {
+                A[2+l][2+m] = q[shiftq];
+                shiftq++;
+            }
+            A[2+l][2+l] += coeff;
+        }
+
+        b0 = N+1+e*(p-1);
+        u_loc[0] = u[e];
+        u_loc[1] = u[e+1];
+        for(k=0; k<p-1; k++)
+        {
+            u_loc[2+k] = u[b0+k];
+        }
+        for(i=0; i<nr_loc; i++)
+        {
+            v_loc[i] = 0;
+            for(j=0; j<nr_loc; j++)
+            {
+                v_loc[i] += ((i<=j)? A[i][j]: A[j][i]) * u_loc[j];
+            }
+        }
+
+        if(e>=e0)
+        {
+            v[e] += v_loc[0];
+            for(k=0; k<p-1; k++)
+            {
+                v[b0+k] += v_loc[2+k];
+            }
+        }
+        if((e+1<e1) || (e1==N))
+        {
+            v[e+1] += v_loc[1];
+        }
+    }
+}
+
+void fem1d_XGSMV
+/* Real - Global Stiffness-Mass Matrix-Vector product */ 
+(
+    matlib_index p,
+    matlib_xm    Q,
+    matlib_xv    phi,
+    matlib_real  coeff,
+    matlib_xv    u,
+    matlib_xv    v
+)
+/* 
+ * v = (M + coeff*S)*u without assembling M or S, where M is the global
+ * mass matrix of fem1d_xm_sparse_GMM for phi and coeff*S the stiffness
+ * part of pde1d_zm_sparse_GSM. u and v are in the vertex-bubble basis.
+ *
+ * */ 
+{
+    debug_enter( "poynomial degree: %d, "
+                 "size of Q: %d-by-%d), "
+                 "length of phi: %d",
+                 p, Q.lenc, Q.lenr, phi.len);
+
+    matlib_index N = (phi.len-1)/(Q.lenr-1);
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
+    assert((u.len==N*p+1) && (v.len==N*p+1));
+
+    fem1d_XGSMV_range(p, N, Q, phi.elem_p, coeff, u.elem_p, v.elem_p, 0, N);
+
+    debug_exit("%s", "");
+}
+
+void fem1d_ZGSMV_range
+/* Complex - Global Stiffness-Mass Matrix-Vector product over elements */ 
+(
+    matlib_index p,
+    matlib_index N,
+    matlib_xm    Q,
+    matlib_complex* phi,
+    matlib_complex  coeff,
+    matlib_complex* u,
+    matlib_complex* v,
+    matlib_index e0,
+    matlib_index e1
+)
+/* 
+ * Writes the rows of v owned by the elements e0,...,e1-1: the left vertex
+ * and the bubbles of each element and the vertex N if e1==N (see
+ * pfem1d_xm_sparse_GMM). The element to the left of e0 is recomputed for
+ * the vertex e0 so that every row is written by one caller only and the
+ * contributions are always added in the order of the elements.
+ *
+ * */ 
+{
+    if(e0>=e1)
+    {
+        return;
+    }
+    matlib_index nr_combi = Q.lenc;
+    matlib_index P        = Q.lenr-1;
+    matlib_index nr_loc   = p+1;
+    matlib_index e, i, j, k, l, m, shiftq, b0;
+
+    matlib_complex q[nr_combi];
+    matlib_complex A[nr_loc][nr_loc];
+    matlib_complex u_loc[nr_loc];
+    matlib_complex v_loc[nr_loc];
+
+    for(e=e0; e<e1; e++)
+    {
+        v[e] = 0;
+        for(k=0; k<p-1; k++)
+        {
+            v[N+1+e*(p-1)+k] = 0;
+        }
+    }
+    if(e1==N)
+    {
+        v[N] = 0;
+    }
+
+    for(e=((e0>0)? e0-1: e0); e<e1; e++)
+    {
+        /* element mass integrals: Q against phi sampled on K_{e+1} */ 
+        for(i=0; i<nr_combi; i++)
+        {
+            q[i] = 0;
+            for(j=0; j<=P; j++)
+            {
+                q[i] += Q.elem_p[i*(P+1)+j] * phi[e*P+j];
+            }
+        }
+
+        /* local matrix: the mass entries in the order of fem1d_ZCSRGMM
+         * and the stiffness of pde1d_zm_sparse_GSM
+         * */ 
+        A[0][0] = q[0] + coeff/2.0;
+        A[0][1] = q[1] - coeff/2.0;
+        A[1][1] = q[2] + coeff/2.0;
+        for(k=0; k<p-1; k++)
+        {
+            A[0][2+k] = q[3+k];
+            A[1][2+k] = q[3+p-1+k];
+        }
+        shiftq = 3+2*(p-1);
+        for(l=0; l<p-1; l++)
+        {
+            for(m=l; m<p-1; m++)
+            {
+                A[2+l][2+m] = q[shiftq];
+                shiftq++;
+            }
+            A[2+l][2+l] += coeff;
+        }
+
+        b0 = N+1+e*(p-1);
+        u_loc[0] = u[e];
+        u_loc[1] = u[e+1];
+        for(k=0; k<p-1; k++)
+        {
+            u_loc[2+k] = u[b0+k];
+        }
+        for(i=0; i<nr_loc; i++)
+        {
+            v_loc[i] = 0;
+            for(j=0; j<nr_loc; j++)
+            {
+                v_loc[i] += ((i<=j)? A[i][j]: A[j][i]) * u_loc[j];
+            }
+        }
+
+        if(e>=e0)
+        {
+            v[e] += v_loc[0];
+            for(k=0; k<p-1; k++)
+            {
+                v[b0+k] += v_loc[2+k];
+            }
+        }
+        if((e+1<e1) || (e1==N))
+        {
+            v[e+1] += v_loc[1];
+        }
+    }
+}
+
+void fem1d_ZGSMV
+/* Complex - Global Stiffness-Mass Matrix-Vector product */ 
+(
+    matlib_index p,
+    matlib_xm    Q,
+    matlib_zv    phi,
+    matlib_complex  coeff,
+    matlib_zv    u,
+    matlib_zv    v
+)
+/* 
+ * v = (M + coeff*S)*u without assembling M or S, where M is the global
+ * mass matrix of fem1d_zm_sparse_GMM for phi and coeff*S the stiffness
+ * part of pde1d_zm_sparse_GSM. u and v are in the vertex-bubble basis.
+ *
+ * */ 
+{
+    debug_enter( "poynomial degree: %d, "
+                 "size of Q: %d-by-%d), "
+                 "length of phi: %d",
+                 p, Q.lenc, Q.lenr, phi.len);
+
+    matlib_index N = (phi.len-1)/(Q.lenr-1);
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
+    assert((u.len==N*p+1) && (v.len==N*p+1));
+
+    fem1d_ZGSMV_range(p, N, Q, phi.elem_p, coeff, u.elem_p, v.elem_p, 0, N);
+
+    debug_exit("%s", "");
+}
+/*============================================================================*/
+
+void fem1d_xm_nsparse_GMM
+/* Double - Assemble Global Mass Matrix*/ 
+(
+    matlib_index       p,
+    matlib_index       N,
+    matlib_index       nsparse,
+    matlib_xm          Q,
+    matlib_xm*         phi,
+    matlib_xm*         q,
+    matlib_xm_nsparse* M,
+    FEM1D_OP_GMM       op_enum /* option */ 
+)
+{
+    debug_enter( "poynomial degree: %d, "
+                 "nr. of fem-elements: %d, "
+                 "nr. of sparse matrices: %d, "
+                 "size of Q: %d-by-%d), ",
+                 p, N, nsparse, Q.lenc, Q.lenr);
+
+
+    if(op_enum == FEM1D_GMM_INIT)
+    {
+        debug_body("%s", "Initializing data structures");
+        assert(Q.lenc==(p-1)*(p+4)/2+3);
+        matlib_index dim, nnz;
+        fem1d_GMMSize(p, N, &dim, &nnz);
+        if(nsparse>MATLIB_INDEX_MAX/(Q.lenc*N))
+        {
+            term_execb( "too many sparse matrices for the index type "
+                        "(nr. of sparse matrices: %llu)", 
+                        (unsigned long long)nsparse);
+        }
+        matlib_create_xm( (Q.lenr-1)*N+1, nsparse, phi, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_xm( Q.lenc*N, nsparse, q, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+        
+        debug_body( "nr. of non-zero elements of M: %d", nnz);
+        M->lenc    = dim;
+        M->lenr    = dim;
+        M->nsparse = nsparse;
+        M->rowIn   = calloc( dim+1, sizeof(matlib_index));
+        M->colIn   = calloc(   nnz, sizeof(matlib_index));
+        M->elem_p  = (matlib_real**)calloc( nsparse, sizeof(matlib_real *));
 
         for(matlib_index i = 0; i<nsparse; i++)
         {
@@ -5515,8 +6826,14 @@ void fem1d_zm_nsparse_GMM
     {
         debug_body("%s", "Initializing data structures");
         assert(Q.lenc==(p-1)*(p+4)/2+3);
-        matlib_index dim = N*p+1;
-        matlib_index nnz = N*(Q.lenc-1)+1;
+        matlib_index dim, nnz;
+        fem1d_GMMSize(p, N, &dim, &nnz);
+        if(nsparse>MATLIB_INDEX_MAX/(Q.lenc*N))
+        {
+            term_execb( "too many sparse matrices for the index type "
+                        "(nr. of sparse matrices: %llu)", 
+                        (unsigned long long)nsparse);
+        }
         matlib_create_zm( (Q.lenr-1)*N+1, nsparse, phi, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
         matlib_create_zm( Q.lenc*N,       nsparse,   q, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
         
@@ -0,0 +1,386 @@
+/*============================================================================+/
+ | File: fem1d_table.c
+ | Description: Cache of LGL/transform tables mapped from disk
+ |
+ |
+/+============================================================================*/
+#include <math.h>
+#include <complex.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define NDEBUG
+#define MATLIB_NTRACE_DATA
+
+#include "legendre.h"
+#include "fem1d.h"
+#include "fem1d_table.h"
+#include "assert.h"
+
+/*============================================================================*/
+
+#define FEM1D_TABLE_MAGIC "FEM1DTBL"
+
+/* On-disk header, followed by xi, quadW, FM, IM and Q in this order */
+typedef struct
+{
+    char     magic[8];
+    uint32_t version;
+    uint32_t real_size;
+    uint64_t p;
+    uint64_t P;
+    uint64_t tol_bits;
+    uint64_t nr_combi;
+    uint64_t payload_len; /* in bytes */
+    uint64_t checksum;    /* FNV-1a of the payload */
+
+} fem1d_table_header_t;
+
+#define FEM1D_TABLE_FNV_BASIS 14695981039346656037ULL
+
+static uint64_t fem1d_table_checksum
+(
+    uint64_t    h,
+    const void* buf,
+    size_t      len
+)
+/*
+ * FNV-1a is sequential, hence the checksum of a payload can be accumulated
+ * across several arrays as if they were contiguous.
+ *
+ * */
+{
+    const unsigned char* b = buf;
+    for(size_t i=0; i<len; i++)
+    {
+        h ^= b[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static uint64_t fem1d_table_tol_bits(matlib_real tol)
+{
+    double   t = tol;
+    uint64_t bits;
+    memcpy(&bits, &t, sizeof(bits));
+    return bits;
+}
+
+static matlib_index fem1d_table_nr_combi(matlib_index p)
+{
+    return 3+(p-1)*(p+4)/2;
+}
+
+/*============================================================================*/
+
+static void fem1d_table_compute
+(
+    matlib_index   p,
+    matlib_index   P,
+    matlib_real    tol,
+    fem1d_table_t* table
+)
+/*
+ * Computes all the tables in memory, each array is allocated separately.
+ *
+ * */
+{
+    legendre_LGLdataLT1( P, tol, &(table->xi), &(table->quadW));
+
+    matlib_create_xm( p+1, P+1, &(table->FM), MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+    matlib_create_xm( P+1, p+1, &(table->IM), MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+
+    legendre_LGLdataFM( table->xi, table->FM);
+    legendre_LGLdataIM( table->xi, table->IM);
+
+    fem1d_quadM( table->quadW, table->IM, &(table->Q));
+
+    table->map_p   = NULL;
+    table->map_len = 0;
+}
+
+static bool fem1d_table_path
+(
+    matlib_index p,
+    matlib_index P,
+    matlib_real  tol,
+    const char*  cache_dir,
+    char*        path,
+    size_t       len
+)
+{
+    int n = snprintf( path, len, "%s/fem1d_table_v%d_p%llu_P%llu_%016llx.bin",
+                      cache_dir, FEM1D_TABLE_VERSION,
+                      (unsigned long long)p, (unsigned long long)P,
+                      (unsigned long long)fem1d_table_tol_bits(tol));
+    return (n>=0) && ((size_t)n<len);
+}
+
+/*============================================================================*/
+
+static bool fem1d_table_map
+(
+    const char*    path,
+    matlib_index   p,
+    matlib_index   P,
+    matlib_real    tol,
+    fem1d_table_t* table
+)
+/*
+ * Maps the cache file and validates it against the key, the expected sizes
+ * and the checksum. Returns false (and leaves nothing mapped) if the file is
+ * missing or unusable.
+ *
+ * */
+{
+    int fd = open(path, O_RDONLY);
+    if(fd<0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if((fstat(fd, &st)!=0) || (st.st_size < (off_t)sizeof(fem1d_table_header_t)))
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t map_len = (size_t)st.st_size;
+    void*  map_p   = mmap(NULL, map_len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(map_p==MAP_FAILED)
+    {
+        return false;
+    }
+
+    const fem1d_table_header_t* hdr = map_p;
+    matlib_index nr_LGL   = P+1;
+    matlib_index nr_combi = fem1d_table_nr_combi(p);
+    uint64_t payload_len  = ( 2*nr_LGL + 2*(p+1)*nr_LGL
+                            + nr_combi*nr_LGL)*sizeof(matlib_real);
+
+    const char* payload = (const char*)map_p + sizeof(fem1d_table_header_t);
+    bool valid =    (memcmp(hdr->magic, FEM1D_TABLE_MAGIC, 8)==0)
+                 && (hdr->version     == FEM1D_TABLE_VERSION)
+                 && (hdr->real_size   == sizeof(matlib_real))
+                 && (hdr->p           == p)
+                 && (hdr->P           == P)
+                 && (hdr->tol_bits    == fem1d_table_tol_bits(tol))
+                 && (hdr->nr_combi    == nr_combi)
+                 && (hdr->payload_len == payload_len)
+                 && (map_len          == sizeof(fem1d_table_header_t)+payload_len)
+                 && (hdr->checksum    == fem1d_table_checksum( FEM1D_TABLE_FNV_BASIS,
+                                                               payload, payload_len));
+    if(!valid)
+    {
+        debug_body("Stale or corrupted table: %s", path);
+        munmap(map_p, map_len);
+        return false;
+    }
+
+    /* The arrays point into the read-only mapping */
+    matlib_real* ptr = (matlib_real*)payload;
+
+    table->xi    = (matlib_xv){ .len = nr_LGL, .type = MATLIB_COL_VECT, .elem_p = ptr};
+    ptr += nr_LGL;
+    table->quadW = (matlib_xv){ .len = nr_LGL, .type = MATLIB_COL_VECT, .elem_p = ptr};
+    ptr += nr_LGL;
+    table->FM    = (matlib_xm){ .lenc  = p+1, .lenr = nr_LGL,
+                                .order = MATLIB_ROW_MAJOR, .op = MATLIB_NO_TRANS,
+                                .elem_p = ptr};
+    ptr += (p+1)*nr_LGL;
+    table->IM    = (matlib_xm){ .lenc  = nr_LGL, .lenr = p+1,
+                                .order = MATLIB_COL_MAJOR, .op = MATLIB_NO_TRANS,
+                                .elem_p = ptr};
+    ptr += (p+1)*nr_LGL;
+    table->Q     = (matlib_xm){ .lenc  = nr_combi, .lenr = nr_LGL,
+                                .order = MATLIB_ROW_MAJOR, .op = MATLIB_NO_TRANS,
+                                .elem_p = ptr};
+
+    table->map_p   = map_p;
+    table->map_len = map_len;
+    return true;
+}
+
+/*============================================================================*/
+
+static bool fem1d_table_write
+(
+    const char*          path,
+    const fem1d_table_t* table
+)
+/*
+ * Writes the in-memory tables to a temporary file in the same directory and
+ * renames it to path so that readers never observe a partial file.
+ *
+ * */
+{
+    matlib_index nr_LGL   = table->P+1;
+    matlib_index nr_combi = fem1d_table_nr_combi(table->p);
+
+    const matlib_real* arrays[5] = { table->xi.elem_p,
+                                     table->quadW.elem_p,
+                                     table->FM.elem_p,
+                                     table->IM.elem_p,
+                                     table->Q.elem_p };
+    size_t sizes[5] = { nr_LGL,
+                        nr_LGL,
+                        (table->p+1)*nr_LGL,
+                        (table->p+1)*nr_LGL,
+                        nr_combi*nr_LGL };
+
+    fem1d_table_header_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, FEM1D_TABLE_MAGIC, 8);
+    hdr.version   = FEM1D_TABLE_VERSION;
+    hdr.real_size = sizeof(matlib_real);
+    hdr.p         = table->p;
+    hdr.P         = table->P;
+    hdr.tol_bits  = fem1d_table_tol_bits(table->tol);
+    hdr.nr_combi  = nr_combi;
+
+    hdr.checksum = FEM1D_TABLE_FNV_BASIS;
+    for(int k=0; k<5; k++)
+    {
+        hdr.checksum = fem1d_table_checksum( hdr.checksum, arrays[k],
+                                             sizes[k]*sizeof(matlib_real));
+        hdr.payload_len += sizes[k]*sizeof(matlib_real);
+    }
+
+    char tmp_path[PATH_MAX];
+    int len = snprintf(tmp_path, PATH_MAX, "%s.%ld.tmp", path, (long)getpid());
+    if(len<0 || len>=PATH_MAX)
+    {
+        return false;
+    }
+
+    FILE* fp = fopen(tmp_path, "wb");
+    if(fp==NULL)
+    {
+        return false;
+    }
+    bool ok = (fwrite(&hdr, sizeof(hdr), 1, fp)==1);
+    for(int k=0; ok && k<5; k++)
+    {
+        ok = (fwrite(arrays[k], sizeof(matlib_real), sizes[k], fp)==sizes[k]);
+    }
+    ok = ok && (fflush(fp)==0) && (fsync(fileno(fp))==0);
+    ok = (fclose(fp)==0) && ok;
+    ok = ok && (rename(tmp_path, path)==0);
+    if(!ok)
+    {
+        unlink(tmp_path);
+    }
+    return ok;
+}
+
+/*============================================================================*/
+
+void fem1d_table_load
+(
+    matlib_index   p,
+    matlib_index   P,
+    matlib_real    tol,
+    const char*    cache_dir,
+    fem1d_table_t* table
+)
+/*
+ * p        : highest degree of polynomials (FM has p+1 rows)
+ * P        : nr. of LGL points is P+1
+ * tol      : tolerance for computing LGL points
+ * cache_dir: directory of the cache, NULL: $FEM1D_TABLE_DIR
+ *
+ * On return the arrays in table are either mapped read-only or allocated;
+ * they must be released with fem1d_table_free and must not be modified.
+ *
+ * */
+{
+    debug_enter( "polynomial degree: %d, nr. of LGL points: %d", p, P+1);
+
+    table->p   = p;
+    table->P   = P;
+    table->tol = tol;
+
+    if(cache_dir==NULL)
+    {
+        cache_dir = getenv(FEM1D_TABLE_ENV);
+    }
+    if((cache_dir==NULL) || (*cache_dir=='\0'))
+    {
+        fem1d_table_compute(p, P, tol, table);
+        debug_exit("%s", "computed in memory");
+        return;
+    }
+
+    char path[PATH_MAX];
+    bool path_ok = fem1d_table_path(p, P, tol, cache_dir, path, PATH_MAX);
+    warn_if(!path_ok, "cache path too long: %s", cache_dir);
+    if(!path_ok)
+    {
+        fem1d_table_compute(p, P, tol, table);
+        debug_exit("%s", "computed in memory");
+        return;
+    }
+
+    if(fem1d_table_map(path, p, P, tol, table))
+    {
+        debug_exit("mapped: %s", path);
+        return;
+    }
+
+    /* Regenerate, publish and map the fresh copy so that it is shared */
+    fem1d_table_compute(p, P, tol, table);
+
+    errno = 0;
+    bool dir_ok = (mkdir(cache_dir, 0755)==0) || (errno==EEXIST);
+    warn_if(!dir_ok, "%s: cannot create %s", strerror(errno), cache_dir);
+
+    bool written = dir_ok && fem1d_table_write(path, table);
+    warn_if(dir_ok && !written, "%s: cannot write %s", strerror(errno), path);
+
+    if(written)
+    {
+        fem1d_table_t mapped = *table;
+        if(fem1d_table_map(path, p, P, tol, &mapped))
+        {
+            fem1d_table_free(table);
+            *table = mapped;
+        }
+    }
+    debug_exit("%s", (table->map_p==NULL)? "computed in memory": path);
+}
+
+void fem1d_table_free(fem1d_table_t* table)
+{
+    if(table->map_p!=NULL)
+    {
+        munmap(table->map_p, table->map_len);
+    }
+    else
+    {
+        matlib_free(table->xi.elem_p);
+        matlib_free(table->quadW.elem_p);
+        matlib_free(table->FM.elem_p);
+        matlib_free(table->IM.elem_p);
+        matlib_free(table->Q.elem_p);
+    }
+    table->xi.elem_p    = NULL;
+    table->quadW.elem_p = NULL;
+    table->FM.elem_p    = NULL;
+    table->IM.elem_p    = NULL;
+    table->Q.elem_p     = NULL;
+    table->map_p        = NULL;
+    table->map_len      = 0;
+}
@@ -204,6 +204,29 @@ matlib_real matlib_znrm2(matlib_zv x)
     return cblas_dznrm2(x.len, x.elem_p, incx);
 
 }
+
+FP_STRICT
+matlib_real matlib_xsum_pairwise(matlib_index n, const matlib_real* x)
+/* 
+ * Blocks of at most 8 terms are summed in order, longer sequences are split 
+ * in halves. The result does not depend on how the caller partitions work 
+ * and the rounding error grows as O(log n) instead of O(n).
+ *
+ * */ 
+{
+    if(n<=8)
+    {
+        matlib_real s = 0;
+        matlib_index i;
+        for(i=0; i<n; i++)
+        {
+            s += x[i];
+        }
+        return s;
+    }
+    matlib_index m = n/2;
+    return matlib_xsum_pairwise(m, x) + matlib_xsum_pairwise(n-m, x+m);
+}
 /*============================================================================*/
 
 void matlib_xaxpy
@@ -464,6 +487,128 @@ void matlib_zgemv
 }
 
 
+static inline void matlib_xcsrsymv_transp
+(
+    const matlib_real* a,
+    matlib_index       c0,
+    matlib_index       c1,
+    matlib_real        ui,
+    matlib_real*       v,
+    matlib_real*       w,
+    matlib_index       r0,
+    matlib_index       r1
+)
+/* 
+ * y[j] += a[j-c0]*ui for the columns j in [c0, c1), y is v inside the rows
+ * [r0, r1) and w outside of them.
+ *
+ * */ 
+{
+    matlib_index j, j0, j1;
+
+    j1 = (c1<r0)? c1: r0;
+    for(j=c0; j<j1; j++)
+    {
+        w[j] += a[j-c0]*ui;
+    }
+    j0 = (c0>r0)? c0: r0;
+    j1 = (c1<r1)? c1: r1;
+    for(j=j0; j<j1; j++)
+    {
+        v[j] += a[j-c0]*ui;
+    }
+    j0 = (c0>r1)? c0: r1;
+    for(j=j0; j<c1; j++)
+    {
+        w[j] += a[j-c0]*ui;
+    }
+}
+
+ISA_CLONES
+void matlib_xcsrsymv_range
+/* Double CSR Symmetric Matrix-Vector over a range of rows */ 
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_xm_sparse A, 
+          matlib_index     nrhs,
+    const matlib_real*     u,
+          matlib_real*     v,
+          matlib_real*     w,
+          matlib_index     r0,
+          matlib_index     r1
+)
+/* 
+ * A: the triangle uplo_enum, including the diagonal, of a symmetric matrix;
+ *    the column indices of a row are sorted and entries of the other
+ *    triangle, if stored, are skipped
+ * u, v, w: nrhs column major vectors of length A.lenc each
+ *
+ * Overwrites the rows [r0, r1) of v with the contributions of the rows
+ * [r0, r1) of A to v = A*u: the products of the rows and the transposed
+ * products of their off-diagonal entries. The transposed products which fall
+ * into rows outside of [r0, r1) are added to w instead, w may be NULL if
+ * there are none (r0=0, r1=A.lenc). The entries of a row are processed in
+ * runs of consecutive columns so that the inner loops are contiguous.
+ *
+ * */ 
+{
+    matlib_index dim = A.lenc;
+    matlib_index i, k, l, s, s0, s1, send, len, c0;
+    assert((w!=NULL) || ((r0==0) && (r1==dim)));
+
+    for(k=0; k<nrhs; k++)
+    {
+        memset(v+k*dim+r0, 0, (r1-r0)*sizeof(matlib_real));
+    }
+    for(i=r0; i<r1; i++)
+    {
+        /* the entries [s0, send) of the row belong to the triangle */ 
+        s0   = A.rowIn[i];
+        send = A.rowIn[i+1];
+        if(uplo_enum==MATLIB_UPPER)
+        {
+            for(; (s0<send) && (A.colIn[s0]<i); s0++);
+        }
+        else
+        {
+            for(; (send>s0) && (A.colIn[send-1]>i); send--);
+        }
+        for(s=s0; s<send; s=s1)
+        {
+            /* run of the columns [c0, c0+len) */ 
+            c0 = A.colIn[s];
+            for(s1=s+1; (s1<send) && (A.colIn[s1]==c0+(s1-s)); s1++);
+            len = s1-s;
+
+            const matlib_real* a = A.elem_p+s;
+            for(k=0; k<nrhs; k++)
+            {
+                const matlib_real* uk = u+k*dim;
+                matlib_real*       vk = v+k*dim;
+                matlib_real*       wk = (w!=NULL)? w+k*dim: NULL;
+                matlib_real sum = 0;
+                for(l=0; l<len; l++)
+                {
+                    sum += a[l]*uk[c0+l];
+                }
+                vk[i] += sum;
+
+                /* transposed products, without the diagonal entry */ 
+                if((i>=c0) && (i<c0+len))
+                {
+                    matlib_xcsrsymv_transp( a, c0, i, uk[i], vk, wk, r0, r1);
+                    matlib_xcsrsymv_transp( a+(i+1-c0), i+1, c0+len, uk[i], 
+                                            vk, wk, r0, r1);
+                }
+                else
+                {
+                    matlib_xcsrsymv_transp( a, c0, c0+len, uk[i], vk, wk, r0, r1);
+                }
+            }
+        }
+    }
+}
+
 void matlib_xcsrsymv
 /* Double CSR Symmetric Matrix-Vector */ 
 (
@@ -473,8 +618,9 @@ void matlib_xcsrsymv
           matlib_xv        v
 )
 /* 
- * A: sparse matrix
- * v <-- alpha A * u + beta * v
+ * A: upper or lower triangle of a symmetric matrix, entries of the other
+ *    triangle are ignored (see matlib_xcsrsymv_range)
+ * v <-- A * u
  *
  * */
 
@@ -484,18 +630,9 @@ void matlib_xcsrsymv
     assert(((A.elem_p != NULL) && (u.elem_p != NULL)) && (v.elem_p != NULL));
     
     /* check if the dimensions of the matrices are correct */ 
+    assert((u.len == A.lenc) && (v.len == A.lenc));
     
-    char uplo_char[1];
-    
-    if (uplo_enum == MATLIB_UPPER)
-    {
-        uplo_char[0] = 'U';
-    }
-    else if (uplo_enum == MATLIB_LOWER)
-    {
-        uplo_char[0] = 'L';
-    }
-    else
+    if ((uplo_enum != MATLIB_UPPER) && (uplo_enum != MATLIB_LOWER))
     {
         term_execb("unknown upper/lower part (uplo_enum: %d)", uplo_enum);
     }
@@ -503,18 +640,171 @@ void matlib_xcsrsymv
                 A.lenc, A.lenr,
                 A.rowIn[A.lenc] );
 
-    mkl_cspblas_dcsrsymv( uplo_char, 
-                          &A.lenc, 
-                          A.elem_p, 
-                          A.rowIn,
-                          A.colIn,
-                          u.elem_p, 
-                          v.elem_p);
+    matlib_xcsrsymv_range(uplo_enum, A, 1, u.elem_p, v.elem_p, NULL, 0, A.lenc);
 
     debug_exit("%s", "");
 }
+
+void matlib_xcsrsymm
+/* Double CSR Symmetric Matrix-Matrix */ 
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_xm_sparse A, 
+    const matlib_xm        U,
+          matlib_xm        V
+)
+/* 
+ * V <-- A * U for the columns of the column major matrices U and V
+ *
+ * */
+
+{
+    debug_enter("%s", "");
+    /* check if the input has NULL poindexers */
+    assert(((A.elem_p != NULL) && (U.elem_p != NULL)) && (V.elem_p != NULL));
+    
+    /* check if the dimensions of the matrices are correct */ 
+    assert((U.order == MATLIB_COL_MAJOR) && (V.order == MATLIB_COL_MAJOR));
+    assert((U.lenc == A.lenc) && (V.lenc == A.lenc) && (U.lenr == V.lenr));
+    
+    if ((uplo_enum != MATLIB_UPPER) && (uplo_enum != MATLIB_LOWER))
+    {
+        term_execb("unknown upper/lower part (uplo_enum: %d)", uplo_enum);
+    }
+    debug_body( "size of A: %d-by-%d, nnz: %d, nr. of vectors: %d", 
+                A.lenc, A.lenr,
+                A.rowIn[A.lenc], U.lenr );
+
+    matlib_xcsrsymv_range( uplo_enum, A, U.lenr, U.elem_p, V.elem_p, 
+                            NULL, 0, A.lenc);
+
+    debug_exit("%s", "");
+}
+
+static inline void matlib_zcsrsymv_transp
+(
+    const matlib_complex* a,
+    matlib_index          c0,
+    matlib_index          c1,
+    matlib_complex        ui,
+    matlib_complex*       v,
+    matlib_complex*       w,
+    matlib_index          r0,
+    matlib_index          r1
+)
+/* 
+ * y[j] += a[j-c0]*ui for the columns j in [c0, c1), y is v inside the rows
+ * [r0, r1) and w outside of them.
+ *
+ * */ 
+{
+    matlib_index j, j0, j1;
+
+    j1 = (c1<r0)? c1: r0;
+    for(j=c0; j<j1; j++)
+    {
+        w[j] += a[j-c0]*ui;
+    }
+    j0 = (c0>r0)? c0: r0;
+    j1 = (c1<r1)? c1: r1;
+    for(j=j0; j<j1; j++)
+    {
+        v[j] += a[j-c0]*ui;
+    }
+    j0 = (c0>r1)? c0: r1;
+    for(j=j0; j<c1; j++)
+    {
+        w[j] += a[j-c0]*ui;
+    }
+}
+
+ISA_CLONES
+void matlib_zcsrsymv_range
+/* Complex CSR Symmetric Matrix-Vector over a range of rows */ 
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_zm_sparse A, 
+          matlib_index     nrhs,
+    const matlib_complex*  u,
+          matlib_complex*  v,
+          matlib_complex*  w,
+          matlib_index     r0,
+          matlib_index     r1
+)
+/* 
+ * A: the triangle uplo_enum, including the diagonal, of a symmetric matrix;
+ *    the column indices of a row are sorted and entries of the other
+ *    triangle, if stored, are skipped
+ * u, v, w: nrhs column major vectors of length A.lenc each
+ *
+ * Overwrites the rows [r0, r1) of v with the contributions of the rows
+ * [r0, r1) of A to v = A*u: the products of the rows and the transposed
+ * products of their off-diagonal entries. The transposed products which fall
+ * into rows outside of [r0, r1) are added to w instead, w may be NULL if
+ * there are none (r0=0, r1=A.lenc). The entries of a row are processed in
+ * runs of consecutive columns so that the inner loops are contiguous.
+ *
+ * */ 
+{
+    matlib_index dim = A.lenc;
+    matlib_index i, k, l, s, s0, s1, send, len, c0;
+    assert((w!=NULL) || ((r0==0) && (r1==dim)));
+
+    for(k=0; k<nrhs; k++)
+    {
+        memset(v+k*dim+r0, 0, (r1-r0)*sizeof(matlib_complex));
+    }
+    for(i=r0; i<r1; i++)
+    {
+        /* the entries [s0, send) of the row belong to the triangle */ 
+        s0   = A.rowIn[i];
+        send = A.rowIn[i+1];
+        if(uplo_enum==MATLIB_UPPER)
+        {
+            for(; (s0<send) && (A.colIn[s0]<i); s0++);
+        }
+        else
+        {
+            for(; (send>s0) && (A.colIn[send-1]>i); send--);
+        }
+        for(s=s0; s<send; s=s1)
+        {
+            /* run of the columns [c0, c0+len) */ 
+            c0 = A.colIn[s];
+            for(s1=s+1; (s1<send) && (A.colIn[s1]==c0+(s1-s)); s1++);
+            len = s1-s;
+
+            const matlib_complex* a = A.elem_p+s;
+            for(k=0; k<nrhs; k++)
+            {
+                const matlib_complex* uk = u+k*dim;
+                matlib_complex*       vk = v+k*dim;
+                matlib_complex*       wk = (w!=NULL)? w+k*dim: NULL;
+                matlib_complex sum = 0;
+                for(l=0; l<len; l++)
+                {
+                    sum += a[l]*uk[c0+l];
+                }
+                vk[i] += sum;
+
+                /* transposed products, without the diagonal entry */ 
+                if((i>=c0) && (i<c0+len))
+                {
+                    matlib_zcsrsymv_transp( a, c0, i, uk[i], vk, wk, r0, r1);
+                    matlib_zcsrsymv_transp( a+(i+1-c0), i+1, c0+len, uk[i], 
+                                            vk, wk, r0, r1);
+                }
+                else
+                {
+                    matlib_zcsrsymv_transp( a, c0, c0+len, uk[i], vk, wk, r0, r1);
+                }
+            }
+        }
+    }
+}
+
 void matlib_zcsrsymv
-/* Double CSR Symmetric Matrix-Vector */ 
+/* Complex CSR Symmetric Matrix-Vector */ 
 (
     const MATLIB_UPLO      uplo_enum,
           matlib_zm_sparse A, 
@@ -522,8 +812,9 @@ void matlib_zcsrsymv
           matlib_zv        v
 )
 /* 
- * Z GE M V
- * v <-- alpha A * u + beta * v
+ * A: upper or lower triangle of a symmetric matrix, entries of the other
+ *    triangle are ignored (see matlib_zcsrsymv_range)
+ * v <-- A * u
  *
  * */
 
@@ -533,36 +824,287 @@ void matlib_zcsrsymv
     assert(((A.elem_p != NULL) && (u.elem_p != NULL)) && (v.elem_p != NULL));
     
     /* check if the dimensions of the matrices are correct */ 
+    assert((u.len == A.lenc) && (v.len == A.lenc));
+    
+    if ((uplo_enum != MATLIB_UPPER) && (uplo_enum != MATLIB_LOWER))
+    {
+        term_execb("unknown upper/lower part (uplo_enum: %d)", uplo_enum);
+    }
+    debug_body( "size of A: %d-by-%d, nnz: %d", 
+                A.lenc, A.lenr,
+                A.rowIn[A.lenc] );
+
+    matlib_zcsrsymv_range(uplo_enum, A, 1, u.elem_p, v.elem_p, NULL, 0, A.lenc);
+
+    debug_exit("%s", "");
+}
+
+void matlib_zcsrsymm
+/* Complex CSR Symmetric Matrix-Matrix */ 
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_zm_sparse A, 
+    const matlib_zm        U,
+          matlib_zm        V
+)
+/* 
+ * V <-- A * U for the columns of the column major matrices U and V
+ *
+ * */
+
+{
+    debug_enter("%s", "");
+    /* check if the input has NULL poindexers */
+    assert(((A.elem_p != NULL) && (U.elem_p != NULL)) && (V.elem_p != NULL));
     
-    char uplo_char[1];
+    /* check if the dimensions of the matrices are correct */ 
+    assert((U.order == MATLIB_COL_MAJOR) && (V.order == MATLIB_COL_MAJOR));
+    assert((U.lenc == A.lenc) && (V.lenc == A.lenc) && (U.lenr == V.lenr));
     
-    if (uplo_enum == MATLIB_UPPER)
+    if ((uplo_enum != MATLIB_UPPER) && (uplo_enum != MATLIB_LOWER))
+    {
+        term_execb("unknown upper/lower part (uplo_enum: %d)", uplo_enum);
+    }
+    debug_body( "size of A: %d-by-%d, nnz: %d, nr. of vectors: %d", 
+                A.lenc, A.lenr,
+                A.rowIn[A.lenc], U.lenr );
+
+    matlib_zcsrsymv_range( uplo_enum, A, U.lenr, U.elem_p, V.elem_p, 
+                            NULL, 0, A.lenc);
+
+    debug_exit("%s", "");
+}
+
+
+/*============================================================================+/
+ | Banded (DIA) complex symmetric matrices
+/+============================================================================*/
+void matlib_create_zm_dia
+(
+    matlib_index   lenc,
+    matlib_index   kd,
+    matlib_zm_dia* B
+)
+{
+    assert((lenc>0) && (kd<lenc));
+    B->lenc   = lenc;
+    B->lenr   = lenc;
+    B->kd     = kd;
+    B->format = MATLIB_DIA;
+
+    errno = 0;
+    B->elem_p = calloc( (kd+1)*lenc, sizeof(matlib_complex));
+    if (B->elem_p == NULL)
     {
-        uplo_char[0] = 'U';
+        term_exec( "%s: initialization error: band of order %d with %d diagonals", 
+                   strerror(errno), lenc, kd+1);
     }
-    else if (uplo_enum == MATLIB_LOWER)
+}
+
+void matlib_zcsr2dia
+(
+    const matlib_zm_sparse A, 
+    const matlib_index*    perm,
+          matlib_index     kd,
+          matlib_zm_dia*   B
+)
+/* 
+ * A : upper part of a symmetric matrix in CSR3 format
+ *
+ * The band is created here; an entry of A outside of kd diagonals after
+ * renumbering is an error.
+ *
+ * */ 
+{
+    debug_enter( "size of A: %d-by-%d, nnz: %d, nr. of super-diagonals: %d", 
+                 A.lenc, A.lenr, A.rowIn[A.lenc], kd);
+
+    matlib_index n = A.lenc;
+    matlib_index i, j, s, a, b;
+
+    matlib_create_zm_dia(n, kd, B);
+
+    /* position of each row of A in the band */ 
+    errno = 0;
+    matlib_index* iperm = calloc(n, sizeof(matlib_index));
+    if (iperm == NULL)
     {
-        uplo_char[0] = 'L';
+        term_exec( "%s: initialization error: permutation of length %d", 
+                   strerror(errno), n);
     }
-    else
+    for(i=0; i<n; i++)
     {
-        term_execb("unknown upper/lower part (uplo_enum: %d)", uplo_enum);
+        iperm[(perm==NULL)? i: perm[i]] = i;
     }
-    debug_body( "size of A: %d-by-%d, nnz: %d", 
-                A.lenc, A.lenr,
-                A.rowIn[A.lenc] );
 
-    mkl_cspblas_zcsrsymv( uplo_char, 
-                          &A.lenc, 
-                          A.elem_p, 
-                          A.rowIn,
-                          A.colIn,
-                          u.elem_p, 
-                          v.elem_p);
+    for(i=0; i<n; i++)
+    {
+        for(s=A.rowIn[i]; s<A.rowIn[i+1]; s++)
+        {
+            j = A.colIn[s];
+            a = (iperm[i]<iperm[j])? iperm[i]: iperm[j];
+            b = (iperm[i]<iperm[j])? iperm[j]: iperm[i];
+            if(b-a>kd)
+            {
+                matlib_free(iperm);
+                term_execb( "entry (%d,%d) lies outside of the band (kd: %d)", 
+                            i, j, kd);
+            }
+            B->elem_p[(b-a)*n+a] = A.elem_p[s];
+        }
+    }
+    matlib_free(iperm);
+    debug_exit("%s", "");
+}
 
+void matlib_zdiasymv
+(
+    const matlib_zm_dia B, 
+    const matlib_zv     u,
+          matlib_zv     v
+)
+/* 
+ * Diagonal by diagonal, the inner loops have unit stride and no index
+ * arrays.
+ *
+ * */ 
+{
+    debug_enter( "order of B: %d, nr. of super-diagonals: %d", B.lenc, B.kd);
+    assert((u.len==B.lenc) && (v.len==B.lenc));
+
+    matlib_index n = B.lenc;
+    matlib_index i, d;
+    const matlib_complex* b = B.elem_p;
+
+    for(i=0; i<n; i++)
+    {
+        v.elem_p[i] = b[i] * u.elem_p[i];
+    }
+    for(d=1; d<=B.kd; d++)
+    {
+        b = B.elem_p+d*n;
+        for(i=0; i<n-d; i++)
+        {
+            v.elem_p[i]   += b[i] * u.elem_p[i+d];
+        }
+        for(i=0; i<n-d; i++)
+        {
+            v.elem_p[i+d] += b[i] * u.elem_p[i];
+        }
+    }
     debug_exit("%s", "");
 }
 
+void matlib_zdiaLDLT(matlib_zm_dia B)
+/* 
+ * B = U^T*D*U for complex symmetric B (transpose, not conjugate transpose)
+ * D is stored on the diagonal and U(i,i+d) in place of B(i,i+d). There is
+ * no pivoting, which is sufficient for the mass and stiffness matrices
+ * of the Schroedinger solvers.
+ *
+ * */ 
+{
+    debug_enter( "order of B: %d, nr. of super-diagonals: %d", B.lenc, B.kd);
+
+    matlib_index n  = B.lenc;
+    matlib_index kd = B.kd;
+    matlib_index i, j, k, k0;
+    matlib_complex* b = B.elem_p;
+    matlib_complex  s;
+
+    /* U(k,i) = b[(i-k)*n+k], D(k) = b[k] */ 
+    for(i=0; i<n; i++)
+    {
+        k0 = (i>kd)? i-kd: 0;
+        s  = b[i];
+        for(k=k0; k<i; k++)
+        {
+            s -= b[(i-k)*n+k] * b[(i-k)*n+k] * b[k];
+        }
+        if(s==0)
+        {
+            term_execb("zero pivot in row %d", i);
+        }
+        b[i] = s;
+
+        for(j=i+1; (j<n) && (j<=i+kd); j++)
+        {
+            k0 = (j>kd)? j-kd: 0;
+            s  = b[(j-i)*n+i];
+            for(k=k0; k<i; k++)
+            {
+                s -= b[(i-k)*n+k] * b[k] * b[(j-k)*n+k];
+            }
+            b[(j-i)*n+i] = s/b[i];
+        }
+    }
+    debug_exit("%s", "");
+}
+
+void matlib_zdiaLDLT_solve
+(
+    const matlib_zm_dia B, 
+          matlib_zv     b
+)
+{
+    debug_enter( "order of B: %d, nr. of super-diagonals: %d", B.lenc, B.kd);
+    assert(b.len==B.lenc);
+
+    matlib_index n  = B.lenc;
+    matlib_index kd = B.kd;
+    matlib_index i, k, d;
+    const matlib_complex* u = B.elem_p;
+    matlib_complex* x = b.elem_p;
+
+    /* U^T*y = b */ 
+    for(i=0; i<n; i++)
+    {
+        for(k=(i>kd)? i-kd: 0; k<i; k++)
+        {
+            x[i] -= u[(i-k)*n+k] * x[k];
+        }
+    }
+    /* D*z = y */ 
+    for(i=0; i<n; i++)
+    {
+        x[i] /= u[i];
+    }
+    /* U*x = z */ 
+    for(i=n; i-->0;)
+    {
+        for(d=1; (d<=kd) && (i+d<n); d++)
+        {
+            x[i] -= u[d*n+i] * x[i+d];
+        }
+    }
+    debug_exit("%s", "");
+}
+
+void matlib_zpermute
+(
+    const matlib_index* perm,
+          bool          inverse,
+    const matlib_zv     x,
+          matlib_zv     y
+)
+{
+    assert(x.len==y.len);
+    matlib_index i;
+    if(inverse)
+    {
+        for(i=0; i<x.len; i++)
+        {
+            y.elem_p[perm[i]] = x.elem_p[i];
+        }
+    }
+    else
+    {
+        for(i=0; i<x.len; i++)
+        {
+            y.elem_p[i] = x.elem_p[perm[i]];
+        }
+    }
+}
 
 /*============================================================================+/
  |BLAS Level III Routines
@@ -134,13 +134,19 @@ void pde1d_LSE_set_defaultsIVP(pde1d_LSE_data_t* input)
     input->dt = dt_DEFAULT;
     input->Nt = Nt_DEFAULT;
     input->nsparse = nsparse_DEFAULT;
+    input->nsparse_mode = PDE1D_LSE_NSPARSE_FULL;
+    input->phi_tol      = 0;
 
     input->tol = TOL_DEFAULT;
+    input->table_dir = NULL;
 
     input->alpha = 1.0;
 
     input->sol_mode = PDE1D_LSE_EVOLVE_ONLY;
 
+    input->num_threads = 0;
+    input->mp          = NULL;
+
     input->u_analytic = NULL;
     input->params  = NULL;
     input->phix_p  = NULL;
@@ -161,6 +167,8 @@ void pde1d_LSE_set_potential
     switch (input->phi_type)
     {
         case PDE1D_LSE_STATIC :
+        case PDE1D_LSE_STATIC_REAL :
+        case PDE1D_LSE_STATIC_POLY :
             if(phi_p != NULL)
             {
                 input->phix_p  = phi_p;
@@ -215,6 +223,116 @@ void pde1d_analytic_evol
 
 /*============================================================================*/
 
+static void pde1d_LSE_assemble_GMM
+(
+    pde1d_LSE_data_t*   input,
+    pde1d_LSE_solver_t* data,
+    matlib_zv           phi,
+    matlib_index        num_threads,
+    pthpool_data_t*     mp
+)
+/* 
+ * The first call plans M, every call overwrites the non-zero elements of M
+ * in place so that a re-solve does no allocation. mp==NULL: serial.
+ *
+ * */ 
+{
+    if(data->GMM_plan.map==NULL)
+    {
+        fem1d_zm_sparse_GMM_plan( input->p, input->N, data->Q, 
+                                  &(data->M), &(data->GMM_plan));
+    }
+    if(mp!=NULL)
+    {
+        pfem1d_zm_sparse_GMM_exec( &(data->GMM_plan), data->Q, phi, &(data->M), 
+                                   num_threads, mp);
+    }
+    else
+    {
+        fem1d_zm_sparse_GMM_exec(&(data->GMM_plan), data->Q, phi, &(data->M));
+    }
+}
+
+static void pde1d_LSE_assemble_static
+(
+    pde1d_LSE_data_t*   input,
+    pde1d_LSE_solver_t* data,
+    matlib_zv           phi,
+    matlib_index        num_threads,
+    pthpool_data_t*     mp
+)
+/* 
+ * Evaluates the static potential and assembles the Global Stiffness-Mass
+ * Matrix M. A real potential (PDE1D_LSE_STATIC_REAL) is evaluated into the
+ * storage of phi, which holds twice as many reals as needed, and its complex
+ * scale factors are folded into the mass matrix while it is scattered. A
+ * polynomial potential (PDE1D_LSE_STATIC_POLY) is converted to Legendre
+ * coefficients on each element and assembled from the triple products,
+ * serially as it costs no transform.
+ *
+ * */ 
+{
+    void (*phi_p)() = input->phix_p;
+    if(input->phi_type==PDE1D_LSE_STATIC_POLY)
+    {
+        matlib_complex a_p[PDE1D_LSE_POLY_DEG+1] = {0};
+        matlib_zv a = { .len    = PDE1D_LSE_POLY_DEG+1, 
+                        .type   = MATLIB_COL_VECT,
+                        .elem_p = a_p};
+        (*phi_p)(input->params, data->m_coeff, a);
+        debug_body("%s", "polynomial potential computed");
+
+        if(data->GMM_plan.map==NULL)
+        {
+            fem1d_zm_sparse_GMM_plan( input->p, input->N, data->Q, 
+                                      &(data->M), &(data->GMM_plan));
+            fem1d_triple_table( input->p, PDE1D_LSE_POLY_DEG, input->tol, 
+                                &(data->T));
+            matlib_create_zv( input->N*(PDE1D_LSE_POLY_DEG+1), 
+                              &(data->phi_leg), MATLIB_COL_VECT);
+        }
+        fem1d_zpoly2leg( a, input->N, input->domain[0], input->domain[1], 
+                         data->phi_leg);
+        fem1d_zm_sparse_GMM_exec_leg( &(data->GMM_plan), data->T, 
+                                      data->phi_leg, &(data->M));
+    }
+    else if(input->phi_type==PDE1D_LSE_STATIC_REAL)
+    {
+        matlib_xv V = { .len    = input->x.len, 
+                        .type   = MATLIB_COL_VECT,
+                        .elem_p = (matlib_real*)phi.elem_p};
+        matlib_complex c[2];
+        (*phi_p)(input->params, data->m_coeff, input->x, V, c);
+        debug_body("%s", "real potential computed");
+
+        if(data->GMM_plan.map==NULL)
+        {
+            fem1d_zm_sparse_GMM_plan( input->p, input->N, data->Q, 
+                                      &(data->M), &(data->GMM_plan));
+        }
+        if(mp!=NULL)
+        {
+            pfem1d_xzm_sparse_GMM_exec( &(data->GMM_plan), data->Q, V, c, 
+                                        &(data->M), num_threads, mp);
+        }
+        else
+        {
+            fem1d_xzm_sparse_GMM_exec( &(data->GMM_plan), data->Q, V, c, 
+                                       &(data->M));
+        }
+    }
+    else
+    {
+        (*phi_p)(input->params, data->m_coeff, input->x, phi);
+        debug_body("%s", "potential computed");
+
+        pde1d_LSE_assemble_GMM(input, data, phi, num_threads, mp);
+    }
+    pde1d_zm_sparse_GSM(input->N, data->s_coeff, data->M);
+}
+
+/*============================================================================*/
+
 void pde1d_LSE_init_solverIVP
 (
     pde1d_LSE_data_t*   input, 
@@ -266,31 +384,26 @@ void pde1d_LSE_init_solverIVP
      * vector: xi
      * Quadrature weights on LGL-points
      * vector: quadW 
-     * */ 
-    legendre_LGLdataLT1( (input->nr_LGL)-1, 
-                          input->tol, 
-                          &(data->xi), 
-                          &(data->quadW));
-    
-    /* Forward Transform matrix : FM
+     * Forward Transform matrix : FM
      * Backward Transform matrix: IM
+     * Quadrature matrix needed for assembling Global Mass Matrix: Q
+     *
+     * These depend only on (p, nr_LGL, tol) and are mapped read-only from
+     * the table cache when one is configured.
      * */ 
-    matlib_create_xm( (input->p)+1, 
-                      (data->xi).len, 
-                      &(data->FM), 
-                      MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+    fem1d_table_load( input->p, 
+                      (input->nr_LGL)-1, 
+                      input->tol, 
+                      input->table_dir, 
+                      &(data->table));
 
-    matlib_create_xm( (data->xi).len, 
-                      (input->p)+1, 
-                      &(data->IM), 
-                      MATLIB_COL_MAJOR, MATLIB_NO_TRANS);    
+    data->xi    = data->table.xi;
+    data->quadW = data->table.quadW;
+    data->FM    = data->table.FM;
+    data->IM    = data->table.IM;
+    data->Q     = data->table.Q;
 
-    legendre_LGLdataFM( data->xi, data->FM);
-    legendre_LGLdataIM( data->xi, data->IM);
-
-    /* Quadrature matrix needed for assembling Global Mass Matrix 
-     * */ 
-    fem1d_quadM( data->quadW, data->IM, &(data->Q));
+    data->GMM_plan.map = NULL;
 
     /* generate the grid: x */ 
     fem1d_ref2mesh( data->xi, 
@@ -313,7 +426,8 @@ void pde1d_LSE_init_solverIVP
     /* Initialize all temporary variables using this array of pointers 
      * */ 
     matlib_index i;
-    data->nr_vars = 5;
+    bool overlap  = (input->sol_mode==PDE1D_LSE_ERROR_ONLY) && (input->mp!=NULL);
+    data->nr_vars = overlap? 6: 5;
     matlib_zv** var_p_ = (matlib_zv**)calloc(data->nr_vars, sizeof(matlib_zv*));
     for(i=0; i<data->nr_vars; i++)
     {
@@ -355,6 +469,14 @@ void pde1d_LSE_init_solverIVP
                       var_p_[4], 
                       MATLIB_COL_VECT);
 
+    /* Analytic solution in Legendre basis while the step is computed
+     * var_p[5] : W
+     * */ 
+    if(overlap)
+    {
+        matlib_create_zv( dim, var_p_[5], MATLIB_COL_VECT);
+    }
+
     if(input->sol_mode==PDE1D_LSE_ERROR_ONLY)
     {
         matlib_create_xv( (input->Nt)+1,
@@ -406,6 +528,8 @@ void pde1d_LSE_solve_IVP
     switch(input->phi_type)
     {
         case PDE1D_LSE_STATIC:
+        case PDE1D_LSE_STATIC_REAL:
+        case PDE1D_LSE_STATIC_POLY:
             (*LSE_solver_IVP_p[0])(input, data);
             break;
 
@@ -416,6 +540,264 @@ void pde1d_LSE_solve_IVP
 
 }
 
+/*============================================================================*/
+/* Task graph of a time step
+ * */ 
+typedef struct
+{
+    pde1d_LSE_data_t*   input;
+    pde1d_LSE_solver_t* data;
+    pardiso_solver_t*   eq_data;
+    matlib_index        step;
+    matlib_zv           U_tmp;
+    matlib_zv           V_tmp;
+    matlib_zv           phi;
+    matlib_real*        snorm2[2]; /* per norm block: exact solution, error */ 
+
+} pde1d_LSE_graph_t;
+
+static void* pde1d_LSE_thfunc_solve(void* mp)
+{
+    pthpool_arg_t*     ptr = (pthpool_arg_t*) mp;
+    pde1d_LSE_graph_t* g   = (pde1d_LSE_graph_t*) (ptr->shared_data[0]);
+
+    debug_body("begin iteration: %d", g->step);
+    g->eq_data->phase_enum = PARDISO_SOLVE_AND_REFINE;
+    matlib_pardiso(g->eq_data);
+    return NULL;
+}
+
+static void* pde1d_LSE_thfunc_save(void* mp)
+{
+    pthpool_arg_t*     ptr = (pthpool_arg_t*) mp;
+    pde1d_LSE_graph_t* g   = (pde1d_LSE_graph_t*) (ptr->shared_data[0]);
+
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index  i, q = g->input->p+1;
+
+    matlib_complex* U = g->input->U_evol.elem_p + (g->step+1)*g->input->U_evol.lenc;
+    for(i=start_end_index[0]*q; i<start_end_index[1]*q; i++)
+    {
+        U[i] = g->U_tmp.elem_p[i];
+    }
+    return NULL;
+}
+
+static void* pde1d_LSE_thfunc_exact(void* mp)
+/* 
+ * The shared vertex of two blocks is evaluated by the block on its right.
+ *
+ * */ 
+{
+    pthpool_arg_t*     ptr = (pthpool_arg_t*) mp;
+    pde1d_LSE_graph_t* g   = (pde1d_LSE_graph_t*) (ptr->shared_data[0]);
+
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index  s = start_end_index[0], e = start_end_index[1];
+    matlib_index  P = g->input->nr_LGL-1;
+
+    matlib_index len = (e-s)*P + (e==g->input->N);
+    matlib_xv x   = { .len = len, .type = MATLIB_COL_VECT, 
+                      .elem_p = g->input->x.elem_p + s*P};
+    matlib_zv phi = { .len = len, .type = MATLIB_COL_VECT, 
+                      .elem_p = g->phi.elem_p + s*P};
+
+    void (*u_analytic)() = g->input->u_analytic;
+    (*u_analytic)(g->input->params, x, g->input->t.elem_p[g->step+1], phi);
+    return NULL;
+}
+
+static void* pde1d_LSE_thfunc_error(void* mp)
+/* 
+ * Blocks start at multiples of FEM1D_NORM_BLOCK, see PDE1D_LSE_BLOCK.
+ *
+ * */ 
+{
+    pthpool_arg_t*     ptr = (pthpool_arg_t*) mp;
+    pde1d_LSE_graph_t* g   = (pde1d_LSE_graph_t*) (ptr->shared_data[0]);
+
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index  s = start_end_index[0], e = start_end_index[1];
+    matlib_index  i, p = g->input->p, N = g->input->N;
+    matlib_index  P = g->input->nr_LGL-1;
+
+    matlib_zv phi = { .len = (e-s)*P+1, .type = MATLIB_COL_VECT, 
+                      .elem_p = g->phi.elem_p + s*P};
+    matlib_zv V   = { .len = (e-s)*(p+1), .type = MATLIB_COL_VECT, 
+                      .elem_p = g->V_tmp.elem_p + s*(p+1)};
+    matlib_complex* U = g->U_tmp.elem_p + s*(p+1);
+
+    fem1d_ZFLT(e-s, g->data->FM, phi, V);
+
+    matlib_index b0 = s/FEM1D_NORM_BLOCK;
+    matlib_index b1 = (e+FEM1D_NORM_BLOCK-1)/FEM1D_NORM_BLOCK;
+    fem1d_zlp_snorm2_b(p, N, b0, b1, g->V_tmp.elem_p, g->snorm2[0]);
+
+    for(i=0; i<V.len; i++)
+    {
+        V.elem_p[i] -= U[i];
+    }
+    fem1d_zlp_snorm2_b(p, N, b0, b1, g->V_tmp.elem_p, g->snorm2[1]);
+    return NULL;
+}
+
+static void* pde1d_LSE_thfunc_reduce(void* mp)
+{
+    pthpool_arg_t*     ptr = (pthpool_arg_t*) mp;
+    pde1d_LSE_graph_t* g   = (pde1d_LSE_graph_t*) (ptr->shared_data[0]);
+
+    matlib_index nblk = (g->input->N+FEM1D_NORM_BLOCK-1)/FEM1D_NORM_BLOCK;
+    matlib_index i    = g->step+1;
+
+    matlib_real norm_actual = sqrt(matlib_xsum_pairwise(nblk, g->snorm2[0]));
+
+    (g->input->e_abs).elem_p[i] = sqrt(matlib_xsum_pairwise(nblk, g->snorm2[1]));
+    (g->input->e_rel).elem_p[i] = (g->input->e_abs).elem_p[i]/fmax(norm_actual, g->input->tol);
+    
+    debug_body("Absolute Error: %0.16f", (g->input->e_abs).elem_p[i]);
+    debug_body("Relative Error: %0.16f", (g->input->e_rel).elem_p[i]);
+    return NULL;
+}
+
+void pde1d_LSE_solve_IVP_graph
+(
+    pde1d_LSE_data_t*   input,
+    pde1d_LSE_solver_t* data,
+    matlib_index        num_threads,
+    pthpool_data_t*     mp
+)
+{
+    debug_enter( "polynomial degree: %d, "
+                 "nr. of LGL points: %d, threads: %d", 
+                 input->p, input->nr_LGL, num_threads );
+
+    if(input->phi_type==PDE1D_LSE_DYNAMIC)
+    {
+        pde1d_LSE_solve_IVP(input, data);
+        debug_exit("%s", "dynamic potential solved sequentially");
+        return;
+    }
+
+    matlib_index i;
+    matlib_index N = input->N;
+    bool error = (input->sol_mode==PDE1D_LSE_ERROR_ONLY);
+
+    /* Other temporary variables 
+     * */ 
+    matlib_zv Pvb   = *(matlib_zv*)(data->var_p[0]);
+    matlib_zv V_vb  = *(matlib_zv*)(data->var_p[1]);
+    matlib_zv V_tmp = *(matlib_zv*)(data->var_p[2]);
+    matlib_zv U_tmp = *(matlib_zv*)(data->var_p[3]);
+    matlib_zv phi   = *(matlib_zv*)(data->var_p[4]);
+
+    if(error)
+    {
+        void (*u_analytic)() = input->u_analytic;
+        (*u_analytic)(input->params, input->x, (input->t).elem_p[0], input->u_init);
+        (input->e_abs).elem_p[0] = 0;
+        (input->e_rel).elem_p[0] = 0;
+    }
+
+    pde1d_LSE_assemble_static(input, data, phi, num_threads, mp);
+
+    fem1d_ZFLT(input->N, data->FM, input->u_init, U_tmp);
+    if(!error)
+    {
+        for(i=0; i<U_tmp.len; i++)
+        {
+            input->U_evol.elem_p[i] = U_tmp.elem_p[i];
+        }
+    }
+
+    pardiso_solver_t eq_data = { .nsparse  = 1, 
+                                 .mnum     = 1, 
+                                 .sol_enum = PARDISO_LHS, 
+                                 .mtype    = PARDISO_COMPLEX_SYM,
+                                 .smat_p   = (void*) &(data->M),
+                                 .rhs_p    = (void*) &Pvb,
+                                 .sol_p    = (void*) &V_vb};
+
+    eq_data.phase_enum = PARDISO_INIT;
+    matlib_pardiso(&eq_data);
+
+    eq_data.phase_enum = PARDISO_ANALYSIS_AND_FACTOR;
+    matlib_pardiso(&eq_data);
+
+    /* Build the graph of a time step
+     * */ 
+    matlib_index nblk = (N+FEM1D_NORM_BLOCK-1)/FEM1D_NORM_BLOCK;
+    matlib_real  snorm2[2*nblk];
+
+    pde1d_LSE_graph_t g = { .input   = input,
+                            .data    = data,
+                            .eq_data = &eq_data,
+                            .step    = 0,
+                            .U_tmp   = U_tmp,
+                            .V_tmp   = V_tmp,
+                            .phi     = phi,
+                            .snorm2  = { snorm2, snorm2+nblk}};
+    void* shared_data[1] = { (void*) &g};
+
+    pfem1d_phase_args_t args[3];
+    pthpool_phase_t     phase[3];
+    pfem1d_ZPrjL2F_phase(input->p, U_tmp, Pvb, &args[0], &phase[0]);
+    pfem1d_ZF2L_phase(input->p, V_vb, V_tmp, &args[1], &phase[1]);
+
+    /* 2.0 * V_tmp -U_tmp --> U_tmp
+     * */ 
+    pfem1d_zaxpby_phase(input->p, 2.0, V_tmp, -1.0, U_tmp, &args[2], &phase[2]);
+
+    pthpool_graph_t graph;
+    pthpool_graph_init(&graph);
+
+    matlib_index prj = pthpool_graph_add( &graph, 0, N, PDE1D_LSE_BLOCK, 
+                                          phase[0].shared_data, phase[0].thfunc, 
+                                          0, NULL, 0);
+    matlib_index sol = pthpool_graph_add( &graph, 0, N, 0, shared_data, 
+                                          pde1d_LSE_thfunc_solve, 1, &prj, 0);
+    matlib_index f2l = pthpool_graph_add( &graph, 0, N, PDE1D_LSE_BLOCK, 
+                                          phase[1].shared_data, phase[1].thfunc, 
+                                          1, &sol, 0);
+    matlib_index upd = pthpool_graph_add( &graph, 0, N, PDE1D_LSE_BLOCK, 
+                                          phase[2].shared_data, phase[2].thfunc, 
+                                          1, &f2l, 0);
+    if(error)
+    {
+        /* the analytic solution only waits for the previous step */ 
+        matlib_index up[2];
+        up[0] = upd;
+        up[1] = pthpool_graph_add( &graph, 0, N, PDE1D_LSE_BLOCK, shared_data, 
+                                   pde1d_LSE_thfunc_exact, 0, NULL, 0);
+        matlib_index err = pthpool_graph_add( &graph, 0, N, PDE1D_LSE_BLOCK, 
+                                              shared_data, pde1d_LSE_thfunc_error, 
+                                              2, up, 1);
+        pthpool_graph_add( &graph, 0, N, 0, shared_data, 
+                           pde1d_LSE_thfunc_reduce, 1, &err, 0);
+    }
+    else
+    {
+        pthpool_graph_add( &graph, 0, N, PDE1D_LSE_BLOCK, shared_data, 
+                           pde1d_LSE_thfunc_save, 1, &upd, 0);
+    }
+
+    for (i=0; i<input->Nt; i++)
+    {
+        g.step = i;
+        pthpool_graph_exec(&graph, num_threads, mp);
+    }
+
+    pthpool_graph_destroy(&graph);
+    for(i=0; i<3; i++)
+    {
+        pfem1d_phase_free(&args[i]);
+    }
+
+    eq_data.phase_enum = PARDISO_FREE;
+    matlib_pardiso(&eq_data);
+
+    debug_exit("%s", "");
+}
+
 void pde1d_LSE_destroy_solverIVP
 (
     pde1d_LSE_data_t*   input,
@@ -433,29 +815,28 @@ void pde1d_LSE_destroy_solverIVP
     matlib_free(input->u_init.elem_p);
     debug_body("Freed: %s", "u_init");
     
-    matlib_free(data->xi.elem_p);
-    debug_body("Freed: %s", "xi");
-
-    matlib_free(data->quadW.elem_p);
-    debug_body("Freed: %s", "quadW");
-
-    matlib_free(data->FM.elem_p);
-    debug_body("Freed: %s", "FM");
-
-    matlib_free(data->IM.elem_p);
-    debug_body("Freed: %s", "IM");
-
-    matlib_free(data->Q.elem_p);
-    debug_body("Freed: %s", "Q");
+    fem1d_table_free(&(data->table));
+    debug_body("Freed: %s", "xi, quadW, FM, IM, Q");
 
     switch(input->phi_type)
     {
         case PDE1D_LSE_STATIC:
+        case PDE1D_LSE_STATIC_REAL:
             matlib_free(data->M.elem_p);
             matlib_free(data->M.colIn);
             matlib_free(data->M.rowIn);
+            fem1d_GMM_plan_free(&(data->GMM_plan));
             debug_body("Freed: %s", "M");
             break;
+        case PDE1D_LSE_STATIC_POLY:
+            matlib_free(data->M.elem_p);
+            matlib_free(data->M.colIn);
+            matlib_free(data->M.rowIn);
+            fem1d_GMM_plan_free(&(data->GMM_plan));
+            matlib_free(data->T.elem_p);
+            matlib_free(data->phi_leg.elem_p);
+            debug_body("Freed: %s", "M, T");
+            break;
         case PDE1D_LSE_DYNAMIC:
             break;
     }
@@ -506,18 +887,11 @@ void pde1d_LSE_solve_IVP_evol
     matlib_zv phi   = *(matlib_zv*)(data->var_p[4]);
 
     debug_body("%s", "declared temporary vars");
-    /* Filling the potential vector
-     * */ 
-    void (*phi_p)() = input->phix_p;
-    (*phi_p)(input->params, data->m_coeff, input->x, phi);
-    debug_body("%s", "potential computed");
 
-    /* Initialize the sparse matrix in order to store the 
-     * Global Stiffness-Mass Matrix: M
+    /* Filling the potential vector and initialize the sparse matrix in 
+     * order to store the Global Stiffness-Mass Matrix: M
      * */ 
-    //matlib_zm_sparse M;
-    fem1d_zm_sparse_GMM(input->p, data->Q, phi, &(data->M));
-    pde1d_zm_sparse_GSM(input->N, data->s_coeff, data->M);
+    pde1d_LSE_assemble_static(input, data, phi, input->num_threads, input->mp);
 
     BEGIN_DTRACE
         debug_print( "dimension of the sparse square matrix: %d",
@@ -603,11 +977,6 @@ void pde1d_LSE_solve_IVP_error
     matlib_zv phi   = *(matlib_zv*)(data->var_p[4]);
 
     debug_body("%s", "declared temporary vars");
-    /* Filling the potential vector
-     * */ 
-    void (*phi_p)() = input->phix_p;
-    (*phi_p)(input->params, data->m_coeff, input->x, phi);
-    debug_body("%s", "potential computed");
 
     /* Analytic solution
      * */ 
@@ -618,11 +987,10 @@ void pde1d_LSE_solve_IVP_error
     debug_body("%s", "provided initial data");
     
 
-    /* Initialize the sparse matrix in order to store the 
-     * Global Stiffness-Mass Matrix: M
+    /* Filling the potential vector and initialize the sparse matrix in 
+     * order to store the Global Stiffness-Mass Matrix: M
      * */ 
-    fem1d_zm_sparse_GMM(input->p, data->Q, phi, &data->M);
-    pde1d_zm_sparse_GSM(input->N, data->s_coeff, data->M);
+    pde1d_LSE_assemble_static(input, data, phi, input->num_threads, input->mp);
 
     BEGIN_DTRACE
         debug_print("dimension of the sparse square matrix: %d", data->M.lenc);
@@ -661,9 +1029,25 @@ void pde1d_LSE_solve_IVP_error
     (input->e_abs).elem_p[0] = 0;
     (input->e_rel).elem_p[0] = 0;
 
+    /* With a pool the analytic solution is transformed into W while the
+     * step is computed, else V_tmp is reused after the step.
+     * */ 
+    bool overlap = (data->nr_vars>5);
+    matlib_zv W  = overlap? *(matlib_zv*)(data->var_p[5]): V_tmp;
+    pfem1d_future_t future;
+
     for (i=0; i<input->Nt; i++)
     {
         debug_body("begin iteration: %d", i);
+        /* Using phi to store the analytic solution
+         * */ 
+        if(overlap)
+        {
+            (*u_analytic)(input->params, input->x, input->t.elem_p[i+1], phi);
+            pfem1d_ZFLT_async( input->N, data->FM, phi, W, 
+                               input->num_threads, input->mp, &future);
+        }
+
         fem1d_ZPrjL2F(input->p, U_tmp, Pvb);
 
         eq_data.phase_enum = PARDISO_SOLVE_AND_REFINE;
@@ -675,17 +1059,22 @@ void pde1d_LSE_solve_IVP_error
          * */ 
         matlib_zaxpby(2.0, V_tmp, -1.0, U_tmp );
 
-        /* Using phi to store the analytic solution
-         * */ 
-        (*u_analytic)(input->params, input->x, input->t.elem_p[i+1], phi);
-        fem1d_ZFLT(input->N, data->FM, phi, V_tmp);
+        if(overlap)
+        {
+            pfem1d_wait(&future);
+        }
+        else
+        {
+            (*u_analytic)(input->params, input->x, input->t.elem_p[i+1], phi);
+            fem1d_ZFLT(input->N, data->FM, phi, W);
+        }
 
         /* Error analysis: 
          * */ 
-        norm_actual = fem1d_ZNorm2(input->p, input->N, V_tmp);
-        matlib_zaxpy(-1.0, U_tmp, V_tmp );
+        norm_actual = fem1d_ZNorm2(input->p, input->N, W);
+        matlib_zaxpy(-1.0, U_tmp, W );
 
-        (input->e_abs).elem_p[i+1] = fem1d_ZNorm2(input->p, input->N, V_tmp);
+        (input->e_abs).elem_p[i+1] = fem1d_ZNorm2(input->p, input->N, W);
         (input->e_rel).elem_p[i+1] = (input->e_abs).elem_p[i+1]/fmax(norm_actual, input->tol);
         
         debug_body("Absolute Error: %0.16f", (input->e_abs).elem_p[i+1]);
@@ -700,6 +1089,171 @@ void pde1d_LSE_solve_IVP_error
     debug_exit("%s", "");
 }
 
+/*============================================================================*/
+/* Batches of time levels of a dynamic potential, see PDE1D_LSE_NSPARSE
+ * */ 
+static void pde1d_LSE_nGMM_init
+(
+    pde1d_LSE_data_t*   input,
+    pde1d_LSE_solver_t* data,
+    matlib_zm*          phi,
+    matlib_zm*          q,
+    pardiso_solver_t*   eq_data
+)
+{
+    matlib_index nsparse = input->nsparse;
+    if(input->nsparse_mode==PDE1D_LSE_NSPARSE_COMPRESSED)
+    {
+        matlib_create_zm( input->x.len, nsparse, phi, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+        *q = (matlib_zm){ .lenc = 0, .lenr = 0, .elem_p = NULL};
+
+        fem1d_zm_sparse_GMM_plan( input->p, input->N, data->Q, 
+                                  &(data->M), &(data->GMM_plan));
+        data->phi_ref.elem_p = NULL;
+        data->S_base         = NULL;
+        eq_data->nsparse = 1;
+        eq_data->smat_p  = (void*)&(data->M);
+    }
+    else
+    {
+        fem1d_zm_nsparse_GMM( input->p, input->N, nsparse, 
+                              data->Q, phi, q, &data->nM, FEM1D_GMM_INIT);
+
+        fem1d_zm_nsparse_GMM( input->p, input->N, nsparse, data->Q, 
+                              NULL, NULL, &data->nM, FEM1D_GET_SPARSITY_ONLY);
+        eq_data->nsparse = nsparse;
+        eq_data->smat_p  = (void*)&(data->nM);
+    }
+    debug_body("phi: %d-by-%d", phi->lenc, phi->lenr);
+}
+
+static void pde1d_LSE_nGMM_batch
+(
+    pde1d_LSE_data_t*   input,
+    pde1d_LSE_solver_t* data,
+    matlib_zm*          phi,
+    matlib_zm*          q
+)
+/* 
+ * Assembles all the matrices of a batch once the potential is known,
+ * nothing to be done in the compressed mode.
+ *
+ * */ 
+{
+    if(input->nsparse_mode==PDE1D_LSE_NSPARSE_COMPRESSED)
+    {
+        return;
+    }
+    if(input->mp!=NULL)
+    {
+        pfem1d_zm_nsparse_GMM( input->p, input->N, data->Q, phi, q, 
+                               &data->nM, input->num_threads, input->mp);
+    }
+    else
+    {
+        fem1d_zm_nsparse_GMM( input->p, input->N, input->nsparse, data->Q, 
+                              phi, q, &data->nM, FEM1D_GET_NZE_ONLY);
+    }
+    pde1d_zm_nsparse_GSM(input->N, data->s_coeff, data->nM);
+}
+
+static bool pde1d_LSE_nGMM_level
+(
+    pde1d_LSE_data_t*   input,
+    pde1d_LSE_solver_t* data,
+    matlib_zm*          phi,
+    matlib_index        j,
+    pardiso_solver_t*   eq_data
+)
+/* 
+ * Selects the matrix of the j-th level of a batch for the factorization,
+ * in the compressed mode it is re-assembled from the j-th column of phi:
+ * completely the first time, afterwards only the elements which changed.
+ * Returns false if the matrix is unchanged and need not be factored again.
+ *
+ * */ 
+{
+    if(input->nsparse_mode==PDE1D_LSE_NSPARSE_COMPRESSED)
+    {
+        matlib_zv phi_j = { .len    = phi->lenc, 
+                            .type   = MATLIB_COL_VECT,
+                            .elem_p = phi->elem_p+j*phi->lenc};
+        if(data->phi_ref.elem_p==NULL)
+        {
+            if(input->mp!=NULL)
+            {
+                pfem1d_zm_sparse_GMM_exec( &(data->GMM_plan), data->Q, phi_j, 
+                                           &(data->M), input->num_threads, input->mp);
+            }
+            else
+            {
+                fem1d_zm_sparse_GMM_exec(&(data->GMM_plan), data->Q, phi_j, &(data->M));
+            }
+            pde1d_zm_sparse_GSM(input->N, data->s_coeff, data->M);
+
+            matlib_create_zv( phi_j.len, &(data->phi_ref), MATLIB_COL_VECT);
+            matlib_zcopy(phi_j, data->phi_ref);
+
+            /* the stiffness part is added to the entries rewritten later */ 
+            matlib_index nnz = data->M.rowIn[data->M.lenc];
+            errno = 0;
+            data->S_base = calloc(nnz, sizeof(matlib_complex));
+            if(data->S_base==NULL)
+            {
+                term_exec( "%s: initialization error: sparse matrix with %d entries", 
+                           strerror(errno), nnz);
+            }
+            matlib_zm_sparse S = data->M;
+            S.elem_p = data->S_base;
+            pde1d_zm_sparse_GSM(input->N, data->s_coeff, S);
+        }
+        else
+        {
+            matlib_index nr_changed 
+                = fem1d_zm_sparse_GMM_update( &(data->GMM_plan), data->Q, phi_j, 
+                                              data->phi_ref, input->phi_tol, 
+                                              data->S_base, &(data->M), NULL);
+            debug_body("nr. of re-integrated elements: %d", nr_changed);
+            if(nr_changed==0)
+            {
+                return false;
+            }
+        }
+    }
+    else
+    {
+        eq_data->mnum = j+1;
+    }
+    return true;
+}
+
+static void pde1d_LSE_nGMM_free
+(
+    pde1d_LSE_data_t*   input,
+    pde1d_LSE_solver_t* data,
+    matlib_zm*          phi,
+    matlib_zm*          q
+)
+{
+    if(input->nsparse_mode==PDE1D_LSE_NSPARSE_COMPRESSED)
+    {
+        matlib_free(phi->elem_p);
+        matlib_free(data->phi_ref.elem_p);
+        matlib_free(data->S_base);
+        data->phi_ref.elem_p = NULL;
+        data->S_base         = NULL;
+        matlib_free(data->M.elem_p);
+        matlib_free(data->M.colIn);
+        matlib_free(data->M.rowIn);
+        fem1d_GMM_plan_free(&(data->GMM_plan));
+    }
+    else
+    {
+        fem1d_zm_nsparse_GMM( input->p, input->N, input->nsparse, 
+                              data->Q, phi, q, &data->nM, FEM1D_GMM_FREE);
+    }
+}
+
 /*============================================================================*/
 
 void pde1d_LSE_solve_IVP2_evol
@@ -729,17 +1283,8 @@ void pde1d_LSE_solve_IVP2_evol
     void (*phi_p)() = input->phixt_p;
     debug_body("%s", "potential function declared");
 
-    /* Assemble the global mass matrix 
-     * */ 
     matlib_zm phi, q;
     matlib_index nsparse = input->nsparse;
-    fem1d_zm_nsparse_GMM( input->p, input->N, nsparse, 
-                          data->Q, &phi, &q, &data->nM, FEM1D_GMM_INIT);
-
-    fem1d_zm_nsparse_GMM( input->p, input->N, nsparse, data->Q, 
-                          NULL, NULL, &data->nM, FEM1D_GET_SPARSITY_ONLY);
-    
-    debug_body("phi: %d-by-%d", phi.lenc, phi.lenr);
     /* Setup the sparse linear system */
     /* Solve the equation while marching in time 
      *
@@ -753,34 +1298,17 @@ void pde1d_LSE_solve_IVP2_evol
     matlib_zcopy(U_tmp, U_tmp1 );
     (U_tmp1.elem_p) += (U_tmp1.len); 
 
-    pardiso_solver_t eq_data = { .nsparse  = nsparse, 
-                                 .mnum     = 1, 
+    pardiso_solver_t eq_data = { .mnum     = 1, 
                                  .sol_enum = PARDISO_LHS, 
                                  .mtype    = PARDISO_COMPLEX_SYM,
-                                 .smat_p   = (void*)&(data->nM),
                                  .rhs_p    = (void*)&Pvb,
                                  .sol_p    = (void*)&V_vb};
 
+    /* Assemble the global mass matrix 
+     * */ 
+    pde1d_LSE_nGMM_init(input, data, &phi, &q, &eq_data);
     debug_body("%s", "Solver data initialized");
 
-    BEGIN_DTRACE
-        matlib_complex *ptr;
-        for(matlib_index k = 0; k< nsparse; k++)
-        {
-            debug_print( "dimension of the sparse square matrix: %d", 
-                         data->nM.lenc);
-            ptr = data->nM.elem_p[k];
-            for(i=0; i<data->nM.lenc; i++)
-            {
-                for(j=data->nM.rowIn[i]; j<data->nM.rowIn[i+1]; j++)
-                {
-                    debug_print( "M(%d,%d): % 0.16f %+0.16fi",
-                                 i, data->nM.colIn[j], ptr[j]);
-                }
-            }
-        }
-    END_DTRACE
-
     eq_data.phase_enum = PARDISO_INIT;
     matlib_pardiso(&eq_data);
     debug_body("%s", "PARDISO initialized");
@@ -791,18 +1319,18 @@ void pde1d_LSE_solve_IVP2_evol
     for (i=0; i<Nt_; i++)
     {
         (*phi_p)(input->params, data->m_coeff, input->x, t_tmp, phi);
-        fem1d_zm_nsparse_GMM( input->p, input->N, nsparse, data->Q, 
-                              &phi, &q, &data->nM, FEM1D_GET_NZE_ONLY);
-        pde1d_zm_nsparse_GSM(input->N, data->s_coeff, data->nM);
+        pde1d_LSE_nGMM_batch(input, data, &phi, &q);
 
         for(j=0; j<nsparse; j++)
         {
             debug_body("begin iteration: %d", i*nsparse+j);
             fem1d_ZPrjL2F(input->p, U_tmp, Pvb);
 
-            eq_data.mnum = j+1;
-            eq_data.phase_enum = PARDISO_ANALYSIS_AND_FACTOR;
-            matlib_pardiso(&eq_data);
+            if(pde1d_LSE_nGMM_level(input, data, &phi, j, &eq_data))
+            {
+                eq_data.phase_enum = PARDISO_ANALYSIS_AND_FACTOR;
+                matlib_pardiso(&eq_data);
+            }
 
             eq_data.phase_enum = PARDISO_SOLVE_AND_REFINE;
             matlib_pardiso(&eq_data);
@@ -819,8 +1347,7 @@ void pde1d_LSE_solve_IVP2_evol
 
     eq_data.phase_enum = PARDISO_FREE;
     matlib_pardiso(&eq_data);
-    fem1d_zm_nsparse_GMM( input->p, input->N, nsparse, 
-                          data->Q, &phi, &q, &data->nM, FEM1D_GMM_FREE);
+    pde1d_LSE_nGMM_free(input, data, &phi, &q);
 
     debug_exit("%s", "");
 }
@@ -861,17 +1388,8 @@ void pde1d_LSE_solve_IVP2_error
     (*u_analytic)(input->params, input->x, (input->t).elem_p[0], input->u_init);
     debug_body("%s", "provided initial data");
 
-    /* Assemble the global mass matrix 
-     * */ 
     matlib_zm phi, q;
     matlib_index nsparse = input->nsparse;
-    fem1d_zm_nsparse_GMM( input->p, input->N, nsparse, 
-                          data->Q, &phi, &q, &data->nM, FEM1D_GMM_INIT);
-
-    fem1d_zm_nsparse_GMM( input->p, input->N, nsparse, data->Q, 
-                          NULL, NULL, &data->nM, FEM1D_GET_SPARSITY_ONLY);
-    
-    debug_body("phi: %d-by-%d", phi.lenc, phi.lenr);
     /* Setup the sparse linear system */
     /* Solve the equation while marching in time 
      *
@@ -881,34 +1399,17 @@ void pde1d_LSE_solve_IVP2_error
     fem1d_ZFLT(input->N, data->FM, input->u_init, U_tmp);
 
 
-    pardiso_solver_t eq_data = { .nsparse  = nsparse, 
-                                 .mnum     = 1, 
+    pardiso_solver_t eq_data = { .mnum     = 1, 
                                  .sol_enum = PARDISO_LHS, 
                                  .mtype    = PARDISO_COMPLEX_SYM,
-                                 .smat_p   = (void*)&(data->nM),
                                  .rhs_p    = (void*)&Pvb,
                                  .sol_p    = (void*)&V_vb};
 
+    /* Assemble the global mass matrix 
+     * */ 
+    pde1d_LSE_nGMM_init(input, data, &phi, &q, &eq_data);
     debug_body("%s", "Solver data initialized");
 
-    BEGIN_DTRACE
-        matlib_complex *ptr;
-        for(matlib_index k = 0; k< nsparse; k++)
-        {
-            debug_print( "dimension of the sparse square matrix: %d", 
-                         data->nM.lenc);
-            ptr = data->nM.elem_p[k];
-            for(i=0; i<data->nM.lenc; i++)
-            {
-                for(j=data->nM.rowIn[i]; j<data->nM.rowIn[i+1]; j++)
-                {
-                    debug_print( "M(%d,%d): % 0.16f %+0.16fi",
-                                 i, data->nM.colIn[j], ptr[j]);
-                }
-            }
-        }
-    END_DTRACE
-
     eq_data.phase_enum = PARDISO_INIT;
     matlib_pardiso(&eq_data);
     debug_body("%s", "PARDISO initialized");
@@ -919,22 +1420,35 @@ void pde1d_LSE_solve_IVP2_error
     matlib_real norm_actual;
     (input->e_abs).elem_p[0] = 0;
     (input->e_rel).elem_p[0] = 0;
+
+    /* see pde1d_LSE_solve_IVP_error */ 
+    bool overlap = (data->nr_vars>5);
+    matlib_zv W  = overlap? *(matlib_zv*)(data->var_p[5]): V_tmp;
+    pfem1d_future_t future;
     
     for (i=0; i<Nt_; i++)
     {
         (*phi_p)(input->params, data->m_coeff, input->x, t_tmp, phi);
-        fem1d_zm_nsparse_GMM( input->p, input->N, nsparse, data->Q, 
-                              &phi, &q, &data->nM, FEM1D_GET_NZE_ONLY);
-        pde1d_zm_nsparse_GSM(input->N, data->s_coeff, data->nM);
+        pde1d_LSE_nGMM_batch(input, data, &phi, &q);
 
         for(j=0; j<nsparse; j++)
         {
             debug_body("begin iteration: %d", i*nsparse+j);
+            /* Using u_exact to store the analytic solution
+             * */ 
+            if(overlap)
+            {
+                (*u_analytic)(input->params, input->x, t_tmp.elem_p[j+1], u_exact);
+                pfem1d_ZFLT_async( input->N, data->FM, u_exact, W, 
+                                   input->num_threads, input->mp, &future);
+            }
             fem1d_ZPrjL2F(input->p, U_tmp, Pvb);
 
-            eq_data.mnum = j+1;
-            eq_data.phase_enum = PARDISO_ANALYSIS_AND_FACTOR;
-            matlib_pardiso(&eq_data);
+            if(pde1d_LSE_nGMM_level(input, data, &phi, j, &eq_data))
+            {
+                eq_data.phase_enum = PARDISO_ANALYSIS_AND_FACTOR;
+                matlib_pardiso(&eq_data);
+            }
 
             eq_data.phase_enum = PARDISO_SOLVE_AND_REFINE;
             matlib_pardiso(&eq_data);
@@ -944,17 +1458,22 @@ void pde1d_LSE_solve_IVP2_error
             /* 2.0 * V_tmp -U_tmp --> U_tmp*/ 
             matlib_zaxpby(2.0, V_tmp, -1.0, U_tmp );
 
-            /* Using u_exact to store the analytic solution
-             * */ 
-            (*u_analytic)(input->params, input->x, t_tmp.elem_p[j+1], u_exact);
-            fem1d_ZFLT(input->N, data->FM, u_exact, V_tmp);
+            if(overlap)
+            {
+                pfem1d_wait(&future);
+            }
+            else
+            {
+                (*u_analytic)(input->params, input->x, t_tmp.elem_p[j+1], u_exact);
+                fem1d_ZFLT(input->N, data->FM, u_exact, W);
+            }
 
             /* Error analysis: 
              * */ 
-            norm_actual = fem1d_ZNorm2(input->p, input->N, V_tmp);
-            matlib_zaxpy(-1.0, U_tmp, V_tmp );
+            norm_actual = fem1d_ZNorm2(input->p, input->N, W);
+            matlib_zaxpy(-1.0, U_tmp, W );
 
-            (input->e_abs).elem_p[j+nsparse*i+1] = fem1d_ZNorm2(input->p, input->N, V_tmp);
+            (input->e_abs).elem_p[j+nsparse*i+1] = fem1d_ZNorm2(input->p, input->N, W);
             (input->e_rel).elem_p[j+nsparse*i+1] = 
                    (input->e_abs).elem_p[j+nsparse*i+1]/fmax(norm_actual, input->tol);
             
@@ -966,8 +1485,7 @@ void pde1d_LSE_solve_IVP2_error
 
     eq_data.phase_enum = PARDISO_FREE;
     matlib_pardiso(&eq_data);
-    fem1d_zm_nsparse_GMM( input->p, input->N, nsparse, 
-                          data->Q, &phi, &q, &data->nM, FEM1D_GMM_FREE);
+    pde1d_LSE_nGMM_free(input, data, &phi, &q);
 
     debug_exit("%s", "");
 }
@@ -1054,6 +1572,73 @@ void pde1d_LSE_constant_potential
     }
 }
 
+void pde1d_LSE_constant_rpotential
+( 
+    void**         params,
+    matlib_complex m_coeff[2], 
+    matlib_xv      x, 
+    matlib_xv      y,
+    matlib_complex c[2]
+)
+/* 
+ * Real counterpart of pde1d_LSE_constant_potential: the (complex) constant
+ * goes entirely into c[0] so that no transform is needed.
+ *
+ * */ 
+{
+    matlib_index i;
+    matlib_complex a = 0, b = 0;
+
+    matlib_complex phi_0 = *(matlib_complex*) params[3];
+    
+    if(m_coeff != NULL)
+    {
+        a = m_coeff[0];
+        b = m_coeff[1];
+    }
+    if(y.len >= x.len)
+    {
+        for (i=0; i<x.len; i++)
+        {
+            y.elem_p[i] = 0;
+        }
+    }
+    else
+    {
+        term_exec("%s", "size mismatch for vectors");
+    }
+    c[0] = a + b*phi_0;
+    c[1] = 0;
+}
+
+void pde1d_LSE_constant_ppotential
+( 
+    void**         params,
+    matlib_complex m_coeff[2], 
+    matlib_zv      a
+)
+/* 
+ * Polynomial counterpart of pde1d_LSE_constant_potential: a[0] only.
+ *
+ * */ 
+{
+    matlib_index i;
+    matlib_complex c0 = 0, c1 = 0;
+
+    matlib_complex phi_0 = *(matlib_complex*) params[3];
+    
+    if(m_coeff != NULL)
+    {
+        c0 = m_coeff[0];
+        c1 = m_coeff[1];
+    }
+    for (i=0; i<a.len; i++)
+    {
+        a.elem_p[i] = 0;
+    }
+    a.elem_p[0] = c0 + c1*phi_0;
+}
+
 void pde1d_LSE_Gaussian_CW_constant_potential
 (
     void** params,
@@ -1161,6 +1746,61 @@ void pde1d_LSE_harmonic_potential
     }
 }
 
+void pde1d_LSE_harmonic_rpotential
+( 
+    void**         params,
+    matlib_complex m_coeff[2], 
+    matlib_xv      x, 
+    matlib_xv      y,
+    matlib_complex c[2]
+)
+/* 
+ * Real counterpart of pde1d_LSE_harmonic_potential: y = -x^2 and the
+ * potential is m_coeff[0]+m_coeff[1]*y.
+ *
+ * */ 
+{
+    matlib_index i;
+    if(y.len >= x.len)
+    {
+        for (i=0; i<x.len; i++)
+        {
+            y.elem_p[i] = -x.elem_p[i]*x.elem_p[i];
+        }
+    }
+    else
+    {
+        term_exec("%s", "size mismatch for vectors");
+    }
+    c[0] = m_coeff[0];
+    c[1] = m_coeff[1];
+}
+
+void pde1d_LSE_harmonic_ppotential
+( 
+    void**         params,
+    matlib_complex m_coeff[2], 
+    matlib_zv      a
+)
+/* 
+ * Polynomial counterpart of pde1d_LSE_harmonic_potential: 
+ * a[0]+a[2]*x^2 with a[2] = -m_coeff[1].
+ *
+ * */ 
+{
+    matlib_index i;
+    if(a.len < 3)
+    {
+        term_exec("%s", "size mismatch for vectors");
+    }
+    for (i=0; i<a.len; i++)
+    {
+        a.elem_p[i] = 0;
+    }
+    a.elem_p[0] =  m_coeff[0];
+    a.elem_p[2] = -m_coeff[1];
+}
+
 
 /*============================================================================*/
 void pde1d_LSE_Gaussian_WP_timedependent_linear_potential
@@ -18,6 +18,7 @@
 #define NDEBUG
 #define MATLIB_NTRACE_DATA
 #include "assert.h"
+#include "fem1d.h"
 #include "pfem1d.h"
 /*============================================================================*/
 
@@ -128,31 +129,165 @@ static void* thfunc_zprjLP2FEM_ShapeFunc_8 (void* mp);
 static void* thfunc_zprjLP2FEM_ShapeFunc_9 (void* mp);
 static void* thfunc_zprjLP2FEM_ShapeFunc_10(void* mp);
 
-static void* thfunc_dlp_snorm2_d(void* mp);
-static void* thfunc_zlp_snorm2_d(void* mp);
-
-static void* thfunc_dlp_snorm2_d_2(void* mp);
-static void* thfunc_dlp_snorm2_d_3(void* mp);
-static void* thfunc_dlp_snorm2_d_4(void* mp);
-static void* thfunc_dlp_snorm2_d_5(void* mp);
-static void* thfunc_dlp_snorm2_d_6(void* mp);
-static void* thfunc_dlp_snorm2_d_7(void* mp);
-static void* thfunc_dlp_snorm2_d_8(void* mp);
-static void* thfunc_dlp_snorm2_d_9(void* mp);
-static void* thfunc_dlp_snorm2_d_10(void* mp);
-
-static void* thfunc_zlp_snorm2_d_2(void* mp);
-static void* thfunc_zlp_snorm2_d_3(void* mp);
-static void* thfunc_zlp_snorm2_d_4(void* mp);
-static void* thfunc_zlp_snorm2_d_5(void* mp);
-static void* thfunc_zlp_snorm2_d_6(void* mp);
-static void* thfunc_zlp_snorm2_d_7(void* mp);
-static void* thfunc_zlp_snorm2_d_8(void* mp);
-static void* thfunc_zlp_snorm2_d_9(void* mp);
-static void* thfunc_zlp_snorm2_d_10(void* mp);
-
+static void* pfem1d_thfunc_XCSRGMM(void* mp);
+static void* pfem1d_thfunc_ZCSRGMM(void* mp);
 static void* pfem1d_thfunc_XCSRGMM2(void* mp);
 static void* pfem1d_thfunc_ZCSRGMM2(void* mp);
+static void* pfem1d_thfunc_XZGMMq(void* mp);
+static void* pfem1d_thfunc_XGSMV(void* mp);
+static void* pfem1d_thfunc_ZGSMV(void* mp);
+static void* pfem1d_thfunc_XCSRSYMV(void* mp);
+static void* pfem1d_thfunc_ZCSRSYMV(void* mp);
+static void* pfem1d_thfunc_XCSRSYMV_sum(void* mp);
+static void* pfem1d_thfunc_ZCSRSYMV_sum(void* mp);
+
+static void* pfem1d_thfunc_znv(void* mp);
+
+static void* pfem1d_thfunc_XEval(void* mp);
+static void* pfem1d_thfunc_ZEval(void* mp);
+
+static matlib_real pfem1d_thfunc_XNorm2(void* mp);
+static matlib_real pfem1d_thfunc_ZNorm2(void* mp);
+
+/*============================================================================+/
+ | Element loops
+ | All the kernels below iterate over ranges of elements (or columns, or
+ | points) with pthpool_for, so that idle threads steal from the busy ones;
+ | the schedule is chosen here for all of them. The *_pv variants instead
+ | run every part of the partition of their output on its owner (see
+ | pfem1d_create_zpv), so that the threads stream the memory they touched
+ | first.
+/+============================================================================*/
+#define PFEM1D_SCHED PTHPOOL_SCHED_STATIC
+#define PFEM1D_GRAIN 0
+
+static inline void pfem1d_for
+(
+    matlib_index    N,
+    void**          shared_data,
+    void*           thfunc,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+)
+{
+    pthpool_for( 0, N, PFEM1D_SCHED, PFEM1D_GRAIN, shared_data, thfunc, 
+                 num_threads, mp);
+}
+
+static inline void pfem1d_for_owned
+(
+    matlib_index               N,
+    const pthpool_partition_t* part,
+    void**                     shared_data,
+    void*                      thfunc,
+    pthpool_data_t*            mp
+)
+/* A partition of a different number of elements cannot be followed */ 
+{
+    if(part->N==N)
+    {
+        pthpool_for_partition(part, shared_data, thfunc, mp);
+    }
+    else
+    {
+        pfem1d_for(N, shared_data, thfunc, part->num_threads, mp);
+    }
+}
+
+/*============================================================================+/
+ | Partitioned vectors
+/+============================================================================*/
+
+static void* pfem1d_create_pv
+(
+    matlib_index         N,
+    matlib_index         block,
+    matlib_index         len,
+    size_t               elem_size,
+    matlib_index         num_threads,
+    pthpool_data_t*      mp,
+    pthpool_partition_t* part
+)
+/* 
+ * Allocates len entries without touching them, so that the pages are
+ * placed by pthpool_partition_touch.
+ *
+ * */ 
+{
+    assert(len>=N*block);
+
+    errno = 0;
+    void* elem_p = malloc(len*elem_size);
+    part->start  = calloc(num_threads+1, sizeof(matlib_index));
+    if((elem_p==NULL) || (part->start==NULL))
+    {
+        term_exec( "%s: initialization error: vector of length %d", 
+                   strerror(errno), len);
+    }
+    pthpool_partition_split(N, num_threads, part);
+    pthpool_partition_touch(part, block*elem_size, len*elem_size, elem_p, mp);
+    return elem_p;
+}
+
+void pfem1d_create_xpv
+(
+    matlib_index    N,
+    matlib_index    block,
+    matlib_index    len,
+    matlib_index    num_threads,
+    pthpool_data_t* mp,
+    pfem1d_xpv_t*   pv
+)
+/* 
+ * N    : nr. of finite elements
+ * block: nr. of entries per element
+ * len  : length of the vector, at least N*block
+ *
+ * */ 
+{
+    debug_enter("N: %d, block: %d, length: %d", N, block, len);
+    pv->block    = block;
+    pv->v.len    = len;
+    pv->v.type   = MATLIB_COL_VECT;
+    pv->v.elem_p = pfem1d_create_pv( N, block, len, sizeof(matlib_real),
+                                     num_threads, mp, &(pv->part));
+    debug_exit("%s", "");
+}
+
+void pfem1d_create_zpv
+(
+    matlib_index    N,
+    matlib_index    block,
+    matlib_index    len,
+    matlib_index    num_threads,
+    pthpool_data_t* mp,
+    pfem1d_zpv_t*   pv
+)
+{
+    debug_enter("N: %d, block: %d, length: %d", N, block, len);
+    pv->block    = block;
+    pv->v.len    = len;
+    pv->v.type   = MATLIB_COL_VECT;
+    pv->v.elem_p = pfem1d_create_pv( N, block, len, sizeof(matlib_complex),
+                                     num_threads, mp, &(pv->part));
+    debug_exit("%s", "");
+}
+
+void pfem1d_free_xpv(pfem1d_xpv_t* pv)
+{
+    matlib_free(pv->v.elem_p);
+    matlib_free(pv->part.start);
+    pv->v.elem_p   = NULL;
+    pv->part.start = NULL;
+}
+
+void pfem1d_free_zpv(pfem1d_zpv_t* pv)
+{
+    matlib_free(pv->v.elem_p);
+    matlib_free(pv->part.start);
+    pv->v.elem_p   = NULL;
+    pv->part.start = NULL;
+}
 
 /*============================================================================*/
 static void* pfem1d_thfunc_XFLT(void* mp)
@@ -250,51 +385,39 @@ void pfem1d_XFLT
           pthpool_data_t* mp
 )
 {
-    matlib_index i; 
     /* define the shared data */ 
     void* shared_data[4] = { (void*) &N,
                              (void*) &FM,
                              (void*) &u,
                              (void*) &U };
 
-    matlib_index nsdata[num_threads][2];
-
-
-    pthpool_arg_t   arg[num_threads];
-    pthpool_task_t  task[num_threads];
-
-    /* define the block of data per thread */ 
-    matlib_index Np = N/(num_threads);
-
-    for(i=0; i<num_threads-1; i++)
-    {
-        nsdata[i][0] = i*Np;
-        nsdata[i][1] = (i+1)*Np;
-        arg[i].shared_data    = shared_data; 
-        arg[i].nonshared_data = (void**)&nsdata[i];
-        arg[i].thread_index   = i;
-        /* Define the task */ 
-        task[i].function  = (void*)pfem1d_thfunc_XFLT;
-        task[i].argument  = &arg[i];
-        
-    }
-    nsdata[i][0] = i*Np;
-    nsdata[i][1] = N;
-    arg[i].shared_data    = shared_data; 
-    arg[i].nonshared_data = (void**)&nsdata[i];
-    arg[i].thread_index   = i;
-    /* Define the task */ 
-    task[i].function  = (void*)pfem1d_thfunc_XFLT;
-    task[i].argument  = &arg[i];
-    
-
     debug_body("%s", "created task");
-
-    pthpool_exec_task(num_threads, mp, task);
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_XFLT, num_threads, mp);
     
     debug_exit("%s", "");
 
 }
+
+void pfem1d_XFLT_pv
+(
+    const matlib_index    N,
+    const matlib_xm       FM,
+    const pfem1d_xpv_t*   u,
+          pfem1d_xpv_t*   U,
+          pthpool_data_t* mp
+)
+/* 
+ * As pfem1d_XFLT with each part of the partition of U run on its owner.
+ *
+ * */ 
+{
+    void* shared_data[4] = { (void*) &N,
+                             (void*) &FM,
+                             (void*) &(u->v),
+                             (void*) &(U->v) };
+
+    pfem1d_for_owned( N, &(U->part), shared_data, (void*)pfem1d_thfunc_XFLT, mp);
+}
 /*============================================================================*/
 static void* pfem1d_thfunc_ZFLT(void* mp)
 /* 
@@ -404,51 +527,39 @@ void pfem1d_ZFLT
           pthpool_data_t* mp
 )
 {
-    matlib_index i; 
     /* define the shared data */ 
     void* shared_data[4] = { (void*) &N,
                              (void*) &FM,
                              (void*) &u,
                              (void*) &U };
 
-    matlib_index nsdata[num_threads][2];
-
-
-    pthpool_arg_t   arg[num_threads];
-    pthpool_task_t  task[num_threads];
-
-    /* define the block of data per thread */ 
-    matlib_index Np = N/(num_threads);
-
-    for(i=0; i<num_threads-1; i++)
-    {
-        nsdata[i][0] = i*Np;
-        nsdata[i][1] = (i+1)*Np;
-        arg[i].shared_data    = shared_data; 
-        arg[i].nonshared_data = (void**)&nsdata[i];
-        arg[i].thread_index   = i;
-        /* Define the task */ 
-        task[i].function  = (void*)pfem1d_thfunc_ZFLT;
-        task[i].argument  = &arg[i];
-        
-    }
-    nsdata[i][0] = i*Np;
-    nsdata[i][1] = N;
-    arg[i].shared_data    = shared_data; 
-    arg[i].nonshared_data = (void**)&nsdata[i];
-    arg[i].thread_index   = i;
-    /* Define the task */ 
-    task[i].function  = (void*)pfem1d_thfunc_ZFLT;
-    task[i].argument  = &arg[i];
-    
-
     debug_body("%s", "created task");
-
-    pthpool_exec_task(num_threads, mp, task);
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_ZFLT, num_threads, mp);
     
     debug_exit("%s", "");
 
 }
+
+void pfem1d_ZFLT_pv
+(
+    const matlib_index    N,
+    const matlib_xm       FM,
+    const pfem1d_zpv_t*   u,
+          pfem1d_zpv_t*   U,
+          pthpool_data_t* mp
+)
+/* 
+ * As pfem1d_ZFLT with each part of the partition of U run on its owner.
+ *
+ * */ 
+{
+    void* shared_data[4] = { (void*) &N,
+                             (void*) &FM,
+                             (void*) &(u->v),
+                             (void*) &(U->v) };
+
+    pfem1d_for_owned( N, &(U->part), shared_data, (void*)pfem1d_thfunc_ZFLT, mp);
+}
 /*============================================================================*/
 static void* pfem1d_thfunc_XILT(void* mp)
 /* 
@@ -462,8 +573,6 @@ static void* pfem1d_thfunc_XILT(void* mp)
     matlib_xv U    = *((matlib_xv*) (ptr->shared_data[2]));
     matlib_xv u    = *((matlib_xv*) (ptr->shared_data[3]));
     
-    pthread_mutex_t* lock_common = ((pthread_mutex_t*) (ptr->shared_data[4]));
-    
     debug_enter( "thread index: %d, "
                  "nr. finite-elements: %d, "
                  "matrix IM: %d-by-%d, "
@@ -484,13 +593,11 @@ static void* pfem1d_thfunc_XILT(void* mp)
 
     assert(((IM.elem_p!=NULL) && (u.elem_p !=NULL)) && (U.elem_p!=NULL));
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
     
     debug_body( "Thread id: %d, start_index: %d, end_index: %d",
                 ptr->thread_index, 
                 start_end_index[0], start_end_index[1]);
-    bool not_first = !(start_end_index[0]==0);
-    bool not_last  = !(start_end_index[1]==N);
 
     if(p>1)
     {
@@ -510,35 +617,15 @@ static void* pfem1d_thfunc_XILT(void* mp)
 
             (u.elem_p) += (P*start_end_index[0]);
             (U.elem_p) += (IM.lenr*start_end_index[0]);
-            if(not_first)
-            {
-                pthread_mutex_lock(&lock_common[ptr->thread_index-1]);
-            }
-            cblas_dgemv( order_enum, 
-                         CblasNoTrans, 
-                         IM.lenc, 
-                         IM.lenr,
-                         1.0, 
-                         IM.elem_p, 
-                         strideIM, 
-                         U.elem_p, 
-                         incU, 
-                         0,
-                         u.elem_p,
-                         incu);
-            if(not_first)
-            {
-                matlib_real* common_u = (matlib_real*) (ptr->nonshared_data[1]);
-                *common_u = *(u.elem_p);
-                pthread_mutex_unlock(&lock_common[ptr->thread_index-1]);
-            }
-            (U.elem_p) += (IM.lenr);
-            (u.elem_p) += P;
-            for(i=start_end_index[0]+1; i<start_end_index[1]-1; i++)
+            for(i=start_end_index[0]; i<start_end_index[1]; i++)
             {
+                /* The vertex shared with the next element is written by
+                 * that element as in the serial version, so that ranges
+                 * of elements can be processed in any order.
+                 * */ 
                 cblas_dgemv( order_enum, 
                              CblasNoTrans, 
-                             IM.lenc, 
+                             (i==N-1)? IM.lenc: P, 
                              IM.lenr,
                              1.0, 
                              IM.elem_p, 
@@ -551,26 +638,6 @@ static void* pfem1d_thfunc_XILT(void* mp)
                 (U.elem_p) += (IM.lenr);
                 (u.elem_p) += P;
             }
-            if(not_last)
-            {
-                pthread_mutex_lock(&lock_common[ptr->thread_index]);
-            }
-            cblas_dgemv( order_enum, 
-                         CblasNoTrans, 
-                         IM.lenc, 
-                         IM.lenr,
-                         1.0, 
-                         IM.elem_p, 
-                         strideIM, 
-                         U.elem_p, 
-                         incU, 
-                         0,
-                         u.elem_p,
-                         incu);
-            if(not_last)
-            {
-                pthread_mutex_unlock(&lock_common[ptr->thread_index]);
-            }
         }
         else
         {
@@ -597,90 +664,38 @@ void pfem1d_XILT
 )
 {
 
-    matlib_index i; 
-    /* define mutexes for adjacent elements of u w.r.t. threads */
-    pthread_mutex_t lock_common[num_threads-1];
-    for(i=0; i<num_threads-1; i++)
-    {
-       pthread_mutex_init(&(lock_common[i]), NULL);
-    }
     /* define the shared data */ 
-    void* shared_data[5] = { (void*) &N,
+    void* shared_data[4] = { (void*) &N,
                              (void*) &IM,
                              (void*) &U,
-                             (void*) &u,
-                             (void*) &(lock_common)};
-    void* nonshared_data[num_threads][2];
-    matlib_real common_u[num_threads-1];
-
-    matlib_index nsdata[num_threads][2];
+                             (void*) &u };
 
-
-    pthpool_arg_t   arg[num_threads];
-    pthpool_task_t  task[num_threads];
-
-    /* define the block of data per thread */ 
-    matlib_index Np = N/(num_threads);
-
-    i = 0;
-    nsdata[i][0] = i*Np;
-    nsdata[i][1] = (i+1)*Np;
-    arg[i].shared_data    = shared_data; 
-
-    nonshared_data[i][0]  = (void*)nsdata[i];
-    nonshared_data[i][1]  = NULL;
-    arg[i].nonshared_data = (void**)&nonshared_data[i];
-    arg[i].thread_index   = i;
-    /* Define the task */ 
-    task[i].function  = (void*)pfem1d_thfunc_XILT;
-    task[i].argument  = &arg[i];
-    
-    for(i=1; i<num_threads-1; i++)
-    {
-        nsdata[i][0] = i*Np;
-        nsdata[i][1] = (i+1)*Np;
-        arg[i].shared_data    = shared_data; 
-        nonshared_data[i][0]  = (void*)nsdata[i];
-        nonshared_data[i][1]  = (void*)&common_u[i-1];
-        arg[i].nonshared_data = (void**)&nonshared_data[i];
-        arg[i].thread_index   = i;
-        /* Define the task */ 
-        task[i].function  = (void*)pfem1d_thfunc_XILT;
-        task[i].argument  = &arg[i];
-        
-    }
-    if(i<num_threads)
-    {
-        nsdata[i][0] = i*Np;
-        nsdata[i][1] = N;
-        arg[i].shared_data    = shared_data; 
-        nonshared_data[i][0]  = (void*)nsdata[i];
-        nonshared_data[i][1]  = (void*)&common_u[i-1];
-        arg[i].nonshared_data = (void**)&nonshared_data[i];
-        arg[i].thread_index   = i;
-        /* Define the task */ 
-        task[i].function  = (void*)pfem1d_thfunc_XILT;
-        task[i].argument  = &arg[i];
-        
-    }
     debug_body("%s", "created task");
-
-    pthpool_exec_task(num_threads, mp, task);
-    matlib_index P = IM.lenc-1; 
-
-    for(i=0; i<num_threads-1; i++)
-    {
-        u.elem_p[(i+1)*Np*P] = common_u[i];
-    }
-
-    debug_body("%s", "destroying mutexes");
-    for(i=0; i<num_threads-1; i++)
-    {
-       pthread_mutex_destroy(&(lock_common[i]));
-    }
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_XILT, num_threads, mp);
     
     debug_exit("%s", "");
 }
+
+void pfem1d_XILT_pv
+(
+    const matlib_index    N,
+    const matlib_xm       IM,
+    const pfem1d_xpv_t*   U,
+          pfem1d_xpv_t*   u,
+          pthpool_data_t* mp
+)
+/* 
+ * As pfem1d_XILT with each part of the partition of u run on its owner.
+ *
+ * */ 
+{
+    void* shared_data[4] = { (void*) &N,
+                             (void*) &IM,
+                             (void*) &(U->v),
+                             (void*) &(u->v) };
+
+    pfem1d_for_owned( N, &(u->part), shared_data, (void*)pfem1d_thfunc_XILT, mp);
+}
 /*============================================================================*/
 static void* pfem1d_thfunc_ZILT(void* mp)
 /* 
@@ -694,7 +709,6 @@ static void* pfem1d_thfunc_ZILT(void* mp)
     matlib_zv U    =    *((matlib_zv*) (ptr->shared_data[2]));
     matlib_zv u    =    *((matlib_zv*) (ptr->shared_data[3]));
     
-    pthread_mutex_t* lock_common = ((pthread_mutex_t*) (ptr->shared_data[4]));
 
     debug_enter( "thread index: %d, "
                  "nr. finite-elements: %d, "
@@ -716,13 +730,11 @@ static void* pfem1d_thfunc_ZILT(void* mp)
 
     assert(((IM.elem_p!=NULL) && (u.elem_p !=NULL)) && (U.elem_p!=NULL));
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
     
     debug_body( "Thread id: %d, start_index: %d, end_index: %d",
                 ptr->thread_index, 
                 start_end_index[0], start_end_index[1]);
-    bool not_first = !(start_end_index[0]==0);
-    bool not_last  = !(start_end_index[1]==N);
     if(p>1)
     {
         debug_body("nr. computed finite-elements: %d", U.len/(p+1));
@@ -738,47 +750,16 @@ static void* pfem1d_thfunc_ZILT(void* mp)
             matlib_index i;
             (u.elem_p) += (P*start_end_index[0]);
             (U.elem_p) += (IM.lenr*start_end_index[0]);
-            if(not_first)
-            {
-                pthread_mutex_lock(&lock_common[ptr->thread_index-1]);
-            }
-            cblas_dgemv( order_enum, 
-                         CblasNoTrans, 
-                         IM.lenc, 
-                         IM.lenr,
-                         1.0, 
-                         IM.elem_p, 
-                         strideIM, 
-                         (matlib_real*)U.elem_p, 
-                         incu, 
-                         0,
-                         (matlib_real*)u.elem_p,
-                         incu);
-            cblas_dgemv( order_enum, 
-                         CblasNoTrans, 
-                         IM.lenc, 
-                         IM.lenr,
-                         1.0, 
-                         IM.elem_p, 
-                         strideIM, 
-                         ((matlib_real*)U.elem_p+1), 
-                         incu, 
-                         0,
-                         ((matlib_real*)u.elem_p+1),
-                         incu);
-            if(not_first)
-            {
-                matlib_complex* common_u = (matlib_complex*) (ptr->nonshared_data[1]);
-                *common_u = *(u.elem_p);
-                pthread_mutex_unlock(&lock_common[ptr->thread_index-1]);
-            }
-            (U.elem_p) += (IM.lenr);
-            (u.elem_p) += P;
-            for(i=start_end_index[0]+1; i<start_end_index[1]-1; i++)
+            for(i=start_end_index[0]; i<start_end_index[1]; i++)
             {
+                /* The vertex shared with the next element is written by
+                 * that element as in the serial version, so that ranges
+                 * of elements can be processed in any order.
+                 * */ 
+                matlib_index nr_rows = (i==N-1)? IM.lenc: P;
                 cblas_dgemv( order_enum, 
                              CblasNoTrans, 
-                             IM.lenc, 
+                             nr_rows, 
                              IM.lenr,
                              1.0, 
                              IM.elem_p, 
@@ -790,7 +771,7 @@ static void* pfem1d_thfunc_ZILT(void* mp)
                              incu);
                 cblas_dgemv( order_enum, 
                              CblasNoTrans, 
-                             IM.lenc, 
+                             nr_rows, 
                              IM.lenr,
                              1.0, 
                              IM.elem_p, 
@@ -803,38 +784,6 @@ static void* pfem1d_thfunc_ZILT(void* mp)
                 (U.elem_p) += (IM.lenr);
                 (u.elem_p) += P;
             }
-            if(not_last)
-            {
-                pthread_mutex_lock(&lock_common[ptr->thread_index]);
-            }
-            cblas_dgemv( order_enum, 
-                         CblasNoTrans, 
-                         IM.lenc, 
-                         IM.lenr,
-                         1.0, 
-                         IM.elem_p, 
-                         strideIM, 
-                         (matlib_real*)U.elem_p, 
-                         incu, 
-                         0,
-                         (matlib_real*)u.elem_p,
-                         incu);
-            cblas_dgemv( order_enum, 
-                         CblasNoTrans, 
-                         IM.lenc, 
-                         IM.lenr,
-                         1.0, 
-                         IM.elem_p, 
-                         strideIM, 
-                         ((matlib_real*)U.elem_p+1), 
-                         incu, 
-                         0,
-                         ((matlib_real*)u.elem_p+1),
-                         incu);
-            if(not_last)
-            {
-                pthread_mutex_unlock(&lock_common[ptr->thread_index]);
-            }
         }
         else
         {
@@ -861,90 +810,38 @@ void pfem1d_ZILT
 )
 {
 
-    matlib_index i; 
-    /* define mutexes for adjacent elements of u w.r.t. threads */
-    pthread_mutex_t lock_common[num_threads-1];
-    for(i=0; i<num_threads-1; i++)
-    {
-       pthread_mutex_init(&(lock_common[i]), NULL);
-    }
     /* define the shared data */ 
-    void* shared_data[5] = { (void*) &N,
+    void* shared_data[4] = { (void*) &N,
                              (void*) &IM,
                              (void*) &U,
-                             (void*) &u,
-                             (void*) &(lock_common)};
-    void* nonshared_data[num_threads][2];
-    matlib_complex common_u[num_threads-1];
-
-    matlib_index nsdata[num_threads][2];
-
-
-    pthpool_arg_t   arg[num_threads];
-    pthpool_task_t  task[num_threads];
+                             (void*) &u };
 
-    /* define the block of data per thread */ 
-    matlib_index Np = N/(num_threads);
-
-    i = 0;
-    nsdata[i][0] = i*Np;
-    nsdata[i][1] = (i+1)*Np;
-    arg[i].shared_data    = shared_data; 
-
-    nonshared_data[i][0]  = (void*)nsdata[i];
-    nonshared_data[i][1]  = NULL;
-    arg[i].nonshared_data = (void**)&nonshared_data[i];
-    arg[i].thread_index   = i;
-    /* Define the task */ 
-    task[i].function  = (void*)pfem1d_thfunc_ZILT;
-    task[i].argument  = &arg[i];
-    
-    for(i=1; i<num_threads-1; i++)
-    {
-        nsdata[i][0] = i*Np;
-        nsdata[i][1] = (i+1)*Np;
-        arg[i].shared_data    = shared_data; 
-        nonshared_data[i][0]  = (void*)nsdata[i];
-        nonshared_data[i][1]  = (void*)&common_u[i-1];
-        arg[i].nonshared_data = (void**)&nonshared_data[i];
-        arg[i].thread_index   = i;
-        /* Define the task */ 
-        task[i].function  = (void*)pfem1d_thfunc_ZILT;
-        task[i].argument  = &arg[i];
-        
-    }
-    if(i<num_threads)
-    {
-        nsdata[i][0] = i*Np;
-        nsdata[i][1] = N;
-        arg[i].shared_data    = shared_data; 
-        nonshared_data[i][0]  = (void*)nsdata[i];
-        nonshared_data[i][1]  = (void*)&common_u[i-1];
-        arg[i].nonshared_data = (void**)&nonshared_data[i];
-        arg[i].thread_index   = i;
-        /* Define the task */ 
-        task[i].function  = (void*)pfem1d_thfunc_ZILT;
-        task[i].argument  = &arg[i];
-        
-    }
     debug_body("%s", "created task");
-
-    pthpool_exec_task(num_threads, mp, task);
-    matlib_index P = IM.lenc-1; 
-
-    for(i=0; i<num_threads-1; i++)
-    {
-        u.elem_p[(i+1)*Np*P] = common_u[i];
-    }
-
-    debug_body("%s", "destroying mutexes");
-    for(i=0; i<num_threads-1; i++)
-    {
-       pthread_mutex_destroy(&(lock_common[i]));
-    }
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_ZILT, num_threads, mp);
     
     debug_exit("%s", "");
 }
+
+void pfem1d_ZILT_pv
+(
+    const matlib_index    N,
+    const matlib_xm       IM,
+    const pfem1d_zpv_t*   U,
+          pfem1d_zpv_t*   u,
+          pthpool_data_t* mp
+)
+/* 
+ * As pfem1d_ZILT with each part of the partition of u run on its owner.
+ *
+ * */ 
+{
+    void* shared_data[4] = { (void*) &N,
+                             (void*) &IM,
+                             (void*) &(U->v),
+                             (void*) &(u->v) };
+
+    pfem1d_for_owned( N, &(u->part), shared_data, (void*)pfem1d_thfunc_ZILT, mp);
+}
 /*============================================================================*/
 static void* pfem1d_thfunc_XFLT2(void* mp)
 /* 
@@ -1065,47 +962,15 @@ void pfem1d_XFLT2
           pthpool_data_t* mp
 )
 {
-    matlib_index i; 
     /* define the shared data */ 
     void* shared_data[4] = { (void*) &N,
                              (void*) &FM,
                              (void*) &u,
                              (void*) &U };
 
-    matlib_index nsdata[num_threads][2];
-
-
-    pthpool_arg_t   arg[num_threads];
-    pthpool_task_t  task[num_threads];
-
-    /* define the block of data per thread */ 
-    matlib_index Np = u.lenr/(num_threads);
-
-    for(i=0; i<num_threads-1; i++)
-    {
-        nsdata[i][0] = i*Np;
-        nsdata[i][1] = (i+1)*Np;
-        arg[i].shared_data    = shared_data; 
-        arg[i].nonshared_data = (void**)&nsdata[i];
-        arg[i].thread_index   = i;
-        /* Define the task */ 
-        task[i].function  = (void*)pfem1d_thfunc_XFLT2;
-        task[i].argument  = &arg[i];
-        
-    }
-    nsdata[i][0] = i*Np;
-    nsdata[i][1] = u.lenr;
-    arg[i].shared_data    = shared_data; 
-    arg[i].nonshared_data = (void**)&nsdata[i];
-    arg[i].thread_index   = i;
-    /* Define the task */ 
-    task[i].function  = (void*)pfem1d_thfunc_XFLT2;
-    task[i].argument  = &arg[i];
-    
-
     debug_body("%s", "created task");
-
-    pthpool_exec_task(num_threads, mp, task);
+    pfem1d_for( u.lenr, shared_data, (void*)pfem1d_thfunc_XFLT2, 
+                num_threads, mp);
     
     debug_exit("%s", "");
 
@@ -1240,47 +1105,15 @@ void pfem1d_ZFLT2
           pthpool_data_t* mp
 )
 {
-    matlib_index i; 
     /* define the shared data */ 
     void* shared_data[4] = { (void*) &N,
                              (void*) &FM,
                              (void*) &u,
                              (void*) &U };
 
-    matlib_index nsdata[num_threads][2];
-
-
-    pthpool_arg_t   arg[num_threads];
-    pthpool_task_t  task[num_threads];
-
-    /* define the block of data per thread */ 
-    matlib_index Np = u.lenr/(num_threads);
-
-    for(i=0; i<num_threads-1; i++)
-    {
-        nsdata[i][0] = i*Np;
-        nsdata[i][1] = (i+1)*Np;
-        arg[i].shared_data    = shared_data; 
-        arg[i].nonshared_data = (void**)&nsdata[i];
-        arg[i].thread_index   = i;
-        /* Define the task */ 
-        task[i].function  = (void*)pfem1d_thfunc_ZFLT2;
-        task[i].argument  = &arg[i];
-        
-    }
-    nsdata[i][0] = i*Np;
-    nsdata[i][1] = u.lenr;
-    arg[i].shared_data    = shared_data; 
-    arg[i].nonshared_data = (void**)&nsdata[i];
-    arg[i].thread_index   = i;
-    /* Define the task */ 
-    task[i].function  = (void*)pfem1d_thfunc_ZFLT2;
-    task[i].argument  = &arg[i];
-    
-
     debug_body("%s", "created task");
-
-    pthpool_exec_task(num_threads, mp, task);
+    pfem1d_for( u.lenr, shared_data, (void*)pfem1d_thfunc_ZFLT2, 
+                num_threads, mp);
     
     debug_exit("%s", "");
 
@@ -1290,6 +1123,7 @@ void pfem1d_ZFLT2
  | Transformation from Legendre basis to FEM-basis and vice-versa
 /+============================================================================*/
 
+ISA_CLONES
 static void* thfunc_dshapefunc2lp(void* mp)
 /* (elem_n+1)-by-1 vector, vertex function basis */
 /* (p-1)-by-1 vector, bubble function basis      */
@@ -1380,15 +1214,7 @@ void pfem1d_XF2L
 
     if(u.len == vb.len+(N-1))
     {
-        matlib_index i,j;
-        matlib_index nsdata[num_threads][2];
-
-        pthpool_arg_t   arg[num_threads];
-        pthpool_task_t  task[num_threads];
-
-        /* define the block of data per thread */ 
-        matlib_index Np = N/(num_threads);
-
+        matlib_index j;
         if(p>10)
         {
 
@@ -1420,31 +1246,9 @@ void pfem1d_XF2L
                                     };
             
 
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data    = shared_data; 
-                arg[i].nonshared_data = (void**)&nsdata[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)thfunc_dshapefunc2lp;
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            arg[i].nonshared_data = (void**)&nsdata[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function  = (void*)thfunc_dshapefunc2lp;
-            task[i].argument  = &arg[i];
-            
-
             debug_body("%s", "created task");
-
-            pthpool_exec_task(num_threads, mp, task);
+            pfem1d_for( N, shared_data, (void*)thfunc_dshapefunc2lp, 
+                        num_threads, mp);
 
             matlib_free(B.elem_p);
             matlib_free(C.elem_p);
@@ -1457,30 +1261,8 @@ void pfem1d_XF2L
                                      (void*) (u.elem_p)
                                     };
             
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data    = shared_data; 
-                arg[i].nonshared_data = (void*)&nsdata[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)fp[func_index];
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            arg[i].nonshared_data = (void*)&nsdata[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function  = (void*)fp[func_index];
-            task[i].argument  = &arg[i];
-            
-
             debug_body("%s", "created task");
-            pthpool_exec_task(num_threads, mp, task);
+            pfem1d_for( N, shared_data, (void*)fp[func_index], num_threads, mp);
 
         }        
     }
@@ -1495,6 +1277,7 @@ void pfem1d_XF2L
 }
 /*============================================================================*/
 
+ISA_CLONES
 static void* thfunc_zshapefunc2lp(void* mp)
 /* (elem_n+1)-by-1 vector, vertex function basis */
 /* (p-1)-by-1 vector, bubble function basis      */
@@ -1587,15 +1370,7 @@ void pfem1d_ZF2L
 
     if(u.len == vb.len+(N-1))
     {
-        matlib_index i,j;
-        matlib_index nsdata[num_threads][2];
-
-
-        pthpool_arg_t   arg[num_threads];
-        pthpool_task_t  task[num_threads];
-
-        /* define the block of data per thread */ 
-        matlib_index Np = N/(num_threads);
+        matlib_index j;
         if(p>10)
         {
 
@@ -1626,30 +1401,9 @@ void pfem1d_ZF2L
                                     };
             
 
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data    = shared_data; 
-                arg[i].nonshared_data = (void*)&nsdata[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)thfunc_zshapefunc2lp;
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            arg[i].nonshared_data = (void*)&nsdata[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function  = (void*)thfunc_zshapefunc2lp;
-            task[i].argument  = &arg[i];
-            
-
             debug_body("%s", "created task");
-            pthpool_exec_task(num_threads, mp, task);
+            pfem1d_for( N, shared_data, (void*)thfunc_zshapefunc2lp, 
+                        num_threads, mp);
 
             matlib_free(B.elem_p);
             matlib_free(C.elem_p);
@@ -1665,30 +1419,8 @@ void pfem1d_ZF2L
                                     };
             
 
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data    = shared_data; 
-                arg[i].nonshared_data = (void*)&nsdata[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)fp[func_index];
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            arg[i].nonshared_data = (void*)&nsdata[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function  = (void*)fp[func_index];
-            task[i].argument  = &arg[i];
-            
-
             debug_body("%s", "created task");
-            pthpool_exec_task(num_threads, mp, task);
+            pfem1d_for( N, shared_data, (void*)fp[func_index], num_threads, mp);
         
         }
         
@@ -1709,6 +1441,7 @@ void pfem1d_ZF2L
 
  
 
+ISA_CLONES
 static void* thfunc_dshapefunc2lp_2(void* mp)
 {
 
@@ -1742,6 +1475,7 @@ static void* thfunc_dshapefunc2lp_2(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dshapefunc2lp_3(void* mp)
 {
 
@@ -1776,6 +1510,7 @@ static void* thfunc_dshapefunc2lp_3(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dshapefunc2lp_4(void* mp)
 {
 
@@ -1811,6 +1546,7 @@ static void* thfunc_dshapefunc2lp_4(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dshapefunc2lp_5(void* mp)
 {
 
@@ -1847,6 +1583,7 @@ static void* thfunc_dshapefunc2lp_5(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dshapefunc2lp_6(void* mp)
 {
 
@@ -1884,6 +1621,7 @@ static void* thfunc_dshapefunc2lp_6(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dshapefunc2lp_7(void* mp)
 {
 
@@ -1922,6 +1660,7 @@ static void* thfunc_dshapefunc2lp_7(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dshapefunc2lp_8(void* mp)
 {
 
@@ -1961,6 +1700,7 @@ static void* thfunc_dshapefunc2lp_8(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dshapefunc2lp_9(void* mp)
 {
 
@@ -2001,6 +1741,7 @@ static void* thfunc_dshapefunc2lp_9(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dshapefunc2lp_10(void* mp)
 {
 
@@ -2044,6 +1785,7 @@ static void* thfunc_dshapefunc2lp_10(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zshapefunc2lp_2(void* mp)
 {
 
@@ -2077,6 +1819,7 @@ static void* thfunc_zshapefunc2lp_2(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zshapefunc2lp_3(void* mp)
 {
 
@@ -2111,6 +1854,7 @@ static void* thfunc_zshapefunc2lp_3(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zshapefunc2lp_4(void* mp)
 {
 
@@ -2146,6 +1890,7 @@ static void* thfunc_zshapefunc2lp_4(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zshapefunc2lp_5(void* mp)
 {
 
@@ -2182,6 +1927,7 @@ static void* thfunc_zshapefunc2lp_5(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zshapefunc2lp_6(void* mp)
 {
 
@@ -2219,6 +1965,7 @@ static void* thfunc_zshapefunc2lp_6(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zshapefunc2lp_7(void* mp)
 {
 
@@ -2257,6 +2004,7 @@ static void* thfunc_zshapefunc2lp_7(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zshapefunc2lp_8(void* mp)
 {
 
@@ -2296,6 +2044,7 @@ static void* thfunc_zshapefunc2lp_8(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zshapefunc2lp_9(void* mp)
 {
 
@@ -2336,6 +2085,7 @@ static void* thfunc_zshapefunc2lp_9(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zshapefunc2lp_10(void* mp)
 {
 
@@ -2379,6 +2129,7 @@ static void* thfunc_zshapefunc2lp_10(void* mp)
  | Projection from LP basis representation to FEM-basis
 /+============================================================================*/
 
+ISA_CLONES
 static void* thfunc_dprjLP2FEM_ShapeFunc(void* mp)
 /* 
  * Pv : vector of size (elem_n+1)     
@@ -2474,13 +2225,6 @@ void pfem1d_XPrjL2F
 
 
         matlib_index i;
-        matlib_index nsdata[num_threads][2];
-
-        pthpool_arg_t   arg[num_threads];
-        pthpool_task_t  task[num_threads];
-
-        /* define the block of data per thread */ 
-        matlib_index Np = N/(num_threads);
         matlib_real tmp = 0;
 
         if(p>10)
@@ -2505,30 +2249,9 @@ void pfem1d_XPrjL2F
                                     };
             
 
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data    = shared_data; 
-                arg[i].nonshared_data = (void**)&nsdata[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)thfunc_dprjLP2FEM_ShapeFunc;
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            arg[i].nonshared_data = (void**)&nsdata[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function  = (void*)thfunc_dprjLP2FEM_ShapeFunc;
-            task[i].argument  = &arg[i];
-            
-
             debug_body("%s", "created task");
-            pthpool_exec_task(num_threads, mp, task);
+            pfem1d_for( N, shared_data, (void*)thfunc_dprjLP2FEM_ShapeFunc, 
+                        num_threads, mp);
             
             i = (p+1)*(N-1);
             *(Pvb.elem_p+N) = *(u.elem_p+i) + *(u.elem_p+i+1)/3;
@@ -2544,30 +2267,8 @@ void pfem1d_XPrjL2F
                                      (void*) (Pvb.elem_p+N+1)
                                     };
 
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data    = shared_data; 
-                arg[i].nonshared_data = (void**)&nsdata[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)fp[func_index];
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            arg[i].nonshared_data = (void**)&nsdata[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function  = (void*)fp[func_index];
-            task[i].argument  = &arg[i];
-            
-
             debug_body("%s", "created task");
-            pthpool_exec_task(num_threads, mp, task);
+            pfem1d_for( N, shared_data, (void*)fp[func_index], num_threads, mp);
             
             i = (p+1)*(N-1);
             *(Pvb.elem_p+N) = *(u.elem_p+i) + *(u.elem_p+i+1)/3;
@@ -2584,6 +2285,7 @@ void pfem1d_XPrjL2F
 
 }
 
+ISA_CLONES
 static void* thfunc_zprjLP2FEM_ShapeFunc(void* mp)
 /* 
  * Pv : vector of size (elem_n+1)     
@@ -2679,13 +2381,6 @@ void pfem1d_ZPrjL2F
 
 
         matlib_index i;
-        matlib_index nsdata[num_threads][2];
-
-        pthpool_arg_t   arg[num_threads];
-        pthpool_task_t  task[num_threads];
-
-        /* define the block of data per thread */ 
-        matlib_index Np = N/(num_threads);
         matlib_real tmp = 0;
 
         if(p>10)
@@ -2710,30 +2405,9 @@ void pfem1d_ZPrjL2F
                                     };
             
 
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data    = shared_data; 
-                arg[i].nonshared_data = (void**)&nsdata[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)thfunc_zprjLP2FEM_ShapeFunc;
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            arg[i].nonshared_data = (void**)&nsdata[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function  = (void*)thfunc_zprjLP2FEM_ShapeFunc;
-            task[i].argument  = &arg[i];
-            
-
             debug_body("%s", "created task");
-            pthpool_exec_task(num_threads, mp, task);
+            pfem1d_for( N, shared_data, (void*)thfunc_zprjLP2FEM_ShapeFunc, 
+                        num_threads, mp);
             
             i = (p+1)*(N-1);
             *(Pvb.elem_p+N) = *(u.elem_p+i) + *(u.elem_p+i+1)/3;
@@ -2749,30 +2423,8 @@ void pfem1d_ZPrjL2F
                                      (void*) (Pvb.elem_p+N+1)
                                     };
 
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data    = shared_data; 
-                arg[i].nonshared_data = (void**)&nsdata[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)fp[func_index];
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            arg[i].nonshared_data = (void**)&nsdata[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function  = (void*)fp[func_index];
-            task[i].argument  = &arg[i];
-            
-
             debug_body("%s", "created task");
-            pthpool_exec_task(num_threads, mp, task);
+            pfem1d_for( N, shared_data, (void*)fp[func_index], num_threads, mp);
             
             i = (p+1)*(N-1);
             *(Pvb.elem_p+N) = *(u.elem_p+i) + *(u.elem_p+i+1)/3;
@@ -2792,6 +2444,7 @@ void pfem1d_ZPrjL2F
 
  
 
+ISA_CLONES
 static void* thfunc_dprjLP2FEM_ShapeFunc_2(void* mp)
 {
     matlib_index i;
@@ -2831,6 +2484,7 @@ static void* thfunc_dprjLP2FEM_ShapeFunc_2(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dprjLP2FEM_ShapeFunc_3(void* mp)
 {
     matlib_index i;
@@ -2871,6 +2525,7 @@ static void* thfunc_dprjLP2FEM_ShapeFunc_3(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dprjLP2FEM_ShapeFunc_4(void* mp)
 {
     matlib_index i;
@@ -2912,6 +2567,7 @@ static void* thfunc_dprjLP2FEM_ShapeFunc_4(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dprjLP2FEM_ShapeFunc_5(void* mp)
 {
     matlib_index i;
@@ -2954,6 +2610,7 @@ static void* thfunc_dprjLP2FEM_ShapeFunc_5(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dprjLP2FEM_ShapeFunc_6(void* mp)
 {
     matlib_index i;
@@ -2997,6 +2654,7 @@ static void* thfunc_dprjLP2FEM_ShapeFunc_6(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dprjLP2FEM_ShapeFunc_7(void* mp)
 {
     matlib_index i;
@@ -3040,6 +2698,7 @@ static void* thfunc_dprjLP2FEM_ShapeFunc_7(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dprjLP2FEM_ShapeFunc_8(void* mp)
 {
     matlib_index i;
@@ -3084,6 +2743,7 @@ static void* thfunc_dprjLP2FEM_ShapeFunc_8(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dprjLP2FEM_ShapeFunc_9(void* mp)
 {
     matlib_index i;
@@ -3129,6 +2789,7 @@ static void* thfunc_dprjLP2FEM_ShapeFunc_9(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_dprjLP2FEM_ShapeFunc_10(void* mp)
 {
     matlib_index i;
@@ -3180,6 +2841,7 @@ static void* thfunc_dprjLP2FEM_ShapeFunc_10(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zprjLP2FEM_ShapeFunc_2(void* mp)
 {
     matlib_index i;
@@ -3220,6 +2882,7 @@ static void* thfunc_zprjLP2FEM_ShapeFunc_2(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zprjLP2FEM_ShapeFunc_3(void* mp)
 {
     matlib_index i;
@@ -3261,6 +2924,7 @@ static void* thfunc_zprjLP2FEM_ShapeFunc_3(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zprjLP2FEM_ShapeFunc_4(void* mp)
 {
     matlib_index i;
@@ -3303,6 +2967,7 @@ static void* thfunc_zprjLP2FEM_ShapeFunc_4(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zprjLP2FEM_ShapeFunc_5(void* mp)
 {
     matlib_index i;
@@ -3346,6 +3011,7 @@ static void* thfunc_zprjLP2FEM_ShapeFunc_5(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zprjLP2FEM_ShapeFunc_6(void* mp)
 {
     matlib_index i;
@@ -3390,6 +3056,7 @@ static void* thfunc_zprjLP2FEM_ShapeFunc_6(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zprjLP2FEM_ShapeFunc_7(void* mp)
 {
     matlib_index i;
@@ -3434,6 +3101,7 @@ static void* thfunc_zprjLP2FEM_ShapeFunc_7(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zprjLP2FEM_ShapeFunc_8(void* mp)
 {
     matlib_index i;
@@ -3479,6 +3147,7 @@ static void* thfunc_zprjLP2FEM_ShapeFunc_8(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zprjLP2FEM_ShapeFunc_9(void* mp)
 {
     matlib_index i;
@@ -3525,6 +3194,7 @@ static void* thfunc_zprjLP2FEM_ShapeFunc_9(void* mp)
 
  
 
+ISA_CLONES
 static void* thfunc_zprjLP2FEM_ShapeFunc_10(void* mp)
 {
     matlib_index i;
@@ -3572,1360 +3242,2392 @@ static void* thfunc_zprjLP2FEM_ShapeFunc_10(void* mp)
 }
  
 /*============================================================================+/
- | Norm using Parseval's theorem
+ | Batched transformations between Legendre basis and FEM-basis
 /+============================================================================*/
-static void* thfunc_dlp_snorm2_d(void* mp)
+
+/* Kernel of the batched transforms, see fem1d_zshapefunc2lp_nv */ 
+typedef void (*pfem1d_znv_kernel_t)( matlib_index, matlib_index, matlib_index,
+                                     matlib_index, matlib_index, 
+                                     matlib_complex*, matlib_complex* );
+
+static void* pfem1d_thfunc_znv(void* mp)
 {
     pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
 
-    matlib_real *u   = (matlib_real*) (ptr->shared_data[0]);
-    matlib_xv A = *(matlib_xv*) (ptr->shared_data[1]);
+    pfem1d_znv_kernel_t kernel = *((pfem1d_znv_kernel_t*) (ptr->shared_data[0]));
 
-    matlib_index i, j;
+    matlib_index p     = *((matlib_index*) (ptr->shared_data[1]));
+    matlib_index N     = *((matlib_index*) (ptr->shared_data[2]));
+    matlib_index k     = *((matlib_index*) (ptr->shared_data[3]));
+    matlib_complex* x  = (matlib_complex*) (ptr->shared_data[4]);
+    matlib_complex* y  = (matlib_complex*) (ptr->shared_data[5]);
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
     debug_body( "Thread id: %d, start_index: %d, end_index: %d",
                 ptr->thread_index, 
                 start_end_index[0], start_end_index[1]);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (A.len * start_end_index[0]);
+    (*kernel)(p, N, k, start_end_index[0], start_end_index[1], x, y);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
-    { 
-        (*snorm) += (*u**u*A.elem_p[0]); u++;
-        (*snorm) += (*u**u*A.elem_p[1]); u++;
-        (*snorm) += (*u**u*A.elem_p[2]); u++;
-        (*snorm) += (*u**u*A.elem_p[3]); u++;
-        (*snorm) += (*u**u*A.elem_p[4]); u++;
-        (*snorm) += (*u**u*A.elem_p[5]); u++;
-        (*snorm) += (*u**u*A.elem_p[6]); u++;
-        (*snorm) += (*u**u*A.elem_p[7]); u++;
-        (*snorm) += (*u**u*A.elem_p[8]); u++;
-        (*snorm) += (*u**u*A.elem_p[9]); u++;
-        (*snorm) += (*u**u*A.elem_p[10]); u++;
-        for( j=11; j < A.len; u++, j++)
-        {
-            (*snorm) += (*u**u*A.elem_p[j]);
-        }
-    }
-    debug_exit("Thread id: %d, snorm2: %0.16f", ptr->thread_index, *snorm);
+    debug_exit("Thread id: %d", ptr->thread_index);
 }
 
-matlib_real pfem1d_XNorm2
+static void pfem1d_exec_znv
 (
-    matlib_index    p,
-    matlib_index    N,
-    matlib_xv       u,
-    matlib_index    num_threads,
-    pthpool_data_t* mp
+    pfem1d_znv_kernel_t kernel,
+    matlib_index        p,
+    matlib_index        N,
+    matlib_index        k,
+    matlib_complex*     x,
+    matlib_complex*     y,
+    matlib_index        num_threads,
+    pthpool_data_t*     mp
 )
 {
-    debug_enter( "Highest degree of polynomial: %d "
-                 "nr. finite-elements : %d "
-                 "length of u: %d", p, N, u.len);
+    void* shared_data[6] = { (void*) &kernel,
+                             (void*) &p,
+                             (void*) &N,
+                             (void*) &k,
+                             (void*) x,
+                             (void*) y };
 
-    void* (*fp[9])(void*) = { thfunc_dlp_snorm2_d_2, 
-                              thfunc_dlp_snorm2_d_3, 
-                              thfunc_dlp_snorm2_d_4, 
-                              thfunc_dlp_snorm2_d_5, 
-                              thfunc_dlp_snorm2_d_6, 
-                              thfunc_dlp_snorm2_d_7, 
-                              thfunc_dlp_snorm2_d_8, 
-                              thfunc_dlp_snorm2_d_9, 
-                              thfunc_dlp_snorm2_d_10};
- 
-    matlib_real norm2 = 0;
-    assert(u.elem_p!=NULL);
-    if(u.len == (p+1)*N)
-    {
-        matlib_index i,j;
-        matlib_index nsdata[num_threads][2];
-        matlib_real snorm2[num_threads];
-        void* nonshared_data[num_threads][2];
+    debug_body("%s", "created task");
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_znv, num_threads, mp);
+}
 
-        pthpool_arg_t   arg[num_threads];
-        pthpool_task_t  task[num_threads];
+void pfem1d_ZF2L2
+(
+    const matlib_index    p, 
+    const matlib_zm       vb,
+          matlib_zm       u,
+          matlib_index    num_threads,
+          pthpool_data_t* mp
+)
+{
+    debug_enter( "highest polynomial degree: %d "
+                 "vb: %d-by-%d, u: %d-by-%d", 
+                 p, vb.lenc, vb.lenr, u.lenc, u.lenr );
 
-        /* define the block of data per thread */ 
-        matlib_index Np = N/(num_threads);
-        if(p>10)
-        {
-            matlib_xv A;
-            matlib_create_xv(p+1, &A, MATLIB_COL_VECT);
+    matlib_index N = (vb.lenc-1)/p;
+    debug_body( "nr finite elements: %d ", N);
 
-            for( j=0; j<A.len; j++)
-            {
-                A.elem_p[j] =  1.0/(j+0.5); 
-            }
+    assert((vb.elem_p != NULL) && (u.elem_p != NULL));
 
-            void* shared_data[2] = { (void*) u.elem_p,
-                                     (void*) &A };
-            
+    bool order_OK = (vb.order == MATLIB_ROW_MAJOR) && 
+                    (u.order  == MATLIB_ROW_MAJOR);
 
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data = shared_data; 
-
-                nonshared_data[i][0]  = (void*)nsdata[i];
-                nonshared_data[i][1]  = (void*)&snorm2[i];
-                arg[i].nonshared_data = (void**)&nonshared_data[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)thfunc_dlp_snorm2_d;
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            nonshared_data[i][0]  = (void*)nsdata[i];
-            nonshared_data[i][1]  = (void*)&snorm2[i];
-            arg[i].nonshared_data = (void**)&nonshared_data[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function = (void*)thfunc_dlp_snorm2_d;
-            task[i].argument = &arg[i];
-            
+    if(!order_OK)
+    {
+        term_exec( "Storage order of matrices incorrect: %s", "vb and u");
+    }
 
-            debug_body("%s", "created task");
+    if((u.lenc == vb.lenc+(N-1)) && (u.lenr == vb.lenr))
+    {
+        pfem1d_exec_znv( fem1d_zshapefunc2lp_nv, p, N, u.lenr, 
+                         vb.elem_p, u.elem_p, num_threads, mp);
+    }
+    else
+    {
+        term_execb( "size of matrices incorrect: "
+                    "vb: %d-by-%d, u: %d-by-%d",
+                    vb.lenc, vb.lenr, u.lenc, u.lenr );
+    }
 
-            pthpool_exec_task(num_threads, mp, task);
+    debug_exit("%s", "");
+}
 
-            matlib_free((void*)A.elem_p);
-        }
-        else
-        {
-            matlib_index func_index = p-2;
-            void* shared_data = (void*) u.elem_p;
-            
+void pfem1d_ZL2F2
+(
+    const matlib_index    p, 
+    const matlib_zm       u,
+          matlib_zm       vb,
+          matlib_index    num_threads,
+          pthpool_data_t* mp
+)
+{
+    debug_enter( "highest polynomial degree: %d "
+                 "u: %d-by-%d, vb: %d-by-%d", 
+                 p, u.lenc, u.lenr, vb.lenc, vb.lenr );
 
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data = shared_data; 
-
-                nonshared_data[i][0]  = (void*)nsdata[i];
-                nonshared_data[i][1]  = (void*)&snorm2[i];
-                arg[i].nonshared_data = (void**)&nonshared_data[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)fp[func_index];
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            nonshared_data[i][0]  = (void*)nsdata[i];
-            nonshared_data[i][1]  = (void*)&snorm2[i];
-            arg[i].nonshared_data = (void**)&nonshared_data[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function = (void*)fp[func_index];
-            task[i].argument = &arg[i];
-            
+    matlib_index N = u.lenc/(p+1);
+    debug_body( "nr finite elements: %d ", N);
 
-            debug_body("%s", "created task");
+    assert((vb.elem_p != NULL) && (u.elem_p != NULL));
 
-            pthpool_exec_task(num_threads, mp, task);
+    bool order_OK = (vb.order == MATLIB_ROW_MAJOR) && 
+                    (u.order  == MATLIB_ROW_MAJOR);
 
-        }
-        for(i=0; i<num_threads; i++)
-        {
-            norm2 += (snorm2[i]);
-        }
-        norm2 = sqrt(norm2);
-        
+    if(!order_OK)
+    {
+        term_exec( "Storage order of matrices incorrect: %s", "u and vb");
+    }
+
+    if((u.lenc == vb.lenc+(N-1)) && (u.lenr == vb.lenr))
+    {
+        pfem1d_exec_znv( lp2fem1d_zshapefunc_nv, p, N, u.lenr, 
+                         u.elem_p, vb.elem_p, num_threads, mp);
     }
     else
     {
-        term_execb( "length of vector incorrect: "
-                    "u: %d (degree : %d, nr. fem-elements: %d)",
-                    u.len, p, N);
+        term_execb( "size of matrices incorrect: "
+                    "u: %d-by-%d, vb: %d-by-%d",
+                    u.lenc, u.lenr, vb.lenc, vb.lenr );
     }
 
-    debug_exit("L2 norm: %0.16f", (norm2));
-    return(norm2);
+    debug_exit("%s", "");
+}
+
+void pfem1d_ZPrjL2F2
+(
+    const matlib_index    p, 
+    const matlib_zm       u,
+          matlib_zm       Pvb,
+          matlib_index    num_threads,
+          pthpool_data_t* mp
+)
+{
+    debug_enter( "highest polynomial degree: %d "
+                 "u: %d-by-%d, Pvb: %d-by-%d", 
+                 p, u.lenc, u.lenr, Pvb.lenc, Pvb.lenr );
+
+    matlib_index N = u.lenc/(p+1);
+    debug_body( "nr finite elements: %d ", N);
 
+    assert((u.elem_p != NULL) && (Pvb.elem_p != NULL));
+
+    bool order_OK = (Pvb.order == MATLIB_ROW_MAJOR) && 
+                    (u.order   == MATLIB_ROW_MAJOR);
+
+    if(!order_OK)
+    {
+        term_exec( "Storage order of matrices incorrect: %s", "u and Pvb");
+    }
+
+    if((u.lenc == Pvb.lenc+(N-1)) && (u.lenr == Pvb.lenr))
+    {
+        pfem1d_exec_znv( fem1d_zprjLP2FEM_ShapeFunc_nv, p, N, u.lenr, 
+                         u.elem_p, Pvb.elem_p, num_threads, mp);
+    }
+    else
+    {
+        term_execb( "size of matrices incorrect: "
+                    "u: %d-by-%d, Pvb: %d-by-%d",
+                    u.lenc, u.lenr, Pvb.lenc, Pvb.lenr );
+    }
+
+    debug_exit("%s", "");
 }
-/*============================================================================*/
 
-static void* thfunc_zlp_snorm2_d(void* mp)
+/*============================================================================+/
+ | Evaluation at arbitrary points
+ | The query points are split evenly between the threads.
+/+============================================================================*/
+static void* pfem1d_thfunc_XEval(void* mp)
 {
     pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
 
-    matlib_complex *u   = (matlib_complex*) (ptr->shared_data[0]);
-    matlib_xv A = *(matlib_xv*) (ptr->shared_data[1]);
+    matlib_index p   = *((matlib_index*) (ptr->shared_data[0]));
+    matlib_index N   = *((matlib_index*) (ptr->shared_data[1]));
+    matlib_real  x_l = *((matlib_real*)  (ptr->shared_data[2]));
+    matlib_real  x_r = *((matlib_real*)  (ptr->shared_data[3]));
+    matlib_real* U   = (matlib_real*) (ptr->shared_data[4]);
+    matlib_real* x   = (matlib_real*) (ptr->shared_data[5]);
+    matlib_real* u   = (matlib_real*) (ptr->shared_data[6]);
 
-    matlib_index i, j;
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
+                ptr->thread_index, 
+                start_end_index[0], start_end_index[1]);
+
+    fem1d_xclenshaw( p, N, x_l, x_r, U, 
+                     start_end_index[0], start_end_index[1], x, u);
+
+    debug_exit("Thread id: %d", ptr->thread_index);
+}
+
+static void* pfem1d_thfunc_ZEval(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+
+    matlib_index    p   = *((matlib_index*) (ptr->shared_data[0]));
+    matlib_index    N   = *((matlib_index*) (ptr->shared_data[1]));
+    matlib_real     x_l = *((matlib_real*)  (ptr->shared_data[2]));
+    matlib_real     x_r = *((matlib_real*)  (ptr->shared_data[3]));
+    matlib_complex* U   = (matlib_complex*) (ptr->shared_data[4]);
+    matlib_real*    x   = (matlib_real*)    (ptr->shared_data[5]);
+    matlib_complex* u   = (matlib_complex*) (ptr->shared_data[6]);
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
     debug_body( "Thread id: %d, start_index: %d, end_index: %d",
                 ptr->thread_index, 
                 start_end_index[0], start_end_index[1]);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (A.len * start_end_index[0]);
+    fem1d_zclenshaw( p, N, x_l, x_r, U, 
+                     start_end_index[0], start_end_index[1], x, u);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
-    { 
-        (*snorm) += (*u*conj(*u)*A.elem_p[0]); u++;
-        (*snorm) += (*u*conj(*u)*A.elem_p[1]); u++;
-        (*snorm) += (*u*conj(*u)*A.elem_p[2]); u++;
-        (*snorm) += (*u*conj(*u)*A.elem_p[3]); u++;
-        (*snorm) += (*u*conj(*u)*A.elem_p[4]); u++;
-        (*snorm) += (*u*conj(*u)*A.elem_p[5]); u++;
-        (*snorm) += (*u*conj(*u)*A.elem_p[6]); u++;
-        (*snorm) += (*u*conj(*u)*A.elem_p[7]); u++;
-        (*snorm) += (*u*conj(*u)*A.elem_p[8]); u++;
-        (*snorm) += (*u*conj(*u)*A.elem_p[9]); u++;
-        (*snorm) += (*u*conj(*u)*A.elem_p[10]); u++;
-        for( j=11; j < A.len; u++, j++)
-        {
-            (*snorm) += (*u*conj(*u)*A.elem_p[j]);
-        }
-    }
-    debug_exit("Thread id: %d, snorm2: %0.16f", ptr->thread_index, *snorm);
+    debug_exit("Thread id: %d", ptr->thread_index);
 }
 
-matlib_real pfem1d_ZNorm2
+static void pfem1d_exec_Eval
 (
+    void*           thfunc,
     matlib_index    p,
     matlib_index    N,
-    matlib_zv       u,
+    matlib_real     x_l,
+    matlib_real     x_r,
+    void*           U,
+    matlib_real*    x,
+    void*           u,
+    matlib_index    len,
     matlib_index    num_threads,
     pthpool_data_t* mp
 )
 {
-    debug_enter( "Highest degree of polynomial: %d "
-                 "nr. finite-elements : %d "
-                 "length of u: %d", p, N, u.len);
-
-    void* (*fp[9])(void*) = { thfunc_zlp_snorm2_d_2, 
-                              thfunc_zlp_snorm2_d_3, 
-                              thfunc_zlp_snorm2_d_4, 
-                              thfunc_zlp_snorm2_d_5, 
-                              thfunc_zlp_snorm2_d_6, 
-                              thfunc_zlp_snorm2_d_7, 
-                              thfunc_zlp_snorm2_d_8, 
-                              thfunc_zlp_snorm2_d_9, 
-                              thfunc_zlp_snorm2_d_10};
- 
-    matlib_real norm2 = 0;
-    assert(u.elem_p!=NULL);
-    if(u.len == (p+1)*N)
-    {
-        matlib_index i,j;
-        matlib_index nsdata[num_threads][2];
-        matlib_real snorm2[num_threads];
-        void* nonshared_data[num_threads][2];
-
-        pthpool_arg_t   arg[num_threads];
-        pthpool_task_t  task[num_threads];
-
-        /* define the block of data per thread */ 
-        matlib_index Np = N/(num_threads);
-        if(p>10)
-        {
-            matlib_xv A;
-            matlib_create_xv(p+1, &A, MATLIB_COL_VECT);
-
-            for( j=0; j<A.len; j++)
-            {
-                A.elem_p[j] =  1.0/(j+0.5); 
-            }
-
-            void* shared_data[2] = { (void*) u.elem_p,
-                                     (void*) &A };
-            
-
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data = shared_data; 
-
-                nonshared_data[i][0]  = (void*)nsdata[i];
-                nonshared_data[i][1]  = (void*)&snorm2[i];
-                arg[i].nonshared_data = (void**)&nonshared_data[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)thfunc_zlp_snorm2_d;
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            nonshared_data[i][0]  = (void*)nsdata[i];
-            nonshared_data[i][1]  = (void*)&snorm2[i];
-            arg[i].nonshared_data = (void**)&nonshared_data[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function = (void*)thfunc_zlp_snorm2_d;
-            task[i].argument = &arg[i];
-            
-
-            debug_body("%s", "created task");
-
-            pthpool_exec_task(num_threads, mp, task);
-
-            matlib_free((void*)A.elem_p);
+    void* shared_data[7] = { (void*) &p,
+                             (void*) &N,
+                             (void*) &x_l,
+                             (void*) &x_r,
+                             U,
+                             (void*) x,
+                             u };
 
-        }
-        else
-        {
-            matlib_index func_index = p-2;
-            void* shared_data = (void*) u.elem_p;
-            
+    debug_body("%s", "created task");
+    pfem1d_for( len, shared_data, (void*)thfunc, num_threads, mp);
+}
 
-            for(i=0; i<num_threads-1; i++)
-            {
-                nsdata[i][0] = i*Np;
-                nsdata[i][1] = (i+1)*Np;
-                arg[i].shared_data = shared_data; 
-
-                nonshared_data[i][0]  = (void*)nsdata[i];
-                nonshared_data[i][1]  = (void*)&snorm2[i];
-                arg[i].nonshared_data = (void**)&nonshared_data[i];
-                arg[i].thread_index   = i;
-                /* Define the task */ 
-                task[i].function  = (void*)fp[func_index];
-                task[i].argument  = &arg[i];
-                
-            }
-            nsdata[i][0] = i*Np;
-            nsdata[i][1] = N;
-            arg[i].shared_data    = shared_data; 
-            nonshared_data[i][0]  = (void*)nsdata[i];
-            nonshared_data[i][1]  = (void*)&snorm2[i];
-            arg[i].nonshared_data = (void**)&nonshared_data[i];
-            arg[i].thread_index   = i;
-            /* Define the task */ 
-            task[i].function = (void*)fp[func_index];
-            task[i].argument = &arg[i];
-            
+void pfem1d_XEval
+(
+    const matlib_index    p,
+    const matlib_real     x_l,
+    const matlib_real     x_r,
+    const matlib_xv       U,
+    const matlib_xv       x,
+          matlib_xv       u,
+          matlib_index    num_threads,
+          pthpool_data_t* mp
+)
+{
+    debug_enter( "highest polynomial degree: %d, "
+                 "length of vectors U: %d, x: %d, u: %d", 
+                 p, U.len, x.len, u.len );
 
-            debug_body("%s", "created task");
+    matlib_index N = U.len/(p+1);
+    assert((U.elem_p!=NULL) && (x.elem_p!=NULL) && (u.elem_p!=NULL));
 
-            pthpool_exec_task(num_threads, mp, task);
-        
-        }
-        for(i=0; i<num_threads; i++)
-        {
-            norm2 += (snorm2[i]);
-        }
-        norm2 = sqrt(norm2);
+    if((U.len == N*(p+1)) && (u.len == x.len) && (x_r>x_l))
+    {
+        pfem1d_exec_Eval( (void*)pfem1d_thfunc_XEval, p, N, x_l, x_r, 
+                          (void*)U.elem_p, x.elem_p, (void*)u.elem_p, 
+                          x.len, num_threads, mp);
     }
     else
     {
-        term_execb( "length of vector incorrect: "
-                    "u: %d (degree : %d, nr. fem-elements: %d)",
-                    u.len, p, N);
+        term_execb( "size of vectors or domain incorrect: "
+                    "U: %d, x: %d, u: %d, domain: [%0.16f, %0.16f]",
+                    U.len, x.len, u.len, x_l, x_r );
     }
-
-    debug_exit("L2 norm: %0.16f", (norm2));
-    return(norm2);
-
+    debug_exit("%s", "");
 }
-/*============================================================================*/
 
- 
-static void* thfunc_dlp_snorm2_d_2(void* mp)
+void pfem1d_ZEval
+(
+    const matlib_index    p,
+    const matlib_real     x_l,
+    const matlib_real     x_r,
+    const matlib_zv       U,
+    const matlib_xv       x,
+          matlib_zv       u,
+          matlib_index    num_threads,
+          pthpool_data_t* mp
+)
 {
-    matlib_real tmp;
-    matlib_index i;
+    debug_enter( "highest polynomial degree: %d, "
+                 "length of vectors U: %d, x: %d, u: %d", 
+                 p, U.len, x.len, u.len );
 
-    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
-
-    matlib_real *u   = (matlib_real*) (ptr->shared_data);
-
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
-
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (3 * start_end_index[0]);
+    matlib_index N = U.len/(p+1);
+    assert((U.elem_p!=NULL) && (x.elem_p!=NULL) && (u.elem_p!=NULL));
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
+    if((U.len == N*(p+1)) && (u.len == x.len) && (x_r>x_l))
+    {
+        pfem1d_exec_Eval( (void*)pfem1d_thfunc_ZEval, p, N, x_l, x_r, 
+                          (void*)U.elem_p, x.elem_p, (void*)u.elem_p, 
+                          x.len, num_threads, mp);
+    }
+    else
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2);
-        u += 3;
-        *snorm += tmp;
+        term_execb( "size of vectors or domain incorrect: "
+                    "U: %d, x: %d, u: %d, domain: [%0.16f, %0.16f]",
+                    U.len, x.len, u.len, x_l, x_r );
     }
+    debug_exit("%s", "");
 }
- 
- 
-static void* thfunc_dlp_snorm2_d_3(void* mp)
+
+/*============================================================================+/
+ | Norm using Parseval's theorem
+ | Each chunk of the reduction is one block of FEM1D_NORM_BLOCK elements and
+ | pthpool_for_xreduce sums the block partials with a fixed pairwise tree, so
+ | that the result does not depend on the number of threads.
+/+============================================================================*/
+static matlib_real pfem1d_thfunc_XNorm2(void* mp)
 {
-    matlib_real tmp;
-    matlib_index i;
     pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
 
-    matlib_real *u   = (matlib_real*) (ptr->shared_data);
+    matlib_index p = *((matlib_index*) (ptr->shared_data[0]));
+    matlib_index N = *((matlib_index*) (ptr->shared_data[1]));
+    matlib_real* u = (matlib_real*) (ptr->shared_data[2]);
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
     debug_body( "Thread id: %d, start_index: %d, end_index: %d",
                 ptr->thread_index, 
                 start_end_index[0], start_end_index[1]);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (4 * start_end_index[0]);
+    matlib_real snorm2;
+    fem1d_xlp_snorm2_b( p, N-start_end_index[0], 0, 1, 
+                        u+start_end_index[0]*(p+1), &snorm2);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
-    {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3);
-        u += 4;
-        *snorm += tmp;
-    }
+    return(snorm2);
 }
- 
- 
-static void* thfunc_dlp_snorm2_d_4(void* mp)
+
+static matlib_real pfem1d_thfunc_ZNorm2(void* mp)
 {
-    matlib_real tmp;
-    matlib_index i;
     pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
 
-    matlib_real *u   = (matlib_real*) (ptr->shared_data);
+    matlib_index    p = *((matlib_index*) (ptr->shared_data[0]));
+    matlib_index    N = *((matlib_index*) (ptr->shared_data[1]));
+    matlib_complex* u = (matlib_complex*) (ptr->shared_data[2]);
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
     debug_body( "Thread id: %d, start_index: %d, end_index: %d",
                 ptr->thread_index, 
                 start_end_index[0], start_end_index[1]);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (5 * start_end_index[0]);
+    matlib_real snorm2;
+    fem1d_zlp_snorm2_b( p, N-start_end_index[0], 0, 1, 
+                        u+start_end_index[0]*(p+1), &snorm2);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
-    {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4);
-        u += 5;
-        *snorm += tmp;
-    }
+    return(snorm2);
 }
- 
- 
-static void* thfunc_dlp_snorm2_d_5(void* mp)
+
+static matlib_real pfem1d_Norm2
+(
+    void*           thfunc,
+    matlib_index    p,
+    matlib_index    N,
+    void*           u,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+)
 {
-    matlib_real tmp;
-    matlib_index i;
+    void* shared_data[3] = { (void*) &p,
+                             (void*) &N,
+                             (void*) u };
+
+    debug_body("%s", "created task");
+    return(pthpool_for_xreduce( 0, N, PFEM1D_SCHED, FEM1D_NORM_BLOCK, 
+                                PTHPOOL_REDUCE_SUM, shared_data, thfunc, 
+                                num_threads, mp));
+}
+
+matlib_real pfem1d_XNorm2
+(
+    matlib_index    p,
+    matlib_index    N,
+    matlib_xv       u,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+)
+{
+    debug_enter( "Highest degree of polynomial: %d "
+                 "nr. finite-elements : %d "
+                 "length of u: %d", p, N, u.len);
+
+    matlib_real norm2 = 0;
+    assert(u.elem_p!=NULL);
+    if(u.len == (p+1)*N)
+    {
+        norm2 = sqrt(pfem1d_Norm2( (void*)pfem1d_thfunc_XNorm2, p, N, 
+                                   (void*)u.elem_p, num_threads, mp));
+    }
+    else
+    {
+        term_execb( "length of vector incorrect: "
+                    "u: %d (degree : %d, nr. fem-elements: %d)",
+                    u.len, p, N);
+    }
+
+    debug_exit("L2 norm: %0.16f", (norm2));
+    return(norm2);
+
+}
+
+matlib_real pfem1d_ZNorm2
+(
+    matlib_index    p,
+    matlib_index    N,
+    matlib_zv       u,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+)
+{
+    debug_enter( "Highest degree of polynomial: %d "
+                 "nr. finite-elements : %d "
+                 "length of u: %d", p, N, u.len);
+
+    matlib_real norm2 = 0;
+    assert(u.elem_p!=NULL);
+    if(u.len == (p+1)*N)
+    {
+        norm2 = sqrt(pfem1d_Norm2( (void*)pfem1d_thfunc_ZNorm2, p, N, 
+                                   (void*)u.elem_p, num_threads, mp));
+    }
+    else
+    {
+        term_execb( "length of vector incorrect: "
+                    "u: %d (degree : %d, nr. fem-elements: %d)",
+                    u.len, p, N);
+    }
+
+    debug_exit("L2 norm: %0.16f", (norm2));
+    return(norm2);
+
+}
+
+/*============================================================================+/
+ | Building Global Mass Matrix 
+/+============================================================================*/
+
+static void* pfem1d_thfunc_XCSRGMM2(void* mp)
+/* Real CSR - Assemble Global Mass Matrix*/ 
+{
+
     pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_index p = *((matlib_index*) (ptr->shared_data[0]));
+    matlib_index N = *((matlib_index*) (ptr->shared_data[1]));
+    matlib_xm q    =    *((matlib_xm*) (ptr->shared_data[2]));
+
+    matlib_xm_nsparse M = *((matlib_xm_nsparse*) (ptr->shared_data[3]));
+
+    debug_enter( "Thread id: %d, degree of polynomial: %d, "
+                 "Number of finite-elements: %d, "
+                 "length of q: %d-by-%d", 
+                 ptr->thread_index,
+                 p, N, q.lenc, q.lenr);
+
+   matlib_index nr_combi = q.lenc/N; 
+   debug_body("nr. of combinations of basis functions: %d", nr_combi);
+   
 
-    matlib_real *u   = (matlib_real*) (ptr->shared_data);
+    /* number of nonzero elements nnz = N*p*(p+3)/2+1;
+     * */
+    matlib_index s, i, l, l0, m, st;
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    
     debug_body( "Thread id: %d, start_index: %d, end_index: %d",
                 ptr->thread_index, 
                 start_end_index[0], start_end_index[1]);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (6 * start_end_index[0]);
+    q.elem_p += (q.lenc*start_end_index[0]);
+
+    matlib_real **ugpmm;
+
+    for( ugpmm = M.elem_p+start_end_index[0]; 
+         ugpmm < M.elem_p+start_end_index[1]; ugpmm++)
+    {
+        i = 0;
+        s = 0;
+        (*ugpmm)[s] = *(q.elem_p);
+        s++;
+    
+        (*ugpmm)[s] = *(q.elem_p+1);
+        s++;
+
+        matlib_index shiftq = 3;
+        
+        for (l=N+1; l<(N+p); l++)
+        {
+            (*ugpmm)[s] = (*(q.elem_p + shiftq));
+            shiftq ++;
+            s++;
+        }
+
+        l0 = N+1;
+        st = 0;
+        for( i=1; i<N; i++)
+        {
+            /* i-th row: start from the diagonal 
+             * (v_i,v_i)_{K_i} + (v_i,v_i)_{K_{i+1}}
+             * (v_i,v_{i+1})_{K_{i+1}}
+             * */ 
+            (*ugpmm)[s] = *(q.elem_p+st+2) + *(q.elem_p+st+nr_combi);
+            s++;
+            (*ugpmm)[s] = *(q.elem_p+st+nr_combi+1); 
+            s++;
+            /* v_i interacts with [b_i?], [b_{i+1,?}]
+             * (p-1) bubble functions in each element
+             */
+            shiftq = st+3+p-1;
+            for (l=l0; l<(l0+p-1); l++)
+            {
+                (*ugpmm)[s] = *(q.elem_p + shiftq);
+                shiftq ++;
+                s++;
+            }
+            l0 = l;
+
+            shiftq = st + nr_combi+3;
+            for (l=l0; l<(l0+p-1); l++)
+            {
+                (*ugpmm)[s] = *(q.elem_p+shiftq);
+                shiftq++;
+                s++;
+            
+            }
+            st = st+nr_combi;
+        }
+        /* last row: only the diagonal 
+         * (v_N,v_N)_{K_N}
+         * */ 
+        (*ugpmm)[s] = *(q.elem_p+st+2);
+        s++;
+        shiftq = st+3+(p-1);
+        for (l=l0; l<(l0+p-1); l++)
+        {
+            (*ugpmm)[s] = *(q.elem_p+shiftq);
+            shiftq++;
+            s++;
+        }       
+        i++;
+
+        /* vertex-vertex and vertex-bubble combinations are done
+         * do the bubble-bubble combination
+         * */ 
+        matlib_index shiftq0 = 3+2*(p-1);
+
+        for( st=0; st<N*nr_combi; st +=nr_combi)
+        {
+            shiftq = shiftq0;
+            for( l=0; l<p-1; l++)
+            {
+                for (m=i; m<(i+p-1-l); m++)
+                {
+                    (*ugpmm)[s] = *(q.elem_p+st+shiftq);
+                    shiftq++;
+                    s++;
+                }
+                i++;
+            }
+        }
+        q.elem_p += q.lenc;
+    }
+
+    debug_exit("%s", "");
+}
+
+void pfem1d_xm_nsparse_GMM
+/* Double - Assemble Global Mass Matrix*/ 
+(
+    matlib_index       p,
+    matlib_index       N,
+    matlib_xm          Q,
+    matlib_xm*         phi,
+    matlib_xm*         q,
+    matlib_xm_nsparse* M,
+    matlib_index       num_threads,
+    pthpool_data_t*    mp
+    
+)
+{
+    debug_enter( "poynomial degree: %d, "
+                 "nr. of fem-elements: %d, "
+                 "nr. of sparse matrices: %d, "
+                 "size of Q: %d-by-%d), ",
+                 p, N, M->nsparse, Q.lenc, Q.lenr);
+
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
+    assert(q->lenr==M->nsparse);
+
+    pfem1d_XFLT2( N, Q, *phi, *q, num_threads, mp);
+    if(M->nsparse<num_threads)
+    {
+        /* Too few matrices to keep the pool busy: assemble one matrix at a
+         * time split over the elements instead */ 
+        matlib_xv qk = { .len = q->lenc, .type = MATLIB_COL_VECT};
+        void* shared_data[6] = { (void*) &p,
+                                 (void*) &N,
+                                 (void*) &qk,
+                                 NULL,
+                                 NULL,
+                                 NULL };
+        for(matlib_index k=0; k<M->nsparse; k++)
+        {
+            qk.elem_p      = q->elem_p+k*q->lenc;
+            shared_data[5] = (void*) M->elem_p[k];
+            pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_XCSRGMM, 
+                        num_threads, mp);
+        }
+        debug_exit("%s", "");
+        return;
+    }
+    /* define the shared data */ 
+    void* shared_data[4] = { (void*) &p,
+                             (void*) &N,
+                             (void*) q,
+                             (void*) M };
+
+    debug_body("%s", "created task");
+    pfem1d_for( M->nsparse, shared_data, (void*)pfem1d_thfunc_XCSRGMM2, 
+                num_threads, mp);
+    
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+static void* pfem1d_thfunc_ZCSRGMM2(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_index p = *((matlib_index*) (ptr->shared_data[0]));
+    matlib_index N = *((matlib_index*) (ptr->shared_data[1]));
+    matlib_zm q    =    *((matlib_zm*) (ptr->shared_data[2]));
+
+    matlib_zm_nsparse M = *((matlib_zm_nsparse*) (ptr->shared_data[3]));
+
+    debug_enter( "Thread id: %d, degree of polynomial: %d, "
+                 "Number of finite-elements: %d, "
+                 "length of q: %d-by-%d", 
+                 ptr->thread_index,
+                 p, N, q.lenc, q.lenr);
+
+
+   matlib_index nr_combi = q.lenc/N; 
+   debug_body("nr. of combinations of basis functions: %d", nr_combi);
+   
+
+    /* number of nonzero elements nnz = N*p*(p+3)/2+1;
+     * */
+    matlib_index s, i, l, l0, m, st;
+
+    /* zero-th row 
+     *
+     * (v_0,v_0)_{K_1}
+     * (v_0,v_1)_{K_1}
+     * */ 
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    
+    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
+                ptr->thread_index, 
+                start_end_index[0], start_end_index[1]);
+
+    q.elem_p += (q.lenc*start_end_index[0]);
+
+    matlib_complex **ugpmm;
+
+    for( ugpmm = M.elem_p+start_end_index[0]; 
+         ugpmm < M.elem_p+start_end_index[1]; 
+         ugpmm++, (q.elem_p)+=q.lenc)
+    {
+        i = 0;
+        s = 0;
+        (*ugpmm)[s] = *(q.elem_p);
+        s++;
+    
+        (*ugpmm)[s] = *(q.elem_p+1);
+        s++;
+
+        matlib_index shiftq = 3;
+        
+        for (l=N+1; l<(N+p); l++)
+        {
+            (*ugpmm)[s] = (*(q.elem_p + shiftq));
+            shiftq ++;
+            s++;
+        }
+
+        l0 = N+1;
+        st = 0;
+        for( i=1; i<N; i++)
+        {
+            /* i-th row: start from the diagonal 
+             * (v_i,v_i)_{K_i} + (v_i,v_i)_{K_{i+1}}
+             * (v_i,v_{i+1})_{K_{i+1}}
+             * */ 
+            (*ugpmm)[s] = *(q.elem_p+st+2) + *(q.elem_p+st+nr_combi);
+            s++;
+            (*ugpmm)[s] = *(q.elem_p+st+nr_combi+1); 
+            s++;
+            /* v_i interacts with [b_i?], [b_{i+1,?}]
+             * (p-1) bubble functions in each element
+             */
+            shiftq = st+3+p-1;
+            for (l=l0; l<(l0+p-1); l++)
+            {
+                (*ugpmm)[s] = *(q.elem_p + shiftq);
+                shiftq ++;
+                s++;
+            }
+            l0 = l;
+
+            shiftq = st + nr_combi+3;
+            for (l=l0; l<(l0+p-1); l++)
+            {
+                (*ugpmm)[s] = *(q.elem_p+shiftq);
+                shiftq++;
+                s++;
+            
+            }
+            st = st+nr_combi;
+        }
+        /* last row: only the diagonal 
+         * (v_N,v_N)_{K_N}
+         * */ 
+        (*ugpmm)[s] = *(q.elem_p+st+2);
+        s++;
+        shiftq = st+3+(p-1);
+        for (l=l0; l<(l0+p-1); l++)
+        {
+            (*ugpmm)[s] = *(q.elem_p+shiftq);
+            shiftq++;
+            s++;
+        }
+        i++;
+
+        /* vertex-vertex and vertex-bubble combinations are done
+         * do the bubble-bubble combination
+         * */ 
+        matlib_index shiftq0 = 3+2*(p-1);
+
+        for( st=0; st<N*nr_combi; st +=nr_combi)
+        {
+            shiftq = shiftq0;
+            for( l=0; l<p-1; l++)
+            {
+                for (m=i; m<(i+p-1-l); m++)
+                {
+                    (*ugpmm)[s] = *(q.elem_p+st+shiftq);
+                    shiftq++;
+                    s++;
+                }
+                i++;
+            }
+        }
+    }
+
+    debug_exit("%s", "");
+}
+
+void pfem1d_zm_nsparse_GMM
+/* Double - Assemble Global Mass Matrix*/ 
+(
+    matlib_index       p,
+    matlib_index       N,
+    matlib_xm          Q,
+    matlib_zm*         phi,
+    matlib_zm*         q,
+    matlib_zm_nsparse* M,
+    matlib_index       num_threads,
+    pthpool_data_t*    mp
+    
+)
+{
+    debug_enter( "poynomial degree: %d, "
+                 "nr. of fem-elements: %d, "
+                 "nr. of sparse matrices: %d, "
+                 "size of Q: %d-by-%d), ",
+                 p, N, M->nsparse, Q.lenc, Q.lenr);
+
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
+    assert(q->lenr==M->nsparse);
+
+    pfem1d_ZFLT2( N, Q, *phi, *q, num_threads, mp);
+    if(M->nsparse<num_threads)
+    {
+        /* Too few matrices to keep the pool busy: assemble one matrix at a
+         * time split over the elements instead */ 
+        matlib_zv qk = { .len = q->lenc, .type = MATLIB_COL_VECT};
+        void* shared_data[6] = { (void*) &p,
+                                 (void*) &N,
+                                 (void*) &qk,
+                                 NULL,
+                                 NULL,
+                                 NULL };
+        for(matlib_index k=0; k<M->nsparse; k++)
+        {
+            qk.elem_p      = q->elem_p+k*q->lenc;
+            shared_data[5] = (void*) M->elem_p[k];
+            pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_ZCSRGMM, 
+                        num_threads, mp);
+        }
+        debug_exit("%s", "");
+        return;
+    }
+    /* define the shared data */ 
+    void* shared_data[4] = { (void*) &p,
+                             (void*) &N,
+                             (void*) q,
+                             (void*) M };
+
+
+    debug_body("%s", "created task");
+    pfem1d_for( M->nsparse, shared_data, (void*)pfem1d_thfunc_ZCSRGMM2, 
+                num_threads, mp);
+
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+static void pfem1d_XCSRGMM_range
+/* Real CSR - Assemble the rows owned by a range of elements */ 
+(
+    matlib_index  p,
+    matlib_index  N,
+    matlib_real*  q,
+    matlib_index  e0,
+    matlib_index  e1,
+    matlib_index* row,
+    matlib_index* col,
+    matlib_real*  ugpmm
+)
+/* 
+ * The elements e0,...,e1-1 own the rows of their left vertex and of their
+ * bubbles, the last element owns the row of the vertex N as well. Since
+ * the number of entries of each row is fixed (see fem1d_GMMSparsity) the
+ * offsets are known in advance and every row is written by exactly one
+ * thread. The values are summed in the same order as fem1d_XCSRGMM.
+ *
+ * row, col: NULL to write the values only
+ *
+ * */ 
+{
+    matlib_index nr_combi = (p-1)*(p+4)/2+3;
+    matlib_index nr_bb    = p*(p-1)/2; /* bubble-bubble entries per element */ 
+    matlib_index e, k, l, m, i, s, st, shiftq;
+    bool pattern = (row!=NULL);
+
+    for(e=e0; e<e1; e++)
+    {
+        if(e==0)
+        {
+            /* (v_0,v_0)_{K_1}, (v_0,v_1)_{K_1} */ 
+            s = 0;
+            if(pattern)
+            {
+                row[0] = s;
+                col[s] = 0;
+                col[s+1] = 1;
+                for(k=0; k<p-1; k++)
+                {
+                    col[s+2+k] = N+1+k;
+                }
+            }
+            ugpmm[s]   = q[0];
+            ugpmm[s+1] = q[1];
+            for(k=0; k<p-1; k++)
+            {
+                ugpmm[s+2+k] = q[3+k];
+            }
+        }
+        else
+        {
+            /* (v_e,v_e)_{K_e} + (v_e,v_e)_{K_{e+1}}, (v_e,v_{e+1})_{K_{e+1}}
+             * followed by the bubbles of K_e and K_{e+1}
+             * */ 
+            s  = p+1+(e-1)*2*p;
+            st = (e-1)*nr_combi;
+            i  = N+1+(e-1)*(p-1);
+            if(pattern)
+            {
+                row[e] = s;
+                col[s] = e;
+                col[s+1] = e+1;
+                for(k=0; k<2*(p-1); k++)
+                {
+                    col[s+2+k] = i+k;
+                }
+            }
+            ugpmm[s]   = q[st+2] + q[st+nr_combi];
+            ugpmm[s+1] = q[st+nr_combi+1];
+            for(k=0; k<p-1; k++)
+            {
+                ugpmm[s+2+k]       = q[st+3+p-1+k];
+                ugpmm[s+2+p-1+k]   = q[st+nr_combi+3+k];
+            }
+        }
+
+        /* bubble-bubble combinations */ 
+        s      = 2*p*N+1+e*nr_bb;
+        st     = e*nr_combi;
+        i      = N+1+e*(p-1);
+        shiftq = 3+2*(p-1);
+        for(l=0; l<p-1; l++)
+        {
+            if(pattern)
+            {
+                row[i] = s;
+            }
+            for (m=i; m<(i+p-1-l); m++)
+            {
+                if(pattern)
+                {
+                    col[s] = m;
+                }
+                ugpmm[s] = q[st+shiftq];
+                shiftq++;
+                s++;
+            }
+            i++;
+        }
+    }
+
+    if((e1==N) && (e0<e1))
+    {
+        /* last vertex: (v_N,v_N)_{K_N} and the bubbles of K_N */ 
+        s  = p+1+(N-1)*2*p;
+        st = (N-1)*nr_combi;
+        i  = N+1+(N-1)*(p-1);
+        if(pattern)
+        {
+            row[N] = s;
+            col[s] = N;
+            for(k=0; k<p-1; k++)
+            {
+                col[s+1+k] = i+k;
+            }
+            row[N*p+1] = N*p*(p+3)/2+1;
+        }
+        ugpmm[s] = q[st+2];
+        for(k=0; k<p-1; k++)
+        {
+            ugpmm[s+1+k] = q[st+3+p-1+k];
+        }
+    }
+}
+
+static void* pfem1d_thfunc_XCSRGMM(void* mp)
+/* Real CSR - Assemble Global Mass Matrix*/ 
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_index p = *((matlib_index*) (ptr->shared_data[0]));
+    matlib_index N = *((matlib_index*) (ptr->shared_data[1]));
+    matlib_xv q    =    *((matlib_xv*) (ptr->shared_data[2]));
+
+    matlib_index* row   = (matlib_index*) (ptr->shared_data[3]);
+    matlib_index* col   = (matlib_index*) (ptr->shared_data[4]);
+    matlib_real* ugpmm = (matlib_real*) (ptr->shared_data[5]);
+
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    
+    debug_enter( "Thread id: %d, start_index: %d, end_index: %d",
+                 ptr->thread_index, 
+                 start_end_index[0], start_end_index[1]);
+
+    pfem1d_XCSRGMM_range( p, N, q.elem_p, 
+                           start_end_index[0], start_end_index[1], 
+                           row, col, ugpmm);
+
+    debug_exit("%s", "");
+}
+
+void pfem1d_xm_sparse_GMM
+/* Real - Assemble Global Mass Matrix*/ 
+(
+    matlib_index      p,
+    matlib_xm         Q,
+    matlib_xv         phi,
+    matlib_xm_sparse* M,
+    matlib_index      num_threads,
+    pthpool_data_t*   mp
+)
+{
+    debug_enter( "poynomial degree: %d, "
+                 "size of Q: %d-by-%d), "
+                 "length of phi: %d",
+                 p, Q.lenc, Q.lenr, phi.len);
+
+    matlib_index N = (phi.len-1)/(Q.lenr-1);
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
+
+    matlib_index dim, nnz;
+    fem1d_GMMSize(p, N, &dim, &nnz);
+    debug_body( "nr. finite-elements: %d, "
+                "nr. of non-zero elements: %d", N, nnz);
+
+    M->lenc   = dim;
+    M->lenr   = dim;
+
+    errno = 0;
+    M->rowIn  = calloc( dim+1, sizeof(matlib_index));
+    M->colIn  = calloc(   nnz, sizeof(matlib_index));
+    M->elem_p = calloc(   nnz, sizeof(matlib_real));
+    if((M->rowIn==NULL) || (M->colIn==NULL) || (M->elem_p==NULL))
+    {
+        term_exec( "%s: initialization error: sparse matrix with %d entries", 
+                   strerror(errno), nnz);
+    }
+
+    matlib_xv q;
+    matlib_create_xv( Q.lenc*N, &q, MATLIB_COL_VECT);
+
+    pfem1d_XFLT( N, Q, phi, q, num_threads, mp);
+
+    void* shared_data[6] = { (void*) &p,
+                             (void*) &N,
+                             (void*) &q,
+                             (void*) M->rowIn,
+                             (void*) M->colIn,
+                             (void*) M->elem_p };
+
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_XCSRGMM, 
+                num_threads, mp);
+    
+    matlib_free(q.elem_p);
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+static void pfem1d_ZCSRGMM_range
+/* Complex CSR - Assemble the rows owned by a range of elements */ 
+(
+    matlib_index  p,
+    matlib_index  N,
+    matlib_complex*  q,
+    matlib_index  e0,
+    matlib_index  e1,
+    matlib_index* row,
+    matlib_index* col,
+    matlib_complex*  ugpmm
+)
+/* 
+ * The elements e0,...,e1-1 own the rows of their left vertex and of their
+ * bubbles, the last element owns the row of the vertex N as well. Since
+ * the number of entries of each row is fixed (see fem1d_GMMSparsity) the
+ * offsets are known in advance and every row is written by exactly one
+ * thread. The values are summed in the same order as fem1d_ZCSRGMM.
+ *
+ * row, col: NULL to write the values only
+ *
+ * */ 
+{
+    matlib_index nr_combi = (p-1)*(p+4)/2+3;
+    matlib_index nr_bb    = p*(p-1)/2; /* bubble-bubble entries per element */ 
+    matlib_index e, k, l, m, i, s, st, shiftq;
+    bool pattern = (row!=NULL);
+
+    for(e=e0; e<e1; e++)
+    {
+        if(e==0)
+        {
+            /* (v_0,v_0)_{K_1}, (v_0,v_1)_{K_1} */ 
+            s = 0;
+            if(pattern)
+            {
+                row[0] = s;
+                col[s] = 0;
+                col[s+1] = 1;
+                for(k=0; k<p-1; k++)
+                {
+                    col[s+2+k] = N+1+k;
+                }
+            }
+            ugpmm[s]   = q[0];
+            ugpmm[s+1] = q[1];
+            for(k=0; k<p-1; k++)
+            {
+                ugpmm[s+2+k] = q[3+k];
+            }
+        }
+        else
+        {
+            /* (v_e,v_e)_{K_e} + (v_e,v_e)_{K_{e+1}}, (v_e,v_{e+1})_{K_{e+1}}
+             * followed by the bubbles of K_e and K_{e+1}
+             * */ 
+            s  = p+1+(e-1)*2*p;
+            st = (e-1)*nr_combi;
+            i  = N+1+(e-1)*(p-1);
+            if(pattern)
+            {
+                row[e] = s;
+                col[s] = e;
+                col[s+1] = e+1;
+                for(k=0; k<2*(p-1); k++)
+                {
+                    col[s+2+k] = i+k;
+                }
+            }
+            ugpmm[s]   = q[st+2] + q[st+nr_combi];
+            ugpmm[s+1] = q[st+nr_combi+1];
+            for(k=0; k<p-1; k++)
+            {
+                ugpmm[s+2+k]       = q[st+3+p-1+k];
+                ugpmm[s+2+p-1+k]   = q[st+nr_combi+3+k];
+            }
+        }
+
+        /* bubble-bubble combinations */ 
+        s      = 2*p*N+1+e*nr_bb;
+        st     = e*nr_combi;
+        i      = N+1+e*(p-1);
+        shiftq = 3+2*(p-1);
+        for(l=0; l<p-1; l++)
+        {
+            if(pattern)
+            {
+                row[i] = s;
+            }
+            for (m=i; m<(i+p-1-l); m++)
+            {
+                if(pattern)
+                {
+                    col[s] = m;
+                }
+                ugpmm[s] = q[st+shiftq];
+                shiftq++;
+                s++;
+            }
+            i++;
+        }
+    }
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
+    if((e1==N) && (e0<e1))
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5);
-        u += 6;
-        *snorm += tmp;
+        /* last vertex: (v_N,v_N)_{K_N} and the bubbles of K_N */ 
+        s  = p+1+(N-1)*2*p;
+        st = (N-1)*nr_combi;
+        i  = N+1+(N-1)*(p-1);
+        if(pattern)
+        {
+            row[N] = s;
+            col[s] = N;
+            for(k=0; k<p-1; k++)
+            {
+                col[s+1+k] = i+k;
+            }
+            row[N*p+1] = N*p*(p+3)/2+1;
+        }
+        ugpmm[s] = q[st+2];
+        for(k=0; k<p-1; k++)
+        {
+            ugpmm[s+1+k] = q[st+3+p-1+k];
+        }
     }
 }
- 
- 
-static void* thfunc_dlp_snorm2_d_6(void* mp)
+
+static void* pfem1d_thfunc_ZCSRGMM(void* mp)
+/* Complex CSR - Assemble Global Mass Matrix*/ 
 {
-    matlib_real tmp;
-    matlib_index i;
     pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_index p = *((matlib_index*) (ptr->shared_data[0]));
+    matlib_index N = *((matlib_index*) (ptr->shared_data[1]));
+    matlib_zv q    =    *((matlib_zv*) (ptr->shared_data[2]));
 
-    matlib_real *u   = (matlib_real*) (ptr->shared_data);
+    matlib_index* row   = (matlib_index*) (ptr->shared_data[3]);
+    matlib_index* col   = (matlib_index*) (ptr->shared_data[4]);
+    matlib_complex* ugpmm = (matlib_complex*) (ptr->shared_data[5]);
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    
+    debug_enter( "Thread id: %d, start_index: %d, end_index: %d",
+                 ptr->thread_index, 
+                 start_end_index[0], start_end_index[1]);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (7 * start_end_index[0]);
+    pfem1d_ZCSRGMM_range( p, N, q.elem_p, 
+                           start_end_index[0], start_end_index[1], 
+                           row, col, ugpmm);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
-    {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5)
-        	+ _N6 * *(u+6) * *(u+6);
-        u += 7;
-        *snorm += tmp;
-    }
+    debug_exit("%s", "");
 }
- 
- 
-static void* thfunc_dlp_snorm2_d_7(void* mp)
+
+void pfem1d_zm_sparse_GMM
+/* Complex - Assemble Global Mass Matrix*/ 
+(
+    matlib_index      p,
+    matlib_xm         Q,
+    matlib_zv         phi,
+    matlib_zm_sparse* M,
+    matlib_index      num_threads,
+    pthpool_data_t*   mp
+)
 {
-    matlib_real tmp;
-    matlib_index i;
-    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    debug_enter( "poynomial degree: %d, "
+                 "size of Q: %d-by-%d), "
+                 "length of phi: %d",
+                 p, Q.lenc, Q.lenr, phi.len);
 
-    matlib_real *u   = (matlib_real*) (ptr->shared_data);
+    matlib_index N = (phi.len-1)/(Q.lenr-1);
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+    matlib_index dim, nnz;
+    fem1d_GMMSize(p, N, &dim, &nnz);
+    debug_body( "nr. finite-elements: %d, "
+                "nr. of non-zero elements: %d", N, nnz);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (8 * start_end_index[0]);
+    M->lenc   = dim;
+    M->lenr   = dim;
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
+    errno = 0;
+    M->rowIn  = calloc( dim+1, sizeof(matlib_index));
+    M->colIn  = calloc(   nnz, sizeof(matlib_index));
+    M->elem_p = calloc(   nnz, sizeof(matlib_complex));
+    if((M->rowIn==NULL) || (M->colIn==NULL) || (M->elem_p==NULL))
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5)
-        	+ _N6 * *(u+6) * *(u+6)
-        	+ _N7 * *(u+7) * *(u+7);
-        u += 8;
-        *snorm += tmp;
+        term_exec( "%s: initialization error: sparse matrix with %d entries", 
+                   strerror(errno), nnz);
     }
+
+    matlib_zv q;
+    matlib_create_zv( Q.lenc*N, &q, MATLIB_COL_VECT);
+
+    pfem1d_ZFLT( N, Q, phi, q, num_threads, mp);
+
+    void* shared_data[6] = { (void*) &p,
+                             (void*) &N,
+                             (void*) &q,
+                             (void*) M->rowIn,
+                             (void*) M->colIn,
+                             (void*) M->elem_p };
+
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_ZCSRGMM, 
+                num_threads, mp);
+    
+    matlib_free(q.elem_p);
+    debug_exit("%s", "");
 }
- 
- 
-static void* thfunc_dlp_snorm2_d_8(void* mp)
+
+void pfem1d_xm_sparse_GMM_exec
+/* Real - Assemble the Global Mass Matrix in place */ 
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_xv         phi,
+    matlib_xm_sparse* M,
+    matlib_index      num_threads,
+    pthpool_data_t*   mp
+)
+/* 
+ * The scatter map of the plan is not needed here: the rows are overwritten
+ * by their owners as in pfem1d_xm_sparse_GMM.
+ *
+ * */ 
 {
-    matlib_real tmp;
-    matlib_index i;
-    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    debug_enter( "size of Q: %d-by-%d), "
+                 "length of phi: %d",
+                 Q.lenc, Q.lenr, phi.len);
 
-    matlib_real *u   = (matlib_real*) (ptr->shared_data);
+    matlib_index p = plan->p;
+    matlib_index N = plan->N;
+    assert((phi.len-1)==N*(Q.lenr-1));
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+    pfem1d_XFLT( N, Q, phi, plan->xq, num_threads, mp);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (9 * start_end_index[0]);
+    void* shared_data[6] = { (void*) &p,
+                             (void*) &N,
+                             (void*) &(plan->xq),
+                             NULL,
+                             NULL,
+                             (void*) M->elem_p };
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
-    {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5)
-        	+ _N6 * *(u+6) * *(u+6)
-        	+ _N7 * *(u+7) * *(u+7)
-        	+ _N8 * *(u+8) * *(u+8);
-        u += 9;
-        *snorm += tmp;
-    }
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_XCSRGMM, 
+                num_threads, mp);
+
+    debug_exit("%s", "");
 }
- 
- 
-static void* thfunc_dlp_snorm2_d_9(void* mp)
+
+void pfem1d_zm_sparse_GMM_exec
+/* Complex - Assemble the Global Mass Matrix in place */ 
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_zv         phi,
+    matlib_zm_sparse* M,
+    matlib_index      num_threads,
+    pthpool_data_t*   mp
+)
+/* 
+ * The scatter map of the plan is not needed here: the rows are overwritten
+ * by their owners as in pfem1d_zm_sparse_GMM.
+ *
+ * */ 
 {
-    matlib_real tmp;
-    matlib_index i;
-    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    debug_enter( "size of Q: %d-by-%d), "
+                 "length of phi: %d",
+                 Q.lenc, Q.lenr, phi.len);
 
-    matlib_real *u   = (matlib_real*) (ptr->shared_data);
+    matlib_index p = plan->p;
+    matlib_index N = plan->N;
+    assert((phi.len-1)==N*(Q.lenr-1));
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+    pfem1d_ZFLT( N, Q, phi, plan->zq, num_threads, mp);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (10 * start_end_index[0]);
+    void* shared_data[6] = { (void*) &p,
+                             (void*) &N,
+                             (void*) &(plan->zq),
+                             NULL,
+                             NULL,
+                             (void*) M->elem_p };
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
-    {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5)
-        	+ _N6 * *(u+6) * *(u+6)
-        	+ _N7 * *(u+7) * *(u+7)
-        	+ _N8 * *(u+8) * *(u+8)
-        	+ _N9 * *(u+9) * *(u+9);
-        u += 10;
-        *snorm += tmp;
-    }
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_ZCSRGMM, 
+                num_threads, mp);
+
+    debug_exit("%s", "");
 }
- 
- 
-static void* thfunc_dlp_snorm2_d_10(void* mp)
+
+static void* pfem1d_thfunc_XZGMMq(void* mp)
+/* Inner products of c[0]+c[1]*phi from those of phi and of the constant */ 
 {
-    matlib_real tmp;
-    matlib_index i;
     pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_index    nr_combi = *((matlib_index*) (ptr->shared_data[0]));
+    matlib_real*    q1 = (matlib_real*)    (ptr->shared_data[1]);
+    matlib_complex* c  = (matlib_complex*) (ptr->shared_data[2]);
+    matlib_xv       xq = *((matlib_xv*) (ptr->shared_data[3]));
+    matlib_zv       zq = *((matlib_zv*) (ptr->shared_data[4]));
 
-    matlib_real *u   = (matlib_real*) (ptr->shared_data);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    
+    debug_enter( "Thread id: %d, start_index: %d, end_index: %d",
+                 ptr->thread_index, 
+                 start_end_index[0], start_end_index[1]);
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+    fem1d_GMM_combineq( nr_combi, q1, c, (c[1]==0)? NULL: xq.elem_p, 
+                        start_end_index[0], start_end_index[1], zq.elem_p);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (11 * start_end_index[0]);
+    debug_exit("%s", "");
+}
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
+void pfem1d_xzm_sparse_GMM_exec
+/* Complex - Assemble the Global Mass Matrix of a real potential in place */ 
+(
+    fem1d_GMM_plan_t* plan,
+    matlib_xm         Q,
+    matlib_xv         phi,
+    matlib_complex    c[2],
+    matlib_zm_sparse* M,
+    matlib_index      num_threads,
+    pthpool_data_t*   mp
+)
+/* 
+ * The real transform goes into the real workspace of the plan, the complex
+ * inner products are formed in its complex workspace, element by element,
+ * and scattered by the owners of the rows as in pfem1d_zm_sparse_GMM_exec.
+ * The result is identical to that of fem1d_xzm_sparse_GMM_exec.
+ *
+ * */ 
+{
+    debug_enter( "size of Q: %d-by-%d), "
+                 "length of phi: %d",
+                 Q.lenc, Q.lenr, phi.len);
+
+    matlib_index p = plan->p;
+    matlib_index N = plan->N;
+    matlib_index nr_combi = Q.lenc;
+    assert((phi.len-1)==N*(Q.lenr-1));
+
+    matlib_real q1[nr_combi];
+    fem1d_GMM_rowsumQ(Q, q1);
+
+    if(c[1]!=0)
     {
-        tmp = 	  _N0 * *(u+0) * *(u+0)
-        	+ _N1 * *(u+1) * *(u+1)
-        	+ _N2 * *(u+2) * *(u+2)
-        	+ _N3 * *(u+3) * *(u+3)
-        	+ _N4 * *(u+4) * *(u+4)
-        	+ _N5 * *(u+5) * *(u+5)
-        	+ _N6 * *(u+6) * *(u+6)
-        	+ _N7 * *(u+7) * *(u+7)
-        	+ _N8 * *(u+8) * *(u+8)
-        	+ _N9 * *(u+9) * *(u+9)
-        	+ _N10 * *(u+10) * *(u+10);
-        u += 11;
-        *snorm += tmp;
+        if(plan->xq.elem_p==NULL)
+        {
+            matlib_create_xv( nr_combi*N, &(plan->xq), MATLIB_COL_VECT);
+        }
+        pfem1d_XFLT( N, Q, phi, plan->xq, num_threads, mp);
     }
-}
- 
 
-/* COMPLEX VERSION */ 
+    void* shared_data0[5] = { (void*) &nr_combi,
+                              (void*) q1,
+                              (void*) c,
+                              (void*) &(plan->xq),
+                              (void*) &(plan->zq) };
 
- 
-static void* thfunc_zlp_snorm2_d_2(void* mp)
+    pfem1d_for( N, shared_data0, (void*)pfem1d_thfunc_XZGMMq, 
+                num_threads, mp);
+
+    void* shared_data[6] = { (void*) &p,
+                             (void*) &N,
+                             (void*) &(plan->zq),
+                             NULL,
+                             NULL,
+                             (void*) M->elem_p };
+
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_ZCSRGMM, 
+                num_threads, mp);
+
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+static void* pfem1d_thfunc_XGSMV(void* mp)
 {
-    matlib_real tmp;
-    matlib_index i;
     pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_index p = *((matlib_index*) (ptr->shared_data[0]));
+    matlib_index N = *((matlib_index*) (ptr->shared_data[1]));
+    matlib_xm    Q = *((matlib_xm*)    (ptr->shared_data[2]));
+    matlib_xv    phi = *((matlib_xv*) (ptr->shared_data[3]));
+    matlib_real  coeff = *((matlib_real*) (ptr->shared_data[4]));
+    matlib_xv    u = *((matlib_xv*) (ptr->shared_data[5]));
+    matlib_xv    v = *((matlib_xv*) (ptr->shared_data[6]));
 
-    matlib_complex *u = (matlib_complex*) (ptr->shared_data);
-
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    
+    debug_enter( "Thread id: %d, start_index: %d, end_index: %d",
+                 ptr->thread_index, 
+                 start_end_index[0], start_end_index[1]);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (3 * start_end_index[0]);
+    fem1d_XGSMV_range( p, N, Q, phi.elem_p, coeff, u.elem_p, v.elem_p,
+                        start_end_index[0], start_end_index[1]);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
-    {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2));
-        u += 3;
-        *snorm += tmp;
-    }
+    debug_exit("%s", "");
 }
- 
- 
-static void* thfunc_zlp_snorm2_d_3(void* mp)
+
+void pfem1d_XGSMV
+/* Real - Global Stiffness-Mass Matrix-Vector product */ 
+(
+    matlib_index    p,
+    matlib_xm       Q,
+    matlib_xv       phi,
+    matlib_real     coeff,
+    matlib_xv       u,
+    matlib_xv       v,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+)
+/* 
+ * Every thread writes the rows owned by its elements, see fem1d_XGSMV_range;
+ * the result is identical to fem1d_XGSMV.
+ *
+ * */ 
 {
-    matlib_real tmp;
-    matlib_index i;
-    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    debug_enter( "poynomial degree: %d, "
+                 "length of phi: %d, threads: %d",
+                 p, phi.len, num_threads);
 
-    matlib_complex *u = (matlib_complex*) (ptr->shared_data);
+    matlib_index N = (phi.len-1)/(Q.lenr-1);
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
+    assert((u.len==N*p+1) && (v.len==N*p+1));
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+    void* shared_data[7] = { (void*) &p,
+                             (void*) &N,
+                             (void*) &Q,
+                             (void*) &phi,
+                             (void*) &coeff,
+                             (void*) &u,
+                             (void*) &v };
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (4 * start_end_index[0]);
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_XGSMV, 
+                num_threads, mp);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
-    {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3));
-        u += 4;
-        *snorm += tmp;
-    }
+    debug_exit("%s", "");
 }
- 
- 
-static void* thfunc_zlp_snorm2_d_4(void* mp)
+
+/*============================================================================*/
+static void* pfem1d_thfunc_ZGSMV(void* mp)
 {
-    matlib_real tmp;
-    matlib_index i;
     pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_index p = *((matlib_index*) (ptr->shared_data[0]));
+    matlib_index N = *((matlib_index*) (ptr->shared_data[1]));
+    matlib_xm    Q = *((matlib_xm*)    (ptr->shared_data[2]));
+    matlib_zv    phi = *((matlib_zv*) (ptr->shared_data[3]));
+    matlib_complex  coeff = *((matlib_complex*) (ptr->shared_data[4]));
+    matlib_zv    u = *((matlib_zv*) (ptr->shared_data[5]));
+    matlib_zv    v = *((matlib_zv*) (ptr->shared_data[6]));
 
-    matlib_complex *u = (matlib_complex*) (ptr->shared_data);
-
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    
+    debug_enter( "Thread id: %d, start_index: %d, end_index: %d",
+                 ptr->thread_index, 
+                 start_end_index[0], start_end_index[1]);
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (5 * start_end_index[0]);
+    fem1d_ZGSMV_range( p, N, Q, phi.elem_p, coeff, u.elem_p, v.elem_p,
+                        start_end_index[0], start_end_index[1]);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
-    {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4));
-        u += 5;
-        *snorm += tmp;
-    }
+    debug_exit("%s", "");
 }
- 
- 
-static void* thfunc_zlp_snorm2_d_5(void* mp)
+
+void pfem1d_ZGSMV
+/* Complex - Global Stiffness-Mass Matrix-Vector product */ 
+(
+    matlib_index    p,
+    matlib_xm       Q,
+    matlib_zv       phi,
+    matlib_complex     coeff,
+    matlib_zv       u,
+    matlib_zv       v,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+)
+/* 
+ * Every thread writes the rows owned by its elements, see fem1d_ZGSMV_range;
+ * the result is identical to fem1d_ZGSMV.
+ *
+ * */ 
 {
-    matlib_real tmp;
-    matlib_index i;
-    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    debug_enter( "poynomial degree: %d, "
+                 "length of phi: %d, threads: %d",
+                 p, phi.len, num_threads);
 
-    matlib_complex *u = (matlib_complex*) (ptr->shared_data);
+    matlib_index N = (phi.len-1)/(Q.lenr-1);
+    assert(Q.lenc==(p-1)*(p+4)/2+3);
+    assert((u.len==N*p+1) && (v.len==N*p+1));
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+    void* shared_data[7] = { (void*) &p,
+                             (void*) &N,
+                             (void*) &Q,
+                             (void*) &phi,
+                             (void*) &coeff,
+                             (void*) &u,
+                             (void*) &v };
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (6 * start_end_index[0]);
+    pfem1d_for( N, shared_data, (void*)pfem1d_thfunc_ZGSMV, 
+                num_threads, mp);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
-    {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5));
-        u += 6;
-        *snorm += tmp;
-    }
+    debug_exit("%s", "");
 }
- 
- 
-static void* thfunc_zlp_snorm2_d_6(void* mp)
-{
-    matlib_real tmp;
-    matlib_index i;
-    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
 
-    matlib_complex *u = (matlib_complex*) (ptr->shared_data);
+/*============================================================================+/
+ | Symmetric CSR Matrix-Vector product
+ | The rows are split over the threads by the plan. A thread overwrites its
+ | rows of V and adds the transposed products that fall into the rows of
+ | other threads to its private buffer, which it zeroes over the range of
+ | columns its rows reach; every thread then adds the buffers of the others
+ | to its rows, a block of rows at a time and in the order of the threads.
+ | No entry is written by two threads. The ranges and the buffers only
+ | depend on the pattern of A, hence the plan is created once and reused.
+/+============================================================================*/
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+/* Rows of V summed at a time, so that the block stays in cache while the
+ * buffers of all threads are added to it */ 
+#define PFEM1D_CSRSYM_BLOCK 512
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (7 * start_end_index[0]);
+static void pfem1d_csrsym_range
+(
+    matlib_index* rowIn,
+    matlib_index* colIn,
+    matlib_index  r0,
+    matlib_index  r1,
+    matlib_index* range
+)
+/* 
+ * range: columns [range[0], range[1]) reached by the rows [r0, r1), the
+ *        column indices of a row being sorted
+ *
+ * */ 
+{
+    range[0] = MATLIB_INDEX_MAX;
+    range[1] = 0;
+    for(matlib_index i=r0; i<r1; i++)
+    {
+        if(rowIn[i+1]>rowIn[i])
+        {
+            if(colIn[rowIn[i]]<range[0])
+            {
+                range[0] = colIn[rowIn[i]];
+            }
+            if(colIn[rowIn[i+1]-1]+1>range[1])
+            {
+                range[1] = colIn[rowIn[i+1]-1]+1;
+            }
+        }
+    }
+    if(range[1]==0)
+    {
+        range[0] = 0;
+    }
+}
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
+static void pfem1d_csrsym_plan_init
+(
+    matlib_index          dim,
+    matlib_index*         rowIn,
+    matlib_index*         colIn,
+    matlib_index          nrhs,
+    matlib_index          num_threads,
+    pfem1d_csrsym_plan_t* plan
+)
+{
+    matlib_index t;
+    plan->dim        = dim;
+    plan->nrhs       = nrhs;
+    plan->xw         = NULL;
+    plan->zw         = NULL;
+    plan->range      = calloc(2*num_threads, sizeof(matlib_index));
+    plan->part.start = calloc(num_threads+1, sizeof(matlib_index));
+    if((plan->range==NULL) || (plan->part.start==NULL))
+    {
+        term_exec("%s", "memory allocation failed");
+    }
+    pthpool_partition_split(dim, num_threads, &(plan->part));
+    for(t=0; t<num_threads; t++)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5))
-        	+ _N6 * *(u+6) * conj(*(u+6));
-        u += 7;
-        *snorm += tmp;
+        pfem1d_csrsym_range( rowIn, colIn, plan->part.start[t], 
+                             plan->part.start[t+1], plan->range+2*t);
     }
 }
- 
- 
-static void* thfunc_zlp_snorm2_d_7(void* mp)
+
+void pfem1d_xcsrsym_plan
+(
+    matlib_xm_sparse      A, 
+    matlib_index          nrhs,
+    matlib_index          num_threads,
+    pfem1d_csrsym_plan_t* plan
+)
+/* 
+ * The buffers take num_threads*A.lenc*nrhs entries.
+ *
+ * */ 
 {
-    matlib_real tmp;
-    matlib_index i;
-    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
-
-    matlib_complex *u = (matlib_complex*) (ptr->shared_data);
+    debug_enter( "size of A: %d-by-%d, nr. of vectors: %d, threads: %d",
+                 A.lenc, A.lenr, nrhs, num_threads);
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+    pfem1d_csrsym_plan_init(A.lenc, A.rowIn, A.colIn, nrhs, num_threads, plan);
+    errno = 0;
+    plan->xw = malloc(num_threads*A.lenc*nrhs*sizeof(matlib_real));
+    if(plan->xw==NULL)
+    {
+        term_exec( "%s: initialization error: %d buffers of length %d", 
+                   strerror(errno), num_threads, A.lenc*nrhs);
+    }
+    debug_exit("%s", "");
+}
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (8 * start_end_index[0]);
+void pfem1d_zcsrsym_plan
+(
+    matlib_zm_sparse      A, 
+    matlib_index          nrhs,
+    matlib_index          num_threads,
+    pfem1d_csrsym_plan_t* plan
+)
+{
+    debug_enter( "size of A: %d-by-%d, nr. of vectors: %d, threads: %d",
+                 A.lenc, A.lenr, nrhs, num_threads);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
+    pfem1d_csrsym_plan_init(A.lenc, A.rowIn, A.colIn, nrhs, num_threads, plan);
+    errno = 0;
+    plan->zw = malloc(num_threads*A.lenc*nrhs*sizeof(matlib_complex));
+    if(plan->zw==NULL)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5))
-        	+ _N6 * *(u+6) * conj(*(u+6))
-        	+ _N7 * *(u+7) * conj(*(u+7));
-        u += 8;
-        *snorm += tmp;
+        term_exec( "%s: initialization error: %d buffers of length %d", 
+                   strerror(errno), num_threads, A.lenc*nrhs);
     }
+    debug_exit("%s", "");
 }
- 
- 
-static void* thfunc_zlp_snorm2_d_8(void* mp)
-{
-    matlib_real tmp;
-    matlib_index i;
-    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
 
-    matlib_complex *u = (matlib_complex*) (ptr->shared_data);
+void pfem1d_csrsym_plan_free(pfem1d_csrsym_plan_t* plan)
+{
+    matlib_free(plan->range);
+    matlib_free(plan->part.start);
+    matlib_free(plan->xw);
+    matlib_free(plan->zw);
+    plan->range      = NULL;
+    plan->part.start = NULL;
+    plan->xw         = NULL;
+    plan->zw         = NULL;
+}
 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+ISA_CLONES
+static void pfem1d_csrsym_add
+(
+    matlib_index       n,
+    const matlib_real* w,
+          matlib_real* v
+)
+/* v <-- v + w over n entries; a complex block is added as 2n reals */ 
+{
+    for(matlib_index i=0; i<n; i++)
+    {
+        v[i] += w[i];
+    }
+}
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (9 * start_end_index[0]);
+static void pfem1d_csrsym_sum
+(
+    const pfem1d_csrsym_plan_t* plan,
+          matlib_index          nrhs,
+          matlib_index          s,
+          matlib_real*          w,
+          matlib_real*          v,
+          matlib_index          width
+)
+/* 
+ * Adds the buffers of the threads other than s to the rows of thread s;
+ * width is the number of reals per entry (2 for complex).
+ *
+ * */ 
+{
+    matlib_index k, t, b, b1, i0, i1;
+    matlib_index dim = plan->dim, r1 = plan->part.start[s+1];
+    const matlib_index* range = plan->range;
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
+    for(k=0; k<nrhs; k++)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5))
-        	+ _N6 * *(u+6) * conj(*(u+6))
-        	+ _N7 * *(u+7) * conj(*(u+7))
-        	+ _N8 * *(u+8) * conj(*(u+8));
-        u += 9;
-        *snorm += tmp;
+        for(b=plan->part.start[s]; b<r1; b=b1)
+        {
+            b1 = (b+PFEM1D_CSRSYM_BLOCK<r1)? b+PFEM1D_CSRSYM_BLOCK: r1;
+            for(t=0; t<plan->part.num_threads; t++)
+            {
+                i0 = (range[2*t]>b)?    range[2*t]  : b;
+                i1 = (range[2*t+1]<b1)? range[2*t+1]: b1;
+                if((t!=s) && (i0<i1))
+                {
+                    pfem1d_csrsym_add( (i1-i0)*width, 
+                                       w+((t*plan->nrhs+k)*dim+i0)*width,
+                                       v+(k*dim+i0)*width);
+                }
+            }
+        }
     }
 }
- 
- 
-static void* thfunc_zlp_snorm2_d_9(void* mp)
+
+static void* pfem1d_thfunc_XCSRSYMV(void* mp)
 {
-    matlib_real tmp;
-    matlib_index i;
     pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_xm_sparse A = *((matlib_xm_sparse*) (ptr->shared_data[0]));
+    matlib_xm    U     = *((matlib_xm*)        (ptr->shared_data[1]));
+    matlib_xm    V     = *((matlib_xm*)        (ptr->shared_data[2]));
+    pfem1d_csrsym_plan_t* plan = (pfem1d_csrsym_plan_t*) (ptr->shared_data[3]);
+    MATLIB_UPLO  uplo_enum = *((MATLIB_UPLO*)      (ptr->shared_data[4]));
 
-    matlib_complex *u = (matlib_complex*) (ptr->shared_data);
-
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
-
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (10 * start_end_index[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    
+    debug_enter( "Thread id: %d, start_index: %d, end_index: %d",
+                 ptr->thread_index, 
+                 start_end_index[0], start_end_index[1]);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
+    matlib_index k, t = ptr->thread_index, dim = A.lenc;
+    matlib_index* range = plan->range+2*t;
+    matlib_real*  w     = plan->xw+t*dim*plan->nrhs;
+    for(k=0; k<U.lenr; k++)
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5))
-        	+ _N6 * *(u+6) * conj(*(u+6))
-        	+ _N7 * *(u+7) * conj(*(u+7))
-        	+ _N8 * *(u+8) * conj(*(u+8))
-        	+ _N9 * *(u+9) * conj(*(u+9));
-        u += 10;
-        *snorm += tmp;
+        memset(w+k*dim+range[0], 0, (range[1]-range[0])*sizeof(matlib_real));
     }
+    matlib_xcsrsymv_range( uplo_enum, A, U.lenr, U.elem_p, V.elem_p, w, 
+                           start_end_index[0], start_end_index[1]);
+
+    debug_exit("%s", "");
+    return NULL;
 }
- 
- 
-static void* thfunc_zlp_snorm2_d_10(void* mp)
+
+static void* pfem1d_thfunc_XCSRSYMV_sum(void* mp)
 {
-    matlib_real tmp;
-    matlib_index i;
     pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_xm    U     = *((matlib_xm*)        (ptr->shared_data[1]));
+    matlib_xm    V     = *((matlib_xm*)        (ptr->shared_data[2]));
+    pfem1d_csrsym_plan_t* plan = (pfem1d_csrsym_plan_t*) (ptr->shared_data[3]);
 
-    matlib_complex *u = (matlib_complex*) (ptr->shared_data);
-
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data[0]);
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+    pfem1d_csrsym_sum(plan, U.lenr, ptr->thread_index, plan->xw, V.elem_p, 1);
+    return NULL;
+}
 
-    matlib_real* snorm   = (matlib_real*) (ptr->nonshared_data[1]);
-    u += (11 * start_end_index[0]);
+void pfem1d_xcsrsymm_exec
+/* Double CSR Symmetric Matrix-Matrix */ 
+(
+    pfem1d_csrsym_plan_t*  plan,
+    const MATLIB_UPLO      uplo_enum,
+          matlib_xm_sparse A, 
+    const matlib_xm        U,
+          matlib_xm        V,
+          pthpool_data_t*  mp
+)
+/* 
+ * V <-- A * U for the columns of the column major matrices U and V, A holds
+ * one triangle of a symmetric matrix (see matlib_xcsrsymv_range) with the
+ * pattern the plan was created for, U has at most plan->nrhs columns.
+ *
+ * */ 
+{
+    debug_enter( "size of A: %d-by-%d, nr. of vectors: %d, threads: %d",
+                 A.lenc, A.lenr, U.lenr, plan->part.num_threads);
 
-    *snorm = 0;
-    for (i=start_end_index[0]; i<start_end_index[1]; i++)
+    assert((U.order == MATLIB_COL_MAJOR) && (V.order == MATLIB_COL_MAJOR));
+    assert((U.lenc == A.lenc) && (V.lenc == A.lenc) && (U.lenr == V.lenr));
+    assert((plan->dim == A.lenc) && (U.lenr <= plan->nrhs) && (plan->xw != NULL));
+    if ((uplo_enum != MATLIB_UPPER) && (uplo_enum != MATLIB_LOWER))
     {
-        tmp = 	  _N0 * *(u+0) * conj(*(u+0))
-        	+ _N1 * *(u+1) * conj(*(u+1))
-        	+ _N2 * *(u+2) * conj(*(u+2))
-        	+ _N3 * *(u+3) * conj(*(u+3))
-        	+ _N4 * *(u+4) * conj(*(u+4))
-        	+ _N5 * *(u+5) * conj(*(u+5))
-        	+ _N6 * *(u+6) * conj(*(u+6))
-        	+ _N7 * *(u+7) * conj(*(u+7))
-        	+ _N8 * *(u+8) * conj(*(u+8))
-        	+ _N9 * *(u+9) * conj(*(u+9))
-        	+ _N10 * *(u+10) * conj(*(u+10));
-        u += 11;
-        *snorm += tmp;
+        term_execb("unknown upper/lower part (uplo_enum: %d)", uplo_enum);
     }
-}
- 
-/*============================================================================+/
- | Building Global Mass Matrix 
-/+============================================================================*/
 
-static void* pfem1d_thfunc_XCSRGMM2(void* mp)
-/* Real CSR - Assemble Global Mass Matrix*/ 
-{
+    void* shared_data[5] = { (void*) &A,
+                             (void*) &U,
+                             (void*) &V,
+                             (void*) plan,
+                             (void*) &uplo_enum };
 
-    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
-    matlib_index p = *((matlib_index*) (ptr->shared_data[0]));
-    matlib_index N = *((matlib_index*) (ptr->shared_data[1]));
-    matlib_xm q    =    *((matlib_xm*) (ptr->shared_data[2]));
+    pthpool_for_partition( &(plan->part), shared_data, 
+                           (void*)pfem1d_thfunc_XCSRSYMV, mp);
+    pthpool_for_partition( &(plan->part), shared_data, 
+                           (void*)pfem1d_thfunc_XCSRSYMV_sum, mp);
 
-    matlib_xm_nsparse M = *((matlib_xm_nsparse*) (ptr->shared_data[3]));
+    debug_exit("%s", "");
+}
 
-    debug_enter( "Thread id: %d, degree of polynomial: %d, "
-                 "Number of finite-elements: %d, "
-                 "length of q: %d-by-%d", 
-                 ptr->thread_index,
-                 p, N, q.lenc, q.lenr);
+void pfem1d_xcsrsymm
+/* Double CSR Symmetric Matrix-Matrix */ 
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_xm_sparse A, 
+    const matlib_xm        U,
+          matlib_xm        V,
+          matlib_index     num_threads,
+          pthpool_data_t*  mp
+)
+/* 
+ * One product with a plan of its own; repeated products with the same
+ * pattern should keep a plan (see pfem1d_xcsrsym_plan).
+ *
+ * */ 
+{
+    pfem1d_csrsym_plan_t plan;
+    pfem1d_xcsrsym_plan(A, U.lenr, num_threads, &plan);
+    pfem1d_xcsrsymm_exec(&plan, uplo_enum, A, U, V, mp);
+    pfem1d_csrsym_plan_free(&plan);
+}
 
-   matlib_index nr_combi = q.lenc/N; 
-   debug_body("nr. of combinations of basis functions: %d", nr_combi);
-   
+void pfem1d_xcsrsymv
+/* Double CSR Symmetric Matrix-Vector */ 
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_xm_sparse A, 
+    const matlib_xv        u,
+          matlib_xv        v,
+          matlib_index     num_threads,
+          pthpool_data_t*  mp
+)
+{
+    matlib_xm U = { .lenc = u.len, .lenr = 1, .order = MATLIB_COL_MAJOR, 
+                    .op = MATLIB_NO_TRANS, .elem_p = u.elem_p};
+    matlib_xm V = { .lenc = v.len, .lenr = 1, .order = MATLIB_COL_MAJOR, 
+                    .op = MATLIB_NO_TRANS, .elem_p = v.elem_p};
+    pfem1d_xcsrsymm(uplo_enum, A, U, V, num_threads, mp);
+}
 
-    /* number of nonzero elements nnz = N*p*(p+3)/2+1;
-     * */
-    matlib_index s, i, l, l0, m, st;
+static void* pfem1d_thfunc_ZCSRSYMV(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_zm_sparse A = *((matlib_zm_sparse*) (ptr->shared_data[0]));
+    matlib_zm    U     = *((matlib_zm*)        (ptr->shared_data[1]));
+    matlib_zm    V     = *((matlib_zm*)        (ptr->shared_data[2]));
+    pfem1d_csrsym_plan_t* plan = (pfem1d_csrsym_plan_t*) (ptr->shared_data[3]);
+    MATLIB_UPLO  uplo_enum = *((MATLIB_UPLO*)      (ptr->shared_data[4]));
 
-    i = 0;
-    s = 0;
-    
     matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
     
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
-
-    q.elem_p += (q.lenc*start_end_index[0]);
+    debug_enter( "Thread id: %d, start_index: %d, end_index: %d",
+                 ptr->thread_index, 
+                 start_end_index[0], start_end_index[1]);
 
-    matlib_real **ugpmm;
-
-    for( ugpmm = M.elem_p+start_end_index[0]; 
-         ugpmm < M.elem_p+start_end_index[1]; ugpmm++)
+    matlib_index k, t = ptr->thread_index, dim = A.lenc;
+    matlib_index*   range = plan->range+2*t;
+    matlib_complex* w     = plan->zw+t*dim*plan->nrhs;
+    for(k=0; k<U.lenr; k++)
     {
-        (*ugpmm)[s] = *(q.elem_p);
-        s++;
-    
-        (*ugpmm)[s] = *(q.elem_p+1);
-        s++;
+        memset(w+k*dim+range[0], 0, (range[1]-range[0])*sizeof(matlib_complex));
+    }
+    matlib_zcsrsymv_range( uplo_enum, A, U.lenr, U.elem_p, V.elem_p, w, 
+                           start_end_index[0], start_end_index[1]);
 
-        matlib_index shiftq = 3;
-        
-        for (l=N+1; l<(N+p); l++)
-        {
-            (*ugpmm)[s] = (*(q.elem_p + shiftq));
-            shiftq ++;
-            s++;
-        }
+    debug_exit("%s", "");
+    return NULL;
+}
 
-        l0 = N+1;
-        st = 0;
-        for( i=1; i<N; i++)
-        {
-            /* i-th row: start from the diagonal 
-             * (v_i,v_i)_{K_i} + (v_i,v_i)_{K_{i+1}}
-             * (v_i,v_{i+1})_{K_{i+1}}
-             * */ 
-            (*ugpmm)[s] = *(q.elem_p+st+2) + *(q.elem_p+st+nr_combi);
-            s++;
-            (*ugpmm)[s] = *(q.elem_p+st+nr_combi+1); 
-            s++;
-            /* v_i interacts with [b_i?], [b_{i+1,?}]
-             * (p-1) bubble functions in each element
-             */
-            shiftq = st+3+p-1;
-            for (l=l0; l<(l0+p-1); l++)
-            {
-                (*ugpmm)[s] = *(q.elem_p + shiftq);
-                shiftq ++;
-                s++;
-            }
-            l0 = l;
+static void* pfem1d_thfunc_ZCSRSYMV_sum(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_zm    U     = *((matlib_zm*)        (ptr->shared_data[1]));
+    matlib_zm    V     = *((matlib_zm*)        (ptr->shared_data[2]));
+    pfem1d_csrsym_plan_t* plan = (pfem1d_csrsym_plan_t*) (ptr->shared_data[3]);
 
-            shiftq = st + nr_combi+3;
-            for (l=l0; l<(l0+p-1); l++)
-            {
-                (*ugpmm)[s] = *(q.elem_p+shiftq);
-                shiftq++;
-                s++;
-            
-            }
-            st = st+nr_combi;
-        }
-        /* last row: only the diagonal 
-         * (v_N,v_N)_{K_N}
-         * */ 
-        (*ugpmm)[s] = *(q.elem_p+st+2);
-        s++;
-        shiftq = st+3+(p-1);
-        for (l=l0; l<(l0+p-1); l++)
-        {
-            (*ugpmm)[s] = *(q.elem_p+shiftq);
-            shiftq++;
-            s++;
-        }       
-        i++;
+    pfem1d_csrsym_sum( plan, U.lenr, ptr->thread_index, 
+                       (matlib_real*)plan->zw, (matlib_real*)V.elem_p, 2);
+    return NULL;
+}
 
-        /* vertex-vertex and vertex-bubble combinations are done
-         * do the bubble-bubble combination
-         * */ 
-        matlib_index shiftq0 = 3+2*(p-1);
+void pfem1d_zcsrsymm_exec
+/* Complex CSR Symmetric Matrix-Matrix */ 
+(
+    pfem1d_csrsym_plan_t*  plan,
+    const MATLIB_UPLO      uplo_enum,
+          matlib_zm_sparse A, 
+    const matlib_zm        U,
+          matlib_zm        V,
+          pthpool_data_t*  mp
+)
+{
+    debug_enter( "size of A: %d-by-%d, nr. of vectors: %d, threads: %d",
+                 A.lenc, A.lenr, U.lenr, plan->part.num_threads);
 
-        for( st=0; st<N*nr_combi; st +=nr_combi)
-        {
-            shiftq = shiftq0;
-            for( l=0; l<p-1; l++)
-            {
-                for (m=i; m<(i+p-1-l); m++)
-                {
-                    (*ugpmm)[s] = *(q.elem_p+st+shiftq);
-                    shiftq++;
-                    s++;
-                }
-                i++;
-            }
-        }
-        q.elem_p += q.lenc;
+    assert((U.order == MATLIB_COL_MAJOR) && (V.order == MATLIB_COL_MAJOR));
+    assert((U.lenc == A.lenc) && (V.lenc == A.lenc) && (U.lenr == V.lenr));
+    assert((plan->dim == A.lenc) && (U.lenr <= plan->nrhs) && (plan->zw != NULL));
+    if ((uplo_enum != MATLIB_UPPER) && (uplo_enum != MATLIB_LOWER))
+    {
+        term_execb("unknown upper/lower part (uplo_enum: %d)", uplo_enum);
     }
 
+    void* shared_data[5] = { (void*) &A,
+                             (void*) &U,
+                             (void*) &V,
+                             (void*) plan,
+                             (void*) &uplo_enum };
+
+    pthpool_for_partition( &(plan->part), shared_data, 
+                           (void*)pfem1d_thfunc_ZCSRSYMV, mp);
+    pthpool_for_partition( &(plan->part), shared_data, 
+                           (void*)pfem1d_thfunc_ZCSRSYMV_sum, mp);
+
     debug_exit("%s", "");
 }
 
-void pfem1d_xm_nsparse_GMM
-/* Double - Assemble Global Mass Matrix*/ 
+void pfem1d_zcsrsymm
+/* Complex CSR Symmetric Matrix-Matrix */ 
 (
-    matlib_index       p,
-    matlib_index       N,
-    matlib_xm          Q,
-    matlib_xm*         phi,
-    matlib_xm*         q,
-    matlib_xm_nsparse* M,
-    matlib_index       num_threads,
-    pthpool_data_t*    mp
-    
+    const MATLIB_UPLO      uplo_enum,
+          matlib_zm_sparse A, 
+    const matlib_zm        U,
+          matlib_zm        V,
+          matlib_index     num_threads,
+          pthpool_data_t*  mp
 )
 {
-    debug_enter( "poynomial degree: %d, "
-                 "nr. of fem-elements: %d, "
-                 "nr. of sparse matrices: %d, "
-                 "size of Q: %d-by-%d), ",
-                 p, N, M->nsparse, Q.lenc, Q.lenr);
+    pfem1d_csrsym_plan_t plan;
+    pfem1d_zcsrsym_plan(A, U.lenr, num_threads, &plan);
+    pfem1d_zcsrsymm_exec(&plan, uplo_enum, A, U, V, mp);
+    pfem1d_csrsym_plan_free(&plan);
+}
 
-    assert(Q.lenc==(p-1)*(p+4)/2+3);
-    assert(q->lenr==M->nsparse);
+void pfem1d_zcsrsymv
+/* Complex CSR Symmetric Matrix-Vector */ 
+(
+    const MATLIB_UPLO      uplo_enum,
+          matlib_zm_sparse A, 
+    const matlib_zv        u,
+          matlib_zv        v,
+          matlib_index     num_threads,
+          pthpool_data_t*  mp
+)
+{
+    matlib_zm U = { .lenc = u.len, .lenr = 1, .order = MATLIB_COL_MAJOR, 
+                    .op = MATLIB_NO_TRANS, .elem_p = u.elem_p};
+    matlib_zm V = { .lenc = v.len, .lenr = 1, .order = MATLIB_COL_MAJOR, 
+                    .op = MATLIB_NO_TRANS, .elem_p = v.elem_p};
+    pfem1d_zcsrsymm(uplo_enum, A, U, V, num_threads, mp);
+}
 
-    matlib_index i; 
-    pfem1d_XFLT2( N, Q, *phi, *q, num_threads, mp);
-    /* define the shared data */ 
-    void* shared_data[4] = { (void*) &p,
-                             (void*) &N,
-                             (void*) q,
-                             (void*) M };
+/*============================================================================+/
+ | Phases of persistent regions
+/+============================================================================*/
+
+static void pfem1d_phase_kernel(pfem1d_phase_args_t* args, pthpool_arg_t* ptr)
+{
+    pthpool_arg_t arg = { .shared_data    = args->shared_data,
+                          .nonshared_data = ptr->nonshared_data,
+                          .thread_index   = ptr->thread_index };
 
-    matlib_index nsdata[num_threads][2];
+    ((void* (*)(void*))args->kernel)(&arg);
+}
 
-    pthpool_arg_t   arg[num_threads];
-    pthpool_task_t  task[num_threads];
+static void* pfem1d_thfunc_ZPrjL2F_phase(void* mp)
+{
+    pthpool_arg_t*       ptr  = (pthpool_arg_t*) mp;
+    pfem1d_phase_args_t* args = (pfem1d_phase_args_t*) (ptr->shared_data[0]);
 
-    /* define the block of data per thread */ 
-    matlib_index Np = M->nsparse/(num_threads);
-    if(Np<1)
-    {
-        term_exec( "Work distribution across %d threads is not optimal.",
-                   num_threads);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
     
-    }
-    for(i=0; i<num_threads-1; i++)
+    pfem1d_phase_kernel(args, ptr);
+
+    if(start_end_index[1]==args->N)
     {
-        nsdata[i][0] = i*Np;
-        nsdata[i][1] = (i+1)*Np;
-        arg[i].shared_data    = shared_data; 
-        arg[i].nonshared_data = (void**)&nsdata[i];
-        arg[i].thread_index   = i;
-        /* Define the task */ 
-        task[i].function  = (void*)pfem1d_thfunc_XCSRGMM2;
-        task[i].argument  = &arg[i];
-        
+        /* last vertex, see pfem1d_ZPrjL2F */ 
+        matlib_index i = (args->p+1)*(args->N-1);
+        args->y.elem_p[args->N] = args->x.elem_p[i] + args->x.elem_p[i+1]/3;
     }
-    nsdata[i][0] = i*Np;
-    nsdata[i][1] = M->nsparse;
-    arg[i].shared_data    = shared_data; 
-    arg[i].nonshared_data = (void**)&nsdata[i];
-    arg[i].thread_index   = i;
-    /* Define the task */ 
-    task[i].function  = (void*)pfem1d_thfunc_XCSRGMM2;
-    task[i].argument  = &arg[i];
-    
+    return NULL;
+}
 
-    debug_body("%s", "created task");
+static void* pfem1d_thfunc_range_phase(void* mp)
+{
+    pthpool_arg_t*       ptr  = (pthpool_arg_t*) mp;
+    pfem1d_phase_args_t* args = (pfem1d_phase_args_t*) (ptr->shared_data[0]);
 
-    pthpool_exec_task(num_threads, mp, task);
-    
-    debug_exit("%s", "");
+    pfem1d_phase_kernel(args, ptr);
+    return NULL;
 }
 
-/*============================================================================*/
-static void* pfem1d_thfunc_ZCSRGMM2(void* mp)
+static void* pfem1d_thfunc_zaxpby_phase(void* mp)
 {
-    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
-    matlib_index p = *((matlib_index*) (ptr->shared_data[0]));
-    matlib_index N = *((matlib_index*) (ptr->shared_data[1]));
-    matlib_zm q    =    *((matlib_zm*) (ptr->shared_data[2]));
+    pthpool_arg_t*       ptr  = (pthpool_arg_t*) mp;
+    pfem1d_phase_args_t* args = (pfem1d_phase_args_t*) (ptr->shared_data[0]);
 
-    matlib_zm_nsparse M = *((matlib_zm_nsparse*) (ptr->shared_data[3]));
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i;
+    matlib_index start = start_end_index[0]*(args->p+1);
+    matlib_index end   = start_end_index[1]*(args->p+1);
 
-    debug_enter( "Thread id: %d, degree of polynomial: %d, "
-                 "Number of finite-elements: %d, "
-                 "length of q: %d-by-%d", 
-                 ptr->thread_index,
-                 p, N, q.lenc, q.lenr);
+    matlib_complex  alpha = args->coeff[0];
+    matlib_complex  beta  = args->coeff[1];
+    matlib_complex* x     = args->x.elem_p;
+    matlib_complex* y     = args->y.elem_p;
 
+    for(i=start; i<end; i++)
+    {
+        y[i] = alpha*x[i] + beta*y[i];
+    }
+    return NULL;
+}
 
-   matlib_index nr_combi = q.lenc/N; 
-   debug_body("nr. of combinations of basis functions: %d", nr_combi);
-   
+static void pfem1d_phase_init
+(
+    matlib_index         p,
+    matlib_index         N,
+    void*                thfunc,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
+)
+{
+    args->p             = p;
+    args->N             = N;
+    args->B.elem_p      = NULL;
+    args->C.elem_p      = NULL;
+    args->phase_data[0] = (void*)args;
+
+    phase->thfunc       = thfunc;
+    phase->shared_data  = args->phase_data;
+    phase->serial       = false;
+}
 
-    /* number of nonzero elements nnz = N*p*(p+3)/2+1;
-     * */
-    matlib_index s, i, l, l0, m, st;
+static void pfem1d_LT_phase
+(
+    matlib_index         N,
+    matlib_xm            M,
+    matlib_zv            x,
+    matlib_zv            y,
+    void*                kernel,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
+)
+/* 
+ * The kernels of the transforms read N, the matrix and both vectors by
+ * reference, hence the copies in args.
+ *
+ * */ 
+{
+    pfem1d_phase_init(0, N, (void*)pfem1d_thfunc_range_phase, args, phase);
+    args->M              = M;
+    args->x              = x;
+    args->y              = y;
+    args->kernel         = kernel;
+    args->shared_data[0] = (void*) &(args->N);
+    args->shared_data[1] = (void*) &(args->M);
+    args->shared_data[2] = (void*) &(args->x);
+    args->shared_data[3] = (void*) &(args->y);
+}
 
-    /* zero-th row 
-     *
-     * (v_0,v_0)_{K_1}
-     * (v_0,v_1)_{K_1}
-     * */ 
-    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
-    
-    debug_body( "Thread id: %d, start_index: %d, end_index: %d",
-                ptr->thread_index, 
-                start_end_index[0], start_end_index[1]);
+void pfem1d_ZFLT_phase
+(
+    matlib_index         N,
+    matlib_xm            FM,
+    matlib_zv            u,
+    matlib_zv            U,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
+)
+{
+    pfem1d_LT_phase(N, FM, u, U, (void*)pfem1d_thfunc_ZFLT, args, phase);
+}
 
-    q.elem_p += (q.lenc*start_end_index[0]);
+void pfem1d_ZILT_phase
+(
+    matlib_index         N,
+    matlib_xm            IM,
+    matlib_zv            U,
+    matlib_zv            u,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
+)
+{
+    pfem1d_LT_phase(N, IM, U, u, (void*)pfem1d_thfunc_ZILT, args, phase);
+}
 
-    matlib_complex **ugpmm;
+void pfem1d_ZPrjL2F_phase
+(
+    matlib_index         p,
+    matlib_zv            u,
+    matlib_zv            Pvb,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
+)
+{
+    debug_enter( "highest polynomial degree: %d "
+                 "length of vectors u: %d, Pbv: %d", 
+                 p, u.len, Pvb.len );
 
-    for( ugpmm = M.elem_p+start_end_index[0]; 
-         ugpmm < M.elem_p+start_end_index[1]; 
-         ugpmm++, (q.elem_p)+=q.lenc)
+    matlib_index i, N = u.len/(p+1);
+    assert((u.elem_p != NULL) && (Pvb.elem_p != NULL));
+
+    if(u.len != Pvb.len+N-1)
     {
-        i = 0;
-        s = 0;
-        (*ugpmm)[s] = *(q.elem_p);
-        s++;
-    
-        (*ugpmm)[s] = *(q.elem_p+1);
-        s++;
+        term_execb( "length of vectors incorrect: "
+                    "u: %d, Pvb: %d",
+                    u.len, Pvb.len);
+    }
+    pfem1d_phase_init(p, N, (void*)pfem1d_thfunc_ZPrjL2F_phase, args, phase);
+    args->x = u;
+    args->y = Pvb;
 
-        matlib_index shiftq = 3;
+    if(p>10)
+    {
+        matlib_real tmp;
+        matlib_create_xv(p-1, &(args->B), MATLIB_COL_VECT);
+        matlib_create_xv(p-1, &(args->C), MATLIB_COL_VECT);
         
-        for (l=N+1; l<(N+p); l++)
+        for(i=0; i<p-1; i++)
         {
-            (*ugpmm)[s] = (*(q.elem_p + shiftq));
-            shiftq ++;
-            s++;
+            tmp =  1.0/sqrt(4*i+6);
+            args->B.elem_p[i] =  tmp/(i+2.5);
+            args->C.elem_p[i] = -tmp/(i+0.5);
         }
+        args->kernel         = (void*)thfunc_zprjLP2FEM_ShapeFunc;
+        args->shared_data[0] = (void*) &(args->p);
+        args->shared_data[1] = (void*) (u.elem_p);
+        args->shared_data[2] = (void*) (Pvb.elem_p);
+        args->shared_data[3] = (void*) (Pvb.elem_p+N+1);
+        args->shared_data[4] = (void*) args->B.elem_p;
+        args->shared_data[5] = (void*) args->C.elem_p;
+    }
+    else
+    {
+        void* (*fp[9])(void*) = { thfunc_zprjLP2FEM_ShapeFunc_2,
+                                  thfunc_zprjLP2FEM_ShapeFunc_3, 
+                                  thfunc_zprjLP2FEM_ShapeFunc_4, 
+                                  thfunc_zprjLP2FEM_ShapeFunc_5, 
+                                  thfunc_zprjLP2FEM_ShapeFunc_6, 
+                                  thfunc_zprjLP2FEM_ShapeFunc_7, 
+                                  thfunc_zprjLP2FEM_ShapeFunc_8, 
+                                  thfunc_zprjLP2FEM_ShapeFunc_9, 
+                                  thfunc_zprjLP2FEM_ShapeFunc_10};
 
-        l0 = N+1;
-        st = 0;
-        for( i=1; i<N; i++)
-        {
-            /* i-th row: start from the diagonal 
-             * (v_i,v_i)_{K_i} + (v_i,v_i)_{K_{i+1}}
-             * (v_i,v_{i+1})_{K_{i+1}}
-             * */ 
-            (*ugpmm)[s] = *(q.elem_p+st+2) + *(q.elem_p+st+nr_combi);
-            s++;
-            (*ugpmm)[s] = *(q.elem_p+st+nr_combi+1); 
-            s++;
-            /* v_i interacts with [b_i?], [b_{i+1,?}]
-             * (p-1) bubble functions in each element
-             */
-            shiftq = st+3+p-1;
-            for (l=l0; l<(l0+p-1); l++)
-            {
-                (*ugpmm)[s] = *(q.elem_p + shiftq);
-                shiftq ++;
-                s++;
-            }
-            l0 = l;
+        args->kernel         = (void*)fp[p-2];
+        args->shared_data[0] = (void*) (u.elem_p);
+        args->shared_data[1] = (void*) (Pvb.elem_p);
+        args->shared_data[2] = (void*) (Pvb.elem_p+N+1);
+    }
+    debug_exit("%s", "");
+}
 
-            shiftq = st + nr_combi+3;
-            for (l=l0; l<(l0+p-1); l++)
-            {
-                (*ugpmm)[s] = *(q.elem_p+shiftq);
-                shiftq++;
-                s++;
-            
-            }
-            st = st+nr_combi;
-        }
-        /* last row: only the diagonal 
-         * (v_N,v_N)_{K_N}
-         * */ 
-        (*ugpmm)[s] = *(q.elem_p+st+2);
-        s++;
-        shiftq = st+3+(p-1);
-        for (l=l0; l<(l0+p-1); l++)
-        {
-            (*ugpmm)[s] = *(q.elem_p+shiftq);
-            shiftq++;
-            s++;
-        }
-        i++;
+void pfem1d_ZF2L_phase
+(
+    matlib_index         p,
+    matlib_zv            vb,
+    matlib_zv            u,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
+)
+{
+    debug_enter( "highest polynomial degree: %d "
+                 "length of vectors vb: %d, u: %d", 
+                 p, vb.len, u.len );
 
-        /* vertex-vertex and vertex-bubble combinations are done
-         * do the bubble-bubble combination
-         * */ 
-        matlib_index shiftq0 = 3+2*(p-1);
+    matlib_index j, N = (vb.len-1)/p;
+    assert((vb.elem_p != NULL) && (u.elem_p != NULL));
 
-        for( st=0; st<N*nr_combi; st +=nr_combi)
+    if(u.len != vb.len+(N-1))
+    {
+        term_execb( "length of vectors incorrect: "
+                    "vb: %d, u: %d",
+                    vb.len, u.len);
+    }
+    pfem1d_phase_init(p, N, (void*)pfem1d_thfunc_range_phase, args, phase);
+    args->x = vb;
+    args->y = u;
+
+    if(p>10)
+    {
+        matlib_create_xv(p-3, &(args->B), MATLIB_COL_VECT);
+        matlib_create_xv(p-3, &(args->C), MATLIB_COL_VECT);
+        
+        args->A[0] = -1.0/sqrt(6);
+        args->A[1] = -1.0/sqrt(10);
+        args->A[2] =  1.0/sqrt(2*(2*p-3));
+        args->A[3] =  1.0/sqrt(2*(2*p-1));
+
+        for( j=0; j<(p-3); j++)
         {
-            shiftq = shiftq0;
-            for( l=0; l<p-1; l++)
-            {
-                for (m=i; m<(i+p-1-l); m++)
-                {
-                    (*ugpmm)[s] = *(q.elem_p+st+shiftq);
-                    shiftq++;
-                    s++;
-                }
-                i++;
-            }
+            args->B.elem_p[j] =  1.0/sqrt(2*(2*j+3.0)); 
+            args->C.elem_p[j] = -1.0/sqrt(2*(2*j+7.0)); 
         }
+        args->kernel         = (void*)thfunc_zshapefunc2lp;
+        args->shared_data[0] = (void*) &(args->p);
+        args->shared_data[1] = (void*) (vb.elem_p);
+        args->shared_data[2] = (void*) (vb.elem_p+N+1);
+        args->shared_data[3] = (void*) (u.elem_p);
+        args->shared_data[4] = (void*) args->A;
+        args->shared_data[5] = (void*) args->B.elem_p;
+        args->shared_data[6] = (void*) args->C.elem_p;
+    }
+    else
+    {
+        void* (*fp[9])(void*) = { thfunc_zshapefunc2lp_2,
+                                  thfunc_zshapefunc2lp_3, 
+                                  thfunc_zshapefunc2lp_4, 
+                                  thfunc_zshapefunc2lp_5, 
+                                  thfunc_zshapefunc2lp_6, 
+                                  thfunc_zshapefunc2lp_7, 
+                                  thfunc_zshapefunc2lp_8, 
+                                  thfunc_zshapefunc2lp_9, 
+                                  thfunc_zshapefunc2lp_10};
+
+        args->kernel         = (void*)fp[p-2];
+        args->shared_data[0] = (void*) (vb.elem_p);
+        args->shared_data[1] = (void*) (vb.elem_p+N+1);
+        args->shared_data[2] = (void*) (u.elem_p);
     }
-
     debug_exit("%s", "");
 }
 
-void pfem1d_zm_nsparse_GMM
-/* Double - Assemble Global Mass Matrix*/ 
+void pfem1d_zaxpby_phase
 (
-    matlib_index       p,
-    matlib_index       N,
-    matlib_xm          Q,
-    matlib_zm*         phi,
-    matlib_zm*         q,
-    matlib_zm_nsparse* M,
-    matlib_index       num_threads,
-    pthpool_data_t*    mp
-    
+    matlib_index         p,
+    matlib_complex       alpha,
+    matlib_zv            x,
+    matlib_complex       beta,
+    matlib_zv            y,
+    pfem1d_phase_args_t* args,
+    pthpool_phase_t*     phase
 )
 {
-    debug_enter( "poynomial degree: %d, "
-                 "nr. of fem-elements: %d, "
-                 "nr. of sparse matrices: %d, "
-                 "size of Q: %d-by-%d), ",
-                 p, N, M->nsparse, Q.lenc, Q.lenr);
+    debug_enter( "highest polynomial degree: %d "
+                 "length of vectors x: %d, y: %d", 
+                 p, x.len, y.len );
 
-    assert(Q.lenc==(p-1)*(p+4)/2+3);
-    assert(q->lenr==M->nsparse);
+    assert((x.elem_p != NULL) && (y.elem_p != NULL));
+    if((x.len != y.len) || (x.len % (p+1) != 0))
+    {
+        term_execb( "length of vectors incorrect: "
+                    "x: %d, y: %d",
+                    x.len, y.len);
+    }
+    pfem1d_phase_init( p, x.len/(p+1), (void*)pfem1d_thfunc_zaxpby_phase, 
+                       args, phase);
+    args->kernel   = NULL;
+    args->coeff[0] = alpha;
+    args->coeff[1] = beta;
+    args->x        = x;
+    args->y        = y;
+    debug_exit("%s", "");
+}
 
-    matlib_index i; 
-    pfem1d_ZFLT2( N, Q, *phi, *q, num_threads, mp);
-    /* define the shared data */ 
-    void* shared_data[4] = { (void*) &p,
-                             (void*) &N,
-                             (void*) q,
-                             (void*) M };
+void pfem1d_phase_free(pfem1d_phase_args_t* args)
+{
+    matlib_free(args->B.elem_p);
+    matlib_free(args->C.elem_p);
+    args->B.elem_p = NULL;
+    args->C.elem_p = NULL;
+}
 
-    matlib_index nsdata[num_threads][2];
+/*============================================================================+/
+ | Asynchronous calls
+ | The phase of a persistent region carries the kernel and its arguments;
+ | an asynchronous call runs it over the element partition of pfem1d_for.
+/+============================================================================*/
 
-    pthpool_arg_t   arg[num_threads];
-    pthpool_task_t  task[num_threads];
+static void pfem1d_launch
+(
+    matlib_index     num_threads,
+    pthpool_data_t*  mp,
+    pfem1d_future_t* future
+)
+{
+    debug_enter("nr. finite-elements: %d, threads: %d", future->args.N, num_threads);
 
-    /* define the block of data per thread */ 
-    matlib_index Np = M->nsparse/(num_threads);
-    if(Np<1)
+    errno = 0;
+    future->mp         = mp;
+    future->part.start = calloc(num_threads+1, sizeof(matlib_index));
+    future->arg        = calloc(num_threads, sizeof(pthpool_arg_t));
+    future->task       = calloc(num_threads, sizeof(pthpool_task_t));
+    if((future->part.start==NULL) || (future->arg==NULL) || (future->task==NULL))
     {
-        term_exec( "Work distribution across %d threads is not optimal.",
-                   num_threads);
-    
+        term_exec("%s: future of %d threads", strerror(errno), num_threads);
     }
+    pthpool_partition_split(future->args.N, num_threads, &(future->part));
 
-    for(i=0; i<num_threads-1; i++)
-    {
-        nsdata[i][0] = i*Np;
-        nsdata[i][1] = (i+1)*Np;
-        arg[i].shared_data    = shared_data; 
-        arg[i].nonshared_data = (void**)&nsdata[i];
-        arg[i].thread_index   = i;
-        /* Define the task */ 
-        task[i].function  = (void*)pfem1d_thfunc_ZCSRGMM2;
-        task[i].argument  = &arg[i];
-        
-    }
-    nsdata[i][0] = i*Np;
-    nsdata[i][1] = M->nsparse;
-    arg[i].shared_data    = shared_data; 
-    arg[i].nonshared_data = (void**)&nsdata[i];
-    arg[i].thread_index   = i;
-    /* Define the task */ 
-    task[i].function  = (void*)pfem1d_thfunc_ZCSRGMM2;
-    task[i].argument  = &arg[i];
-    
+    pthpool_handle_init(&(future->handle));
+    pthpool_for_partition_async( &(future->part), 
+                                 future->phase.shared_data,
+                                 future->phase.thfunc, mp,
+                                 future->arg, future->task, 
+                                 &(future->handle));
+    debug_exit("%s", "");
+}
 
-    debug_body("%s", "created task");
+void pfem1d_ZFLT_async
+(
+    matlib_index     N,
+    matlib_xm        FM,
+    matlib_zv        u,
+    matlib_zv        U,
+    matlib_index     num_threads,
+    pthpool_data_t*  mp,
+    pfem1d_future_t* future
+)
+{
+    pfem1d_ZFLT_phase(N, FM, u, U, &(future->args), &(future->phase));
+    pfem1d_launch(num_threads, mp, future);
+}
 
-    pthpool_exec_task(num_threads, mp, task);
+void pfem1d_ZILT_async
+(
+    matlib_index     N,
+    matlib_xm        IM,
+    matlib_zv        U,
+    matlib_zv        u,
+    matlib_index     num_threads,
+    pthpool_data_t*  mp,
+    pfem1d_future_t* future
+)
+{
+    pfem1d_ZILT_phase(N, IM, U, u, &(future->args), &(future->phase));
+    pfem1d_launch(num_threads, mp, future);
+}
 
-    debug_exit("%s", "");
+void pfem1d_ZPrjL2F_async
+(
+    matlib_index     p,
+    matlib_zv        u,
+    matlib_zv        Pvb,
+    matlib_index     num_threads,
+    pthpool_data_t*  mp,
+    pfem1d_future_t* future
+)
+{
+    pfem1d_ZPrjL2F_phase(p, u, Pvb, &(future->args), &(future->phase));
+    pfem1d_launch(num_threads, mp, future);
 }
 
+void pfem1d_ZF2L_async
+(
+    matlib_index     p,
+    matlib_zv        vb,
+    matlib_zv        u,
+    matlib_index     num_threads,
+    pthpool_data_t*  mp,
+    pfem1d_future_t* future
+)
+{
+    pfem1d_ZF2L_phase(p, vb, u, &(future->args), &(future->phase));
+    pfem1d_launch(num_threads, mp, future);
+}
+
+void pfem1d_wait(pfem1d_future_t* future)
+{
+    debug_enter("nr. finite-elements: %d", future->args.N);
+
+    pthpool_wait(future->mp, &(future->handle));
+    pthpool_handle_destroy(&(future->handle));
+
+    matlib_free(future->part.start);
+    matlib_free(future->arg);
+    matlib_free(future->task);
+    future->part.start = NULL;
+    future->arg        = NULL;
+    future->task       = NULL;
+    pfem1d_phase_free(&(future->args));
+    debug_exit("%s", "");
+}
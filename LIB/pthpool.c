@@ -12,6 +12,12 @@
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <sched.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
 
 #define NDEBUG
 #include "assert.h"
@@ -19,310 +25,2269 @@
 /*============================================================================*/
 
 static void* pthpool_schedule_task(void *mp);
+
+/* Thread of the pool executing the calling code, NULL for other threads */ 
+static __thread pthpool_data_t* pthpool_self = NULL;
+
+/*============================================================================+/
+ | Spinning and parking
+/+============================================================================*/
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PTHPOOL_CPU_RELAX() __builtin_ia32_pause()
+#else
+#define PTHPOOL_CPU_RELAX() __asm__ __volatile__("" ::: "memory")
+#endif
+
+/* States of the futex word of a handle */ 
+#define PTHPOOL_HANDLE_RUNNING 0
+#define PTHPOOL_HANDLE_PARKED  1
+#define PTHPOOL_HANDLE_DONE    2
+
+static void pthpool_futex_wait
+(
+    uint32_t* addr, 
+    uint32_t  val
+)
+{
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+static void pthpool_futex_wake
+(
+    uint32_t* addr, 
+    int       nr
+)
+{
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, nr, NULL, NULL, 0);
+}
+
+static inline void pthpool_backoff(matlib_index iter)
+/* Exponential backoff: 1, 2, 4, 8 pauses per poll */ 
+{
+    matlib_index k, nr_pause = (matlib_index)1<<(iter<3? iter: 3);
+    for(k=0; k<nr_pause; k++)
+    {
+        PTHPOOL_CPU_RELAX();
+    }
+}
+
+static matlib_index pthpool_spin_limit(matlib_index nr_threads)
+/* Spinning only pays off if every spinning thread has a CPU of its own */ 
+{
+    cpu_set_t cpuset;
+    matlib_index nr_cpu = 1;
+    if(sched_getaffinity(0, sizeof(cpu_set_t), &cpuset)==0)
+    {
+        nr_cpu = CPU_COUNT(&cpuset);
+    }
+    return (nr_threads<=nr_cpu)? PTHPOOL_SPIN_LIMIT: 0;
+}
+
+static inline PTHPOOL_DISPATCH pthpool_dispatch(pthpool_data_t* pth)
+{
+    return __atomic_load_n(&(pth->shared->dispatch), __ATOMIC_RELAXED);
+}
+
+/*============================================================================+/
+ | Completion handles
+/+============================================================================*/
+
+void pthpool_handle_init(pthpool_handle_t* handle)
+{
+    handle->pending = 0;
+    handle->state   = PTHPOOL_HANDLE_DONE;
+    pthread_mutex_init(&(handle->lock), NULL);
+    pthread_cond_init(&(handle->done), NULL);
+}
+
+void pthpool_handle_destroy(pthpool_handle_t* handle)
+{
+    pthread_mutex_destroy(&(handle->lock));
+    pthread_cond_destroy(&(handle->done));
+}
+
+static inline void pthpool_handle_arm(pthpool_handle_t* handle)
+/* 
+ * Counts a submitted job. The count leaves zero only under the lock, where
+ * the handle is re-armed as well; above zero a CAS suffices.
+ *
+ * */ 
+{
+    matlib_index pending = __atomic_load_n(&(handle->pending), __ATOMIC_ACQUIRE);
+    while(pending>0)
+    {
+        if(__atomic_compare_exchange_n( &(handle->pending), &pending, pending+1, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            return;
+        }
+    }
+    pthread_mutex_lock(&(handle->lock));
+    if(__atomic_add_fetch(&(handle->pending), 1, __ATOMIC_ACQ_REL)==1)
+    {
+        __atomic_store_n(&(handle->state), PTHPOOL_HANDLE_RUNNING, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&(handle->lock));
+}
+
+static void pthpool_complete(pthpool_handle_t* handle)
+/* 
+ * Counts a finished job. The count reaches zero only under the lock, where
+ * the handle is marked done, so that the state cannot disagree with the
+ * count when a submit races with the last completion. A waiter which
+ * observes the done state takes the lock once before it returns, hence the
+ * handle is not touched after that; only the address is passed to the futex
+ * wake which does not dereference it.
+ *
+ * */ 
+{
+    uint32_t old;
+    matlib_index pending = __atomic_load_n(&(handle->pending), __ATOMIC_ACQUIRE);
+    while(pending>1)
+    {
+        if(__atomic_compare_exchange_n( &(handle->pending), &pending, pending-1, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        {
+            return;
+        }
+    }
+    pthread_mutex_lock(&(handle->lock));
+    if(__atomic_sub_fetch(&(handle->pending), 1, __ATOMIC_ACQ_REL)==0)
+    {
+        old = __atomic_exchange_n(&(handle->state), PTHPOOL_HANDLE_DONE, __ATOMIC_ACQ_REL);
+        pthread_cond_broadcast(&(handle->done));
+        if(old==PTHPOOL_HANDLE_PARKED)
+        {
+            pthpool_futex_wake(&(handle->state), INT_MAX);
+        }
+    }
+    pthread_mutex_unlock(&(handle->lock));
+}
+
+static void pthpool_wake(pthpool_data_t* pth)
+/* 
+ * Wakes pth if it sleeps. A spinning thread notices the queued job by itself,
+ * a parked one needs the futex wake.
+ *
+ * */ 
+{
+    if(pthpool_dispatch(pth)==PTHPOOL_DISPATCH_SPIN)
+    {
+        __atomic_add_fetch(&(pth->wake), 1, __ATOMIC_SEQ_CST);
+        if(__atomic_load_n(&(pth->idle), __ATOMIC_SEQ_CST))
+        {
+            pthpool_futex_wake(&(pth->wake), 1);
+        }
+    }
+    else
+    {
+        pthread_mutex_lock(&(pth->lock));
+        pthread_cond_signal(&(pth->notify));
+        pthread_mutex_unlock(&(pth->lock));
+    }
+}
+
+static void pthpool_wake_idle(pthpool_data_t* pool)
+/* Wakes the first idle thread of the pool, if any */ 
+{
+    matlib_index i;
+    for(i=0; i<pool->num_threads; i++)
+    {
+        if(__atomic_load_n(&(pool[i].idle), __ATOMIC_ACQUIRE))
+        {
+            pthpool_wake(&pool[i]);
+            break;
+        }
+    }
+}
+
+/*============================================================================+/
+ | Sense-reversing barrier
+/+============================================================================*/
+
+void pthpool_barrier_init
+(
+    pthpool_barrier_t* barrier,
+    matlib_index       nr_threads
+)
+{
+    barrier->count      = 0;
+    barrier->sense      = 0;
+    barrier->parked     = 0;
+    barrier->nr_threads = (uint32_t)nr_threads;
+    barrier->spin_limit = (uint32_t)pthpool_spin_limit(nr_threads);
+}
+
+void pthpool_barrier_wait(pthpool_barrier_t* barrier)
+/* 
+ * The sense read on arrival belongs to the current episode since it cannot
+ * flip before this thread has arrived. The last thread resets the count and
+ * flips the sense; the others spin, then park, until the sense changes.
+ *
+ * */ 
+{
+    matlib_index i;
+    uint32_t sense = __atomic_load_n(&(barrier->sense), __ATOMIC_ACQUIRE);
+
+    if(__atomic_add_fetch(&(barrier->count), 1, __ATOMIC_ACQ_REL)==barrier->nr_threads)
+    {
+        __atomic_store_n(&(barrier->count), 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&(barrier->sense), sense^1, __ATOMIC_SEQ_CST);
+        if(__atomic_load_n(&(barrier->parked), __ATOMIC_SEQ_CST)>0)
+        {
+            pthpool_futex_wake(&(barrier->sense), INT_MAX);
+        }
+        return;
+    }
+
+    for(i=0; (i<barrier->spin_limit) && 
+             (__atomic_load_n(&(barrier->sense), __ATOMIC_ACQUIRE)==sense); i++)
+    {
+        pthpool_backoff(i);
+    }
+    while(__atomic_load_n(&(barrier->sense), __ATOMIC_ACQUIRE)==sense)
+    {
+        __atomic_add_fetch(&(barrier->parked), 1, __ATOMIC_SEQ_CST);
+        if(__atomic_load_n(&(barrier->sense), __ATOMIC_SEQ_CST)==sense)
+        {
+            pthpool_futex_wait(&(barrier->sense), sense);
+        }
+        __atomic_sub_fetch(&(barrier->parked), 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+/*============================================================================+/
+ | Telemetry
+/+============================================================================*/
+
+static inline uint64_t pthpool_now(void)
+{
+#ifndef PTHPOOL_NSTATS
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL + (uint64_t)ts.tv_nsec;
+#else
+    return 0;
+#endif
+}
+
+/* Single writer: relaxed stores suffice for a concurrent snapshot */ 
+#define PTHPOOL_STATS_STORE(field, value) \
+    __atomic_store_n(&(field), (value), __ATOMIC_RELAXED)
+
+static inline void pthpool_stats_task
+(
+    pthpool_data_t* pth,
+    uint64_t        submit_ns,
+    uint64_t        start_ns,
+    uint64_t        end_ns
+)
+{
+#ifndef PTHPOOL_NSTATS
+    pthpool_stats_t* stats = &(pth->stats);
+    uint64_t duration = end_ns - start_ns;
+    uint64_t latency  = (start_ns>submit_ns)? start_ns-submit_ns: 0;
+    matlib_index bin  = (latency==0)? 0: 63-__builtin_clzll(latency);
+
+    bin = (bin<PTHPOOL_STATS_BINS)? bin: PTHPOOL_STATS_BINS-1;
+    PTHPOOL_STATS_STORE(stats->nr_tasks, stats->nr_tasks+1);
+    PTHPOOL_STATS_STORE(stats->busy_ns, stats->busy_ns+duration);
+    PTHPOOL_STATS_STORE(stats->wake_hist[bin], stats->wake_hist[bin]+1);
+    if(duration<stats->task_min_ns)
+    {
+        PTHPOOL_STATS_STORE(stats->task_min_ns, duration);
+    }
+    if(duration>stats->task_max_ns)
+    {
+        PTHPOOL_STATS_STORE(stats->task_max_ns, duration);
+    }
+#endif
+}
+
+static inline void pthpool_stats_wait
+(
+    pthpool_data_t* pth,
+    uint64_t        start_ns
+)
+{
+#ifndef PTHPOOL_NSTATS
+    PTHPOOL_STATS_STORE( pth->stats.wait_ns, 
+                         pth->stats.wait_ns+(pthpool_now()-start_ns));
+#endif
+}
+
+static void pthpool_stats_clear(pthpool_stats_t* stats)
+{
+    matlib_index k;
+    PTHPOOL_STATS_STORE(stats->nr_tasks, 0);
+    PTHPOOL_STATS_STORE(stats->busy_ns, 0);
+    PTHPOOL_STATS_STORE(stats->wait_ns, 0);
+    PTHPOOL_STATS_STORE(stats->task_min_ns, UINT64_MAX);
+    PTHPOOL_STATS_STORE(stats->task_max_ns, 0);
+    for(k=0; k<PTHPOOL_STATS_BINS; k++)
+    {
+        PTHPOOL_STATS_STORE(stats->wake_hist[k], 0);
+    }
+}
+
+void pthpool_stats_snapshot
+(
+    matlib_index     num_threads,
+    pthpool_data_t*  mp,
+    pthpool_stats_t* stats
+)
+{
+    matlib_index i, k;
+    for(i=0; i<num_threads; i++)
+    {
+        pthpool_stats_t* src = &(mp[i].stats);
+        stats[i].nr_tasks    = __atomic_load_n(&(src->nr_tasks),    __ATOMIC_RELAXED);
+        stats[i].busy_ns     = __atomic_load_n(&(src->busy_ns),     __ATOMIC_RELAXED);
+        stats[i].wait_ns     = __atomic_load_n(&(src->wait_ns),     __ATOMIC_RELAXED);
+        stats[i].task_min_ns = __atomic_load_n(&(src->task_min_ns), __ATOMIC_RELAXED);
+        stats[i].task_max_ns = __atomic_load_n(&(src->task_max_ns), __ATOMIC_RELAXED);
+        for(k=0; k<PTHPOOL_STATS_BINS; k++)
+        {
+            stats[i].wake_hist[k] = __atomic_load_n(&(src->wake_hist[k]), __ATOMIC_RELAXED);
+        }
+        if(stats[i].nr_tasks==0)
+        {
+            stats[i].task_min_ns = 0;
+        }
+    }
+}
+
+void pthpool_stats_reset
+(
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+)
+{
+    matlib_index i;
+    for(i=0; i<num_threads; i++)
+    {
+        pthpool_stats_clear(&(mp[i].stats));
+    }
+}
+
+matlib_real pthpool_stats_imbalance
+(
+    matlib_index           num_threads,
+    const pthpool_stats_t* stats
+)
+{
+    matlib_index i;
+    matlib_real  total = 0, max = 0;
+    for(i=0; i<num_threads; i++)
+    {
+        total += stats[i].busy_ns;
+        max    = (stats[i].busy_ns>max)? stats[i].busy_ns: max;
+    }
+    return (total>0)? max*num_threads/total: 0;
+}
+
+/*============================================================================+/
+ | Per-thread deques
+/+============================================================================*/
+
+static bool pthpool_push
+(
+    pthpool_data_t* pth,
+    pthpool_job_t*  job
+)
+/* 
+ * Pushes the job at the bottom of the deque of pth and wakes pth up; if pth
+ * already had work queued, an idle thread is woken as well so that it can
+ * steal. Returns false if the deque is full.
+ *
+ * */ 
+{
+    pthpool_data_t* pool = pth->pool;
+    matlib_index backlog;
+
+    pthread_mutex_lock(&(pth->qlock));
+    backlog = pth->bottom - pth->top;
+    if(backlog==PTHPOOL_DEQUE_SIZE)
+    {
+        pthread_mutex_unlock(&(pth->qlock));
+        return false;
+    }
+    pth->deque[pth->bottom%PTHPOOL_DEQUE_SIZE] = *job;
+    pth->bottom++;
+    __atomic_add_fetch(&(pth->shared->queued), 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&(pth->qlock));
+
+    pthpool_wake(pth);
+
+    if((backlog>0) || (pth==pthpool_self))
+    {
+        pthpool_wake_idle(pool);
+    }
+    return true;
+}
+
+static bool pthpool_pop
+(
+    pthpool_data_t* pth,
+    pthpool_job_t*  job,
+    bool            steal
+)
+/* 
+ * Takes a job from the bottom of the deque (owner) or from the top (thief).
+ *
+ * */ 
+{
+    bool found = false;
+    pthread_mutex_lock(&(pth->qlock));
+    if(pth->bottom > pth->top)
+    {
+        if(steal)
+        {
+            *job = pth->deque[pth->top%PTHPOOL_DEQUE_SIZE];
+            pth->top++;
+        }
+        else
+        {
+            pth->bottom--;
+            *job = pth->deque[pth->bottom%PTHPOOL_DEQUE_SIZE];
+        }
+        __atomic_sub_fetch(&(pth->shared->queued), 1, __ATOMIC_ACQ_REL);
+        found = true;
+    }
+    pthread_mutex_unlock(&(pth->qlock));
+    return found;
+}
+
+static bool pthpool_pop_pinned
+(
+    pthpool_data_t* pth,
+    pthpool_job_t*  job
+)
+{
+    bool found = false;
+    if(__atomic_load_n(&(pth->npinned), __ATOMIC_ACQUIRE)==0)
+    {
+        return false;
+    }
+    pthread_mutex_lock(&(pth->qlock));
+    if(pth->pin_bottom > pth->pin_top)
+    {
+        *job = pth->pinned[pth->pin_top%PTHPOOL_PINNED_SIZE];
+        pth->pin_top++;
+        __atomic_sub_fetch(&(pth->npinned), 1, __ATOMIC_ACQ_REL);
+        found = true;
+    }
+    pthread_mutex_unlock(&(pth->qlock));
+    return found;
+}
+
+/*============================================================================+/
+ | Shared queue of external submits
+/+============================================================================*/
+
+static bool pthpool_inject
+(
+    pthpool_shared_t* pool,
+    pthpool_task_t*   task,
+    pthpool_handle_t* handle
+)
+/* 
+ * Bounded multi-producer multi-consumer ring: the slot at position pos is
+ * free for a producer if its seq equals pos and holds a job for a consumer
+ * if its seq equals pos+1; producers and consumers claim positions with a
+ * CAS on the tail and on the head respectively. The job is counted in the
+ * handle and in the pool before it is published. Returns false if the queue
+ * is full.
+ *
+ * */ 
+{
+    pthpool_slot_t* slot;
+    uint64_t pos = __atomic_load_n(&(pool->inject_tail), __ATOMIC_RELAXED);
+    while(1)
+    {
+        slot = &(pool->inject[pos%PTHPOOL_INJECT_SIZE]);
+        int64_t diff = (int64_t)(__atomic_load_n(&(slot->seq), __ATOMIC_ACQUIRE)-pos);
+        if(diff==0)
+        {
+            if(__atomic_compare_exchange_n( &(pool->inject_tail), &pos, pos+1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if(diff<0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = __atomic_load_n(&(pool->inject_tail), __ATOMIC_RELAXED);
+        }
+    }
+    pthpool_handle_arm(handle);
+    slot->job = (pthpool_job_t){ .task = *task, .handle = handle, .submit_ns = pthpool_now()};
+    __atomic_add_fetch(&(pool->queued), 1, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&(slot->seq), pos+1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool pthpool_take_injected
+(
+    pthpool_shared_t* pool,
+    pthpool_job_t*    job
+)
+/* 
+ * Consumer side of pthpool_inject; the slot is released for the producers
+ * of the next lap.
+ *
+ * */ 
+{
+    pthpool_slot_t* slot;
+    uint64_t pos = __atomic_load_n(&(pool->inject_head), __ATOMIC_RELAXED);
+    while(1)
+    {
+        slot = &(pool->inject[pos%PTHPOOL_INJECT_SIZE]);
+        int64_t diff = (int64_t)(__atomic_load_n(&(slot->seq), __ATOMIC_ACQUIRE)-(pos+1));
+        if(diff==0)
+        {
+            if(__atomic_compare_exchange_n( &(pool->inject_head), &pos, pos+1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if(diff<0)
+        {
+            return false;
+        }
+        else
+        {
+            pos = __atomic_load_n(&(pool->inject_head), __ATOMIC_RELAXED);
+        }
+    }
+    *job = slot->job;
+    __atomic_store_n(&(slot->seq), pos+PTHPOOL_INJECT_SIZE, __ATOMIC_RELEASE);
+    __atomic_sub_fetch(&(pool->queued), 1, __ATOMIC_ACQ_REL);
+    return true;
+}
+
+/*============================================================================*/
+
+static inline bool pthpool_has_work(pthpool_data_t* pth)
+{
+    return    (__atomic_load_n(&(pth->shared->queued), __ATOMIC_SEQ_CST)>0)
+           || (__atomic_load_n(&(pth->npinned), __ATOMIC_SEQ_CST)>0);
+}
+
+static bool pthpool_run_one(pthpool_data_t* pth)
+/* 
+ * Executes one pinned job, else one job of the own deque, else one of the
+ * shared queue or, if that is empty too, one stolen from the other threads
+ * starting with the right neighbour.
+ *
+ * */ 
+{
+    pthpool_data_t* pool = pth->pool;
+    pthpool_job_t job;
+    matlib_index i;
+    bool found =    pthpool_pop_pinned(pth, &job)
+                 || pthpool_pop(pth, &job, false)
+                 || pthpool_take_injected(pth->shared, &job);
+
+    for(i=1; !found && (i<pool->num_threads); i++)
+    {
+        found = pthpool_pop( &pool[(pth->thread_index+i)%pool->num_threads], 
+                             &job, true);
+    }
+    if(found)
+    {
+        debug_body("performing task with thread: %d", pth->thread_index);
+        uint64_t start_ns = pthpool_now();
+        job.task.function(job.task.argument);
+        pthpool_stats_task(pth, job.submit_ns, start_ns, pthpool_now());
+        pthpool_complete(job.handle);
+    }
+    return found;
+}
+
+/*============================================================================*/
+
+static void pthpool_park(pthpool_data_t* pth)
+/* 
+ * Idle wait of the SPIN mode: poll for queued jobs with backoff, then park
+ * on the wake word. The idle flag is published before the final check and
+ * read by pthpool_wake after the job count is raised, so either side sees
+ * the other.
+ *
+ * */ 
+{
+    matlib_index i;
+    uint32_t seen = __atomic_load_n(&(pth->wake), __ATOMIC_ACQUIRE);
+
+    for(i=0; i<pth->shared->spin_limit; i++)
+    {
+        if(    pthpool_has_work(pth)
+            || (__atomic_load_n(&(pth->action), __ATOMIC_ACQUIRE)==PTHPOOL_EXIT)
+            || (pthpool_dispatch(pth)!=PTHPOOL_DISPATCH_SPIN))
+        {
+            return;
+        }
+        pthpool_backoff(i);
+    }
+
+    __atomic_store_n(&(pth->idle), true, __ATOMIC_SEQ_CST);
+    if(    !pthpool_has_work(pth)
+        && (__atomic_load_n(&(pth->action), __ATOMIC_SEQ_CST)!=PTHPOOL_EXIT)
+        && (pthpool_dispatch(pth)==PTHPOOL_DISPATCH_SPIN))
+    {
+        debug_body("parking (thread: %d)", pth->thread_index);
+        pthpool_futex_wait(&(pth->wake), seen);
+    }
+    __atomic_store_n(&(pth->idle), false, __ATOMIC_SEQ_CST);
+}
+
+static void* pthpool_schedule_task(void *mp)
+{
+    pthpool_data_t* pth  = (pthpool_data_t*) mp;
+    debug_enter("Executing thread index: %d", pth->thread_index);
+
+    pthpool_self = pth;
+
+    while(1) /* Keep the thread waiting in an infinite loop */ 
+    {
+        if(pthpool_run_one(pth))
+        {
+            continue;
+        }
+
+        uint64_t wait_ns = pthpool_now();
+        if(pthpool_dispatch(pth)==PTHPOOL_DISPATCH_SPIN)
+        {
+            pthpool_park(pth);
+            pthpool_stats_wait(pth, wait_ns);
+            if(    (__atomic_load_n(&(pth->action), __ATOMIC_SEQ_CST)==PTHPOOL_EXIT)
+                && !pthpool_has_work(pth))
+            {
+                debug_body("exit request made for thread: %d", pth->thread_index);
+                break;
+            }
+            continue;
+        }
+
+        pthread_mutex_lock(&(pth->lock));
+        /* Sleep only if no job is queued anywhere; a submitter signals
+         * after the push while holding this lock, hence no wake-up is lost.
+         * */ 
+        while(    !pthpool_has_work(pth)
+               && ((pth->action) != PTHPOOL_EXIT)
+               && (pthpool_dispatch(pth)==PTHPOOL_DISPATCH_MUTEX))
+        {
+            debug_body("waiting (thread: %d)", pth->thread_index);
+            __atomic_store_n(&(pth->idle), true, __ATOMIC_RELEASE);
+            pthread_cond_wait(&(pth->notify), &(pth->lock)); 
+            debug_body("notice recieved (thread: %d)", pth->thread_index);
+        }
+        __atomic_store_n(&(pth->idle), false, __ATOMIC_RELEASE);
+        pthpool_stats_wait(pth, wait_ns);
+
+        if(    ((pth->action)==PTHPOOL_EXIT)
+            && !pthpool_has_work(pth))
+        {
+            debug_body("exit request made for thread: %d", pth->thread_index);
+            pthread_mutex_unlock(&(pth->lock));
+            break;
+        }
+        pthread_mutex_unlock(&(pth->lock));
+    }
+    debug_exit("exiting thread: %d", pth->thread_index);
+    pthread_exit(NULL);
+    return(NULL);
+}
+/*============================================================================*/
+
+/*============================================================================+/
+ | Topology and placement
+/+============================================================================*/
+
+static int pthpool_read_int
+(
+    const char* fmt,
+    int         cpu,
+    int         default_value
+)
+{
+    char path[128];
+    int  value;
+    snprintf(path, sizeof(path), fmt, cpu);
+    FILE* fp = fopen(path, "r");
+    if(fp==NULL)
+    {
+        return default_value;
+    }
+    if(fscanf(fp, "%d", &value)!=1)
+    {
+        value = default_value;
+    }
+    fclose(fp);
+    return value;
+}
+
+static int pthpool_read_node(int cpu)
+/* The NUMA node appears as a link named node<k> in the sysfs cpu directory */ 
+{
+    char path[128];
+    int  node = 0;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+    DIR* dp = opendir(path);
+    if(dp==NULL)
+    {
+        return 0;
+    }
+    struct dirent* ep;
+    while((ep = readdir(dp))!=NULL)
+    {
+        if((strncmp(ep->d_name, "node", 4)==0) && isdigit((unsigned char)ep->d_name[4]))
+        {
+            node = atoi(ep->d_name+4);
+            break;
+        }
+    }
+    closedir(dp);
+    return node;
+}
+
+static matlib_index pthpool_dense_index
+(
+    int*         label,
+    matlib_index n
+)
+/* Renumbers the labels to 0, 1, ... in order of first appearance */ 
+{
+    matlib_index i, j, nr_distinct = 0;
+    int dense[n];
+    for(i=0; i<n; i++)
+    {
+        for(j=0; (j<i) && (label[j]!=label[i]); j++);
+        dense[i] = (j==i)? (int)(nr_distinct++): dense[j];
+    }
+    for(i=0; i<n; i++)
+    {
+        label[i] = dense[i];
+    }
+    return nr_distinct;
+}
+
+void pthpool_get_topology(pthpool_topology_t* topo)
+/* 
+ * Only the CPUs in the affinity mask of the process are listed. Missing
+ * sysfs entries are treated as one core per CPU on a single node.
+ *
+ * */ 
+{
+    debug_enter("%s", "");
+    cpu_set_t cpuset;
+    matlib_index i, n = 0;
+    int c;
+
+    if(sched_getaffinity(0, sizeof(cpu_set_t), &cpuset)!=0)
+    {
+        CPU_ZERO(&cpuset);
+        CPU_SET(0, &cpuset);
+    }
+    topo->nr_cpu  = CPU_COUNT(&cpuset);
+    topo->cpu     = calloc(topo->nr_cpu, sizeof(int));
+    topo->core    = calloc(topo->nr_cpu, sizeof(int));
+    topo->package = calloc(topo->nr_cpu, sizeof(int));
+    topo->node    = calloc(topo->nr_cpu, sizeof(int));
+    if((topo->cpu==NULL) || (topo->core==NULL) || (topo->package==NULL) || (topo->node==NULL))
+    {
+        term_exec("%s: topology of %d CPUs", strerror(errno), topo->nr_cpu);
+    }
+
+    for(c=0; (c<CPU_SETSIZE) && (n<topo->nr_cpu); c++)
+    {
+        if(CPU_ISSET(c, &cpuset))
+        {
+            topo->cpu[n]     = c;
+            topo->package[n] = pthpool_read_int(
+                "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", c, 0);
+            topo->core[n]    = pthpool_read_int(
+                "/sys/devices/system/cpu/cpu%d/topology/core_id", c, c);
+            topo->node[n]    = pthpool_read_node(c);
+            n++;
+        }
+    }
+    /* core ids are only unique within a package */ 
+    int core_key[n];
+    for(i=0; i<n; i++)
+    {
+        core_key[i] = topo->package[i]*65536 + topo->core[i];
+    }
+    topo->nr_core = pthpool_dense_index(core_key, n);
+    memcpy(topo->core, core_key, n*sizeof(int));
+
+    int tmp[n];
+    memcpy(tmp, topo->package, n*sizeof(int));
+    topo->nr_package = pthpool_dense_index(tmp, n);
+    memcpy(tmp, topo->node, n*sizeof(int));
+    topo->nr_node = pthpool_dense_index(tmp, n);
+
+    debug_exit( "CPUs: %d, cores: %d, packages: %d, NUMA nodes: %d", 
+                topo->nr_cpu, topo->nr_core, topo->nr_package, topo->nr_node);
+}
+
+void pthpool_free_topology(pthpool_topology_t* topo)
+{
+    matlib_free(topo->cpu);
+    matlib_free(topo->core);
+    matlib_free(topo->package);
+    matlib_free(topo->node);
+}
+
+/* Sort keys of a CPU for the placement policies */ 
+typedef struct
+{
+    int cpu;
+    int key[3];
+
+} pthpool_place_key_t;
+
+static int pthpool_place_cmp
+(
+    const void* a,
+    const void* b
+)
+{
+    const pthpool_place_key_t* ka = a;
+    const pthpool_place_key_t* kb = b;
+    int k;
+    for(k=0; k<3; k++)
+    {
+        if(ka->key[k]!=kb->key[k])
+        {
+            return (ka->key[k]<kb->key[k])? -1: 1;
+        }
+    }
+    return (ka->cpu<kb->cpu)? -1: (ka->cpu>kb->cpu);
+}
+
+void pthpool_place_threads
+(
+    matlib_index              num_threads,
+    PTHPOOL_PLACE             place,
+    const pthpool_topology_t* topo,
+    int*                      cpu_id
+)
+/* 
+ * Assigns a CPU to each thread, -1 for PTHPOOL_PLACE_NONE. Each CPU gets a
+ * domain (NUMA node, or socket if there is a single node), the rank of its
+ * core within the domain and its rank among the SMT siblings of the core;
+ * the policies differ only in the order of these keys. Threads beyond the
+ * number of CPUs wrap around.
+ *
+ * */ 
+{
+    matlib_index i, j, n = topo->nr_cpu;
+    if((place==PTHPOOL_PLACE_NONE) || (n==0))
+    {
+        for(i=0; i<num_threads; i++)
+        {
+            cpu_id[i] = -1;
+        }
+        return;
+    }
+
+    const int* domain = (topo->nr_node>1)? topo->node: topo->package;
+    pthpool_place_key_t order[n];
+    for(i=0; i<n; i++)
+    {
+        int smt = 0, core_rank = 0;
+        for(j=0; j<i; j++)
+        {
+            smt += (topo->core[j]==topo->core[i]);
+        }
+        /* cores of the same domain which appear first */ 
+        for(j=0; j<n; j++)
+        {
+            if((domain[j]==domain[i]) && (topo->core[j]<topo->core[i]))
+            {
+                matlib_index k;
+                for(k=0; (k<j) && (topo->core[k]!=topo->core[j]); k++);
+                core_rank += (k==j);
+            }
+        }
+        order[i].cpu = topo->cpu[i];
+        switch(place)
+        {
+            case PTHPOOL_PLACE_COMPACT:
+                order[i].key[0] = domain[i];
+                order[i].key[1] = core_rank;
+                order[i].key[2] = smt;
+                break;
+            case PTHPOOL_PLACE_SCATTER:
+                order[i].key[0] = smt;
+                order[i].key[1] = core_rank;
+                order[i].key[2] = domain[i];
+                break;
+            default: /* PTHPOOL_PLACE_CORE */ 
+                order[i].key[0] = smt;
+                order[i].key[1] = domain[i];
+                order[i].key[2] = core_rank;
+                break;
+        }
+    }
+    qsort(order, n, sizeof(pthpool_place_key_t), pthpool_place_cmp);
+
+    for(i=0; i<num_threads; i++)
+    {
+        cpu_id[i] = order[i%n].cpu;
+    }
+}
+
+static PTHPOOL_PLACE pthpool_default_place(void)
+{
+    const char* env = getenv(PTHPOOL_PLACE_ENV);
+    if(env!=NULL)
+    {
+        if(strcmp(env, "none")==0)
+        {
+            return PTHPOOL_PLACE_NONE;
+        }
+        if(strcmp(env, "compact")==0)
+        {
+            return PTHPOOL_PLACE_COMPACT;
+        }
+        if(strcmp(env, "scatter")==0)
+        {
+            return PTHPOOL_PLACE_SCATTER;
+        }
+        warn_if(strcmp(env, "core")!=0, "unknown placement: %s", env);
+    }
+    return PTHPOOL_PLACE_CORE;
+}
+
+/*============================================================================*/
+
+void pthpool_create_threads
+( 
+    matlib_index    num_threads, 
+    pthpool_data_t* mp
+)
+{
+    pthpool_create_threads_placed(num_threads, mp, pthpool_default_place());
+}
+
+void pthpool_create_threads_placed
+( 
+    matlib_index    num_threads, 
+    pthpool_data_t* mp,
+    PTHPOOL_PLACE   place
+)
+{
+    debug_enter("Number of threads: %d, placement: %d", num_threads, place);
+    matlib_index i, j;
+    pthread_attr_t attr;
+
+    /* initialize and set thread detached attribute */
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+
+    int pthread_r;
+
+    pthpool_topology_t topo;
+    int cpu_id[num_threads];
+    pthpool_get_topology(&topo);
+    pthpool_place_threads(num_threads, place, &topo, cpu_id);
+
+    pthpool_shared_t* shared = calloc(1, sizeof(pthpool_shared_t));
+    if(shared==NULL)
+    {
+        term_exec("%s", "memory allocation failed");
+    }
+    shared->dispatch = PTHPOOL_DISPATCH_MUTEX;
+    for(j=0; j<PTHPOOL_INJECT_SIZE; j++)
+    {
+        shared->inject[j].seq = j;
+    }
+    pthread_mutex_init(&(shared->region_lock), NULL);
+
+    /* All deques must exist before the first thread starts stealing */ 
+    for(i=0; i<num_threads; i++)
+    {
+        mp[i].thread_index = i;
+        mp[i].num_threads  = num_threads;
+        mp[i].pool         = mp;
+        mp[i].shared       = shared;
+        mp[i].idle         = false;
+        mp[i].top          = 0;
+        mp[i].bottom       = 0;
+        mp[i].pin_top      = 0;
+        mp[i].pin_bottom   = 0;
+        mp[i].npinned      = 0;
+        mp[i].wake         = 0;
+
+        mp[i].cpu_id    = cpu_id[i];
+        mp[i].numa_node = 0;
+        CPU_ZERO(&mp[i].cpu);
+        for(j=0; j<topo.nr_cpu; j++)
+        {
+            if(cpu_id[i]<0)
+            {
+                CPU_SET(topo.cpu[j], &mp[i].cpu);
+            }
+            else if(topo.cpu[j]==cpu_id[i])
+            {
+                CPU_SET(topo.cpu[j], &mp[i].cpu);
+                mp[i].numa_node = topo.node[j];
+            }
+        }
+        
+        pthread_mutex_init(&(mp[i].lock), NULL);
+        pthread_mutex_init(&(mp[i].qlock), NULL);
+        pthread_cond_init(&(mp[i].notify), NULL);
+        pthpool_handle_init(&(mp[i].nosync));
+        pthpool_stats_clear(&(mp[i].stats));
+        mp[i].action = PTHPOOL_WAIT;
+        debug_body("thread index: %d, action : WAIT", mp[i].thread_index);
+    }
+    pthpool_free_topology(&topo);
+
+    for(i=0; i<num_threads; i++)
+    {
+        /* set the CPU affinity */ 
+        pthread_r = pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &mp[i].cpu);
+        warn_if(pthread_r!=0, "CPU affinity of thread %d not set (return value: %d)", i, pthread_r);
+        
+        pthread_r = pthread_create( &(mp[i].thread), 
+                                    &attr, 
+                                    pthpool_schedule_task, 
+                                    (void *) &mp[i]); 
+
+        if(pthread_r)
+        {
+            term_exec("failed to create the pthread (return value: %d)", pthread_r);
+        }
+        debug_body("thread: %d, CPU: %d, NUMA node: %d", i, mp[i].cpu_id, mp[i].numa_node);
+    }
+    pthread_attr_destroy(&attr);
+    debug_exit("%s", "");
+}
+/*============================================================================*/
+
+void pthpool_submit_to
+( 
+    matlib_index      thread_index, 
+    pthpool_data_t*   mp, 
+    pthpool_task_t*   task,
+    pthpool_handle_t* handle
+)
+/* 
+ * Queues the task on the given thread of the pool; it may still be stolen
+ * by another thread. The task is copied, its argument must stay valid until
+ * the handle has been waited upon.
+ *
+ * */ 
+{
+    pthpool_job_t job = { .task = *task, .handle = handle, .submit_ns = pthpool_now()};
+
+    pthpool_handle_arm(handle);
+    if(!pthpool_push(&mp[thread_index], &job))
+    {
+        /* queue full: run it here */ 
+        task->function(task->argument);
+        pthpool_complete(handle);
+    }
+}
+
+void pthpool_submit_pinned
+( 
+    matlib_index      thread_index, 
+    pthpool_data_t*   mp, 
+    pthpool_task_t*   task,
+    pthpool_handle_t* handle
+)
+/* 
+ * Queues a task which must run on the given thread, e.g. to initialize the
+ * memory that thread owns. Pinned tasks are never stolen and take
+ * precedence over the deque. If the queue is full the submitter waits, or
+ * runs the task itself if it is that thread.
+ *
+ * */ 
+{
+    pthpool_data_t* pth = &mp[thread_index];
+    pthpool_job_t   job = { .task = *task, .handle = handle, .submit_ns = pthpool_now()};
+
+    pthpool_handle_arm(handle);
+    while(1)
+    {
+        pthread_mutex_lock(&(pth->qlock));
+        if(pth->pin_bottom - pth->pin_top < PTHPOOL_PINNED_SIZE)
+        {
+            pth->pinned[pth->pin_bottom%PTHPOOL_PINNED_SIZE] = job;
+            pth->pin_bottom++;
+            __atomic_add_fetch(&(pth->npinned), 1, __ATOMIC_SEQ_CST);
+            pthread_mutex_unlock(&(pth->qlock));
+            break;
+        }
+        pthread_mutex_unlock(&(pth->qlock));
+        if(pth==pthpool_self)
+        {
+            task->function(task->argument);
+            pthpool_complete(handle);
+            return;
+        }
+        sched_yield();
+    }
+    pthpool_wake(pth);
+}
+
+void pthpool_submit
+( 
+    matlib_index      num_threads, 
+    pthpool_data_t*   mp, 
+    pthpool_task_t*   task,
+    pthpool_handle_t* handle
+)
+/* 
+ * Tasks submitted from a thread of the pool go to its own deque, tasks from
+ * outside go to the shared queue, or round-robin to the deques if it is
+ * full. Waking the round-robin target unconditionally guarantees that some
+ * thread sees the job; an idle thread is woken as well in case the target
+ * is busy.
+ *
+ * */ 
+{
+    matlib_index thread_index;
+    if((pthpool_self!=NULL) && (pthpool_self->pool==mp))
+    {
+        thread_index = pthpool_self->thread_index;
+    }
+    else
+    {
+        thread_index = __atomic_fetch_add(&(mp->shared->next), 1, __ATOMIC_RELAXED)%num_threads;
+        if(pthpool_inject(mp->shared, task, handle))
+        {
+            pthpool_wake(&mp[thread_index]);
+            pthpool_wake_idle(mp);
+            return;
+        }
+    }
+    pthpool_submit_to(thread_index, mp, task, handle);
+}
+
+void pthpool_wait
+( 
+    pthpool_data_t*   mp, 
+    pthpool_handle_t* handle
+)
+/* 
+ * A thread of the pool keeps executing queued tasks while it waits so that
+ * tasks may wait on their children; any other thread blocks.
+ *
+ * */ 
+{
+    matlib_index i;
+    bool spin = (pthpool_dispatch(mp)==PTHPOOL_DISPATCH_SPIN);
+
+    if((pthpool_self!=NULL) && (pthpool_self->pool==mp))
+    {
+        while(__atomic_load_n(&(handle->state), __ATOMIC_ACQUIRE)!=PTHPOOL_HANDLE_DONE)
+        {
+            if(!pthpool_run_one(pthpool_self))
+            {
+                sched_yield();
+            }
+        }
+        /* the last completion may still hold the lock */ 
+        pthread_mutex_lock(&(handle->lock));
+        pthread_mutex_unlock(&(handle->lock));
+    }
+    else if(spin)
+    {
+        for(i=0; (i<mp->shared->spin_limit) && 
+                 (__atomic_load_n(&(handle->state), __ATOMIC_ACQUIRE)!=PTHPOOL_HANDLE_DONE); i++)
+        {
+            pthpool_backoff(i);
+        }
+        while(__atomic_load_n(&(handle->state), __ATOMIC_ACQUIRE)!=PTHPOOL_HANDLE_DONE)
+        {
+            uint32_t expected = PTHPOOL_HANDLE_RUNNING;
+            __atomic_compare_exchange_n( &(handle->state), &expected, PTHPOOL_HANDLE_PARKED, 
+                                         false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+            pthpool_futex_wait(&(handle->state), PTHPOOL_HANDLE_PARKED);
+        }
+        pthread_mutex_lock(&(handle->lock));
+        pthread_mutex_unlock(&(handle->lock));
+    }
+    else
+    {
+        pthread_mutex_lock(&(handle->lock));
+        while(__atomic_load_n(&(handle->state), __ATOMIC_ACQUIRE)!=PTHPOOL_HANDLE_DONE)
+        {
+            pthread_cond_wait(&(handle->done), &(handle->lock));
+        }
+        pthread_mutex_unlock(&(handle->lock));
+    }
+}
+/*============================================================================*/
+
+void pthpool_exec_task
+( 
+    matlib_index    num_threads, 
+    pthpool_data_t* mp, 
+    pthpool_task_t* task
+)
+/* 
+ * Task i is queued on thread i and the call returns after all tasks are
+ * done. Threads which finish early steal the remaining tasks.
+ *
+ * */ 
+{
+    debug_enter("Number of threads: %d", num_threads);
+    matlib_index i;
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    for(i=0; i<num_threads; i++)
+    {
+        pthpool_submit_to(i, mp, &task[i], &handle);
+    }
+    pthpool_wait(mp, &handle);
+    pthpool_handle_destroy(&handle);
+    debug_exit("%s", "");
+}
+/*============================================================================*/
+
+void pthpool_exec_task_async
+( 
+    matlib_index      num_threads, 
+    pthpool_data_t*   mp, 
+    pthpool_task_t*   task,
+    pthpool_handle_t* handle
+)
+/* 
+ * As pthpool_exec_task but returns right away; the tasks are counted in the
+ * handle of the caller, which must be waited upon with pthpool_wait before
+ * the tasks or their arguments go out of scope.
+ *
+ * */ 
+{
+    debug_enter("Number of threads: %d", num_threads);
+    matlib_index i;
+    for(i=0; i<num_threads; i++)
+    {
+        pthpool_submit_to(i, mp, &task[i], handle);
+    }
+    debug_exit("%s", "");
+}
+
+void pthpool_exec_task_nosync
+( 
+    matlib_index    num_threads, 
+    pthpool_data_t* mp, 
+    pthpool_task_t* task
+)
+{
+    debug_enter("Number of threads: %d", num_threads);
+    matlib_index i;
+    for(i=0; i<num_threads; i++)
+    {
+        pthpool_submit_to(i, mp, &task[i], &(mp[i].nosync));
+    }
+    debug_exit("%s", "");
+}
+
+void pthpool_sync_threads
+( 
+    matlib_index    num_threads, 
+    pthpool_data_t* mp 
+)
+{
+    debug_enter("Number of threads: %d", num_threads);
+    matlib_index i;
+    for(i=0; i<num_threads; i++)
+    {
+        pthpool_wait(mp, &(mp[i].nosync));
+        debug_body("completed thread: %d", mp[i].thread_index);
+    }
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+
+void pthpool_destroy_threads
+( 
+    matlib_index    num_threads, 
+    pthpool_data_t* mp 
+)
+/* 
+ * Queued tasks are drained before the threads exit.
+ *
+ * */ 
+{
+    debug_enter("number of threads: %d", num_threads);
+    matlib_index i;
+    void* status;
+    for( i=0; i<num_threads; i++)
+    {
+        debug_body("thread id: %d", i);
+        pthread_mutex_lock(&(mp[i].lock));
+        __atomic_store_n(&(mp[i].action), PTHPOOL_EXIT, __ATOMIC_SEQ_CST);
+        debug_body("thread index: %d, action : EXIT", mp[i].thread_index);
+        pthread_mutex_unlock(&(mp[i].lock));
+        pthpool_wake(&mp[i]);
+    }
+    for(i=0; i<num_threads; i++)
+    {
+        pthread_join((mp[i].thread), &status); 
+    }
+    for(i=0; i<num_threads; i++)
+    {
+        pthread_mutex_destroy(&(mp[i].lock));
+        pthread_mutex_destroy(&(mp[i].qlock));
+        pthread_cond_destroy(&(mp[i].notify));
+        pthpool_handle_destroy(&(mp[i].nosync));
+    }
+    pthread_mutex_destroy(&(mp->shared->region_lock));
+    matlib_free(mp->shared);
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+
+void pthpool_set_dispatch
+( 
+    matlib_index     num_threads, 
+    pthpool_data_t*  mp, 
+    PTHPOOL_DISPATCH dispatch
+)
+/* 
+ * Selects how the threads of the pool wait; to be called while no task is
+ * in flight. Sleeping threads are woken so that they switch over.
+ *
+ * */ 
+{
+    debug_enter("dispatch: %d", dispatch);
+    matlib_index i;
+    mp->shared->spin_limit = pthpool_spin_limit(num_threads+1);
+    __atomic_store_n(&(mp->shared->dispatch), dispatch, __ATOMIC_SEQ_CST);
+    for(i=0; i<num_threads; i++)
+    {
+        pthread_mutex_lock(&(mp[i].lock));
+        pthread_cond_signal(&(mp[i].notify));
+        pthread_mutex_unlock(&(mp[i].lock));
+
+        __atomic_add_fetch(&(mp[i].wake), 1, __ATOMIC_SEQ_CST);
+        pthpool_futex_wake(&(mp[i].wake), 1);
+    }
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+
+static void pthpool_thfunc_first_touch(void* mp)
+{
+    pthpool_arg_t* ptr = (pthpool_arg_t*) mp;
+    char*  base        = (char*) (ptr->shared_data[0]);
+    size_t block_size  = *((size_t*) (ptr->shared_data[1]));
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+
+    memset( base + start_end_index[0]*block_size, 0, 
+            (start_end_index[1]-start_end_index[0])*block_size);
+}
+
+void pthpool_first_touch
+(
+    matlib_index*   Np,
+    size_t          block_size,
+    void*           ptr,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+)
+/* 
+ * Zeroes ptr with the partition of pthpool_func (Np[0] blocks per thread,
+ * Np[1] blocks in total, the last thread takes the remainder) from the
+ * owning threads, so that with first-touch page placement each partition
+ * lands on the NUMA node of its thread. ptr must not have been written
+ * yet; large calloc/malloc allocations are fresh anonymous mappings.
+ *
+ * */ 
+{
+    debug_enter("Np: [%d, %d], block size: %d", Np[0], Np[1], block_size);
+    matlib_index i;
+    matlib_index nsdata[num_threads][2];
+    void* shared_data[2] = { ptr, (void*)&block_size};
+
+    pthpool_arg_t    arg[num_threads];
+    pthpool_task_t   task[num_threads];
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    for(i=0; i<num_threads; i++)
+    {
+        nsdata[i][0] = i*Np[0];
+        nsdata[i][1] = (i<num_threads-1)? (i+1)*Np[0]: Np[1];
+        arg[i].shared_data    = shared_data; 
+        arg[i].nonshared_data = (void**)&nsdata[i];
+        arg[i].thread_index   = i;
+        task[i].function      = pthpool_thfunc_first_touch;
+        task[i].argument      = &arg[i];
+        pthpool_submit_pinned(i, mp, &task[i], &handle);
+    }
+    pthpool_wait(mp, &handle);
+    pthpool_handle_destroy(&handle);
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+
+void pthpool_partition_split
+(
+    matlib_index         N,
+    matlib_index         num_threads,
+    pthpool_partition_t* part
+)
+/* 
+ * part->start must provide num_threads+1 entries.
+ *
+ * */ 
+{
+    matlib_index i;
+    part->N           = N;
+    part->num_threads = num_threads;
+    for(i=0; i<=num_threads; i++)
+    {
+        part->start[i] = i*N/num_threads;
+    }
+}
+
+void pthpool_partition_touch
+(
+    const pthpool_partition_t* part,
+    size_t                     block_size,
+    size_t                     size,
+    void*                      ptr,
+    pthpool_data_t*            mp
+)
+/* 
+ * Zeroes the size bytes at ptr from the owning threads: thread i touches
+ * the blocks [start[i], start[i+1]) and the last thread also the bytes past
+ * N blocks. As for pthpool_first_touch, ptr must not have been written yet.
+ *
+ * */ 
+{
+    debug_enter("N: %d, block size: %d, size: %d", part->N, block_size, size);
+    matlib_index i, num_threads = part->num_threads;
+    matlib_index nsdata[num_threads][2];
+    size_t byte_size = 1;
+    void* shared_data[2] = { ptr, (void*)&byte_size};
+
+    assert(size>=part->N*block_size);
+
+    pthpool_arg_t    arg[num_threads];
+    pthpool_task_t   task[num_threads];
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    for(i=0; i<num_threads; i++)
+    {
+        nsdata[i][0] = part->start[i]*block_size;
+        nsdata[i][1] = (i<num_threads-1)? part->start[i+1]*block_size: size;
+        arg[i].shared_data    = shared_data; 
+        arg[i].nonshared_data = (void**)&nsdata[i];
+        arg[i].thread_index   = i;
+        task[i].function      = pthpool_thfunc_first_touch;
+        task[i].argument      = &arg[i];
+        pthpool_submit_pinned(i, mp, &task[i], &handle);
+    }
+    pthpool_wait(mp, &handle);
+    pthpool_handle_destroy(&handle);
+    debug_exit("%s", "");
+}
+
+void pthpool_for_partition
+(
+    const pthpool_partition_t* part,
+    void**                     shared_data,
+    void*                      thfunc,
+    pthpool_data_t*            mp
+)
+{
+    debug_enter("N: %d, threads: %d", part->N, part->num_threads);
+
+    pthpool_arg_t    arg[part->num_threads];
+    pthpool_task_t   task[part->num_threads];
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    pthpool_for_partition_async(part, shared_data, thfunc, mp, arg, task, &handle);
+    pthpool_wait(mp, &handle);
+    pthpool_handle_destroy(&handle);
+    debug_exit("%s", "");
+}
+
+void pthpool_for_partition_async
+(
+    const pthpool_partition_t* part,
+    void**                     shared_data,
+    void*                      thfunc,
+    pthpool_data_t*            mp,
+    pthpool_arg_t*             arg,
+    pthpool_task_t*            task,
+    pthpool_handle_t*          handle
+)
+/* 
+ * Queues thfunc over [start[i], start[i+1]) on thread i and returns; the
+ * ranges are pinned, not stolen, so that every thread works on the memory
+ * it owns. Empty ranges are skipped. arg and task provide num_threads
+ * entries; they, the partition and shared_data must stay valid until the
+ * handle has been waited upon.
+ *
+ * */ 
+{
+    matlib_index i;
+    for(i=0; i<part->num_threads; i++)
+    {
+        if(part->start[i+1]>part->start[i])
+        {
+            arg[i].shared_data    = shared_data; 
+            arg[i].nonshared_data = (void**)&(part->start[i]);
+            arg[i].thread_index   = i;
+            task[i].function      = (void*)thfunc;
+            task[i].argument      = &arg[i];
+            pthpool_submit_pinned(i, mp, &task[i], handle);
+        }
+    }
+}
+
+/*============================================================================*/
+
+void pthpool_func
+(
+    matlib_index*   Np,
+    void**          shared_data,
+    void*           thfunc,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+
+)
+{
+    debug_enter("Np: [%d, %d]", Np[0], Np[1]);
+
+    matlib_index i; 
+    /* define the shared data */ 
+
+    matlib_index nsdata[num_threads][2];
+
+    pthpool_arg_t  arg[num_threads];
+    pthpool_task_t task[num_threads];
+
+
+    for(i=0; i<num_threads-1; i++)
+    {
+        nsdata[i][0] = i*Np[0];
+        nsdata[i][1] = (i+1)*Np[0];
+        arg[i].shared_data    = shared_data; 
+        arg[i].nonshared_data = (void**)&nsdata[i];
+        arg[i].thread_index   = i;
+        /* Define the task */ 
+        task[i].function  = (void*)thfunc;
+        task[i].argument  = &arg[i];
+    }
+    nsdata[i][0] = i*Np[0];
+    nsdata[i][1] = Np[1];
+    arg[i].shared_data    = shared_data; 
+    arg[i].nonshared_data = (void**)&nsdata[i];
+    arg[i].thread_index   = i;
+    /* Define the task */ 
+    task[i].function  = (void*)thfunc;
+    task[i].argument  = &arg[i];
+
+    debug_body("%s", "created task");
+
+    pthpool_exec_task(num_threads, mp, task);
+    
+    debug_exit("%s", "");
+}
+
 /*============================================================================*/
 
-static void* pthpool_schedule_task(void *mp)
+/* What the iterations of a loop compute */ 
+typedef enum
+{
+    PTHPOOL_LOOP_FOR,
+    PTHPOOL_LOOP_XREDUCE,
+    PTHPOOL_LOOP_ZREDUCE
+
+} PTHPOOL_LOOP;
+
+typedef struct
+{
+    matlib_index  start;
+    matlib_index  end;
+    matlib_index  grain;
+    matlib_index  nr_chunk;
+    matlib_index  num_threads;    /* nr. of participating threads */ 
+    PTHPOOL_SCHED sched;
+    PTHPOOL_LOOP  kind;
+    matlib_index  next;           /* first chunk not taken yet */ 
+    void**        shared_data;
+    void*         thfunc;
+    void*         partial;        /* one entry per chunk for reductions */ 
+
+} pthpool_loop_t;
+
+static bool pthpool_loop_take
+(
+    pthpool_loop_t* loop,
+    matlib_index    thread_index,
+    bool*           first,
+    matlib_index*   chunk
+)
+/* 
+ * Hands out the next run of chunks [chunk[0], chunk[1]) of the calling
+ * participant, returns false once the loop is exhausted.
+ *
+ * */ 
+{
+    matlib_index nr_chunk = loop->nr_chunk;
+    matlib_index size;
+
+    switch(loop->sched)
+    {
+        case PTHPOOL_SCHED_DYNAMIC:
+            chunk[0] = __atomic_fetch_add(&(loop->next), 1, __ATOMIC_RELAXED);
+            chunk[1] = chunk[0]+1;
+            return (chunk[0]<nr_chunk);
+
+        case PTHPOOL_SCHED_GUIDED:
+            chunk[0] = __atomic_load_n(&(loop->next), __ATOMIC_RELAXED);
+            do
+            {
+                if(chunk[0]>=nr_chunk)
+                {
+                    return false;
+                }
+                size = (nr_chunk-chunk[0])/(2*loop->num_threads);
+                size = (size<1)? 1: size;
+            }
+            while(!__atomic_compare_exchange_n( &(loop->next), &chunk[0], 
+                                                chunk[0]+size, true, 
+                                                __ATOMIC_RELAXED, 
+                                                __ATOMIC_RELAXED));
+            chunk[1] = chunk[0]+size;
+            return true;
+
+        default:
+            if(!*first)
+            {
+                return false;
+            }
+            *first   = false;
+            chunk[0] = thread_index*nr_chunk/loop->num_threads;
+            chunk[1] = (thread_index+1)*nr_chunk/loop->num_threads;
+            return (chunk[1]>chunk[0]);
+    }
+}
+
+static inline matlib_index pthpool_loop_bound
+(
+    pthpool_loop_t* loop,
+    matlib_index    chunk
+)
+{
+    matlib_index i = loop->start+chunk*loop->grain;
+    return (i<loop->end)? i: loop->end;
+}
+
+static void pthpool_thfunc_loop(void* mp)
+{
+    pthpool_arg_t*  ptr  = (pthpool_arg_t*) mp;
+    pthpool_loop_t* loop = (pthpool_loop_t*) (ptr->shared_data[0]);
+
+    matlib_index c, chunk[2], start_end_index[2];
+    bool first = true;
+
+    pthpool_arg_t arg = { .shared_data    = loop->shared_data, 
+                          .nonshared_data = (void**)start_end_index,
+                          .thread_index   = ptr->thread_index };
+
+    while(pthpool_loop_take(loop, ptr->thread_index, &first, chunk))
+    {
+        if(loop->kind==PTHPOOL_LOOP_FOR)
+        {
+            start_end_index[0] = pthpool_loop_bound(loop, chunk[0]);
+            start_end_index[1] = pthpool_loop_bound(loop, chunk[1]);
+            ((void* (*)(void*))loop->thfunc)(&arg);
+            continue;
+        }
+        for(c=chunk[0]; c<chunk[1]; c++)
+        {
+            start_end_index[0] = pthpool_loop_bound(loop, c);
+            start_end_index[1] = pthpool_loop_bound(loop, c+1);
+            if(loop->kind==PTHPOOL_LOOP_XREDUCE)
+            {
+                ((matlib_real*)loop->partial)[c] = 
+                    ((matlib_real (*)(void*))loop->thfunc)(&arg);
+            }
+            else
+            {
+                ((matlib_complex*)loop->partial)[c] = 
+                    ((matlib_complex (*)(void*))loop->thfunc)(&arg);
+            }
+        }
+    }
+}
+
+static void pthpool_loop_exec
+(
+    pthpool_loop_t* loop,
+    pthpool_data_t* mp
+)
+/* 
+ * One participant is queued per thread (at most one per chunk) and the
+ * call returns after the loop is done; the caller must have set the range,
+ * the grain and the number of threads.
+ *
+ * */ 
+{
+    matlib_index i;
+    loop->grain    = (loop->grain<1)? 1: loop->grain;
+    loop->nr_chunk = (loop->end>loop->start)? 
+                     (loop->end-loop->start+loop->grain-1)/loop->grain: 0;
+    loop->next     = 0;
+    if(loop->num_threads>loop->nr_chunk)
+    {
+        loop->num_threads = loop->nr_chunk;
+    }
+    debug_body( "range: [%d, %d), grain: %d, nr. chunks: %d, threads: %d",
+                loop->start, loop->end, loop->grain, 
+                loop->nr_chunk, loop->num_threads);
+
+    void* shared_data[1] = { (void*)loop };
+
+    pthpool_arg_t    arg[loop->num_threads+1];
+    pthpool_task_t   task[loop->num_threads+1];
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    for(i=0; i<loop->num_threads; i++)
+    {
+        arg[i].shared_data    = shared_data;
+        arg[i].nonshared_data = NULL;
+        arg[i].thread_index   = i;
+        task[i].function      = pthpool_thfunc_loop;
+        task[i].argument      = &arg[i];
+        pthpool_submit_to(i, mp, &task[i], &handle);
+    }
+    pthpool_wait(mp, &handle);
+    pthpool_handle_destroy(&handle);
+}
+
+void pthpool_for
+(
+    matlib_index    start,
+    matlib_index    end,
+    PTHPOOL_SCHED   sched,
+    matlib_index    grain,
+    void**          shared_data,
+    void*           thfunc,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+)
+/* 
+ * Calls thfunc over the iterations [start, end). With STATIC and grain 0
+ * thread i processes [start+i*n/num_threads, start+(i+1)*n/num_threads).
+ *
+ * */ 
+{
+    debug_enter("range: [%d, %d), schedule: %d", start, end, sched);
+
+    pthpool_loop_t loop = { .start       = start,
+                            .end         = end,
+                            .grain       = grain,
+                            .num_threads = num_threads,
+                            .sched       = sched,
+                            .kind        = PTHPOOL_LOOP_FOR,
+                            .shared_data = shared_data,
+                            .thfunc      = thfunc,
+                            .partial     = NULL };
+    pthpool_loop_exec(&loop, mp);
+
+    debug_exit("%s", "");
+}
+
+matlib_real pthpool_for_xreduce
+(
+    matlib_index    start,
+    matlib_index    end,
+    PTHPOOL_SCHED   sched,
+    matlib_index    grain,
+    PTHPOOL_REDUCE  op,
+    void**          shared_data,
+    void*           thfunc,
+    matlib_index    num_threads,
+    pthpool_data_t* mp
+)
+/* 
+ * thfunc returns the partial of its range as matlib_real. An empty range
+ * gives 0 for PTHPOOL_REDUCE_SUM and -HUGE_VAL for PTHPOOL_REDUCE_MAX.
+ *
+ * */ 
 {
-    pthpool_data_t* pth = (pthpool_data_t*) mp;
-    debug_enter("Executing thread index: %d", pth->thread_index);
-    pthpool_task_t task; 
+    debug_enter("range: [%d, %d), schedule: %d, op: %d", start, end, sched, op);
+
+    matlib_index c;
+    matlib_real result = (op==PTHPOOL_REDUCE_MAX)? -HUGE_VAL: 0;
 
-    clock_t start, duration;
+    pthpool_loop_t loop = { .start       = start,
+                            .end         = end,
+                            .grain       = (grain<1)? PTHPOOL_REDUCE_GRAIN: grain,
+                            .num_threads = num_threads,
+                            .sched       = sched,
+                            .kind        = PTHPOOL_LOOP_XREDUCE,
+                            .shared_data = shared_data,
+                            .thfunc      = thfunc };
     
-    while(1) /* Keep the thread waiting in an infinite loop */ 
+    matlib_xv partial = {.len = 0, .elem_p = NULL};
+    if(end>start)
     {
-        debug_body("Entering infinite loop (thread: %d)", pth->thread_index);
-        pthread_mutex_lock(&(pth->lock));
-        while((pth->action) == PTHPOOL_WAIT)
-        {
-            debug_body("waiting (thread: %d)", pth->thread_index);
-            /* Keep waiting on the condition variable until the thread is awaken */ 
-            /* Here the mutex gets unlocked */ 
-            pthread_cond_wait(&(pth->notify), &(pth->lock)); 
-            /* on returning we regain the lock */ 
-            debug_body("notice recieved (thread: %d)", pth->thread_index);
-        }
-        if((pth->action)==PTHPOOL_EXIT)
-        {
-            debug_body("exit request made for thread: %d", pth->thread_index);
-            break;
-        }
-
-        /* do the task */
-        debug_body("performing task with thread: %d", pth->thread_index);
-        task = *(pth->task);
-        pthread_mutex_unlock(&(pth->lock));
-        task.function(task.argument);
+        matlib_create_xv( (end-start+loop.grain-1)/loop.grain, 
+                          &partial, MATLIB_COL_VECT);
+    }
+    loop.partial = (void*)partial.elem_p;
+    pthpool_loop_exec(&loop, mp);
 
-        /* Check if any threads are waiting for finishing the task */ 
-        debug_body("task completed with thread: %d", pth->thread_index);
-        pthread_mutex_lock(&(pth->lock));
-        if((pth->action) == PTHPOOL_NOTIFY)
-        {
-            debug_body("notify thread: %d", pth->thread_index);
-            (pth->action) = PTHPOOL_WAIT;
-            debug_body("thread index: %d, action : WAIT", pth->thread_index);
-            pthread_cond_signal(&(pth->notify)); 
-            pthread_mutex_unlock(&(pth->lock));
-        }
-        else
+    if(op==PTHPOOL_REDUCE_SUM)
+    {
+        result = matlib_xsum_pairwise(partial.len, partial.elem_p);
+    }
+    else
+    {
+        for(c=0; c<partial.len; c++)
         {
-            (pth->action) = PTHPOOL_WAIT;
-            debug_body("thread index: %d, action : WAIT", pth->thread_index);
-            pthread_mutex_unlock(&(pth->lock));
+            result = (partial.elem_p[c]>result)? partial.elem_p[c]: result;
         }
     }
-    pthread_mutex_unlock(&(pth->lock));
-    debug_exit("exiting thread: %d", pth->thread_index);
-    pthread_exit(NULL);
-    return(NULL);
+    matlib_free(partial.elem_p);
+
+    debug_exit("result: %0.16f", result);
+    return(result);
 }
-/*============================================================================*/
 
-void pthpool_create_threads
-( 
-    matlib_index    num_threads, 
+matlib_complex pthpool_for_zreduce
+(
+    matlib_index    start,
+    matlib_index    end,
+    PTHPOOL_SCHED   sched,
+    matlib_index    grain,
+    void**          shared_data,
+    void*           thfunc,
+    matlib_index    num_threads,
     pthpool_data_t* mp
 )
+/* 
+ * thfunc returns the partial sum of its range as matlib_complex; the real
+ * and imaginary parts are summed pairwise separately.
+ *
+ * */ 
 {
-    debug_enter("Number of threads: %d", num_threads);
-    matlib_index i, j;
-    pthread_attr_t attr;
-
-    /* initialize and set thread detached attribute */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+    debug_enter("range: [%d, %d), schedule: %d", start, end, sched);
 
-    int pthread_r;
+    matlib_index c;
+    matlib_complex result = 0;
 
-    for(i=0; i<num_threads; i++)
+    pthpool_loop_t loop = { .start       = start,
+                            .end         = end,
+                            .grain       = (grain<1)? PTHPOOL_REDUCE_GRAIN: grain,
+                            .num_threads = num_threads,
+                            .sched       = sched,
+                            .kind        = PTHPOOL_LOOP_ZREDUCE,
+                            .shared_data = shared_data,
+                            .thfunc      = thfunc };
+    
+    if(end>start)
     {
-        mp[i].thread_index = i;
-        /* set the CPU affinity */ 
-        CPU_ZERO(&mp[i].cpu);
-        CPU_SET( i%MAX_NUM_CPU, &mp[i].cpu);
-        pthread_r = pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &mp[i].cpu);
-        
-        pthread_mutex_init(&(mp[i].lock), NULL);
-        pthread_cond_init(&(mp[i].notify), NULL);
-        mp[i].action = PTHPOOL_WAIT;
-        debug_body("thread index: %d, action : WAIT", mp[i].thread_index);
-        pthread_r = pthread_create( &(mp[i].thread), 
-                                    &attr, 
-                                    pthpool_schedule_task, 
-                                    (void *) &mp[i]); 
+        matlib_zv partial;
+        matlib_xv re, im;
+        matlib_index nr_chunk = (end-start+loop.grain-1)/loop.grain;
+        matlib_create_zv( nr_chunk, &partial, MATLIB_COL_VECT);
+        matlib_create_xv( nr_chunk, &re, MATLIB_COL_VECT);
+        matlib_create_xv( nr_chunk, &im, MATLIB_COL_VECT);
 
-        //pthread_setaffinity_np(mp[i].thread, sizeof(cpu_set_t), &mp[i].cpu);
-        if(pthread_r)
+        loop.partial = (void*)partial.elem_p;
+        pthpool_loop_exec(&loop, mp);
+
+        for(c=0; c<nr_chunk; c++)
         {
-            term_exec("failed to create the pthread (return value: %d)", pthread_r);
+            re.elem_p[c] = creal(partial.elem_p[c]);
+            im.elem_p[c] = cimag(partial.elem_p[c]);
         }
+        result =    matlib_xsum_pairwise(nr_chunk, re.elem_p)
+                 + I*matlib_xsum_pairwise(nr_chunk, im.elem_p);
 
-        BEGIN_DEBUG
-            cpu_set_t cpuset_tmp;
-
-            pthread_getaffinity_np(mp[i].thread, sizeof(cpu_set_t), &cpuset_tmp);
-            if (CPU_ISSET(i, &cpuset_tmp))
-            {
-                debug_print("thread: %d, CPU affinity: %d", i, i);
-            }
-        END_DEBUG
+        matlib_free(partial.elem_p);
+        matlib_free(re.elem_p);
+        matlib_free(im.elem_p);
     }
-    debug_exit("%s", "");
+
+    debug_exit("result: %0.16f%+0.16fi", creal(result), cimag(result));
+    return(result);
 }
+
 /*============================================================================*/
 
-void pthpool_exec_task
-( 
-    matlib_index    num_threads, 
-    pthpool_data_t* mp, 
-    pthpool_task_t* task
+void pthpool_region_init
+(
+    matlib_index      N,
+    matlib_index      num_threads,
+    pthpool_region_t* region
 )
+/* 
+ * The partition is the one of pthpool_for with PTHPOOL_SCHED_STATIC and
+ * grain 0.
+ *
+ * */ 
 {
-    debug_enter("Number of threads: %d", num_threads);
-    matlib_index i;
-    for(i=0; i<num_threads; i++)
+    debug_enter("range: [0, %d), threads: %d", N, num_threads);
+
+    region->N           = N;
+    region->num_threads = num_threads;
+    region->partition   = calloc(num_threads+1, sizeof(matlib_index));
+    if(region->partition==NULL)
     {
-        debug_enter("pthpool_data_t*: %p", &mp[i]);
-        pthread_mutex_lock(&(mp[i].lock));
-        debug_body("thread id: %d", i);
+        term_exec("%s: partition of %d threads", strerror(errno), num_threads);
+    }
+    pthpool_partition_t part = { .start = region->partition };
+    pthpool_partition_split(N, num_threads, &part);
+    pthpool_barrier_init(&(region->barrier), num_threads);
+    debug_exit("%s", "");
+}
 
-        mp[i].task = &task[i];
-        (mp[i].action) = PTHPOOL_PERFORM;
-        debug_body("thread index: %d, action : PERFORM", mp[i].thread_index);
+void pthpool_region_destroy(pthpool_region_t* region)
+{
+    matlib_free(region->partition);
+    region->partition   = NULL;
+    region->num_threads = 0;
+}
 
-        pthread_cond_signal(&(mp[i].notify));
-        pthread_mutex_unlock(&(mp[i].lock));
-        
-    }
-    //sleep(1);
-    for(i=0; i<num_threads; i++)
+static void pthpool_thfunc_region(void* mp)
+{
+    pthpool_arg_t*    ptr       = (pthpool_arg_t*) mp;
+    pthpool_region_t* region    = (pthpool_region_t*) (ptr->shared_data[0]);
+    pthpool_phase_t*  phase     = (pthpool_phase_t*) (ptr->shared_data[1]);
+    matlib_index      nr_phases = *((matlib_index*) (ptr->shared_data[2]));
+    matlib_index      nr_repeat = *((matlib_index*) (ptr->shared_data[3]));
+
+    matlib_index i = ptr->thread_index;
+    matlib_index r, k;
+    matlib_index own[2] = { region->partition[i], region->partition[i+1]};
+    matlib_index all[2] = { 0, region->N};
+
+    pthpool_arg_t arg = { .shared_data    = NULL, 
+                          .nonshared_data = NULL,
+                          .thread_index   = i };
+
+    for(r=0; r<nr_repeat; r++)
     {
-        pthread_mutex_lock(&(mp[i].lock));
-        if((mp[i].action) == PTHPOOL_PERFORM)
+        for(k=0; k<nr_phases; k++)
         {
-            debug_body("thread id: %d", i);
-            (mp[i].action) = PTHPOOL_NOTIFY;
-            debug_body("thread index: %d, action : NOTIFY", mp[i].thread_index);
-            debug_body("Going to wait for thread: %d", mp[i].thread_index);
-            pthread_cond_wait(&(mp[i].notify), &(mp[i].lock));
-            debug_body("completed thread: %d", mp[i].thread_index);
+            if(!phase[k].serial || (i==0))
+            {
+                arg.shared_data    = phase[k].shared_data;
+                arg.nonshared_data = (void**)(phase[k].serial? all: own);
+                ((void* (*)(void*))phase[k].thfunc)(&arg);
+            }
+            /* completion of the region replaces the last barrier */ 
+            if((r<nr_repeat-1) || (k<nr_phases-1))
+            {
+                pthpool_barrier_wait(&(region->barrier));
+            }
         }
-        debug_body("Thread id: %d, unlocking", i); 
-        pthread_mutex_unlock(&(mp[i].lock));
-        
     }
-    debug_exit("%s", "");
 }
-/*============================================================================*/
 
-void pthpool_exec_task_nosync
-( 
-    matlib_index    num_threads, 
-    pthpool_data_t* mp, 
-    pthpool_task_t* task
+void pthpool_region_exec
+(
+    pthpool_region_t* region,
+    matlib_index      nr_phases,
+    pthpool_phase_t*  phase,
+    matlib_index      nr_repeat,
+    pthpool_data_t*   mp
 )
 {
-    debug_enter("Number of threads: %d", num_threads);
+    debug_enter( "nr. phases: %d, nr. repetitions: %d, threads: %d", 
+                 nr_phases, nr_repeat, region->num_threads);
     matlib_index i;
-    for(i=0; i<num_threads; i++)
+
+    if((pthpool_self!=NULL) && (pthpool_self->pool==mp))
     {
-        debug_enter("pthpool_data_t*: %p", &mp[i]);
-        pthread_mutex_lock(&(mp[i].lock));
-        debug_body("thread id: %d", i);
+        term_exec("%s", "a region cannot be executed from a thread of its pool");
+    }
 
-        mp[i].task = &task[i];
-        (mp[i].action) = PTHPOOL_PERFORM;
-        debug_body("thread index: %d, action : PERFORM", mp[i].thread_index);
+    void* shared_data[4] = { (void*)region, 
+                             (void*)phase, 
+                             (void*)&nr_phases, 
+                             (void*)&nr_repeat };
 
-        pthread_cond_signal(&(mp[i].notify));
-        pthread_mutex_unlock(&(mp[i].lock));
-        
+    pthpool_arg_t    arg[region->num_threads];
+    pthpool_task_t   task[region->num_threads];
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    /* The participants of two regions queued in different orders on two
+     * threads would wait for each other at the barriers.
+     * */ 
+    pthread_mutex_lock(&(mp->shared->region_lock));
+    for(i=0; i<region->num_threads; i++)
+    {
+        arg[i].shared_data    = shared_data;
+        arg[i].nonshared_data = NULL;
+        arg[i].thread_index   = i;
+        task[i].function      = pthpool_thfunc_region;
+        task[i].argument      = &arg[i];
+        pthpool_submit_pinned(i, mp, &task[i], &handle);
     }
+    pthpool_wait(mp, &handle);
+    pthread_mutex_unlock(&(mp->shared->region_lock));
+    pthpool_handle_destroy(&handle);
     debug_exit("%s", "");
 }
 
-void pthpool_sync_threads
-( 
-    matlib_index    num_threads, 
-    pthpool_data_t* mp 
+/*============================================================================*/
+
+void pthpool_graph_init(pthpool_graph_t* graph)
+{
+    graph->nr_stages  = 0;
+    graph->cap_stages = 0;
+    graph->stage      = NULL;
+    graph->nr_nodes   = 0;
+    graph->cap_nodes  = 0;
+    graph->node       = NULL;
+    graph->mp         = NULL;
+}
+
+static void* pthpool_grow
+(
+    void*         ptr,
+    matlib_index* capacity,
+    matlib_index  len,
+    size_t        size
 )
+/* 
+ * Doubles the capacity of the array ptr until it can hold len entries.
+ *
+ * */ 
 {
-    debug_enter("Number of threads: %d", num_threads);
-    matlib_index i;
-    for(i=0; i<num_threads; i++)
+    if(len>*capacity)
     {
-        pthread_mutex_lock(&(mp[i].lock));
-        debug_body("thread id: %d", i);
-
-        if((mp[i].action) == PTHPOOL_PERFORM)
+        matlib_index cap = (*capacity==0)? 8: *capacity;
+        while(cap<len)
         {
-            (mp[i].action) = PTHPOOL_NOTIFY;
-            debug_body("thread index: %d, action : NOTIFY", mp[i].thread_index);
-            debug_body("Going to wait for thread: %d", mp[i].thread_index);
-            pthread_cond_wait(&(mp[i].notify), &(mp[i].lock));
+            cap *= 2;
         }
-        debug_body("completed thread: %d", mp[i].thread_index);
-        pthread_mutex_unlock(&(mp[i].lock));
+        ptr = realloc(ptr, cap*size);
+        if(ptr==NULL)
+        {
+            term_exec("%s: array of %d entries", strerror(errno), cap);
+        }
+        *capacity = cap;
     }
-    debug_exit("%s", "");
+    return ptr;
 }
 
-/*============================================================================*/
+static void pthpool_graph_edge
+(
+    pthpool_graph_t* graph,
+    matlib_index     from,
+    matlib_index     to
+)
+{
+    pthpool_node_t* node = &(graph->node[from]);
+    node->succ = pthpool_grow( node->succ, &(node->cap_succ), 
+                               node->nr_succ+1, sizeof(matlib_index));
+    node->succ[node->nr_succ] = to;
+    node->nr_succ++;
+    graph->node[to].nr_deps++;
+}
 
-void pthpool_destroy_threads
-( 
-    matlib_index    num_threads, 
-    pthpool_data_t* mp 
+matlib_index pthpool_graph_add
+(
+    pthpool_graph_t*    graph,
+    matlib_index        start,
+    matlib_index        end,
+    matlib_index        block,
+    void**              shared_data,
+    void*               thfunc,
+    matlib_index        nr_upstream,
+    const matlib_index* upstream,
+    matlib_index        halo
 )
 {
-    debug_enter("number of threads: %d", num_threads);
-    matlib_index pthread_r, i;
-    void* status;
-    for( i=0; i<num_threads; i++)
+    debug_enter( "range: [%d, %d), block: %d, nr. upstream stages: %d", 
+                 start, end, block, nr_upstream);
+    matlib_index i, j, k, lo, hi, j0, j1;
+
+    if(end<start)
     {
-        debug_body("thread id: %d", i);
-        pthread_mutex_lock(&(mp[i].lock));
-        if((mp[i].action) == PTHPOOL_PERFORM)
-        {
-            (mp[i].action) = PTHPOOL_NOTIFY;
-            debug_body("thread index: %d, action : NOTIFY", mp[i].thread_index);
-            debug_body("Going to wait for task to finish (thread index: %d)", i);
-            pthread_cond_wait(&(mp[i].notify), &(mp[i].lock)); 
-            (mp[i].action) = PTHPOOL_EXIT;
-            debug_body("thread index: %d, action : EXIT", mp[i].thread_index);
-        }
-        else if((mp[i].action) == PTHPOOL_WAIT)
+        term_execb("invalid range: [%d, %d)", start, end);
+    }
+    for(k=0; k<nr_upstream; k++)
+    {
+        if(upstream[k]>=graph->nr_stages)
         {
-            (mp[i].action) = PTHPOOL_EXIT;
-            debug_body("thread index: %d, action : EXIT", mp[i].thread_index);
-            pthread_cond_signal(&(mp[i].notify));
+            term_execb( "upstream stage %d not in the graph (nr. stages: %d)",
+                        upstream[k], graph->nr_stages);
         }
-        pthread_mutex_unlock(&(mp[i].lock));
     }
-    for(i=0; i<num_threads; i++)
+
+    graph->stage = pthpool_grow( graph->stage, &(graph->cap_stages), 
+                                 graph->nr_stages+1, sizeof(pthpool_stage_t));
+    pthpool_stage_t* stage = &(graph->stage[graph->nr_stages]);
+    stage->start    = start;
+    stage->end      = end;
+    stage->block    = block;
+    stage->first    = graph->nr_nodes;
+    stage->nr_nodes = (block==0)? 1: (end-start+block-1)/block;
+
+    graph->node = pthpool_grow( graph->node, &(graph->cap_nodes), 
+                                graph->nr_nodes+stage->nr_nodes, 
+                                sizeof(pthpool_node_t));
+    for(i=0; i<stage->nr_nodes; i++)
     {
-        pthread_r = pthread_join((mp[i].thread), &status); 
+        pthpool_node_t* node = &(graph->node[stage->first+i]);
+        node->thfunc      = thfunc;
+        node->shared_data = shared_data;
+        node->bounds[0]   = (block==0)? start: start+i*block;
+        node->bounds[1]   = (block==0)? end: start+(i+1)*block;
+        node->bounds[1]   = (node->bounds[1]>end)? end: node->bounds[1];
+        node->nr_deps     = 0;
+        node->pending     = 0;
+        node->nr_succ     = 0;
+        node->cap_succ    = 0;
+        node->succ        = NULL;
     }
-    for(i=0; i<num_threads; i++)
+    graph->nr_nodes += stage->nr_nodes;
+
+    for(k=0; k<nr_upstream; k++)
     {
-        pthread_r = pthread_mutex_destroy(&(mp[i].lock));
-        pthread_r = pthread_cond_destroy(&(mp[i].notify));
+        pthpool_stage_t* up = &(graph->stage[upstream[k]]);
+        for(i=0; i<stage->nr_nodes; i++)
+        {
+            pthpool_node_t* node = &(graph->node[stage->first+i]);
+            if((block==0) || (up->block==0))
+            {
+                j0 = 0;
+                j1 = up->nr_nodes;
+            }
+            else
+            {
+                lo = (node->bounds[0]>halo)? node->bounds[0]-halo: 0;
+                hi = node->bounds[1]+halo;
+                if((hi<=up->start) || (lo>=up->end))
+                {
+                    continue;
+                }
+                j0 = (lo<=up->start)? 0: (lo-up->start)/up->block;
+                j1 = (hi-up->start+up->block-1)/up->block;
+                j1 = (j1>up->nr_nodes)? up->nr_nodes: j1;
+            }
+            for(j=j0; j<j1; j++)
+            {
+                pthpool_graph_edge(graph, up->first+j, stage->first+i);
+            }
+        }
     }
-    debug_exit("%s", "");
+    debug_exit("stage: %d, nr. nodes: %d", graph->nr_stages, stage->nr_nodes);
+    return(graph->nr_stages++);
 }
 
-/*============================================================================*/
-
-void pthpool_func
-(
-    matlib_index*   Np,
-    void**          shared_data,
-    void*           thfunc,
-    matlib_index    num_threads,
-    pthpool_data_t* mp
-
-)
+static void pthpool_thfunc_node(void* mp)
 {
-    debug_enter("Np: [%d, %d]", Np[0], Np[1]);
-
-    matlib_index i; 
-    /* define the shared data */ 
+    pthpool_arg_t*   ptr   = (pthpool_arg_t*) mp;
+    pthpool_graph_t* graph = (pthpool_graph_t*) (ptr->shared_data[0]);
+    pthpool_node_t*  node  = (pthpool_node_t*)  (ptr->shared_data[1]);
+    matlib_index i;
 
-    matlib_index nsdata[num_threads][2];
+    ((void* (*)(void*))node->thfunc)(&(node->arg));
 
-    pthpool_arg_t  arg[num_threads];
-    pthpool_task_t task[num_threads];
+    /* the successors are submitted before this task completes, hence the
+     * handle cannot drop to zero in between */ 
+    for(i=0; i<node->nr_succ; i++)
+    {
+        pthpool_node_t* succ = &(graph->node[node->succ[i]]);
+        if(__atomic_sub_fetch(&(succ->pending), 1, __ATOMIC_ACQ_REL)==0)
+        {
+            pthpool_submit(graph->num_threads, graph->mp, &(succ->task), &(graph->handle));
+        }
+    }
+}
 
+void pthpool_graph_exec
+(
+    pthpool_graph_t* graph,
+    matlib_index     num_threads,
+    pthpool_data_t*  mp
+)
+/* 
+ * Nodes without dependencies are distributed over the pool, a node whose
+ * last dependency completes is pushed to the deque of the thread that
+ * completed it, so that it runs on the data just produced unless stolen.
+ *
+ * */ 
+{
+    debug_enter( "nr. stages: %d, nr. nodes: %d, threads: %d", 
+                 graph->nr_stages, graph->nr_nodes, num_threads);
+    matlib_index i;
 
-    for(i=0; i<num_threads-1; i++)
+    graph->num_threads = num_threads;
+    graph->mp          = mp;
+    for(i=0; i<graph->nr_nodes; i++)
     {
-        nsdata[i][0] = i*Np[0];
-        nsdata[i][1] = (i+1)*Np[0];
-        arg[i].shared_data    = shared_data; 
-        arg[i].nonshared_data = (void**)&nsdata[i];
-        arg[i].thread_index   = i;
-        /* Define the task */ 
-        task[i].function  = (void*)thfunc;
-        task[i].argument  = &arg[i];
+        pthpool_node_t* node = &(graph->node[i]);
+        node->pending             = node->nr_deps;
+        node->link[0]             = (void*)graph;
+        node->link[1]             = (void*)node;
+        node->arg.shared_data     = node->shared_data;
+        node->arg.nonshared_data  = (void**)node->bounds;
+        node->self.shared_data    = node->link;
+        node->self.nonshared_data = NULL;
+        node->task.function       = pthpool_thfunc_node;
+        node->task.argument       = &(node->self);
+    }
+    for(i=0; i<graph->nr_stages; i++)
+    {
+        pthpool_stage_t* stage = &(graph->stage[i]);
+        for(matlib_index j=0; j<stage->nr_nodes; j++)
+        {
+            graph->node[stage->first+j].arg.thread_index  = j;
+            graph->node[stage->first+j].self.thread_index = j;
+        }
     }
-    nsdata[i][0] = i*Np[0];
-    nsdata[i][1] = Np[1];
-    arg[i].shared_data    = shared_data; 
-    arg[i].nonshared_data = (void**)&nsdata[i];
-    arg[i].thread_index   = i;
-    /* Define the task */ 
-    task[i].function  = (void*)thfunc;
-    task[i].argument  = &arg[i];
-
-    debug_body("%s", "created task");
 
-    pthpool_exec_task(num_threads, mp, task);
-    
+    pthpool_handle_init(&(graph->handle));
+    for(i=0; i<graph->nr_nodes; i++)
+    {
+        if(graph->node[i].nr_deps==0)
+        {
+            pthpool_submit(num_threads, mp, &(graph->node[i].task), &(graph->handle));
+        }
+    }
+    pthpool_wait(mp, &(graph->handle));
+    pthpool_handle_destroy(&(graph->handle));
     debug_exit("%s", "");
 }
 
-/*============================================================================*/
-
-
+void pthpool_graph_destroy(pthpool_graph_t* graph)
+{
+    matlib_index i;
+    for(i=0; i<graph->nr_nodes; i++)
+    {
+        matlib_free(graph->node[i].succ);
+    }
+    matlib_free(graph->node);
+    matlib_free(graph->stage);
+    pthpool_graph_init(graph);
+}
 
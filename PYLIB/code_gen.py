@@ -4,61 +4,9 @@ import math
 
 #------------------------------------------------------------------------------#
 
-def fem1d_dlp_snorm2_d_(N, file_name, PRECISION):
+def fem1d_lp_snorm2_weights_(N, file_name, PRECISION):
     
     num_format = '0.%sf' % PRECISION
-    ST  = "    "
-    ST2 = "%s%s" % (ST, ST)
-    with open ( file_name, 'w') as fobj:
-        mystr = "/* Printed with precision 0.%sf.*/\n" % PRECISION
-        fobj.write(mystr);
-        for k in range(0, N):
-            num_str = format((2/(2*k+1.0)), num_format )
-            mystr = "#define _N%i %s\n" %( k, num_str )
-            fobj.write(mystr);
-        for p in range(2, N):
-            mystr = "double fem1d_dlp_snorm2_d_%i( Index elem_n, double *u);\n" % p
-            fobj.write(mystr);
-
-        for p in range( 2, N):
-    
-            mystr = "/*** Begin Subroutine ***/\n"
-            fobj.write(mystr);
-            mystr = "double fem1d_dlp_snorm2_d_%i(Index elem_n, double *u)\n{\n" % p
-            fobj.write(mystr);
-            mystr = "%sdouble snorm = 0, tmp;\n" % ST
-            fobj.write(mystr);
-            mystr = "%sIndex i;\n" % ST
-            fobj.write(mystr);
-            mystr = "%sIndex tmp1 = 0;\n" % ST
-            fobj.write(mystr);
-            mystr = "%sfor (i=0; i<elem_n; i++)\n%s{\n" % (ST, ST)
-            fobj.write(mystr);
-            mystr = "%stmp = \t  _N0 * *(u+0) * *(u+0)\n" % ST2 
-            fobj.write(mystr);
-            for k in range(1,p):
-                mystr = "%s\t+ _N%i * *(u+%i) * *(u+%i)\n" % (ST2, k, k, k)
-                fobj.write(mystr);
-            mystr = "%s\t+ _N%i * *(u+%i) * *(u+%i);\n" % (ST2, p, p, p)
-            fobj.write(mystr);
-            mystr = "%su += %i;\n" % (ST2, p+1) 
-            fobj.write(mystr);
-            mystr = "%ssnorm += tmp;\n" % ST2 
-            fobj.write(mystr);
-            mystr = "%s}\n" % ST
-            fobj.write(mystr);
-            mystr = "%sreturn snorm;\n" % ST
-            fobj.write(mystr);
-            mystr = "}\n"
-            fobj.write(mystr);
-            mystr = "/*** End of subroutine ***/\n"
-            fobj.write(mystr);
-    return
-def fem1d_zlp_snorm2_d_(N, file_name, PRECISION):
-    
-    num_format = '0.%sf' % PRECISION
-    ST  = "    "
-    ST2 = "%s%s" % (ST, ST)
     with open ( file_name, 'w') as fobj:
         mystr = "/* Printed with precision 0.%sf.*/\n" % PRECISION
         fobj.write(mystr);
@@ -66,43 +14,6 @@ def fem1d_zlp_snorm2_d_(N, file_name, PRECISION):
             num_str = format((2/(2*k+1.0)), num_format )
             mystr = "#define _N%i %s\n" %( k, num_str )
             fobj.write(mystr);
-        for p in range(2, N):
-            mystr = "double fem1d_zlp_snorm2_d_%i( Index elem_n, MATLIB_COMPLEX *u);\n" % p
-            fobj.write(mystr);
-
-        for p in range( 2, N):
-    
-            mystr = "/*** Begin Subroutine ***/\n"
-            fobj.write(mystr);
-            mystr = "double fem1d_zlp_snorm2_d_%i(Index elem_n, MATLIB_COMPLEX *u)\n{\n" % p
-            fobj.write(mystr);
-            mystr = "%sdouble snorm = 0, tmp;\n" % ST
-            fobj.write(mystr);
-            mystr = "%sIndex i;\n" % ST
-            fobj.write(mystr);
-            mystr = "%sIndex tmp1 = 0;\n" % ST
-            fobj.write(mystr);
-            mystr = "%sfor (i=0; i<elem_n; i++)\n%s{\n" % (ST, ST)
-            fobj.write(mystr);
-            mystr = "%stmp = \t  _N0 * *(u+0) * conj(*(u+0))\n" % ST2 
-            fobj.write(mystr);
-            for k in range(1,p):
-                mystr = "%s\t+ _N%i * *(u+%i) * conj(*(u+%i))\n" % (ST2, k, k, k)
-                fobj.write(mystr);
-            mystr = "%s\t+ _N%i * *(u+%i) * conj(*(u+%i));\n" % (ST2, p, p, p)
-            fobj.write(mystr);
-            mystr = "%su += %i;\n" % (ST2, p+1) 
-            fobj.write(mystr);
-            mystr = "%ssnorm += tmp;\n" % ST2 
-            fobj.write(mystr);
-            mystr = "%s}\n" % ST
-            fobj.write(mystr);
-            mystr = "%sreturn snorm;\n" % ST
-            fobj.write(mystr);
-            mystr = "}\n"
-            fobj.write(mystr);
-            mystr = "/*** End of subroutine ***/\n"
-            fobj.write(mystr);
     return
 #------------------------------------------------------------------------------#
 
@@ -584,8 +495,7 @@ if __name__ == '__main__':
     
     file_name = 'test.c'
     PRECISION = '20'
-    # fem1d_zlp_snorm2_d_(11, file_name, PRECISION)
-    # fem1d_dlp_snorm2_d_(11, file_name, PRECISION)
+    # fem1d_lp_snorm2_weights_(11, file_name, PRECISION)
     # fem_ddot_(17, file_name)
     # fem_zdot_(17, file_name)
     # fem_shapeFunc2lp_(10, file_name, '20')
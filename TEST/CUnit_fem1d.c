@@ -12,6 +12,9 @@
 #include <stdbool.h>
 #include <string.h>
 #include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <unistd.h>
 #include "mkl.h"
 
 #define NDEBUG
@@ -19,6 +22,7 @@
 
 #include "legendre.h"
 #include "fem1d.h"
+#include "fem1d_table.h"
 #include "assert.h"
 
 /* CUnit modules */
@@ -962,6 +966,177 @@ void test_fem1d_ZL2F1(void)
 
 /*============================================================================*/
 
+matlib_real test_fem1d_ZL2F2_general
+(
+    matlib_index p,
+    matlib_index N,
+    matlib_index k
+)
+/* 
+ * Compares the batched transforms against the single-vector versions applied
+ * to each of the k interleaved vectors.
+ * */ 
+{
+    matlib_real x_l =  -5.0;
+    matlib_real x_r =   5.0;
+
+    debug_enter( "polynomial degree: %d, nr. of vectors: %d", p, k );
+
+    matlib_xv x, xi, quadW;
+    legendre_LGLdataLT1( p, TOL, &xi, &quadW);
+    fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+    
+    matlib_xm FM;
+    matlib_create_xm( xi.len, xi.len, &FM, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataFM( xi, FM);
+
+    matlib_zv u, U, vb, U1, Pvb;
+    matlib_create_zv( x.len,   &u,   MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &U,   MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &U1,  MATLIB_COL_VECT);
+    matlib_create_zv( N*p+1,   &vb,  MATLIB_COL_VECT);
+    matlib_create_zv( N*p+1,   &Pvb, MATLIB_COL_VECT);
+
+    Gaussian_zfunc(x, u);
+    fem1d_ZFLT( N, FM, u, U);
+    fem1d_ZL2F(p, U, vb);
+    fem1d_ZF2L(p, vb, U1);
+    fem1d_ZPrjL2F(p, U, Pvb);
+
+    matlib_zm UU, vvb, UU1, PPvb;
+    matlib_create_zm( N*(p+1), k, &UU,   MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+    matlib_create_zm( N*(p+1), k, &UU1,  MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+    matlib_create_zm( N*p+1,   k, &vvb,  MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+    matlib_create_zm( N*p+1,   k, &PPvb, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+
+    matlib_index i, j;
+    matlib_complex c[k];
+    for(j=0; j<k; j++)
+    {
+        c[j] = (j+1.0) + I*j;
+    }
+    for(i=0; i<U.len; i++)
+    {
+        for(j=0; j<k; j++)
+        {
+            UU.elem_p[i*k+j] = c[j]*U.elem_p[i];
+        }
+    }
+
+    fem1d_ZL2F2(p, UU, vvb);
+    fem1d_ZF2L2(p, vvb, UU1);
+    fem1d_ZPrjL2F2(p, UU, PPvb);
+
+    matlib_real e, e_relative = 0;
+    for(j=0; j<k; j++)
+    {
+        e = 0;
+        for(i=0; i<vb.len; i++)
+        {
+            e = fmax(e, cabs(vvb.elem_p[i*k+j]-c[j]*vb.elem_p[i]));
+            e = fmax(e, cabs(PPvb.elem_p[i*k+j]-c[j]*Pvb.elem_p[i]));
+        }
+        for(i=0; i<U1.len; i++)
+        {
+            e = fmax(e, cabs(UU1.elem_p[i*k+j]-c[j]*U1.elem_p[i]));
+        }
+        e_relative = fmax(e_relative, e/cabs(c[j]));
+    }
+
+    matlib_free(x.elem_p);
+    matlib_free(xi.elem_p);
+    matlib_free(quadW.elem_p);
+    matlib_free(FM.elem_p);
+    matlib_free(u.elem_p);
+    matlib_free(U.elem_p);
+    matlib_free(U1.elem_p);
+    matlib_free(vb.elem_p);
+    matlib_free(Pvb.elem_p);
+    matlib_free(UU.elem_p);
+    matlib_free(UU1.elem_p);
+    matlib_free(vvb.elem_p);
+    matlib_free(PPvb.elem_p);
+
+    debug_exit("Relative error: % 0.16g", e_relative);
+    return(e_relative);
+}
+
+void test_fem1d_ZL2F2(void)
+{
+    matlib_index N = 40;
+    matlib_index p_max = 15;
+    matlib_real e_relative;
+    for(matlib_index p=2; p<p_max; p++)
+    {
+        e_relative = test_fem1d_ZL2F2_general(p, N, 3);
+        CU_ASSERT_TRUE(e_relative<TOL);
+    }
+}
+
+/*============================================================================*/
+
+matlib_real test_fem1d_ZEval_general
+(
+    matlib_index p,
+    matlib_index N
+)
+/* 
+ * With p+1 LGL points per element the Legendre transform interpolates, so
+ * the series evaluated at the mesh points reproduces the samples.
+ * */ 
+{
+    matlib_real x_l =  -5.0;
+    matlib_real x_r =   5.0;
+
+    debug_enter( "polynomial degree: %d, nr. of LGL points: %d", p, p+1 );
+
+    matlib_xv x, xi, quadW;
+    legendre_LGLdataLT1( p, TOL, &xi, &quadW);
+    fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+    
+    matlib_xm FM;
+    matlib_create_xm( xi.len, xi.len, &FM, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataFM( xi, FM);
+
+    matlib_zv u, U, u1;
+    matlib_create_zv( x.len,   &u,  MATLIB_COL_VECT);
+    matlib_create_zv( x.len,   &u1, MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &U,  MATLIB_COL_VECT);
+
+    Gaussian_zfunc(x, u);
+    fem1d_ZFLT( N, FM, u, U);
+    fem1d_ZEval( p, x_l, x_r, U, x, u1);
+
+    matlib_real norm_actual = matlib_znrm2(u);
+    matlib_zaxpy(-1.0, u, u1);
+    matlib_real e_relative = matlib_znrm2(u1)/norm_actual;
+
+    matlib_free(x.elem_p);
+    matlib_free(xi.elem_p);
+    matlib_free(quadW.elem_p);
+    matlib_free(FM.elem_p);
+    matlib_free(u.elem_p);
+    matlib_free(u1.elem_p);
+    matlib_free(U.elem_p);
+
+    debug_exit("Relative error: % 0.16g", e_relative);
+    return(e_relative);
+}
+
+void test_fem1d_ZEval(void)
+{
+    matlib_index N = 40;
+    matlib_index p_max = 15;
+    matlib_real e_relative;
+    for(matlib_index p=2; p<p_max; p++)
+    {
+        e_relative = test_fem1d_ZEval_general(p, N);
+        CU_ASSERT_TRUE(e_relative<TOL);
+    }
+}
+
+/*============================================================================*/
+
 void test_fem1d_quadM1(void)
 {
     matlib_index p = 11;
@@ -1590,6 +1765,664 @@ void test_fem1d_zm_nsparse_GMM(void)
                                        linear_timedependent_zpotential);
 }
 
+/*============================================================================*/
+/* Plan once, execute for two potentials: identical to a fresh assembly */ 
+void test_fem1d_GMM_plan(void)
+{
+    debug_enter("%s", "");
+    matlib_index i, j, k, p, N = 37;
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    for(p=2; p<9; p++)
+    {
+        matlib_xv xi, quadW;
+        legendre_LGLdataLT1( 2*p, TOL, &xi, &quadW);
+        
+        matlib_xm IM, Q;
+        matlib_create_xm( xi.len, p+1, &IM, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);    
+        legendre_LGLdataIM( xi, IM);
+        fem1d_quadM( quadW, IM, &Q);
+
+        matlib_xv x, xphi;
+        matlib_zv zphi;
+        fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+        matlib_create_xv( x.len, &xphi, MATLIB_COL_VECT);
+        matlib_create_zv( x.len, &zphi, MATLIB_COL_VECT);
+
+        matlib_xm_sparse xM1, xM2;
+        matlib_zm_sparse zM1, zM2;
+        fem1d_GMM_plan_t xplan, zplan;
+        fem1d_xm_sparse_GMM_plan(p, N, Q, &xM2, &xplan);
+        fem1d_zm_sparse_GMM_plan(p, N, Q, &zM2, &zplan);
+
+        matlib_index dim, nnz0;
+        fem1d_GMMSize(p, N, &dim, &nnz0);
+        CU_ASSERT_TRUE((xM2.lenc==dim) && (xM2.rowIn[dim]==nnz0));
+
+        for(k=0; k<2; k++)
+        {
+            if(k==0)
+            {
+                Gaussian_func(x, xphi);
+                Gaussian_zfunc(x, zphi);
+            }
+            else
+            {
+                for(i=0; i<x.len; i++)
+                {
+                    xphi.elem_p[i] = x.elem_p[i]*x.elem_p[i];
+                }
+                harmonic_zpotential(x, zphi);
+            }
+            fem1d_xm_sparse_GMM(p, Q, xphi, &xM1);
+            fem1d_zm_sparse_GMM(p, Q, zphi, &zM1);
+            fem1d_xm_sparse_GMM_exec(&xplan, Q, xphi, &xM2);
+            fem1d_zm_sparse_GMM_exec(&zplan, Q, zphi, &zM2);
+
+            matlib_index nnz = xM1.rowIn[xM1.lenc];
+            bool same = (xM2.lenc==xM1.lenc) && (zM2.rowIn[zM2.lenc]==nnz);
+            for(j=0; j<=xM1.lenc; j++)
+            {
+                same = same && (xM1.rowIn[j]==xM2.rowIn[j]) && (zM1.rowIn[j]==zM2.rowIn[j]);
+            }
+            for(j=0; j<nnz; j++)
+            {
+                same =    same 
+                       && (xM1.colIn[j]==xM2.colIn[j])   && (zM1.colIn[j]==zM2.colIn[j])
+                       && (xM1.elem_p[j]==xM2.elem_p[j]) && (zM1.elem_p[j]==zM2.elem_p[j]);
+            }
+            CU_ASSERT_TRUE(same);
+
+            /* real potential with complex scale factors, c[1]=0 skips the
+             * transform */ 
+            matlib_complex c[2] = {0.5-I*0.25, (k==0)? 2.0+I: 0};
+            for(i=0; i<x.len; i++)
+            {
+                zphi.elem_p[i] = c[0] + c[1]*xphi.elem_p[i];
+            }
+            fem1d_zm_sparse_GMM_exec(&zplan, Q, zphi, &zM2);
+            fem1d_xzm_sparse_GMM_exec(&zplan, Q, xphi, c, &zM1);
+            matlib_real e = 0;
+            for(j=0; j<nnz; j++)
+            {
+                e = fmax(e, cabs(zM1.elem_p[j]-zM2.elem_p[j]));
+            }
+            debug_body("Max. difference (real potential): %0.16g", e);
+            CU_ASSERT_TRUE(e<TOL);
+
+            matlib_free(xM1.rowIn);
+            matlib_free(xM1.colIn);
+            matlib_free(xM1.elem_p);
+            matlib_free(zM1.rowIn);
+            matlib_free(zM1.colIn);
+            matlib_free(zM1.elem_p);
+        }
+        fem1d_GMM_plan_free(&xplan);
+        fem1d_GMM_plan_free(&zplan);
+        CU_ASSERT_TRUE((xplan.map==NULL) && (zplan.zq.elem_p==NULL));
+
+        matlib_free(xM2.rowIn);
+        matlib_free(xM2.colIn);
+        matlib_free(xM2.elem_p);
+        matlib_free(zM2.rowIn);
+        matlib_free(zM2.colIn);
+        matlib_free(zM2.elem_p);
+        matlib_free(xi.elem_p);
+        matlib_free(quadW.elem_p);
+        matlib_free(IM.elem_p);
+        matlib_free(Q.elem_p);
+        matlib_free(x.elem_p);
+        matlib_free(xphi.elem_p);
+        matlib_free(zphi.elem_p);
+    }
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+/* Change tracking: partial re-assembly against a full re-assembly */ 
+void test_fem1d_GMM_update(void)
+{
+    debug_enter("%s", "");
+    matlib_index i, j, p, N = 23;
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    for(p=2; p<7; p++)
+    {
+        matlib_xv xi, quadW;
+        legendre_LGLdataLT1( 2*p, TOL, &xi, &quadW);
+        
+        matlib_xm IM, Q;
+        matlib_create_xm( xi.len, p+1, &IM, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);    
+        legendre_LGLdataIM( xi, IM);
+        fem1d_quadM( quadW, IM, &Q);
+
+        matlib_index P = xi.len-1;
+        matlib_xv x;
+        matlib_zv phi, phi_ref;
+        fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+        matlib_create_zv( x.len, &phi,     MATLIB_COL_VECT);
+        matlib_create_zv( x.len, &phi_ref, MATLIB_COL_VECT);
+        harmonic_zpotential(x, phi);
+        matlib_zcopy(phi, phi_ref);
+
+        matlib_zm_sparse M1, M2;
+        fem1d_GMM_plan_t plan1, plan2;
+        fem1d_zm_sparse_GMM_plan(p, N, Q, &M1, &plan1);
+        fem1d_zm_sparse_GMM_plan(p, N, Q, &M2, &plan2);
+        fem1d_zm_sparse_GMM_exec(&plan2, Q, phi, &M2);
+
+        matlib_index nnz = M2.rowIn[M2.lenc];
+        matlib_complex* base = calloc(nnz, sizeof(matlib_complex));
+        for(j=0; j<nnz; j++)
+        {
+            base[j] = 0.25*j - I*0.5;
+            M2.elem_p[j] += base[j];
+        }
+        bool* row_changed = calloc(M2.lenc, sizeof(bool));
+
+        /* nothing changed */ 
+        matlib_index nr_changed 
+            = fem1d_zm_sparse_GMM_update( &plan2, Q, phi, phi_ref, 0, base, 
+                                          &M2, row_changed);
+        bool any = false;
+        for(j=0; j<M2.lenc; j++)
+        {
+            any = any || row_changed[j];
+        }
+        CU_ASSERT_TRUE((nr_changed==0) && !any);
+
+        /* perturb the first, an interior and the last element; a change
+         * below the tolerance is ignored */ 
+        matlib_index elems[3] = {0, N/2, N-1};
+        for(i=0; i<3; i++)
+        {
+            phi.elem_p[elems[i]*P+1] += 1.0+I;
+        }
+        phi.elem_p[5*P+1] += 1e-12;
+
+        nr_changed = fem1d_zm_sparse_GMM_update( &plan2, Q, phi, phi_ref, 1e-9, 
+                                                 base, &M2, row_changed);
+        CU_ASSERT_EQUAL(nr_changed, 3);
+
+        bool rows_ok = true;
+        for(j=0; j<=N; j++)
+        {
+            bool expected = (j==0) || (j==1) || (j==N/2) || (j==N/2+1) || (j>=N-1);
+            rows_ok = rows_ok && (row_changed[j]==expected);
+        }
+        for(j=0; j<N*(p-1); j++)
+        {
+            matlib_index e = j/(p-1);
+            bool expected = (e==0) || (e==N/2) || (e==N-1);
+            rows_ok = rows_ok && (row_changed[N+1+j]==expected);
+        }
+        CU_ASSERT_TRUE(rows_ok);
+
+        /* full re-assembly of the samples the update accepted */ 
+        fem1d_zm_sparse_GMM_exec(&plan1, Q, phi_ref, &M1);
+        bool same = true;
+        for(j=0; j<nnz; j++)
+        {
+            same = same && ((M1.elem_p[j]+base[j])==M2.elem_p[j]);
+        }
+        CU_ASSERT_TRUE(same);
+        CU_ASSERT_TRUE(phi_ref.elem_p[5*P+1]!=phi.elem_p[5*P+1]);
+
+        /* only the sample shared by the elements 2 and 3 changes: both are
+         * re-integrated, with tol=0 as well */ 
+        phi.elem_p[5*P+1] = phi_ref.elem_p[5*P+1];
+        phi.elem_p[3*P]  += 0.5-I;
+        nr_changed = fem1d_zm_sparse_GMM_update( &plan2, Q, phi, phi_ref, 0, 
+                                                 base, &M2, row_changed);
+        CU_ASSERT_EQUAL(nr_changed, 2);
+        CU_ASSERT_TRUE(row_changed[2] && row_changed[3] && row_changed[4]);
+        CU_ASSERT_TRUE(!row_changed[1] && !row_changed[5]);
+
+        fem1d_zm_sparse_GMM_exec(&plan1, Q, phi, &M1);
+        same = true;
+        for(j=0; j<nnz; j++)
+        {
+            same = same && ((M1.elem_p[j]+base[j])==M2.elem_p[j]);
+        }
+        CU_ASSERT_TRUE(same);
+        same = true;
+        for(j=0; j<phi.len; j++)
+        {
+            same = same && (phi_ref.elem_p[j]==phi.elem_p[j]);
+        }
+        CU_ASSERT_TRUE(same);
+
+        fem1d_GMM_plan_free(&plan1);
+        fem1d_GMM_plan_free(&plan2);
+        matlib_free(base);
+        matlib_free(row_changed);
+        matlib_free(M1.rowIn);
+        matlib_free(M1.colIn);
+        matlib_free(M1.elem_p);
+        matlib_free(M2.rowIn);
+        matlib_free(M2.colIn);
+        matlib_free(M2.elem_p);
+        matlib_free(xi.elem_p);
+        matlib_free(quadW.elem_p);
+        matlib_free(IM.elem_p);
+        matlib_free(Q.elem_p);
+        matlib_free(x.elem_p);
+        matlib_free(phi.elem_p);
+        matlib_free(phi_ref.elem_p);
+    }
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+/* Exact assembly of polynomial potentials against the quadrature with Q */ 
+void test_fem1d_GMM_leg(void)
+{
+    debug_enter("%s", "");
+    matlib_index i, j, n, p, d, N = 29;
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    matlib_complex a_p[4] = {0.5-I*0.25, 0.3, -1.0+I*0.5, 0.02-I*0.01};
+
+    for(p=2; p<9; p++)
+    {
+        matlib_xv xi, quadW;
+        legendre_LGLdataLT1( 2*p+2, TOL, &xi, &quadW);
+        
+        matlib_xm IM, Q;
+        matlib_create_xm( xi.len, p+1, &IM, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);    
+        legendre_LGLdataIM( xi, IM);
+        fem1d_quadM( quadW, IM, &Q);
+
+        matlib_xv x;
+        matlib_zv phi;
+        fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+        matlib_create_zv( x.len, &phi, MATLIB_COL_VECT);
+
+        matlib_zm_sparse M1, M2;
+        fem1d_GMM_plan_t plan1, plan2;
+        fem1d_zm_sparse_GMM_plan(p, N, Q, &M1, &plan1);
+        fem1d_zm_sparse_GMM_plan(p, N, Q, &M2, &plan2);
+        matlib_index nnz = M1.rowIn[M1.lenc];
+
+        for(d=0; d<4; d++)
+        {
+            matlib_zv a = { .len = d+1, .type = MATLIB_COL_VECT, .elem_p = a_p};
+            for(i=0; i<x.len; i++)
+            {
+                phi.elem_p[i] = 0;
+                for(n=d+1; n>0; n--)
+                {
+                    phi.elem_p[i] = phi.elem_p[i]*x.elem_p[i] + a_p[n-1];
+                }
+            }
+            fem1d_zm_sparse_GMM_exec(&plan2, Q, phi, &M2);
+
+            matlib_xm T;
+            matlib_zv c;
+            fem1d_triple_table(p, d, TOL, &T);
+            CU_ASSERT_TRUE((T.lenc==Q.lenc) && (T.lenr==d+1));
+            matlib_create_zv( N*(d+1), &c, MATLIB_COL_VECT);
+            fem1d_zpoly2leg(a, N, x_l, x_r, c);
+            fem1d_zm_sparse_GMM_exec_leg(&plan1, T, c, &M1);
+
+            matlib_real e = 0, norm = 0;
+            for(j=0; j<nnz; j++)
+            {
+                e    = fmax(e, cabs(M1.elem_p[j]-M2.elem_p[j]));
+                norm = fmax(norm, cabs(M2.elem_p[j]));
+            }
+            debug_body("p: %d, d: %d, relative difference: %0.16g", p, d, e/norm);
+            CU_ASSERT_TRUE(e<TOL*norm);
+
+            matlib_free(T.elem_p);
+            matlib_free(c.elem_p);
+        }
+        fem1d_GMM_plan_free(&plan1);
+        fem1d_GMM_plan_free(&plan2);
+        matlib_free(M1.rowIn);
+        matlib_free(M1.colIn);
+        matlib_free(M1.elem_p);
+        matlib_free(M2.rowIn);
+        matlib_free(M2.colIn);
+        matlib_free(M2.elem_p);
+        matlib_free(xi.elem_p);
+        matlib_free(quadW.elem_p);
+        matlib_free(IM.elem_p);
+        matlib_free(Q.elem_p);
+        matlib_free(x.elem_p);
+        matlib_free(phi.elem_p);
+    }
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+/* Matrix-free stiffness-mass operator against the assembled CSR matrix */ 
+void test_fem1d_GSMV(void)
+{
+    debug_enter("%s", "");
+    matlib_index i, p, N = 41;
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+    matlib_real      xcoeff = 0.7;
+    matlib_complex   zcoeff = 0.3+I*0.9;
+
+    for(p=2; p<11; p++)
+    {
+        matlib_xv xi, quadW;
+        legendre_LGLdataLT1( 2*p, TOL, &xi, &quadW);
+        
+        matlib_xm IM, Q;
+        matlib_create_xm( xi.len, p+1, &IM, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);    
+        legendre_LGLdataIM( xi, IM);
+        fem1d_quadM( quadW, IM, &Q);
+
+        matlib_xv x, xphi;
+        matlib_zv zphi;
+        fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+        matlib_create_xv( x.len, &xphi, MATLIB_COL_VECT);
+        matlib_create_zv( x.len, &zphi, MATLIB_COL_VECT);
+        Gaussian_func(x, xphi);
+        harmonic_zpotential(x, zphi);
+
+        matlib_xm_sparse xM;
+        matlib_zm_sparse zM;
+        fem1d_xm_sparse_GMM(p, Q, xphi, &xM);
+        fem1d_zm_sparse_GMM(p, Q, zphi, &zM);
+
+        /* stiffness as in pde1d_zm_sparse_GSM */ 
+        xM.elem_p[0] += xcoeff/2.0;
+        xM.elem_p[1] -= xcoeff/2.0;
+        zM.elem_p[0] += zcoeff/2.0;
+        zM.elem_p[1] -= zcoeff/2.0;
+        for(i=1; i<N; i++)
+        {
+            xM.elem_p[xM.rowIn[i]]   += xcoeff;
+            xM.elem_p[xM.rowIn[i]+1] -= xcoeff/2.0;
+            zM.elem_p[zM.rowIn[i]]   += zcoeff;
+            zM.elem_p[zM.rowIn[i]+1] -= zcoeff/2.0;
+        }
+        xM.elem_p[xM.rowIn[N]] += xcoeff/2.0;
+        zM.elem_p[zM.rowIn[N]] += zcoeff/2.0;
+        for(i=N+1; i<xM.lenc; i++)
+        {
+            xM.elem_p[xM.rowIn[i]] += xcoeff;
+            zM.elem_p[zM.rowIn[i]] += zcoeff;
+        }
+
+        matlib_index dim = N*p+1;
+        matlib_xv xu, xv1, xv2;
+        matlib_zv zu, zv1, zv2;
+        matlib_create_xv( dim, &xu,  MATLIB_COL_VECT);
+        matlib_create_xv( dim, &xv1, MATLIB_COL_VECT);
+        matlib_create_xv( dim, &xv2, MATLIB_COL_VECT);
+        matlib_create_zv( dim, &zu,  MATLIB_COL_VECT);
+        matlib_create_zv( dim, &zv1, MATLIB_COL_VECT);
+        matlib_create_zv( dim, &zv2, MATLIB_COL_VECT);
+        for(i=0; i<dim; i++)
+        {
+            xu.elem_p[i] = sin(0.1*i);
+            zu.elem_p[i] = cos(0.1*i) + I*sin(0.3*i);
+        }
+
+        matlib_xcsrsymv(MATLIB_UPPER, xM, xu, xv1);
+        matlib_zcsrsymv(MATLIB_UPPER, zM, zu, zv1);
+        fem1d_XGSMV(p, Q, xphi, xcoeff, xu, xv2);
+        fem1d_ZGSMV(p, Q, zphi, zcoeff, zu, zv2);
+
+        matlib_real norm_actual = matlib_xnrm2(xv1);
+        matlib_xaxpy(-1.0, xv1, xv2);
+        matlib_real e_relative = matlib_xnrm2(xv2)/norm_actual;
+        debug_body("Relative error: % 0.16g", e_relative);
+        CU_ASSERT_TRUE(e_relative<TOL);
+
+        norm_actual = matlib_znrm2(zv1);
+        matlib_zaxpy(-1.0, zv1, zv2);
+        e_relative = matlib_znrm2(zv2)/norm_actual;
+        debug_body("Relative error: % 0.16g", e_relative);
+        CU_ASSERT_TRUE(e_relative<TOL);
+
+        matlib_free(xM.rowIn);
+        matlib_free(xM.colIn);
+        matlib_free(xM.elem_p);
+        matlib_free(zM.rowIn);
+        matlib_free(zM.colIn);
+        matlib_free(zM.elem_p);
+        matlib_free(xu.elem_p);
+        matlib_free(xv1.elem_p);
+        matlib_free(xv2.elem_p);
+        matlib_free(zu.elem_p);
+        matlib_free(zv1.elem_p);
+        matlib_free(zv2.elem_p);
+        matlib_free(xi.elem_p);
+        matlib_free(quadW.elem_p);
+        matlib_free(IM.elem_p);
+        matlib_free(Q.elem_p);
+        matlib_free(x.elem_p);
+        matlib_free(xphi.elem_p);
+        matlib_free(zphi.elem_p);
+    }
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+/* Banded storage of the interleaved global matrix: SpMV and LDL^T solve */ 
+void test_fem1d_GMM_band(void)
+{
+    debug_enter("%s", "");
+    matlib_index i, p, N = 53;
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+    matlib_complex coeff = I*0.8;
+
+    for(p=2; p<11; p++)
+    {
+        matlib_xv xi, quadW;
+        legendre_LGLdataLT1( 2*p, TOL, &xi, &quadW);
+        
+        matlib_xm IM, Q;
+        matlib_create_xm( xi.len, p+1, &IM, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);    
+        legendre_LGLdataIM( xi, IM);
+        fem1d_quadM( quadW, IM, &Q);
+
+        matlib_xv x;
+        matlib_zv phi;
+        fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+        matlib_create_zv( x.len, &phi, MATLIB_COL_VECT);
+        harmonic_zpotential(x, phi);
+
+        /* M + coeff*S as in pde1d_zm_sparse_GSM */ 
+        matlib_zm_sparse M;
+        fem1d_zm_sparse_GMM(p, Q, phi, &M);
+        M.elem_p[0] += coeff/2.0;
+        M.elem_p[1] -= coeff/2.0;
+        for(i=1; i<N; i++)
+        {
+            M.elem_p[M.rowIn[i]]   += coeff;
+            M.elem_p[M.rowIn[i]+1] -= coeff/2.0;
+        }
+        M.elem_p[M.rowIn[N]] += coeff/2.0;
+        for(i=N+1; i<M.lenc; i++)
+        {
+            M.elem_p[M.rowIn[i]] += coeff;
+        }
+
+        matlib_index dim = N*p+1;
+        matlib_index perm[dim];
+        fem1d_GMMBandPerm(p, N, perm);
+
+        matlib_zm_dia B;
+        matlib_zcsr2dia(M, perm, p, &B);
+        CU_ASSERT_TRUE((B.lenc==dim) && (B.kd==p) && (B.format==MATLIB_DIA));
+
+        matlib_zv u, v1, v2, ub, vb;
+        matlib_create_zv( dim, &u,  MATLIB_COL_VECT);
+        matlib_create_zv( dim, &v1, MATLIB_COL_VECT);
+        matlib_create_zv( dim, &v2, MATLIB_COL_VECT);
+        matlib_create_zv( dim, &ub, MATLIB_COL_VECT);
+        matlib_create_zv( dim, &vb, MATLIB_COL_VECT);
+        for(i=0; i<dim; i++)
+        {
+            u.elem_p[i] = cos(0.1*i) + I*sin(0.3*i);
+        }
+
+        /* SpMV */ 
+        matlib_zcsrsymv(MATLIB_UPPER, M, u, v1);
+        matlib_zpermute(perm, false, u, ub);
+        matlib_zdiasymv(B, ub, vb);
+        matlib_zpermute(perm, true, vb, v2);
+
+        matlib_real norm_actual = matlib_znrm2(v1);
+        matlib_zaxpy(-1.0, v1, v2);
+        matlib_real e_relative = matlib_znrm2(v2)/norm_actual;
+        debug_body("SpMV, relative error: % 0.16g", e_relative);
+        CU_ASSERT_TRUE(e_relative<TOL);
+
+        /* solve M*w = v1, w should be u */ 
+        matlib_zdiaLDLT(B);
+        matlib_zpermute(perm, false, v1, vb);
+        matlib_zdiaLDLT_solve(B, vb);
+        matlib_zpermute(perm, true, vb, v2);
+
+        norm_actual = matlib_znrm2(u);
+        matlib_zaxpy(-1.0, u, v2);
+        e_relative = matlib_znrm2(v2)/norm_actual;
+        debug_body("LDLT, relative error: % 0.16g", e_relative);
+        CU_ASSERT_TRUE(e_relative<TOL);
+
+        matlib_free(B.elem_p);
+        matlib_free(M.rowIn);
+        matlib_free(M.colIn);
+        matlib_free(M.elem_p);
+        matlib_free(u.elem_p);
+        matlib_free(v1.elem_p);
+        matlib_free(v2.elem_p);
+        matlib_free(ub.elem_p);
+        matlib_free(vb.elem_p);
+        matlib_free(xi.elem_p);
+        matlib_free(quadW.elem_p);
+        matlib_free(IM.elem_p);
+        matlib_free(Q.elem_p);
+        matlib_free(x.elem_p);
+        matlib_free(phi.elem_p);
+    }
+    debug_exit("%s", "");
+}
+
+/*============================================================================*/
+static bool test_fem1d_table_equal
+(
+    fem1d_table_t* t1,
+    fem1d_table_t* t2
+)
+{
+    return    (t1->Q.lenc==t2->Q.lenc)
+           && (memcmp(t1->xi.elem_p,    t2->xi.elem_p,    t1->xi.len*sizeof(matlib_real))==0)
+           && (memcmp(t1->quadW.elem_p, t2->quadW.elem_p, t1->xi.len*sizeof(matlib_real))==0)
+           && (memcmp(t1->FM.elem_p, t2->FM.elem_p, t1->FM.lenc*t1->FM.lenr*sizeof(matlib_real))==0)
+           && (memcmp(t1->IM.elem_p, t2->IM.elem_p, t1->IM.lenc*t1->IM.lenr*sizeof(matlib_real))==0)
+           && (memcmp(t1->Q.elem_p,  t2->Q.elem_p,  t1->Q.lenc*t1->Q.lenr*sizeof(matlib_real))==0);
+}
+
+void test_fem1d_table(void)
+{
+    matlib_index p = 6;
+    matlib_index P = p+2;
+
+    char dir[] = "/tmp/fem1d_table_XXXXXX";
+    CU_ASSERT_TRUE(mkdtemp(dir)!=NULL);
+
+    /* Reference: computed in memory */ 
+    fem1d_table_t t0, t1, t2;
+    unsetenv(FEM1D_TABLE_ENV);
+    fem1d_table_load(p, P, TOL, NULL, &t0);
+    CU_ASSERT_TRUE(t0.map_p==NULL);
+
+    /* First load generates the file, the second one maps it */ 
+    fem1d_table_load(p, P, TOL, dir, &t1);
+    CU_ASSERT_TRUE(t1.map_p!=NULL);
+    fem1d_table_load(p, P, TOL, dir, &t2);
+    CU_ASSERT_TRUE(t2.map_p!=NULL);
+    CU_ASSERT_TRUE(test_fem1d_table_equal(&t0, &t1));
+    CU_ASSERT_TRUE(test_fem1d_table_equal(&t0, &t2));
+    fem1d_table_free(&t1);
+    fem1d_table_free(&t2);
+
+    /* Corrupt the payload: the table must be regenerated */ 
+    char path[PATH_MAX];
+    DIR* dp = opendir(dir);
+    struct dirent* ep;
+    path[0] = '\0';
+    while((ep = readdir(dp))!=NULL)
+    {
+        if(ep->d_name[0]!='.')
+        {
+            snprintf(path, PATH_MAX, "%s/%s", dir, ep->d_name);
+        }
+    }
+    closedir(dp);
+
+    FILE* fp = fopen(path, "r+b");
+    CU_ASSERT_TRUE(fp!=NULL);
+    if(fp==NULL)
+    {
+        return;
+    }
+    fseek(fp, -1, SEEK_END);
+    int c = fgetc(fp);
+    fseek(fp, -1, SEEK_END);
+    fputc(c ^ 0x5a, fp);
+    fclose(fp);
+
+    /* The environment is used when no directory is given */ 
+    setenv(FEM1D_TABLE_ENV, dir, 1);
+    fem1d_table_load(p, P, TOL, NULL, &t1);
+    unsetenv(FEM1D_TABLE_ENV);
+    CU_ASSERT_TRUE(t1.map_p!=NULL);
+    CU_ASSERT_TRUE(test_fem1d_table_equal(&t0, &t1));
+
+    /* A different key does not pick up the cached file */ 
+    fem1d_table_load(p, P+1, TOL, dir, &t2);
+    CU_ASSERT_TRUE(t2.xi.len==P+2);
+    fem1d_table_free(&t2);
+
+    fem1d_table_free(&t1);
+    fem1d_table_free(&t0);
+
+    dp = opendir(dir);
+    while((ep = readdir(dp))!=NULL)
+    {
+        if(ep->d_name[0]!='.')
+        {
+            snprintf(path, PATH_MAX, "%s/%s", dir, ep->d_name);
+            unlink(path);
+        }
+    }
+    closedir(dp);
+    rmdir(dir);
+}
+
+/*============================================================================*/
+void test_fem1d_isa_path(void)
+{
+    FEM1D_ISA isa = fem1d_isa_path();
+    debug_body("kernel path: %s", fem1d_isa_name(isa));
+
+#ifdef ISA_DISPATCH
+    __builtin_cpu_init();
+    if(isa == FEM1D_ISA_AVX512)
+    {
+        CU_ASSERT_TRUE(__builtin_cpu_supports("avx512f"));
+    }
+    if(isa == FEM1D_ISA_AVX2)
+    {
+        CU_ASSERT_TRUE(__builtin_cpu_supports("avx2"));
+    }
+#endif
+    CU_ASSERT_TRUE(fem1d_isa_name(isa)[0] != '\0');
+}
 
 /*============================================================================
  | Test runner
@@ -1622,11 +2455,20 @@ int main()
         { "L2-Norm for Complex"                    , test_L2_znorm       },
         { "Transformation L2F, F2L for Real"       , test_fem1d_XL2F1    },
         { "Transformation L2F, F2L for Complex"    , test_fem1d_ZL2F1    },
+        { "Batched L2F, F2L, PrjL2F for Complex"   , test_fem1d_ZL2F2    },
+        { "Point evaluation for Complex"           , test_fem1d_ZEval    },
         { "Quadrature Matrix"                      , test_fem1d_quadM1   },
         { "MEMI"                                   , test_fem1d_MEMI     },
         { "Global mass matrix for Gaussian real"   , test_fem1d_XGMM1    },
         { "Global mass matrix for Gaussian complex", test_fem1d_ZGMM1    },
         { "N-Sparse"                          , test_fem1d_zm_nsparse_GMM},
+        { "Global mass matrix plan"                , test_fem1d_GMM_plan },
+        { "Global mass matrix update"              , test_fem1d_GMM_update},
+        { "Global mass matrix of a polynomial"     , test_fem1d_GMM_leg  },
+        { "Matrix-free stiffness-mass operator"    , test_fem1d_GSMV     },
+        { "Banded global matrix"                   , test_fem1d_GMM_band },
+        { "LGL/transform table cache"              , test_fem1d_table    },
+        { "ISA dispatch"                           , test_fem1d_isa_path },
         CU_TEST_INFO_NULL,
     };
 
@@ -25,6 +25,8 @@
 
 #include "legendre.h"
 #include "fem1d.h"
+#include "pfem1d.h"
+#include "pde1d_solver.h"
 #include "assert.h"
 
 /* CUnit modules */
@@ -219,6 +221,17 @@ matlib_real solve_NLSEquation_IVP
     matlib_create_zv(    dim,  &V_tmp, MATLIB_COL_VECT);
     matlib_create_zv(    dim,  &U_tmp, MATLIB_COL_VECT);
 
+    /* The analytic solution is transformed into W by the pool while the
+     * nonlinear iterations of a time-step are running 
+     * */ 
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_zv W;
+    matlib_create_zv( dim, &W, MATLIB_COL_VECT);
+    pfem1d_future_t future;
+
     fem1d_ZFLT( N, FM, u0, U_tmp);
     for(i=0; i<V_tmp.len; i++)
     {
@@ -256,6 +269,9 @@ matlib_real solve_NLSEquation_IVP
     for (i=0; i<Nt; i++)
     {
         debug_body("time-step: %d", i);
+        (*func_p)(params, x, t+dt, u_exact);
+        pfem1d_ZFLT_async(N, FM, u_exact, W, num_threads, mp, &future);
+
         fem1d_ZPrjL2F(p, U_tmp, Pvb);
 
 
@@ -304,8 +320,8 @@ matlib_real solve_NLSEquation_IVP
         matlib_zaxpby(2.0, V_tmp, -1.0, U_tmp );
         t += dt;
 
-        (*func_p)(params, x, t, u_exact);
-        fem1d_ZFLT(N, FM, u_exact, V_tmp);
+        pfem1d_wait(&future);
+        matlib_zcopy(W, V_tmp);
 
         /* Error analysis */ 
         norm_actual = fem1d_ZNorm2(p, N, V_tmp);
@@ -321,6 +337,9 @@ matlib_real solve_NLSEquation_IVP
     data.phase_enum = PARDISO_FREE;
     matlib_pardiso(&data);
 
+    pthpool_destroy_threads(num_threads, mp);
+    matlib_free(W.elem_p);
+
     (*func_p)(params, x, t, u_exact);
     fem1d_ZILT(N, IM, U_tmp, u_computed);
 
@@ -447,24 +466,6 @@ void test_solve_NLSEquation_IVPb(void)
 | chi=2, phi(x,t) = x cos(mu*t)
 | 
 /+============================================================================*/
-void fem1d_linespace
-(
-    matlib_real  t0, 
-    matlib_real  dt, 
-    matlib_index Nt, 
-    matlib_xv    *t
-)
-{
-    matlib_create_xv( Nt+1, t, MATLIB_COL_VECT);
-
-    t->elem_p[0] = t0;
-
-    for(matlib_index i=1; i<Nt+1; i++)
-    {
-        t->elem_p[i] = t->elem_p[i-1] + dt;
-    }
-}
-
 
 matlib_real solve_GPEquation_IVP
 (
@@ -323,6 +323,321 @@ void test_pde1d_LSE_solve_IVP_error3(void)
     pde1d_LSE_destroy_solverIVP(&input, &data);
     debug_exit("%s", "");
 }
+/*============================================================================*/
+/* Time step as a task graph against the sequential solver */ 
+void test_pde1d_LSE_solve_IVP_graph(void)
+{
+    debug_enter("%s", "");
+
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_complex A_0 = 1.0;
+    matlib_complex a = 0.5 + I*0.5;
+    matlib_real c = 0.5;
+    matlib_complex phi_0 = 1.0;
+
+    void* params[4] = { (void*)&A_0, 
+                        (void*)&a, 
+                        (void*)&c, 
+                        (void*)&phi_0};
+
+    PDE1D_LSE_SOLVE mode[2] = { PDE1D_LSE_ERROR_ONLY, PDE1D_LSE_EVOLVE_ONLY};
+    matlib_index i, m, k;
+    for(m=0; m<2; m++)
+    {
+        pde1d_LSE_data_t   input[2];
+        pde1d_LSE_solver_t data[2];
+        for(k=0; k<2; k++)
+        {
+            pde1d_LSE_set_defaultsIVP(&input[k]);
+            input[k].N  = 150;
+            input[k].Nt = 40;
+
+            input[k].sol_mode = mode[m];
+            pde1d_LSE_init_solverIVP(&input[k], &data[k]);
+            pde1d_LSE_set_potential( &input[k], PDE1D_LSE_STATIC, 
+                                     (void*)pde1d_LSE_constant_potential);
+            input[k].params = params;
+            input[k].u_analytic = pde1d_LSE_Gaussian_WP_constant_potential;
+            pde1d_LSE_Gaussian_WP_constant_potential( params, input[k].x, 
+                                                      (input[k].t.elem_p)[0],
+                                                      input[k].u_init);
+        }
+        pde1d_LSE_solve_IVP(&input[0], &data[0]);
+        pde1d_LSE_solve_IVP_graph(&input[1], &data[1], num_threads, mp);
+
+        matlib_real e = 0;
+        if(mode[m]==PDE1D_LSE_ERROR_ONLY)
+        {
+            for(i=0; i<input[0].e_rel.len; i++)
+            {
+                e = fmax(e, fabs(input[0].e_rel.elem_p[i]-input[1].e_rel.elem_p[i]));
+            }
+            debug_body("Relative error: %0.16g", input[1].e_rel.elem_p[input[1].Nt]);
+            CU_ASSERT_TRUE(input[1].e_rel.elem_p[input[1].Nt]<4.0e-6);
+        }
+        else
+        {
+            matlib_index len = input[0].U_evol.lenc*input[0].U_evol.lenr;
+            for(i=0; i<len; i++)
+            {
+                e = fmax(e, cabs(input[0].U_evol.elem_p[i]-input[1].U_evol.elem_p[i]));
+            }
+        }
+        debug_body("Max. difference: %0.16g", e);
+        CU_ASSERT_TRUE(e<TOL);
+
+        for(k=0; k<2; k++)
+        {
+            pde1d_LSE_destroy_solverIVP(&input[k], &data[k]);
+        }
+    }
+    pthpool_destroy_threads(num_threads, mp);
+    debug_exit("%s", "");
+}
+/*============================================================================*/
+/* Error analysis overlapped with the solve against the serial one */ 
+void test_pde1d_LSE_solve_IVP_overlap(void)
+{
+    debug_enter("%s", "");
+
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_complex A_0 = 1.0;
+    matlib_complex a = 0.5 + I*0.5;
+    matlib_real c = 0.5;
+    matlib_complex phi_0 = 1.0;
+    matlib_real g_0 = 1;
+    matlib_real mu  = 2.0*M_PI;
+
+    void* params[6] = { (void*)&A_0, 
+                        (void*)&a, 
+                        (void*)&c, 
+                        (void*)&phi_0,
+                        (void*)&g_0,
+                        (void*)&mu};
+
+    matlib_index i, m, k;
+    for(m=0; m<2; m++)
+    {
+        pde1d_LSE_data_t   input[2];
+        pde1d_LSE_solver_t data[2];
+        for(k=0; k<2; k++)
+        {
+            pde1d_LSE_set_defaultsIVP(&input[k]);
+            input[k].N  = 150;
+            input[k].Nt = 40;
+
+            input[k].sol_mode = PDE1D_LSE_ERROR_ONLY;
+            if(k==1)
+            {
+                input[k].num_threads = num_threads;
+                input[k].mp          = mp;
+            }
+            pde1d_LSE_init_solverIVP(&input[k], &data[k]);
+            input[k].params = params;
+            if(m==0)
+            {
+                pde1d_LSE_set_potential( &input[k], PDE1D_LSE_STATIC, 
+                                         (void*)pde1d_LSE_constant_potential);
+                input[k].u_analytic = pde1d_LSE_Gaussian_WP_constant_potential;
+                pde1d_LSE_Gaussian_WP_constant_potential( params, input[k].x, 
+                                                          (input[k].t.elem_p)[0],
+                                                          input[k].u_init);
+                pde1d_LSE_solve_IVP(&input[k], &data[k]);
+            }
+            else
+            {
+                pde1d_LSE_set_potential( &input[k], PDE1D_LSE_DYNAMIC, 
+                                         (void*)pde1d_LSE_timedependent_linear_potential);
+                input[k].u_analytic = pde1d_LSE_Gaussian_WP_timedependent_linear_potential;
+                pde1d_LSE_Gaussian_WP_timedependent_linear_potential( params, input[k].x, 
+                                                                      (input[k].t.elem_p)[0],
+                                                                      input[k].u_init);
+                pde1d_LSE_solve_IVP2_error(&input[k], &data[k]);
+            }
+        }
+
+        bool same = true;
+        for(i=0; i<input[0].e_abs.len; i++)
+        {
+            same =    same 
+                   && (input[0].e_abs.elem_p[i]==input[1].e_abs.elem_p[i])
+                   && (input[0].e_rel.elem_p[i]==input[1].e_rel.elem_p[i]);
+        }
+        debug_body("Relative error: %0.16g", input[1].e_rel.elem_p[input[1].Nt]);
+        CU_ASSERT_TRUE(same);
+        CU_ASSERT_TRUE(input[1].e_rel.elem_p[input[1].Nt]<4.0e-6);
+
+        for(k=0; k<2; k++)
+        {
+            pde1d_LSE_destroy_solverIVP(&input[k], &data[k]);
+        }
+    }
+    pthpool_destroy_threads(num_threads, mp);
+    debug_exit("%s", "");
+}
+/*============================================================================*/
+/* Real potential with complex scale factors and polynomial potential against
+ * the complex potential */ 
+void test_pde1d_LSE_solve_IVP_real(void)
+{
+    debug_enter("%s", "");
+
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_complex A_0 = 1.0;
+    matlib_complex a = 0.5 + I*0.5;
+    matlib_real c = 0.5;
+    matlib_complex phi_0 = 1.0;
+
+    void* params[4] = { (void*)&A_0, 
+                        (void*)&a, 
+                        (void*)&c, 
+                        (void*)&phi_0};
+
+    PDE1D_LSE_POTENTIAL phi_type[3] = { PDE1D_LSE_STATIC, 
+                                        PDE1D_LSE_STATIC_REAL,
+                                        PDE1D_LSE_STATIC_POLY};
+    void* potential[3][2] = {{ (void*)pde1d_LSE_constant_potential, 
+                               (void*)pde1d_LSE_harmonic_potential},
+                             { (void*)pde1d_LSE_constant_rpotential, 
+                               (void*)pde1d_LSE_harmonic_rpotential},
+                             { (void*)pde1d_LSE_constant_ppotential, 
+                               (void*)pde1d_LSE_harmonic_ppotential}};
+    matlib_index i, m, k;
+    for(m=0; m<2; m++)
+    {
+        pde1d_LSE_data_t   input[3];
+        pde1d_LSE_solver_t data[3];
+        for(k=0; k<3; k++)
+        {
+            pde1d_LSE_set_defaultsIVP(&input[k]);
+            input[k].N  = 150;
+            input[k].Nt = 40;
+            /* LGL points accurate enough to compare with the exact assembly */ 
+            input[k].tol = 1e-14;
+            input[k].sol_mode = PDE1D_LSE_EVOLVE_ONLY;
+            if(k==1)
+            {
+                input[k].num_threads = num_threads;
+                input[k].mp          = mp;
+            }
+            pde1d_LSE_init_solverIVP(&input[k], &data[k]);
+            pde1d_LSE_set_potential( &input[k], phi_type[k], potential[k][m]);
+            input[k].params = params;
+            if(m==0)
+            {
+                pde1d_LSE_Gaussian_WP_constant_potential( params, input[k].x, 
+                                                          (input[k].t.elem_p)[0],
+                                                          input[k].u_init);
+            }
+            else
+            {
+                pde1d_LSE_HermiteGaussian_WP_harmonic_potential( params, input[k].x, 
+                                                                 (input[k].t.elem_p)[0],
+                                                                 input[k].u_init);
+            }
+            pde1d_LSE_solve_IVP(&input[k], &data[k]);
+        }
+
+        matlib_real e[2] = {0, 0};
+        matlib_index len = input[0].U_evol.lenc*input[0].U_evol.lenr;
+        for(i=0; i<len; i++)
+        {
+            e[0] = fmax(e[0], cabs(input[0].U_evol.elem_p[i]-input[1].U_evol.elem_p[i]));
+            e[1] = fmax(e[1], cabs(input[0].U_evol.elem_p[i]-input[2].U_evol.elem_p[i]));
+        }
+        debug_body("Max. difference (real): %0.16g", e[0]);
+        debug_body("Max. difference (polynomial): %0.16g", e[1]);
+        CU_ASSERT_TRUE(e[0]<TOL);
+        CU_ASSERT_TRUE(e[1]<TOL);
+
+        for(k=0; k<3; k++)
+        {
+            pde1d_LSE_destroy_solverIVP(&input[k], &data[k]);
+        }
+    }
+    pthpool_destroy_threads(num_threads, mp);
+    debug_exit("%s", "");
+}
+/*============================================================================*/
+/* Compressed batches of a dynamic potential against the full ones */ 
+void test_pde1d_LSE_solve_IVP_compressed(void)
+{
+    debug_enter("%s", "");
+
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_complex A_0 = 1.0;
+    matlib_complex a = 0.5 + I*0.5;
+    matlib_real c = 0.5;
+    matlib_complex phi_0 = 1.0;
+    matlib_real g_0 = 1;
+    matlib_real mu  = 2.0*M_PI;
+
+    void* params[6] = { (void*)&A_0, 
+                        (void*)&a, 
+                        (void*)&c, 
+                        (void*)&phi_0,
+                        (void*)&g_0,
+                        (void*)&mu};
+
+    matlib_index i, k;
+    pde1d_LSE_data_t   input[3];
+    pde1d_LSE_solver_t data[3];
+    for(k=0; k<3; k++)
+    {
+        pde1d_LSE_set_defaultsIVP(&input[k]);
+        input[k].N  = 150;
+        input[k].Nt = 40;
+        input[k].nsparse  = 10;
+        input[k].sol_mode = PDE1D_LSE_ERROR_ONLY;
+        if(k>0)
+        {
+            input[k].nsparse_mode = PDE1D_LSE_NSPARSE_COMPRESSED;
+        }
+        if(k==2)
+        {
+            input[k].num_threads = num_threads;
+            input[k].mp          = mp;
+        }
+        pde1d_LSE_init_solverIVP(&input[k], &data[k]);
+        input[k].params = params;
+        pde1d_LSE_set_potential( &input[k], PDE1D_LSE_DYNAMIC, 
+                                 (void*)pde1d_LSE_timedependent_linear_potential);
+        input[k].u_analytic = pde1d_LSE_Gaussian_WP_timedependent_linear_potential;
+        pde1d_LSE_solve_IVP(&input[k], &data[k]);
+    }
+
+    matlib_real e = 0;
+    bool same = true;
+    for(i=0; i<input[0].e_abs.len; i++)
+    {
+        e = fmax(e, fabs(input[0].e_abs.elem_p[i]-input[1].e_abs.elem_p[i]));
+        same = same && (input[1].e_abs.elem_p[i]==input[2].e_abs.elem_p[i]);
+    }
+    debug_body("Max. difference: %0.16g", e);
+    debug_body("Relative error: %0.16g", input[1].e_rel.elem_p[input[1].Nt]);
+    CU_ASSERT_TRUE(e<TOL);
+    CU_ASSERT_TRUE(same);
+    CU_ASSERT_TRUE(input[1].e_rel.elem_p[input[1].Nt]<4.0e-6);
+
+    for(k=0; k<3; k++)
+    {
+        pde1d_LSE_destroy_solverIVP(&input[k], &data[k]);
+    }
+    pthpool_destroy_threads(num_threads, mp);
+    debug_exit("%s", "");
+}
 /*============================================================================+/
  | Test runner
  |
@@ -349,6 +664,10 @@ int main(void)
         { "Linear time-dependent potential evolve", test_pde1d_LSE_solve_IVP_evol3},
         //{ "Constant potential error" , test_pde1d_LSE_solve_IVP_error},
         { "Linear time-dependent potential error" , test_pde1d_LSE_solve_IVP_error3},
+        { "Constant potential task graph"         , test_pde1d_LSE_solve_IVP_graph},
+        { "Overlapped error analysis"             , test_pde1d_LSE_solve_IVP_overlap},
+        { "Real and polynomial potential paths"   , test_pde1d_LSE_solve_IVP_real},
+        { "Compressed batches"                    , test_pde1d_LSE_solve_IVP_compressed},
         CU_TEST_INFO_NULL,
     };
 
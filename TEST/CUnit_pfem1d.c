@@ -1409,6 +1409,403 @@ void test_pfem1d_ZPrjL2F(void)
     }
 }
 /*============================================================================*/
+/* The phases of a persistent region reproduce the separate parallel calls */ 
+void test_pfem1d_region_general(matlib_index p)
+{
+    debug_enter("polynomial degree: %d", p);
+
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_index i, N = 301;
+    matlib_index P = 4*p;
+
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    matlib_xv xi, quadW;
+    legendre_LGLdataLT1( P, TOL, &xi, &quadW);
+    
+    matlib_xm FM;
+    matlib_create_xm( p+1, xi.len, &FM, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataFM( xi, FM);
+
+    matlib_xv x;
+    matlib_zv u, U1, U2, V1, V2, Pvb1, Pvb2;
+    fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+    matlib_create_zv( x.len, &u, MATLIB_COL_VECT);
+    zGaussian(x, u);
+
+    matlib_create_zv( N*(p+1), &U1,   MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &U2,   MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &V1,   MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &V2,   MATLIB_COL_VECT);
+    matlib_create_zv( N*p+1,   &Pvb1, MATLIB_COL_VECT);
+    matlib_create_zv( N*p+1,   &Pvb2, MATLIB_COL_VECT);
+    fem1d_ZFLT( N, FM, u, U1);
+    for(i=0; i<U1.len; i++)
+    {
+        U2.elem_p[i] = U1.elem_p[i];
+    }
+
+    /* U <- 2*F2L(PrjL2F(U)) - U, twice */ 
+    matlib_index r, nr_repeat = 2;
+    for(r=0; r<nr_repeat; r++)
+    {
+        pfem1d_ZPrjL2F(p, U1, Pvb1, num_threads, mp);
+        pfem1d_ZF2L(p, Pvb1, V1, num_threads, mp);
+        matlib_zaxpby(2.0, V1, -1.0, U1);
+    }
+
+    pfem1d_phase_args_t args[3];
+    pthpool_phase_t     phase[3];
+    pfem1d_ZPrjL2F_phase(p, U2, Pvb2, &args[0], &phase[0]);
+    pfem1d_ZF2L_phase(p, Pvb2, V2, &args[1], &phase[1]);
+    pfem1d_zaxpby_phase(p, 2.0, V2, -1.0, U2, &args[2], &phase[2]);
+
+    pthpool_region_t region;
+    pthpool_region_init(N, num_threads, &region);
+    pthpool_region_exec(&region, 3, phase, nr_repeat, mp);
+    pthpool_region_destroy(&region);
+    for(i=0; i<3; i++)
+    {
+        pfem1d_phase_free(&args[i]);
+    }
+
+    matlib_real norm_actual = matlib_znrm2(U1);
+    matlib_zaxpy(-1.0, U1, U2);
+    matlib_real e_relative = matlib_znrm2(U2)/norm_actual;
+    debug_body("Relative error: % 0.16g", e_relative);
+    CU_ASSERT_TRUE(e_relative<TOL);
+
+    matlib_free(xi.elem_p);
+    matlib_free(quadW.elem_p);
+    matlib_free(FM.elem_p);
+    matlib_free(x.elem_p);
+    matlib_free(u.elem_p);
+    matlib_free(U1.elem_p);
+    matlib_free(U2.elem_p);
+    matlib_free(V1.elem_p);
+    matlib_free(V2.elem_p);
+    matlib_free(Pvb1.elem_p);
+    matlib_free(Pvb2.elem_p);
+    pthpool_destroy_threads(num_threads, mp);
+    debug_exit("%s", "");
+}
+
+void test_pfem1d_region(void)
+{
+    matlib_index p_max = 15;
+    for (matlib_index p=2; p<p_max; p++)
+    {
+        test_pfem1d_region_general(p);
+    }
+}
+/*============================================================================*/
+/* Partitioned vectors: zeroed by the owners and bit-identical results of the
+ * owner-run element loops and of the stealable ones on the same vectors */ 
+void test_pfem1d_partitioned_general(matlib_index p)
+{
+    debug_enter("polynomial degree: %d", p);
+
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_index i, N = 257;
+    matlib_index P = 4*p;
+
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    matlib_xv xi, quadW;
+    legendre_LGLdataLT1( P, TOL, &xi, &quadW);
+    
+    matlib_xm FM, IM;
+    matlib_create_xm( p+1, xi.len, &FM, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);    
+    matlib_create_xm( xi.len, p+1, &IM, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataFM( xi, FM);
+    legendre_LGLdataIM( xi, IM);
+
+    matlib_xv x;
+    matlib_zv u, v, U, Pvb;
+    fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+    matlib_create_zv( x.len,   &u,   MATLIB_COL_VECT);
+    matlib_create_zv( x.len,   &v,   MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &U,   MATLIB_COL_VECT);
+    matlib_create_zv( N*p+1,   &Pvb, MATLIB_COL_VECT);
+    zGaussian(x, u);
+    fem1d_ZFLT( N, FM, u, U);
+    fem1d_ZILT( N, IM, U, v);
+    fem1d_ZPrjL2F(p, U, Pvb);
+
+    pfem1d_zpv_t u_p, v_p, U_p, Pvb_p;
+    pfem1d_create_zpv( N, P+1, x.len,   num_threads, mp, &u_p);
+    pfem1d_create_zpv( N, P+1, x.len,   num_threads, mp, &v_p);
+    pfem1d_create_zpv( N, p+1, N*(p+1), num_threads, mp, &U_p);
+    pfem1d_create_zpv( N, p,   N*p+1,   num_threads, mp, &Pvb_p);
+
+    bool zero = true;
+    for(i=0; i<Pvb_p.v.len; i++)
+    {
+        zero = zero && (Pvb_p.v.elem_p[i]==0);
+    }
+    CU_ASSERT_TRUE(zero);
+    CU_ASSERT_TRUE(    (U_p.part.N==N) && (U_p.part.num_threads==num_threads)
+                    && (U_p.part.start[0]==0) && (U_p.part.start[num_threads]==N));
+
+    for(i=0; i<u.len; i++)
+    {
+        u_p.v.elem_p[i] = u.elem_p[i];
+    }
+    pfem1d_ZFLT_pv( N, FM, &u_p, &U_p, mp);
+    pfem1d_ZILT_pv( N, IM, &U_p, &v_p, mp);
+    pfem1d_ZPrjL2F(p, U_p.v, Pvb_p.v, num_threads, mp);
+
+    bool same = true;
+    for(i=0; i<U.len; i++)
+    {
+        same = same && (U_p.v.elem_p[i]==U.elem_p[i]);
+    }
+    for(i=0; i<v.len; i++)
+    {
+        same = same && (v_p.v.elem_p[i]==v.elem_p[i]);
+    }
+    for(i=0; i<Pvb.len; i++)
+    {
+        same = same && (Pvb_p.v.elem_p[i]==Pvb.elem_p[i]);
+    }
+    CU_ASSERT_TRUE(same);
+
+    pfem1d_free_zpv(&u_p);
+    pfem1d_free_zpv(&v_p);
+    pfem1d_free_zpv(&U_p);
+    pfem1d_free_zpv(&Pvb_p);
+    CU_ASSERT_TRUE((U_p.v.elem_p==NULL) && (U_p.part.start==NULL));
+
+    matlib_free(xi.elem_p);
+    matlib_free(quadW.elem_p);
+    matlib_free(FM.elem_p);
+    matlib_free(IM.elem_p);
+    matlib_free(x.elem_p);
+    matlib_free(u.elem_p);
+    matlib_free(v.elem_p);
+    matlib_free(U.elem_p);
+    matlib_free(Pvb.elem_p);
+    pthpool_destroy_threads(num_threads, mp);
+    debug_exit("%s", "");
+}
+
+void test_pfem1d_partitioned(void)
+{
+    matlib_index p_max = 10;
+    for (matlib_index p=2; p<p_max; p++)
+    {
+        test_pfem1d_partitioned_general(p);
+    }
+}
+/*============================================================================*/
+/* Asynchronous calls: two futures in flight, results bit-identical to the
+ * synchronous calls with the same arguments */ 
+void test_pfem1d_async_general(matlib_index p)
+{
+    debug_enter("polynomial degree: %d", p);
+
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_index i, N = 263;
+    matlib_index P = 4*p;
+
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    matlib_xv xi, quadW;
+    legendre_LGLdataLT1( P, TOL, &xi, &quadW);
+    
+    matlib_xm FM, IM;
+    matlib_create_xm( p+1, xi.len, &FM, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);    
+    matlib_create_xm( xi.len, p+1, &IM, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataFM( xi, FM);
+    legendre_LGLdataIM( xi, IM);
+
+    matlib_xv x;
+    matlib_zv u, v1, v2, U1, U2, V1, V2, Pvb1, Pvb2;
+    fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+    matlib_create_zv( x.len,   &u,    MATLIB_COL_VECT);
+    matlib_create_zv( x.len,   &v1,   MATLIB_COL_VECT);
+    matlib_create_zv( x.len,   &v2,   MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &U1,   MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &U2,   MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &V1,   MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &V2,   MATLIB_COL_VECT);
+    matlib_create_zv( N*p+1,   &Pvb1, MATLIB_COL_VECT);
+    matlib_create_zv( N*p+1,   &Pvb2, MATLIB_COL_VECT);
+    zGaussian(x, u);
+
+    pfem1d_ZFLT( N, FM, u, U1, num_threads, mp);
+    pfem1d_ZILT( N, IM, U1, v1, num_threads, mp);
+    pfem1d_ZPrjL2F(p, U1, Pvb1, num_threads, mp);
+    pfem1d_ZF2L(p, Pvb1, V1, num_threads, mp);
+
+    /* FLT and PrjL2F of the synchronous result run at the same time */ 
+    pfem1d_future_t future[2];
+    pfem1d_ZFLT_async( N, FM, u, U2, num_threads, mp, &future[0]);
+    pfem1d_ZPrjL2F_async(p, U1, Pvb2, num_threads, mp, &future[1]);
+    pfem1d_wait(&future[1]);
+    pfem1d_wait(&future[0]);
+
+    pfem1d_ZILT_async( N, IM, U2, v2, num_threads, mp, &future[0]);
+    pfem1d_ZF2L_async(p, Pvb2, V2, num_threads, mp, &future[1]);
+    pfem1d_wait(&future[0]);
+    pfem1d_wait(&future[1]);
+
+    bool same = true;
+    for(i=0; i<U1.len; i++)
+    {
+        same = same && (U1.elem_p[i]==U2.elem_p[i]) && (V1.elem_p[i]==V2.elem_p[i]);
+    }
+    for(i=0; i<v1.len; i++)
+    {
+        same = same && (v1.elem_p[i]==v2.elem_p[i]);
+    }
+    for(i=0; i<Pvb1.len; i++)
+    {
+        same = same && (Pvb1.elem_p[i]==Pvb2.elem_p[i]);
+    }
+    CU_ASSERT_TRUE(same);
+
+    matlib_free(xi.elem_p);
+    matlib_free(quadW.elem_p);
+    matlib_free(FM.elem_p);
+    matlib_free(IM.elem_p);
+    matlib_free(x.elem_p);
+    matlib_free(u.elem_p);
+    matlib_free(v1.elem_p);
+    matlib_free(v2.elem_p);
+    matlib_free(U1.elem_p);
+    matlib_free(U2.elem_p);
+    matlib_free(V1.elem_p);
+    matlib_free(V2.elem_p);
+    matlib_free(Pvb1.elem_p);
+    matlib_free(Pvb2.elem_p);
+    pthpool_destroy_threads(num_threads, mp);
+    debug_exit("%s", "");
+}
+
+void test_pfem1d_async(void)
+{
+    matlib_index p_max = 15;
+    for (matlib_index p=2; p<p_max; p++)
+    {
+        test_pfem1d_async_general(p);
+    }
+}
+/*============================================================================*/
+
+void test_pfem1d_ZL2F2_general(matlib_index p)
+{
+    debug_enter("polynomial degree: %d", p);
+
+    /* Create pthreads */
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_index i, j;
+    matlib_index num_exp = 5;
+    matlib_index k = 3;
+
+    matlib_index N, N0 = 200;
+    matlib_index P = 4*p;
+
+    /* define the domain */ 
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    matlib_xv xi, quadW;
+    legendre_LGLdataLT1( P, TOL, &xi, &quadW);
+    
+    matlib_xm FM;
+    matlib_create_xm( p+1, xi.len, &FM, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataFM( xi, FM);
+
+    matlib_xv x;
+    matlib_zv u, U;
+    matlib_zm UU, vb1, vb2, U1, U2, Pvb1, Pvb2;
+    matlib_real e_relative;
+
+    for(j=0; j<num_exp; j++)
+    {
+        N = (j+1)*N0;
+
+        fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+        matlib_create_zv( x.len, &u, MATLIB_COL_VECT);
+        matlib_create_zv( N*(p+1), &U, MATLIB_COL_VECT);
+        zGaussian(x, u);
+        fem1d_ZFLT( N, FM, u, U);
+
+        matlib_create_zm( N*(p+1), k, &UU, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_zm( N*(p+1), k, &U1, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_zm( N*(p+1), k, &U2, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_zm( N*p+1, k, &vb1,  MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_zm( N*p+1, k, &vb2,  MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_zm( N*p+1, k, &Pvb1, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_zm( N*p+1, k, &Pvb2, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);
+
+        for(i=0; i<UU.lenc*k; i++)
+        {
+            UU.elem_p[i] = (1.0+I*(i%k))*U.elem_p[i/k];
+        }
+
+        fem1d_ZL2F2(p, UU, vb1);
+        fem1d_ZF2L2(p, vb1, U1);
+        fem1d_ZPrjL2F2(p, UU, Pvb1);
+
+        pfem1d_ZL2F2(p, UU, vb2, num_threads, mp);
+        pfem1d_ZF2L2(p, vb2, U2, num_threads, mp);
+        pfem1d_ZPrjL2F2(p, UU, Pvb2, num_threads, mp);
+
+        e_relative = 0;
+        for(i=0; i<vb1.lenc*k; i++)
+        {
+            e_relative = fmax(e_relative, cabs(vb1.elem_p[i]-vb2.elem_p[i]));
+            e_relative = fmax(e_relative, cabs(Pvb1.elem_p[i]-Pvb2.elem_p[i]));
+        }
+        for(i=0; i<U1.lenc*k; i++)
+        {
+            e_relative = fmax(e_relative, cabs(U1.elem_p[i]-U2.elem_p[i]));
+        }
+        debug_body("Relative error: % 0.16g", e_relative);
+        CU_ASSERT_TRUE(e_relative<TOL);
+
+        matlib_free(x.elem_p);
+        matlib_free(u.elem_p);
+        matlib_free(U.elem_p);
+        matlib_free(UU.elem_p);
+        matlib_free(U1.elem_p);
+        matlib_free(U2.elem_p);
+        matlib_free(vb1.elem_p);
+        matlib_free(vb2.elem_p);
+        matlib_free(Pvb1.elem_p);
+        matlib_free(Pvb2.elem_p);
+    }
+    
+    debug_body("%s", "signal threads to exit!");
+    pthpool_destroy_threads(num_threads, mp);
+}
+
+void test_pfem1d_ZL2F2(void)
+{
+    matlib_index p;
+    for (p=2; p<15; p++)
+    {
+        test_pfem1d_ZL2F2_general(p);
+    }
+}
 
 void test_pfem1d_ZNorm2_general(matlib_index p)
 {
@@ -1498,6 +1895,117 @@ void test_pfem1d_ZNorm2(void)
     }
 }
 /*============================================================================*/
+void test_pfem1d_ZEval(void)
+{
+    matlib_index p = 8, N = 400, M = 10007;
+    matlib_index i, num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    matlib_xv xi, quadW, x, y;
+    legendre_LGLdataLT1( 4*p, TOL, &xi, &quadW);
+
+    matlib_xm FM;
+    matlib_create_xm( p+1, xi.len, &FM, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataFM( xi, FM);
+
+    fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+
+    matlib_zv u, U, u1, u2;
+    matlib_create_zv( x.len, &u, MATLIB_COL_VECT);
+    matlib_create_zv( N*(p+1), &U, MATLIB_COL_VECT);
+    zGaussian(x, u);
+    fem1d_ZFLT( N, FM, u, U);
+
+    /* uniform detector grid */ 
+    matlib_create_xv( M, &y, MATLIB_COL_VECT);
+    matlib_create_zv( M, &u1, MATLIB_COL_VECT);
+    matlib_create_zv( M, &u2, MATLIB_COL_VECT);
+    for(i=0; i<M; i++)
+    {
+        y.elem_p[i] = x_l + i*(x_r-x_l)/(M-1);
+    }
+
+    fem1d_ZEval( p, x_l, x_r, U, y, u1);
+    pfem1d_ZEval( p, x_l, x_r, U, y, u2, num_threads, mp);
+
+    matlib_real e = 0, norm_actual = matlib_znrm2(u1);
+    for(i=0; i<M; i++)
+    {
+        e = fmax(e, cabs(u1.elem_p[i]-u2.elem_p[i]));
+    }
+    CU_ASSERT_TRUE(e == 0);
+
+    /* the series approximates the Gaussian on the whole grid */ 
+    zGaussian(y, u2);
+    matlib_zaxpy(-1.0, u1, u2);
+    CU_ASSERT_TRUE(matlib_znrm2(u2)/norm_actual<1e-6);
+
+    pthpool_destroy_threads(num_threads, mp);
+    matlib_free(xi.elem_p);
+    matlib_free(quadW.elem_p);
+    matlib_free(FM.elem_p);
+    matlib_free(x.elem_p);
+    matlib_free(y.elem_p);
+    matlib_free(u.elem_p);
+    matlib_free(U.elem_p);
+    matlib_free(u1.elem_p);
+    matlib_free(u2.elem_p);
+}
+
+void test_pfem1d_ZNorm2_reproducible(void)
+/* 
+ * The norm must be bitwise identical for any number of threads and equal to
+ * the serial result; the larger mesh has more block partials than the
+ * serial routine sums at a time.
+ * */ 
+{
+    matlib_index j, p = 6, N;
+    matlib_index N_test[2] = {1237, 40009};
+    matlib_index num_threads, max_threads = 5;
+    pthpool_data_t mp[max_threads];
+
+    matlib_xv xi, quadW, x;
+    legendre_LGLdataLT1( 4*p, TOL, &xi, &quadW);
+
+    matlib_xm FM;
+    matlib_create_xm( p+1, xi.len, &FM, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataFM( xi, FM);
+
+    for(j=0; j<2; j++)
+    {
+        N = N_test[j];
+        fem1d_ref2mesh (xi, N, -5.0, 5.0, &x);
+
+        matlib_zv u, U;
+        matlib_create_zv( x.len, &u, MATLIB_COL_VECT);
+        matlib_create_zv( N*(p+1), &U, MATLIB_COL_VECT);
+        zGaussian(x, u);
+        fem1d_ZFLT( N, FM, u, U);
+
+        matlib_real norm_serial = fem1d_ZNorm2( p, N, U), norm;
+
+        for(num_threads=1; num_threads<=max_threads; num_threads++)
+        {
+            pthpool_create_threads(num_threads, mp);
+            norm = pfem1d_ZNorm2( p, N, U, num_threads, mp);
+            CU_ASSERT_TRUE(norm == norm_serial);
+            pthpool_destroy_threads(num_threads, mp);
+        }
+
+        matlib_free(x.elem_p);
+        matlib_free(u.elem_p);
+        matlib_free(U.elem_p);
+    }
+
+    matlib_free(xi.elem_p);
+    matlib_free(quadW.elem_p);
+    matlib_free(FM.elem_p);
+}
+
 void linear_timedependent_zpotential
 ( 
     matlib_xv   x, 
@@ -1630,6 +2138,476 @@ void test_pfem1d_ZGMM(void)
     }
 }
 
+/*============================================================================*/
+/* Single matrix and small nsparse assembly split over the elements against
+ * the serial assembly */ 
+void test_pfem1d_sparse_GMM_general(matlib_index p)
+{
+    debug_enter("polynomial degree: %d", p);
+
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_index i, j, k, N;
+    matlib_index N_test[4] = {1, 3, 7, 301};
+    matlib_index P = 4*p;
+
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    matlib_xv xi, quadW;
+    legendre_LGLdataLT1( P, TOL, &xi, &quadW);
+    
+    matlib_xm IM, Q;
+    matlib_create_xm( xi.len, p+1, &IM, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataIM( xi, IM);
+    fem1d_quadM( quadW, IM, &Q);
+
+    matlib_xv x, xphi;
+    matlib_zv zphi;
+    matlib_xm_sparse xM1, xM2;
+    matlib_zm_sparse zM1, zM2;
+
+    matlib_index nsparse = 2;
+    matlib_zm phi1, q1, phi2, q2;
+    matlib_zm_nsparse M1, M2;
+
+    for(j=0; j<4; j++)
+    {
+        N = N_test[j];
+        fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+        matlib_create_xv( x.len, &xphi, MATLIB_COL_VECT);
+        matlib_create_zv( x.len, &zphi, MATLIB_COL_VECT);
+        Gaussian(x, xphi);
+        zGaussian(x, zphi);
+
+        fem1d_xm_sparse_GMM(p, Q, xphi, &xM1);
+        pfem1d_xm_sparse_GMM(p, Q, xphi, &xM2, num_threads, mp);
+        fem1d_zm_sparse_GMM(p, Q, zphi, &zM1);
+        pfem1d_zm_sparse_GMM(p, Q, zphi, &zM2, num_threads, mp);
+
+        matlib_index nnz = xM1.rowIn[xM1.lenc];
+        bool same =    (xM2.lenc==xM1.lenc) && (zM2.lenc==zM1.lenc)
+                    && (nnz==N*p*(p+3)/2+1);
+        for(i=0; i<=xM1.lenc; i++)
+        {
+            same = same && (xM1.rowIn[i]==xM2.rowIn[i]) && (zM1.rowIn[i]==zM2.rowIn[i]);
+        }
+        for(i=0; i<nnz; i++)
+        {
+            same =    same 
+                   && (xM1.colIn[i]==xM2.colIn[i])   && (zM1.colIn[i]==zM2.colIn[i])
+                   && (xM1.elem_p[i]==xM2.elem_p[i]) && (zM1.elem_p[i]==zM2.elem_p[i]);
+        }
+        CU_ASSERT_TRUE(same);
+
+        /* in place re-assembly */ 
+        matlib_free(zM2.rowIn);
+        matlib_free(zM2.colIn);
+        matlib_free(zM2.elem_p);
+        fem1d_GMM_plan_t plan;
+        fem1d_zm_sparse_GMM_plan(p, N, Q, &zM2, &plan);
+        pfem1d_zm_sparse_GMM_exec(&plan, Q, zphi, &zM2, num_threads, mp);
+        for(i=0; i<nnz; i++)
+        {
+            same = same && (zM1.elem_p[i]==zM2.elem_p[i]);
+        }
+        CU_ASSERT_TRUE(same);
+
+        /* real potential with complex scale factors */ 
+        matlib_complex c[2] = {0.5-I*0.25, 2.0+I};
+        fem1d_xzm_sparse_GMM_exec(&plan, Q, xphi, c, &zM1);
+        pfem1d_xzm_sparse_GMM_exec(&plan, Q, xphi, c, &zM2, num_threads, mp);
+        for(i=0; i<nnz; i++)
+        {
+            same = same && (zM1.elem_p[i]==zM2.elem_p[i]);
+        }
+        CU_ASSERT_TRUE(same);
+        fem1d_GMM_plan_free(&plan);
+
+        /* fewer matrices than threads */ 
+        fem1d_zm_nsparse_GMM(p, N, nsparse, Q, &phi1, &q1, &M1, FEM1D_GMM_INIT);
+        fem1d_zm_nsparse_GMM(p, N, nsparse, Q, &phi2, &q2, &M2, FEM1D_GMM_INIT);
+        for(k=0; k<nsparse; k++)
+        {
+            for(i=0; i<x.len; i++)
+            {
+                phi1.elem_p[k*x.len+i] = (k+1)*zphi.elem_p[i];
+                phi2.elem_p[k*x.len+i] = (k+1)*zphi.elem_p[i];
+            }
+        }
+        fem1d_zm_nsparse_GMM(p, N, nsparse, Q, &phi1, &q1, &M1, FEM1D_GET_NZE_ONLY);
+        pfem1d_zm_nsparse_GMM(p, N, Q, &phi2, &q2, &M2, num_threads, mp);
+        same = true;
+        for(k=0; k<nsparse; k++)
+        {
+            for(i=0; i<nnz; i++)
+            {
+                same = same && (M1.elem_p[k][i]==M2.elem_p[k][i]);
+            }
+        }
+        CU_ASSERT_TRUE(same);
+        fem1d_zm_nsparse_GMM(p, N, nsparse, Q, &phi1, &q1, &M1, FEM1D_GMM_FREE);
+        fem1d_zm_nsparse_GMM(p, N, nsparse, Q, &phi2, &q2, &M2, FEM1D_GMM_FREE);
+
+        matlib_free(xM1.rowIn);
+        matlib_free(xM1.colIn);
+        matlib_free(xM1.elem_p);
+        matlib_free(xM2.rowIn);
+        matlib_free(xM2.colIn);
+        matlib_free(xM2.elem_p);
+        matlib_free(zM1.rowIn);
+        matlib_free(zM1.colIn);
+        matlib_free(zM1.elem_p);
+        matlib_free(zM2.rowIn);
+        matlib_free(zM2.colIn);
+        matlib_free(zM2.elem_p);
+        matlib_free(x.elem_p);
+        matlib_free(xphi.elem_p);
+        matlib_free(zphi.elem_p);
+    }
+
+    matlib_free(xi.elem_p);
+    matlib_free(quadW.elem_p);
+    matlib_free(IM.elem_p);
+    matlib_free(Q.elem_p);
+    pthpool_destroy_threads(num_threads, mp);
+    debug_exit("%s", "");
+}
+
+void test_pfem1d_sparse_GMM(void)
+{
+    matlib_index p_max = 9;
+    for (matlib_index p=2; p<p_max; p++)
+    {
+        test_pfem1d_sparse_GMM_general(p);
+    }
+}
+/*============================================================================*/
+/* Matrix-free operator: bit-identical to the serial one */ 
+void test_pfem1d_GSMV_general(matlib_index p)
+{
+    debug_enter("polynomial degree: %d", p);
+
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_index i, j, N;
+    matlib_index N_test[3] = {1, 5, 211};
+    matlib_index P = 4*p;
+
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    matlib_xv xi, quadW;
+    legendre_LGLdataLT1( P, TOL, &xi, &quadW);
+    
+    matlib_xm IM, Q;
+    matlib_create_xm( xi.len, p+1, &IM, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataIM( xi, IM);
+    fem1d_quadM( quadW, IM, &Q);
+
+    for(j=0; j<3; j++)
+    {
+        N = N_test[j];
+        matlib_index dim = N*p+1;
+
+        matlib_xv x, xphi, xu, xv1, xv2;
+        matlib_zv zphi, zu, zv1, zv2;
+        fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+        matlib_create_xv( x.len, &xphi, MATLIB_COL_VECT);
+        matlib_create_zv( x.len, &zphi, MATLIB_COL_VECT);
+        matlib_create_xv( dim, &xu,  MATLIB_COL_VECT);
+        matlib_create_xv( dim, &xv1, MATLIB_COL_VECT);
+        matlib_create_xv( dim, &xv2, MATLIB_COL_VECT);
+        matlib_create_zv( dim, &zu,  MATLIB_COL_VECT);
+        matlib_create_zv( dim, &zv1, MATLIB_COL_VECT);
+        matlib_create_zv( dim, &zv2, MATLIB_COL_VECT);
+        Gaussian(x, xphi);
+        zGaussian(x, zphi);
+        for(i=0; i<dim; i++)
+        {
+            xu.elem_p[i] = sin(0.1*i);
+            zu.elem_p[i] = cos(0.1*i) + I*sin(0.3*i);
+        }
+
+        fem1d_XGSMV(p, Q, xphi, 0.7, xu, xv1);
+        pfem1d_XGSMV(p, Q, xphi, 0.7, xu, xv2, num_threads, mp);
+        fem1d_ZGSMV(p, Q, zphi, 0.3+I*0.9, zu, zv1);
+        pfem1d_ZGSMV(p, Q, zphi, 0.3+I*0.9, zu, zv2, num_threads, mp);
+
+        bool same = true;
+        for(i=0; i<dim; i++)
+        {
+            same = same && (xv1.elem_p[i]==xv2.elem_p[i]) && (zv1.elem_p[i]==zv2.elem_p[i]);
+        }
+        CU_ASSERT_TRUE(same);
+
+        matlib_free(x.elem_p);
+        matlib_free(xphi.elem_p);
+        matlib_free(zphi.elem_p);
+        matlib_free(xu.elem_p);
+        matlib_free(xv1.elem_p);
+        matlib_free(xv2.elem_p);
+        matlib_free(zu.elem_p);
+        matlib_free(zv1.elem_p);
+        matlib_free(zv2.elem_p);
+    }
+
+    matlib_free(xi.elem_p);
+    matlib_free(quadW.elem_p);
+    matlib_free(IM.elem_p);
+    matlib_free(Q.elem_p);
+    pthpool_destroy_threads(num_threads, mp);
+    debug_exit("%s", "");
+}
+
+void test_pfem1d_GSMV(void)
+{
+    matlib_index p_max = 12;
+    for (matlib_index p=2; p<p_max; p++)
+    {
+        test_pfem1d_GSMV_general(p);
+    }
+}
+
+/*============================================================================*/
+/* Symmetric CSR products: serial against a direct sum over the stored
+ * entries, threaded with several vectors and the lower triangle against the
+ * serial one */ 
+void test_pfem1d_csrsymv_general(matlib_index p)
+{
+    debug_enter("polynomial degree: %d", p);
+
+    matlib_index num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_index i, j, k, s, N, nrhs = 3;
+    matlib_index N_test[3] = {1, 5, 211};
+    matlib_index P = 2*p;
+
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    matlib_xv xi, quadW;
+    legendre_LGLdataLT1( P, TOL, &xi, &quadW);
+    
+    matlib_xm IM, Q;
+    matlib_create_xm( xi.len, p+1, &IM, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataIM( xi, IM);
+    fem1d_quadM( quadW, IM, &Q);
+
+    for(j=0; j<3; j++)
+    {
+        N = N_test[j];
+
+        matlib_xv x, xphi;
+        matlib_zv zphi;
+        fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+        matlib_create_xv( x.len, &xphi, MATLIB_COL_VECT);
+        matlib_create_zv( x.len, &zphi, MATLIB_COL_VECT);
+        Gaussian(x, xphi);
+        zGaussian(x, zphi);
+
+        matlib_xm_sparse xM;
+        matlib_zm_sparse zM;
+        fem1d_xm_sparse_GMM(p, Q, xphi, &xM);
+        fem1d_zm_sparse_GMM(p, Q, zphi, &zM);
+        matlib_index dim = xM.lenc;
+        matlib_index nnz = xM.rowIn[dim];
+
+        matlib_xm xU, xV1, xV2;
+        matlib_zm zU, zV1, zV2, zV3;
+        matlib_create_xm( dim, nrhs, &xU,  MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_xm( dim, nrhs, &xV1, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_xm( dim, nrhs, &xV2, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_zm( dim, nrhs, &zU,  MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_zm( dim, nrhs, &zV1, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_zm( dim, nrhs, &zV2, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+        matlib_create_zm( dim, nrhs, &zV3, MATLIB_COL_MAJOR, MATLIB_NO_TRANS);
+        for(i=0; i<dim*nrhs; i++)
+        {
+            xU.elem_p[i] = sin(0.1*i);
+            zU.elem_p[i] = cos(0.1*i) + I*sin(0.3*i);
+        }
+
+        /* serial product of each vector */ 
+        for(k=0; k<nrhs; k++)
+        {
+            matlib_xv xu = { .len = dim, .elem_p = xU.elem_p+k*dim};
+            matlib_xv xv = { .len = dim, .elem_p = xV1.elem_p+k*dim};
+            matlib_zv zu = { .len = dim, .elem_p = zU.elem_p+k*dim};
+            matlib_zv zv = { .len = dim, .elem_p = zV1.elem_p+k*dim};
+            matlib_xcsrsymv(MATLIB_UPPER, xM, xu, xv);
+            matlib_zcsrsymv(MATLIB_UPPER, zM, zu, zv);
+        }
+
+        /* direct sum over the stored entries */ 
+        matlib_real xe = 0, ze = 0;
+        for(k=0; k<nrhs; k++)
+        {
+            matlib_real*    xu = xU.elem_p+k*dim;
+            matlib_complex* zu = zU.elem_p+k*dim;
+            matlib_real     xv[dim];
+            matlib_complex  zv[dim];
+            for(i=0; i<dim; i++)
+            {
+                xv[i] = 0;
+                zv[i] = 0;
+            }
+            for(i=0; i<dim; i++)
+            {
+                for(s=xM.rowIn[i]; s<xM.rowIn[i+1]; s++)
+                {
+                    matlib_index c = xM.colIn[s];
+                    xv[i] += xM.elem_p[s]*xu[c];
+                    zv[i] += zM.elem_p[s]*zu[c];
+                    if(c!=i)
+                    {
+                        xv[c] += xM.elem_p[s]*xu[i];
+                        zv[c] += zM.elem_p[s]*zu[i];
+                    }
+                }
+            }
+            for(i=0; i<dim; i++)
+            {
+                xe = fmax(xe, fabs(xv[i]-xV1.elem_p[k*dim+i]));
+                ze = fmax(ze, cabs(zv[i]-zV1.elem_p[k*dim+i]));
+            }
+        }
+        CU_ASSERT_TRUE((xe<TOL) && (ze<TOL));
+
+        /* several vectors over the threads; the plans are reused, the
+         * buffers of the first product must not leak into the second */ 
+        pfem1d_csrsym_plan_t xplan, zplan;
+        pfem1d_xcsrsym_plan(xM, nrhs, num_threads, &xplan);
+        pfem1d_zcsrsym_plan(zM, nrhs, num_threads, &zplan);
+        pfem1d_xcsrsymm_exec(&xplan, MATLIB_UPPER, xM, xV1, xV2, mp);
+        pfem1d_zcsrsymm_exec(&zplan, MATLIB_UPPER, zM, zV1, zV2, mp);
+        pfem1d_xcsrsymm_exec(&xplan, MATLIB_UPPER, xM, xU, xV2, mp);
+        pfem1d_zcsrsymm_exec(&zplan, MATLIB_UPPER, zM, zU, zV2, mp);
+        pfem1d_csrsym_plan_free(&xplan);
+        pfem1d_csrsym_plan_free(&zplan);
+        CU_ASSERT_TRUE((xplan.xw==NULL) && (zplan.zw==NULL) && (zplan.range==NULL));
+
+        /* lower triangle, the transpose of the upper one */ 
+        matlib_zm_sparse zL = { .lenc = dim, .lenr = dim};
+        zL.rowIn  = calloc(dim+1, sizeof(matlib_index));
+        zL.colIn  = calloc(nnz, sizeof(matlib_index));
+        zL.elem_p = calloc(nnz, sizeof(matlib_complex));
+        for(s=0; s<nnz; s++)
+        {
+            zL.rowIn[zM.colIn[s]+1]++;
+        }
+        for(i=0; i<dim; i++)
+        {
+            zL.rowIn[i+1] += zL.rowIn[i];
+        }
+        matlib_index pos[dim];
+        for(i=0; i<dim; i++)
+        {
+            pos[i] = zL.rowIn[i];
+        }
+        for(i=0; i<dim; i++)
+        {
+            for(s=zM.rowIn[i]; s<zM.rowIn[i+1]; s++)
+            {
+                matlib_index c = zM.colIn[s];
+                zL.colIn[pos[c]]  = i;
+                zL.elem_p[pos[c]] = zM.elem_p[s];
+                pos[c]++;
+            }
+        }
+        pfem1d_zcsrsymm(MATLIB_LOWER, zL, zU, zV3, num_threads, mp);
+
+        xe = 0, ze = 0;
+        matlib_real le = 0;
+        for(i=0; i<dim*nrhs; i++)
+        {
+            xe = fmax(xe, fabs(xV1.elem_p[i]-xV2.elem_p[i]));
+            ze = fmax(ze, cabs(zV1.elem_p[i]-zV2.elem_p[i]));
+            le = fmax(le, cabs(zV1.elem_p[i]-zV3.elem_p[i]));
+        }
+        debug_body("N: %d, Max. difference: %0.16g, %0.16g, %0.16g", N, xe, ze, le);
+        CU_ASSERT_TRUE((xe<TOL) && (ze<TOL) && (le<TOL));
+
+        /* full storage: the entries of the other triangle are ignored */ 
+        matlib_zm_sparse zF = { .lenc = dim, .lenr = dim};
+        zF.rowIn  = calloc(dim+1, sizeof(matlib_index));
+        zF.colIn  = calloc(2*nnz-dim, sizeof(matlib_index));
+        zF.elem_p = calloc(2*nnz-dim, sizeof(matlib_complex));
+        for(i=0, k=0; i<dim; i++)
+        {
+            for(s=zL.rowIn[i]; zL.colIn[s]<i; s++, k++)
+            {
+                zF.colIn[k]  = zL.colIn[s];
+                zF.elem_p[k] = zL.elem_p[s];
+            }
+            for(s=zM.rowIn[i]; s<zM.rowIn[i+1]; s++, k++)
+            {
+                zF.colIn[k]  = zM.colIn[s];
+                zF.elem_p[k] = zM.elem_p[s];
+            }
+            zF.rowIn[i+1] = k;
+        }
+        pfem1d_zcsrsymm(MATLIB_UPPER, zF, zU, zV2, num_threads, mp);
+        pfem1d_zcsrsymm(MATLIB_LOWER, zF, zU, zV3, num_threads, mp);
+        matlib_zv zu = { .len = dim, .elem_p = zU.elem_p};
+        matlib_zv zv = { .len = dim, .elem_p = zV1.elem_p};
+        matlib_zcsrsymv(MATLIB_LOWER, zF, zu, zv);
+
+        ze = 0, le = 0;
+        for(i=0; i<dim*nrhs; i++)
+        {
+            ze = fmax(ze, cabs(zV1.elem_p[i]-zV2.elem_p[i]));
+            le = fmax(le, cabs(zV1.elem_p[i]-zV3.elem_p[i]));
+        }
+        debug_body("N: %d, Max. difference: %0.16g, %0.16g", N, ze, le);
+        CU_ASSERT_TRUE((k==2*nnz-dim) && (ze<TOL) && (le<TOL));
+
+        matlib_free(zF.rowIn);
+        matlib_free(zF.colIn);
+        matlib_free(zF.elem_p);
+        matlib_free(zL.rowIn);
+        matlib_free(zL.colIn);
+        matlib_free(zL.elem_p);
+        matlib_free(xM.rowIn);
+        matlib_free(xM.colIn);
+        matlib_free(xM.elem_p);
+        matlib_free(zM.rowIn);
+        matlib_free(zM.colIn);
+        matlib_free(zM.elem_p);
+        matlib_free(xU.elem_p);
+        matlib_free(xV1.elem_p);
+        matlib_free(xV2.elem_p);
+        matlib_free(zU.elem_p);
+        matlib_free(zV1.elem_p);
+        matlib_free(zV2.elem_p);
+        matlib_free(zV3.elem_p);
+        matlib_free(x.elem_p);
+        matlib_free(xphi.elem_p);
+        matlib_free(zphi.elem_p);
+    }
+
+    matlib_free(xi.elem_p);
+    matlib_free(quadW.elem_p);
+    matlib_free(IM.elem_p);
+    matlib_free(Q.elem_p);
+    pthpool_destroy_threads(num_threads, mp);
+    debug_exit("%s", "");
+}
+
+void test_pfem1d_csrsymv(void)
+{
+    matlib_index p_max = 12;
+    for (matlib_index p=2; p<p_max; p++)
+    {
+        test_pfem1d_csrsymv_general(p);
+    }
+}
 /*============================================================================+/
  | Test runner
  |
@@ -1665,8 +2643,17 @@ int main(void)
         { "Parallel ZILT"           , test_pfem1d_ZILT    },
         { "Parallel ZF2L"           , test_pfem1d_ZF2L    },
         { "Parallel projection ZL2F", test_pfem1d_ZPrjL2F },
+        { "Persistent region phases", test_pfem1d_region  },
+        { "Partitioned vectors"     , test_pfem1d_partitioned },
+        { "Asynchronous calls"      , test_pfem1d_async   },
+        { "Parallel batched ZL2F2"  , test_pfem1d_ZL2F2   },
         { "Parallel Z-L2 norm"      , test_pfem1d_ZNorm2  },
+        { "Reproducible Z-L2 norm"  , test_pfem1d_ZNorm2_reproducible },
+        { "Parallel point evaluation", test_pfem1d_ZEval  },
         { "Parallel Complex GMM"    , test_pfem1d_ZGMM    },
+        { "Parallel single GMM"     , test_pfem1d_sparse_GMM },
+        { "Parallel matrix-free GSMV", test_pfem1d_GSMV   },
+        { "Parallel symmetric SpMV" , test_pfem1d_csrsymv },
         CU_TEST_INFO_NULL,
     };
 
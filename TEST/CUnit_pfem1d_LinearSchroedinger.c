@@ -27,6 +27,7 @@
 #include "legendre.h"
 #include "fem1d.h"
 #include "pfem1d.h"
+#include "pde1d_solver.h"
 #include "assert.h"
 
 /* CUnit modules */
@@ -48,24 +49,6 @@ int clean_suite(void)
 
 /*============================================================================*/
 
-void fem1d_linespace
-(
-    matlib_real  t0, 
-    matlib_real  dt, 
-    matlib_index Nt, 
-    matlib_xv    *t
-)
-{
-    matlib_create_xv( Nt+1, t, MATLIB_COL_VECT);
-
-    t->elem_p[0] = t0;
-
-    for(matlib_index i=1; i<Nt+1; i++)
-    {
-        t->elem_p[i] = t->elem_p[i-1] + dt;
-    }
-}
-
 void fem1d_zm_sparse_GSM
 /* Global Stiffness Matrix */ 
 (
@@ -173,6 +156,47 @@ void* _pfem1d_thfunc_calc_error1(void* mp)
     debug_exit("%s", "");
 }
 
+/* Serial phases of a time step, see pfem1d_solve_Schroedinger_IVP1 */ 
+void* _pfem1d_thfunc_solve_step(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    
+    pardiso_solver_t* data = (pardiso_solver_t*) (ptr->shared_data[0]);
+    matlib_index      step = *((matlib_index*)   (ptr->shared_data[1]));
+    pthpool_data_t*   pool = (pthpool_data_t*)   (ptr->shared_data[2]);
+    debug_body("begin iteration: %d", step);
+
+    data->phase_enum = PARDISO_SOLVE_AND_REFINE;
+    matlib_pardiso(data);
+
+    /* the error analysis of the last step uses V_tmp */ 
+    if(step>0)
+    {
+        pthpool_sync_threads( 1, &pool[4]);
+    }
+    return NULL;
+}
+
+void* _pfem1d_thfunc_error_step(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    
+    matlib_index*   step  = (matlib_index*)   (ptr->shared_data[0]);
+    matlib_real**   e_tmp = (matlib_real**)   (ptr->shared_data[1]);
+    matlib_real**   t_tmp = (matlib_real**)   (ptr->shared_data[2]);
+    pthpool_task_t* task  = (pthpool_task_t*) (ptr->shared_data[3]);
+    pthpool_data_t* pool  = (pthpool_data_t*) (ptr->shared_data[4]);
+
+    if(*step>0)
+    {
+        *e_tmp += 1;
+        *t_tmp += 1;
+    }
+    pthpool_exec_task_nosync(1, &pool[4], task);
+    (*step)++;
+    return NULL;
+}
+
 matlib_real pfem1d_solve_Schroedinger_IVP1
 (
     matlib_index p,
@@ -325,37 +349,42 @@ matlib_real pfem1d_solve_Schroedinger_IVP1
     t_tmp = t.elem_p+1;
     e_tmp = e_relative.elem_p;
 
-    /* Evolve the field */ 
-    debug_body("begin iteration: %d", i);
-    pfem1d_ZPrjL2F(p, U_tmp, Pvb, num_threads_, mp);
+    /* Evolve the field: one persistent region for all the time steps with
+     * the linear solve and the error analysis as serial phases */ 
+    matlib_index step = 0;
+    void* shared_solve[3] = { (void*) &data, 
+                              (void*) &step, 
+                              (void*) mp};
+    void* shared_error[5] = { (void*) &step,
+                              (void*) &e_tmp,
+                              (void*) &t_tmp,
+                              (void*) &task,
+                              (void*) mp};
 
-    data.phase_enum = PARDISO_SOLVE_AND_REFINE;
-    matlib_pardiso(&data);
+    pfem1d_phase_args_t args[3];
+    pthpool_phase_t phase[5];
+    pfem1d_ZPrjL2F_phase(p, U_tmp, Pvb, &args[0], &phase[0]);
+
+    phase[1].thfunc      = (void*) _pfem1d_thfunc_solve_step;
+    phase[1].shared_data = shared_solve;
+    phase[1].serial      = true;
     
-    pfem1d_ZF2L(p, V_vb, V_tmp, num_threads_, mp);
+    pfem1d_ZF2L_phase(p, V_vb, V_tmp, &args[1], &phase[2]);
 
     /* 2.0 * V_tmp -U_tmp --> U_tmp*/ 
-    matlib_zaxpby(2.0, V_tmp, -1.0, U_tmp );
+    pfem1d_zaxpby_phase(p, 2.0, V_tmp, -1.0, U_tmp, &args[2], &phase[3]);
 
-    pthpool_exec_task_nosync(1, &mp[4], &task);
+    phase[4].thfunc      = (void*) _pfem1d_thfunc_error_step;
+    phase[4].shared_data = shared_error;
+    phase[4].serial      = true;
 
-    for (i=1; i<Nt; i++)
+    pthpool_region_t region;
+    pthpool_region_init(N, num_threads_, &region);
+    pthpool_region_exec(&region, 5, phase, Nt, mp);
+    pthpool_region_destroy(&region);
+    for(i=0; i<3; i++)
     {
-        debug_body("begin iteration: %d", i);
-        pfem1d_ZPrjL2F(p, U_tmp, Pvb, num_threads_, mp);
-
-        data.phase_enum = PARDISO_SOLVE_AND_REFINE;
-        matlib_pardiso(&data);
-        
-        pthpool_sync_threads( 1, &mp[4]);
-        pfem1d_ZF2L(p, V_vb, V_tmp, num_threads_, mp);
-
-        /* 2.0 * V_tmp -U_tmp --> U_tmp*/ 
-        matlib_zaxpby(2.0, V_tmp, -1.0, U_tmp );
-
-        e_tmp += 1;
-        t_tmp += 1;
-        pthpool_exec_task_nosync(1, &mp[4], &task);
+        pfem1d_phase_free(&args[i]);
     }
     pthpool_sync_threads( 1, &mp[4]);
     
@@ -629,7 +658,7 @@ void* _pfem1d_thfunc_calc_error(void* mp)
     debug_body("Relative error: % 0.16g", e_relative->elem_p[0]);
     debug_exit("%s", "");
 }
-inline void pfem1d_thfunc_evolve_field(void* shared_data[25])
+static inline void pfem1d_thfunc_evolve_field(void* shared_data[25])
 {
 
     debug_enter("%s", "");
@@ -1515,7 +1544,7 @@ void* _pfem1d_thfunc_calc_error4(void* mp)
 }
 
 
-inline void pfem1d_thfunc_evolve_field4(void* shared_data[25])
+static inline void pfem1d_thfunc_evolve_field4(void* shared_data[25])
 {
 
     debug_enter("%s", "");
@@ -149,6 +149,1042 @@ void test_pfunc(void)
     pthpool_destroy_threads(num_threads, mp);
 
 }
+/*============================================================================*/
+/* Work stealing: all tasks are queued on thread 0 and take some time, the
+ * idle threads have to steal them.
+ * */ 
+void thfunc_sleep(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    pthread_t* owner   = (pthread_t*) (ptr->nonshared_data);
+
+    usleep(1000);
+    *owner = pthread_self();
+}
+
+void test_pthpool_steal(void)
+{
+    matlib_index i, j, num_threads = 4;
+    matlib_index num_tasks = 32;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    pthread_t      owner[num_tasks];
+    pthpool_arg_t  arg[num_tasks];
+    pthpool_task_t task[num_tasks];
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    for(i=0; i<num_tasks; i++)
+    {
+        arg[i].shared_data    = NULL;
+        arg[i].nonshared_data = (void**)&owner[i];
+        arg[i].thread_index   = i;
+        task[i].function      = thfunc_sleep;
+        task[i].argument      = &arg[i];
+        pthpool_submit_to(0, mp, &task[i], &handle);
+    }
+    pthpool_wait(mp, &handle);
+    CU_ASSERT_TRUE(handle.pending==0);
+    pthpool_handle_destroy(&handle);
+
+    /* count distinct threads which executed the tasks */ 
+    matlib_index nr_owners = 0;
+    for(i=0; i<num_tasks; i++)
+    {
+        for(j=0; (j<i) && !pthread_equal(owner[i], owner[j]); j++);
+        nr_owners += (j==i);
+    }
+    debug_body("tasks executed by %d threads", nr_owners);
+    CU_ASSERT_TRUE(nr_owners>1);
+
+    pthpool_destroy_threads(num_threads, mp);
+}
+
+/*============================================================================*/
+/* Nested submission: each task splits its range, submits one half and
+ * waits for it while the pool keeps running other tasks.
+ * */ 
+typedef struct
+{
+    matlib_index    start;
+    matlib_index    end;
+    matlib_index    sum;
+    matlib_index    num_threads;
+    pthpool_data_t* mp;
+
+} test_range_t;
+
+void thfunc_range_sum(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    test_range_t* r    = (test_range_t*) (ptr->nonshared_data);
+    matlib_index i;
+
+    if(r->end-r->start <= 64)
+    {
+        r->sum = 0;
+        for(i=r->start; i<r->end; i++)
+        {
+            r->sum += i;
+        }
+        return;
+    }
+    matlib_index mid = (r->start+r->end)/2;
+    test_range_t left  = { r->start, mid, 0, r->num_threads, r->mp};
+    test_range_t right = { mid, r->end,   0, r->num_threads, r->mp};
+
+    pthpool_arg_t  arg[2] = { {NULL, (void**)&left, 0}, {NULL, (void**)&right, 1} };
+    pthpool_task_t task   = { thfunc_range_sum, &arg[0]};
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    pthpool_submit(r->num_threads, r->mp, &task, &handle);
+    thfunc_range_sum(&arg[1]);
+    pthpool_wait(r->mp, &handle);
+    pthpool_handle_destroy(&handle);
+
+    r->sum = left.sum + right.sum;
+}
+
+void test_pthpool_nested(void)
+{
+    matlib_index num_threads = 4;
+    matlib_index n = 100000;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    test_range_t   r    = { 0, n, 0, num_threads, mp};
+    pthpool_arg_t  arg  = { NULL, (void**)&r, 0};
+    pthpool_task_t task = { thfunc_range_sum, &arg};
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    pthpool_submit(num_threads, mp, &task, &handle);
+    pthpool_wait(mp, &handle);
+    pthpool_handle_destroy(&handle);
+
+    CU_ASSERT_TRUE(r.sum==n*(n-1)/2);
+
+    pthpool_destroy_threads(num_threads, mp);
+}
+/*============================================================================*/
+/* SPIN dispatch: the same work as above with spinning/parking threads */ 
+void test_pthpool_spin(void)
+{
+    matlib_index i, num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+    pthpool_set_dispatch(num_threads, mp, PTHPOOL_DISPATCH_SPIN);
+
+    matlib_index n = 10000;
+    matlib_xv x;
+    matlib_zv u_serial, u_parallel;
+    matlib_create_xv( n, &x, MATLIB_COL_VECT);
+    matlib_create_zv( n, &u_serial, MATLIB_COL_VECT);
+    matlib_create_zv( n, &u_parallel, MATLIB_COL_VECT);
+    for(i=0; i<n; i++)
+    {
+        x.elem_p[i] = -5.0+10.0*i/(n-1);
+    }
+    serial_Gaussian(x, u_serial);
+
+    matlib_index Np[2] = {n/num_threads, n};
+    void* shared_data[2] = { (void*) &x, (void*) &u_parallel};
+
+    /* repeated dispatches with pauses long enough for the threads to park */ 
+    for(i=0; i<3; i++)
+    {
+        pthpool_func( Np, shared_data, thfunc_Gaussian, num_threads, mp);
+        usleep(20000);
+    }
+    matlib_zaxpy(-1.0, u_serial, u_parallel);
+    CU_ASSERT_TRUE(matlib_znrm2(u_parallel)/matlib_znrm2(u_serial)<TOL);
+
+    test_range_t   r    = { 0, n, 0, num_threads, mp};
+    pthpool_arg_t  arg  = { NULL, (void**)&r, 0};
+    pthpool_task_t task = { thfunc_range_sum, &arg};
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+    pthpool_submit(num_threads, mp, &task, &handle);
+    pthpool_wait(mp, &handle);
+    pthpool_handle_destroy(&handle);
+    CU_ASSERT_TRUE(r.sum==n*(n-1)/2);
+
+    /* back to condition variables */ 
+    pthpool_set_dispatch(num_threads, mp, PTHPOOL_DISPATCH_MUTEX);
+    pthpool_func( Np, shared_data, thfunc_Gaussian, num_threads, mp);
+
+    matlib_free(x.elem_p);
+    matlib_free(u_serial.elem_p);
+    matlib_free(u_parallel.elem_p);
+    pthpool_destroy_threads(num_threads, mp);
+}
+
+/*============================================================================*/
+/* Handle re-arming: the second task of each round is submitted while the
+ * first one may be completing, the wait must still cover both.
+ * */ 
+void thfunc_increment(void* mp)
+{
+    pthpool_arg_t *ptr  = (pthpool_arg_t*) mp;
+    matlib_index* count = (matlib_index*) (ptr->nonshared_data);
+
+    __atomic_add_fetch(count, 1, __ATOMIC_RELAXED);
+}
+
+void test_pthpool_rearm(void)
+{
+    matlib_index i, d, num_threads = 4;
+    matlib_index nr_rounds = 20000, nr_errors;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    PTHPOOL_DISPATCH dispatch[2] = { PTHPOOL_DISPATCH_SPIN, PTHPOOL_DISPATCH_MUTEX};
+    matlib_index count;
+    pthpool_arg_t  arg  = { NULL, (void**)&count, 0};
+    pthpool_task_t task = { thfunc_increment, &arg};
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    for(d=0; d<2; d++)
+    {
+        pthpool_set_dispatch(num_threads, mp, dispatch[d]);
+        count     = 0;
+        nr_errors = 0;
+        for(i=1; i<=nr_rounds; i++)
+        {
+            pthpool_submit_to(i%num_threads, mp, &task, &handle);
+            pthpool_submit_to((i+1)%num_threads, mp, &task, &handle);
+            pthpool_wait(mp, &handle);
+            nr_errors += (__atomic_load_n(&count, __ATOMIC_RELAXED)!=2*i);
+        }
+        debug_body("dispatch: %d, early returns: %d", dispatch[d], nr_errors);
+        CU_ASSERT_TRUE(nr_errors==0);
+        CU_ASSERT_TRUE(handle.pending==0);
+    }
+    pthpool_handle_destroy(&handle);
+    pthpool_destroy_threads(num_threads, mp);
+}
+
+/*============================================================================*/
+/* Barrier: every round each task writes its slot, after the barrier all
+ * slots must show the same round.
+ * */ 
+typedef struct
+{
+    matlib_index*      slot;
+    matlib_index       nr_rounds;
+    pthpool_barrier_t* barrier;
+    matlib_index       nr_errors;
+
+} test_barrier_t;
+
+void thfunc_barrier(void* mp)
+{
+    pthpool_arg_t *ptr  = (pthpool_arg_t*) mp;
+    test_barrier_t* b   = (test_barrier_t*) (ptr->shared_data[0]);
+    matlib_index* error = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i, k, nr_threads = b->barrier->nr_threads;
+
+    *error = 0;
+    for(k=1; k<=b->nr_rounds; k++)
+    {
+        __atomic_store_n(&(b->slot[ptr->thread_index]), k, __ATOMIC_RELAXED);
+        pthpool_barrier_wait(b->barrier);
+        for(i=0; i<nr_threads; i++)
+        {
+            *error += (__atomic_load_n(&(b->slot[i]), __ATOMIC_RELAXED)!=k);
+        }
+        pthpool_barrier_wait(b->barrier);
+    }
+}
+
+void test_pthpool_barrier(void)
+{
+    matlib_index i, num_threads = 4;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_index slot[num_threads], error[num_threads];
+    pthpool_barrier_t barrier;
+    test_barrier_t b = { slot, 2000, &barrier, 0};
+    void* shared_data[1] = { (void*) &b};
+
+    pthpool_arg_t  arg[num_threads];
+    pthpool_task_t task[num_threads];
+    for(i=0; i<num_threads; i++)
+    {
+        arg[i].shared_data    = shared_data;
+        arg[i].nonshared_data = (void**)&error[i];
+        arg[i].thread_index   = i;
+        task[i].function      = thfunc_barrier;
+        task[i].argument      = &arg[i];
+    }
+
+    PTHPOOL_DISPATCH modes[2] = {PTHPOOL_DISPATCH_MUTEX, PTHPOOL_DISPATCH_SPIN};
+    for(matlib_index m=0; m<2; m++)
+    {
+        pthpool_set_dispatch(num_threads, mp, modes[m]);
+        pthpool_barrier_init(&barrier, num_threads);
+        pthpool_exec_task(num_threads, mp, task);
+        for(i=0; i<num_threads; i++)
+        {
+            CU_ASSERT_TRUE(error[i]==0);
+        }
+    }
+    pthpool_destroy_threads(num_threads, mp);
+}
+/*============================================================================*/
+/* Placement: the CPUs must come from the affinity mask, COMPACT and CORE
+ * must not share CPUs or cores as long as there are enough of them.
+ * */ 
+void test_pthpool_topology(void)
+{
+    matlib_index i, j;
+    pthpool_topology_t topo;
+    pthpool_get_topology(&topo);
+
+    cpu_set_t cpuset;
+    sched_getaffinity(0, sizeof(cpu_set_t), &cpuset);
+    CU_ASSERT_TRUE(topo.nr_cpu==(matlib_index)CPU_COUNT(&cpuset));
+    CU_ASSERT_TRUE((topo.nr_core>0) && (topo.nr_core<=topo.nr_cpu));
+    CU_ASSERT_TRUE((topo.nr_node>0) && (topo.nr_package>0));
+
+    matlib_index num_threads = 2*topo.nr_cpu;
+    int cpu_id[num_threads];
+    PTHPOOL_PLACE place[3] = { PTHPOOL_PLACE_COMPACT, 
+                               PTHPOOL_PLACE_SCATTER, 
+                               PTHPOOL_PLACE_CORE};
+    for(matlib_index m=0; m<3; m++)
+    {
+        pthpool_place_threads(num_threads, place[m], &topo, cpu_id);
+        for(i=0; i<num_threads; i++)
+        {
+            CU_ASSERT_TRUE(CPU_ISSET(cpu_id[i], &cpuset));
+        }
+        /* every CPU is used once before any is used twice */ 
+        for(i=0; i<topo.nr_cpu; i++)
+        {
+            for(j=0; j<i; j++)
+            {
+                CU_ASSERT_TRUE(cpu_id[i]!=cpu_id[j]);
+            }
+        }
+    }
+
+    /* CORE: distinct physical cores for the first nr_core threads */ 
+    pthpool_place_threads(topo.nr_core, PTHPOOL_PLACE_CORE, &topo, cpu_id);
+    int core_of[topo.nr_core];
+    for(i=0; i<topo.nr_core; i++)
+    {
+        for(j=0; topo.cpu[j]!=cpu_id[i]; j++);
+        core_of[i] = topo.core[j];
+        for(j=0; j<i; j++)
+        {
+            CU_ASSERT_TRUE(core_of[i]!=core_of[j]);
+        }
+    }
+
+    pthpool_place_threads(num_threads, PTHPOOL_PLACE_NONE, &topo, cpu_id);
+    CU_ASSERT_TRUE(cpu_id[0]==-1);
+
+    pthpool_free_topology(&topo);
+}
+
+/*============================================================================*/
+/* Pinned tasks run on their thread only; first touch zeroes the vector */ 
+void test_pthpool_pinned(void)
+{
+    matlib_index i, num_threads = 4;
+    matlib_index num_tasks = 16;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads_placed(num_threads, mp, PTHPOOL_PLACE_COMPACT);
+
+    pthread_t      owner[num_tasks];
+    pthpool_arg_t  arg[num_tasks];
+    pthpool_task_t task[num_tasks];
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    for(i=0; i<num_tasks; i++)
+    {
+        arg[i].shared_data    = NULL;
+        arg[i].nonshared_data = (void**)&owner[i];
+        arg[i].thread_index   = i;
+        task[i].function      = thfunc_sleep;
+        task[i].argument      = &arg[i];
+        pthpool_submit_pinned(i%2, mp, &task[i], &handle);
+    }
+    pthpool_wait(mp, &handle);
+    pthpool_handle_destroy(&handle);
+    for(i=0; i<num_tasks; i++)
+    {
+        CU_ASSERT_TRUE(pthread_equal(owner[i], mp[i%2].thread));
+    }
+
+    matlib_index N = 1000, block = 5;
+    matlib_index Np[2] = {N/num_threads, N};
+    matlib_zv u;
+    matlib_create_zv(N*block, &u, MATLIB_COL_VECT);
+    for(i=0; i<u.len; i++)
+    {
+        u.elem_p[i] = 1.0;
+    }
+    pthpool_first_touch(Np, block*sizeof(matlib_complex), u.elem_p, num_threads, mp);
+    matlib_index nr_nonzero = 0;
+    for(i=0; i<u.len; i++)
+    {
+        nr_nonzero += (u.elem_p[i]!=0);
+    }
+    CU_ASSERT_TRUE(nr_nonzero==0);
+    matlib_free(u.elem_p);
+
+    pthpool_destroy_threads(num_threads, mp);
+}
+/*============================================================================*/
+/* Partitions: the split is the one of the regions, touching zeroes the
+ * blocks and the tail, and every range runs on its owner */ 
+void* thfunc_owned(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    pthread_t*    owner = (pthread_t*) (ptr->shared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i;
+
+    for(i=start_end_index[0]; i<start_end_index[1]; i++)
+    {
+        owner[i] = pthread_self();
+    }
+    return NULL;
+}
+
+void test_pthpool_partition(void)
+{
+    matlib_index i, j, num_threads = 4;
+    matlib_index N = 1001, block = 3, tail = 5;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_index start[num_threads+1];
+    pthpool_partition_t part = { .start = start };
+    pthpool_partition_split(N, num_threads, &part);
+
+    pthpool_region_t region;
+    pthpool_region_init(N, num_threads, &region);
+    bool same = (part.N==N) && (part.num_threads==num_threads);
+    for(i=0; i<=num_threads; i++)
+    {
+        same = same && (part.start[i]==region.partition[i]);
+    }
+    CU_ASSERT_TRUE(same);
+    pthpool_region_destroy(&region);
+
+    matlib_index len = N*block+tail;
+    matlib_real* v = malloc(len*sizeof(matlib_real));
+    for(i=0; i<len; i++)
+    {
+        v[i] = 1.0;
+    }
+    pthpool_partition_touch( &part, block*sizeof(matlib_real), 
+                             len*sizeof(matlib_real), v, mp);
+    matlib_index nr_nonzero = 0;
+    for(i=0; i<len; i++)
+    {
+        nr_nonzero += (v[i]!=0);
+    }
+    CU_ASSERT_TRUE(nr_nonzero==0);
+    matlib_free(v);
+
+    pthread_t owner[N];
+    void* shared_owner[1] = { (void*)owner };
+    pthpool_for_partition(&part, shared_owner, thfunc_owned, mp);
+    bool owned = true;
+    for(i=0; i<num_threads; i++)
+    {
+        for(j=part.start[i]; j<part.start[i+1]; j++)
+        {
+            owned = owned && pthread_equal(owner[j], mp[i].thread);
+        }
+    }
+    CU_ASSERT_TRUE(owned);
+
+    /* fewer elements than threads: empty ranges are skipped */ 
+    pthpool_partition_split(2, num_threads, &part);
+    pthpool_for_partition(&part, shared_owner, thfunc_owned, mp);
+    CU_ASSERT_TRUE(pthread_equal(owner[1], mp[3].thread));
+
+    pthpool_destroy_threads(num_threads, mp);
+}
+/*============================================================================*/
+/* Parallel loops: every iteration is visited once under each schedule and the
+ * reductions do not depend on the schedule or the number of threads */ 
+void* thfunc_visit(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_index* hits = (matlib_index*) (ptr->shared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i;
+
+    for(i=start_end_index[0]; i<start_end_index[1]; i++)
+    {
+        hits[i]++;
+    }
+    return NULL;
+}
+
+matlib_real thfunc_xsum(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_real*  x    = (matlib_real*) (ptr->shared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i;
+    matlib_real s = 0;
+
+    for(i=start_end_index[0]; i<start_end_index[1]; i++)
+    {
+        s += x[i];
+    }
+    return s;
+}
+
+matlib_real thfunc_xmax(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_real*  x    = (matlib_real*) (ptr->shared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i;
+    matlib_real m = x[start_end_index[0]];
+
+    for(i=start_end_index[0]+1; i<start_end_index[1]; i++)
+    {
+        m = (x[i]>m)? x[i]: m;
+    }
+    return m;
+}
+
+matlib_complex thfunc_zsum(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i;
+    matlib_complex s = 0;
+
+    for(i=start_end_index[0]; i<start_end_index[1]; i++)
+    {
+        s += i + 2.0*I*i;
+    }
+    return s;
+}
+
+void test_pthpool_for(void)
+{
+    matlib_index i, j, k, num_threads = 4;
+    matlib_index n = 10007, start = 3;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    PTHPOOL_SCHED sched[3] = { PTHPOOL_SCHED_STATIC, 
+                               PTHPOOL_SCHED_DYNAMIC, 
+                               PTHPOOL_SCHED_GUIDED };
+    matlib_index grain[3] = { 0, 1, 61 };
+
+    matlib_index hits[n];
+    void* shared_hits[1] = { (void*)hits };
+    bool visited_once = true;
+    for(j=0; j<3; j++)
+    {
+        for(k=0; k<3; k++)
+        {
+            memset(hits, 0, sizeof(hits));
+            pthpool_for( start, n, sched[j], grain[k], shared_hits, 
+                         thfunc_visit, num_threads, mp);
+            for(i=0; i<n; i++)
+            {
+                visited_once = visited_once && (hits[i]==(i>=start));
+            }
+        }
+    }
+    CU_ASSERT_TRUE(visited_once);
+
+    /* fewer iterations than threads and an empty range */ 
+    memset(hits, 0, sizeof(hits));
+    pthpool_for(0, 2, PTHPOOL_SCHED_STATIC, 0, shared_hits, thfunc_visit, num_threads, mp);
+    pthpool_for(5, 5, PTHPOOL_SCHED_DYNAMIC, 0, shared_hits, thfunc_visit, num_threads, mp);
+    CU_ASSERT_TRUE((hits[0]==1) && (hits[1]==1) && (hits[2]==0) && (hits[5]==0));
+
+    matlib_real x[n], xmax = -1;
+    for(i=0; i<n; i++)
+    {
+        x[i] = sin(0.1*i)/(i+1.0);
+        xmax = (x[i]>xmax)? x[i]: xmax;
+    }
+    void* shared_x[1] = { (void*)x };
+
+    matlib_real sum0 = pthpool_for_xreduce( 0, n, PTHPOOL_SCHED_STATIC, 0, 
+                                            PTHPOOL_REDUCE_SUM, shared_x, 
+                                            thfunc_xsum, 1, mp);
+    bool same_sum = true, same_max = true;
+    for(j=0; j<3; j++)
+    {
+        for(k=1; k<=num_threads; k++)
+        {
+            matlib_real sum = pthpool_for_xreduce( 0, n, sched[j], 0, 
+                                                   PTHPOOL_REDUCE_SUM, shared_x, 
+                                                   thfunc_xsum, k, mp);
+            matlib_real max = pthpool_for_xreduce( 0, n, sched[j], 13, 
+                                                   PTHPOOL_REDUCE_MAX, shared_x, 
+                                                   thfunc_xmax, k, mp);
+            same_sum = same_sum && (sum==sum0);
+            same_max = same_max && (max==xmax);
+        }
+    }
+    CU_ASSERT_TRUE(same_sum);
+    CU_ASSERT_TRUE(same_max);
+    CU_ASSERT_TRUE(fabs(sum0-matlib_xsum_pairwise(n, x))<TOL);
+
+    matlib_complex zsum = pthpool_for_zreduce( 0, n, PTHPOOL_SCHED_GUIDED, 0, 
+                                               NULL, thfunc_zsum, num_threads, mp);
+    matlib_real expected = 0.5*n*(n-1);
+    CU_ASSERT_TRUE((creal(zsum)==expected) && (cimag(zsum)==2*expected));
+
+    CU_ASSERT_TRUE(pthpool_for_xreduce( 7, 7, PTHPOOL_SCHED_STATIC, 0, 
+                                        PTHPOOL_REDUCE_SUM, shared_x, 
+                                        thfunc_xsum, num_threads, mp)==0);
+
+    pthpool_destroy_threads(num_threads, mp);
+}
+/*============================================================================*/
+/* Persistent region: phases read across the partition, hence the barriers must
+ * order them; the serial phase runs once per repetition */ 
+void* thfunc_stencil(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_real*  a = (matlib_real*)  (ptr->shared_data[0]);
+    matlib_real*  b = (matlib_real*)  (ptr->shared_data[1]);
+    matlib_index  n = *((matlib_index*) (ptr->shared_data[2]));
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i;
+
+    for(i=start_end_index[0]; i<start_end_index[1]; i++)
+    {
+        a[i] = 0.5*(b[(i+n-1)%n] + b[(i+1)%n]);
+    }
+    return NULL;
+}
+
+void* thfunc_step(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_index* nr_steps = (matlib_index*) (ptr->shared_data[0]);
+    pthread_t*    owner    = (pthread_t*)    (ptr->shared_data[1]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+
+    (*nr_steps)++;
+    owner[0] = pthread_self();
+    CU_ASSERT_TRUE(start_end_index[0]==0);
+    return NULL;
+}
+
+void* thfunc_owner(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    pthread_t*    owner = (pthread_t*) (ptr->shared_data[0]);
+
+    owner[ptr->thread_index] = pthread_self();
+    return NULL;
+}
+
+void test_pthpool_region(void)
+{
+    matlib_index i, r, num_threads = 4;
+    matlib_index n = 1001, nr_repeat = 50;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_real a[n], b[n], a0[n], b0[n];
+    for(i=0; i<n; i++)
+    {
+        b[i]  = sin(0.1*i);
+        b0[i] = b[i];
+    }
+    for(r=0; r<nr_repeat; r++)
+    {
+        for(i=0; i<n; i++)
+        {
+            a0[i] = 0.5*(b0[(i+n-1)%n] + b0[(i+1)%n]);
+        }
+        for(i=0; i<n; i++)
+        {
+            b0[i] = 0.5*(a0[(i+n-1)%n] + a0[(i+1)%n]);
+        }
+    }
+
+    matlib_index nr_steps = 0;
+    pthread_t owner[num_threads+1];
+    void* shared_ab[3]    = { (void*)a, (void*)b, (void*)&n };
+    void* shared_ba[3]    = { (void*)b, (void*)a, (void*)&n };
+    void* shared_step[2]  = { (void*)&nr_steps, (void*)&owner[num_threads] };
+    void* shared_owner[1] = { (void*)owner };
+
+    pthpool_phase_t phase[4] = 
+    {
+        { .thfunc = thfunc_stencil, .shared_data = shared_ab,    .serial = false },
+        { .thfunc = thfunc_stencil, .shared_data = shared_ba,    .serial = false },
+        { .thfunc = thfunc_step,    .shared_data = shared_step,  .serial = true  },
+        { .thfunc = thfunc_owner,   .shared_data = shared_owner, .serial = false },
+    };
+
+    pthpool_region_t region;
+    pthpool_region_init(n, num_threads, &region);
+    CU_ASSERT_TRUE((region.partition[0]==0) && (region.partition[num_threads]==n));
+
+    pthpool_region_exec(&region, 4, phase, nr_repeat, mp);
+
+    bool same = true;
+    for(i=0; i<n; i++)
+    {
+        same = same && (b[i]==b0[i]);
+    }
+    CU_ASSERT_TRUE(same);
+    CU_ASSERT_TRUE(nr_steps==nr_repeat);
+    CU_ASSERT_TRUE(pthread_equal(owner[num_threads], mp[0].thread));
+    for(i=0; i<num_threads; i++)
+    {
+        CU_ASSERT_TRUE(pthread_equal(owner[i], mp[i].thread));
+    }
+
+    pthpool_region_destroy(&region);
+    pthpool_destroy_threads(num_threads, mp);
+}
+/*============================================================================*/
+/* Task graph: blocks of different sizes read their neighbours in the upstream
+ * stage, a single node joins a stage and the next stage fans out again */ 
+void* thfunc_fill(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_real*  a = (matlib_real*) (ptr->shared_data[0]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i;
+
+    for(i=start_end_index[0]; i<start_end_index[1]; i++)
+    {
+        a[i] = i;
+    }
+    return NULL;
+}
+
+void* thfunc_sum3(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_real*  b = (matlib_real*)  (ptr->shared_data[0]);
+    matlib_real*  a = (matlib_real*)  (ptr->shared_data[1]);
+    matlib_index  n = *((matlib_index*) (ptr->shared_data[2]));
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i;
+
+    for(i=start_end_index[0]; i<start_end_index[1]; i++)
+    {
+        b[i] = (i>0? a[i-1]: 0) + a[i] + (i<n-1? a[i+1]: 0);
+    }
+    return NULL;
+}
+
+void* thfunc_join(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_real*  b     = (matlib_real*)  (ptr->shared_data[1]);
+    matlib_real*  sum   = (matlib_real*)  (ptr->shared_data[2]);
+    matlib_index* count = (matlib_index*) (ptr->shared_data[3]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i;
+
+    *sum = 0;
+    for(i=start_end_index[0]; i<start_end_index[1]; i++)
+    {
+        *sum += b[i];
+    }
+    (*count)++;
+    return NULL;
+}
+
+void* thfunc_shift(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_real*  b   = (matlib_real*) (ptr->shared_data[1]);
+    matlib_real*  sum = (matlib_real*) (ptr->shared_data[2]);
+    matlib_real*  d   = (matlib_real*) (ptr->shared_data[4]);
+    matlib_index* start_end_index = (matlib_index*) (ptr->nonshared_data);
+    matlib_index i;
+
+    for(i=start_end_index[0]; i<start_end_index[1]; i++)
+    {
+        d[i] = b[i] + *sum;
+    }
+    return NULL;
+}
+
+void test_pthpool_graph(void)
+{
+    matlib_index i, r, num_threads = 4;
+    matlib_index n = 1003, nr_repeat = 20;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_real a[n], b[n], d[n], sum, b0[n];
+    matlib_index count = 0;
+    matlib_real sum0 = 0;
+    for(i=0; i<n; i++)
+    {
+        b0[i] = (i>0? i-1.0: 0) + i + (i<n-1? i+1.0: 0);
+        sum0 += b0[i];
+    }
+
+    void* shared_a[1] = { (void*)a };
+    void* shared_b[3] = { (void*)b, (void*)a, (void*)&n };
+    void* shared[5]   = { (void*)a, (void*)b, (void*)&sum, (void*)&count, (void*)d };
+
+    pthpool_graph_t graph;
+    pthpool_graph_init(&graph);
+    matlib_index s0 = pthpool_graph_add( &graph, 0, n, 10, shared_a, thfunc_fill, 
+                                         0, NULL, 0);
+    matlib_index s1 = pthpool_graph_add( &graph, 0, n, 7, shared_b, thfunc_sum3, 
+                                         1, &s0, 1);
+    matlib_index s2 = pthpool_graph_add( &graph, 0, n, 0, shared, thfunc_join, 
+                                         1, &s1, 0);
+    pthpool_graph_add( &graph, 0, n, 64, shared, thfunc_shift, 1, &s2, 0);
+    CU_ASSERT_TRUE(graph.nr_nodes==(101+144+1+16));
+    CU_ASSERT_TRUE(graph.node[graph.stage[s1].first].nr_deps==1);
+    CU_ASSERT_TRUE(graph.node[graph.stage[s1].first+1].nr_deps==2);
+
+    bool same = true;
+    for(r=0; r<nr_repeat; r++)
+    {
+        for(i=0; i<n; i++)
+        {
+            a[i] = -1;
+            b[i] = -1;
+            d[i] = -1;
+        }
+        pthpool_graph_exec(&graph, num_threads, mp);
+        for(i=0; i<n; i++)
+        {
+            same = same && (b[i]==b0[i]) && (d[i]==b0[i]+sum0);
+        }
+    }
+    CU_ASSERT_TRUE(same);
+    CU_ASSERT_TRUE(count==nr_repeat);
+    pthpool_graph_destroy(&graph);
+
+    /* an empty graph */ 
+    pthpool_graph_init(&graph);
+    pthpool_graph_exec(&graph, num_threads, mp);
+    pthpool_graph_destroy(&graph);
+
+    pthpool_destroy_threads(num_threads, mp);
+}
+/*============================================================================*/
+/* Telemetry: every task is counted once with its duration and latency */ 
+void test_pthpool_stats(void)
+{
+    matlib_index i, k, num_threads = 4;
+    matlib_index num_tasks = 32;
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    pthread_t      owner[num_tasks];
+    pthpool_arg_t  arg[num_tasks];
+    pthpool_task_t task[num_tasks];
+    pthpool_handle_t handle;
+    pthpool_stats_t  stats[num_threads];
+
+    pthpool_stats_reset(num_threads, mp);
+    pthpool_handle_init(&handle);
+    for(i=0; i<num_tasks; i++)
+    {
+        arg[i].shared_data    = NULL;
+        arg[i].nonshared_data = (void**)&owner[i];
+        arg[i].thread_index   = i;
+        task[i].function      = thfunc_sleep;
+        task[i].argument      = &arg[i];
+        pthpool_submit(num_threads, mp, &task[i], &handle);
+    }
+    pthpool_wait(mp, &handle);
+    pthpool_handle_destroy(&handle);
+
+    pthpool_stats_snapshot(num_threads, mp, stats);
+    matlib_index nr_tasks = 0, nr_hist = 0;
+    bool consistent = true;
+    for(i=0; i<num_threads; i++)
+    {
+        nr_tasks += stats[i].nr_tasks;
+        for(k=0; k<PTHPOOL_STATS_BINS; k++)
+        {
+            nr_hist += stats[i].wake_hist[k];
+        }
+        if(stats[i].nr_tasks>0)
+        {
+            /* each task sleeps for 1 msec */ 
+            consistent =    consistent
+                         && (stats[i].task_min_ns>=1000000)
+                         && (stats[i].task_min_ns<=stats[i].task_max_ns)
+                         && (stats[i].busy_ns>=stats[i].nr_tasks*stats[i].task_min_ns);
+        }
+    }
+#ifndef PTHPOOL_NSTATS
+    CU_ASSERT_TRUE(nr_tasks==num_tasks);
+    CU_ASSERT_TRUE(nr_hist==num_tasks);
+    CU_ASSERT_TRUE(consistent);
+    CU_ASSERT_TRUE(pthpool_stats_imbalance(num_threads, stats)>=1.0);
+#endif
+
+    pthpool_stats_reset(num_threads, mp);
+    pthpool_stats_snapshot(num_threads, mp, stats);
+    nr_tasks = 0;
+    for(i=0; i<num_threads; i++)
+    {
+        nr_tasks += stats[i].nr_tasks + stats[i].busy_ns + stats[i].task_max_ns;
+    }
+    CU_ASSERT_TRUE(nr_tasks==0);
+    CU_ASSERT_TRUE(pthpool_stats_imbalance(num_threads, stats)==0);
+
+    pthpool_destroy_threads(num_threads, mp);
+}
+/*============================================================================*/
+/* Concurrent clients: several threads outside the pool submit tasks, run
+ * loops, asynchronous batches and regions on the same pool at the same time;
+ * every client checks its own results.
+ * */ 
+typedef struct
+{
+    matlib_index    num_threads;
+    pthpool_data_t* mp;
+    matlib_index    id;
+    bool            ok;
+
+} test_client_t;
+
+void thfunc_count(void* mp)
+{
+    pthpool_arg_t *ptr = (pthpool_arg_t*) mp;
+    matlib_index* count = (matlib_index*) (ptr->shared_data[0]);
+
+    __atomic_add_fetch(count, ptr->thread_index+1, __ATOMIC_RELAXED);
+}
+
+void* test_client(void* data)
+{
+    test_client_t*  c  = (test_client_t*) data;
+    pthpool_data_t* mp = c->mp;
+    matlib_index i, r, k, nr_rounds = 20;
+    matlib_index num_tasks = 300, n = 503, nr_repeat = 5;
+
+    pthpool_arg_t    arg[num_tasks];
+    pthpool_task_t   task[num_tasks];
+    pthpool_handle_t handle;
+    pthpool_handle_init(&handle);
+
+    matlib_real a[n], b[n], a0[n], b0[n];
+    void* shared_ab[3] = { (void*)a, (void*)b, (void*)&n };
+    void* shared_ba[3] = { (void*)b, (void*)a, (void*)&n };
+    pthpool_phase_t phase[2] = 
+    {
+        { .thfunc = thfunc_stencil, .shared_data = shared_ab, .serial = false },
+        { .thfunc = thfunc_stencil, .shared_data = shared_ba, .serial = false },
+    };
+    pthpool_region_t region;
+    pthpool_region_init(n, c->num_threads, &region);
+
+    c->ok = true;
+    for(r=0; r<nr_rounds; r++)
+    {
+        /* tasks through the shared queue, more than it holds */ 
+        matlib_index count = 0;
+        void* shared_count[1] = { (void*)&count };
+        for(i=0; i<num_tasks; i++)
+        {
+            arg[i].shared_data    = shared_count;
+            arg[i].nonshared_data = NULL;
+            arg[i].thread_index   = i;
+            task[i].function      = thfunc_count;
+            task[i].argument      = &arg[i];
+            pthpool_submit(c->num_threads, mp, &task[i], &handle);
+        }
+        pthpool_wait(mp, &handle);
+        c->ok = c->ok && (count==num_tasks*(num_tasks+1)/2);
+
+        /* one task per thread, completion tracked by the own handle */ 
+        count = 0;
+        pthpool_exec_task_async(c->num_threads, mp, task, &handle);
+        pthpool_wait(mp, &handle);
+        c->ok = c->ok && (count==c->num_threads*(c->num_threads+1)/2);
+
+        /* parallel loop */ 
+        for(i=0; i<n; i++)
+        {
+            a[i] = c->id+i;
+        }
+        void* shared_a[1] = { (void*)a };
+        matlib_real s = pthpool_for_xreduce( 0, n, PTHPOOL_SCHED_DYNAMIC, 7,
+                                             PTHPOOL_REDUCE_SUM, shared_a, 
+                                             thfunc_xsum, c->num_threads, mp);
+        c->ok = c->ok && (s==n*c->id+n*(n-1)/2);
+
+        /* persistent region */ 
+        for(i=0; i<n; i++)
+        {
+            b[i]  = sin(0.1*i+c->id+r);
+            b0[i] = b[i];
+        }
+        for(k=0; k<nr_repeat; k++)
+        {
+            for(i=0; i<n; i++)
+            {
+                a0[i] = 0.5*(b0[(i+n-1)%n] + b0[(i+1)%n]);
+            }
+            for(i=0; i<n; i++)
+            {
+                b0[i] = 0.5*(a0[(i+n-1)%n] + a0[(i+1)%n]);
+            }
+        }
+        pthpool_region_exec(&region, 2, phase, nr_repeat, mp);
+        for(i=0; i<n; i++)
+        {
+            c->ok = c->ok && (b[i]==b0[i]);
+        }
+    }
+    pthpool_region_destroy(&region);
+    pthpool_handle_destroy(&handle);
+    return NULL;
+}
+
+void test_pthpool_clients(void)
+{
+    matlib_index i, j, num_threads = 4, nr_clients = 4;
+    pthpool_data_t mp[num_threads];
+    PTHPOOL_DISPATCH dispatch[2] = { PTHPOOL_DISPATCH_MUTEX, PTHPOOL_DISPATCH_SPIN };
+    pthpool_create_threads(num_threads, mp);
+
+    pthread_t     client[nr_clients];
+    test_client_t data[nr_clients];
+    for(j=0; j<2; j++)
+    {
+        pthpool_set_dispatch(num_threads, mp, dispatch[j]);
+        for(i=0; i<nr_clients; i++)
+        {
+            data[i] = (test_client_t){ .num_threads = num_threads, .mp = mp, 
+                                       .id = i, .ok = false };
+            pthread_create(&client[i], NULL, test_client, &data[i]);
+        }
+        for(i=0; i<nr_clients; i++)
+        {
+            pthread_join(client[i], NULL);
+            CU_ASSERT_TRUE(data[i].ok);
+        }
+    }
+
+    pthpool_destroy_threads(num_threads, mp);
+}
 /*============================================================================+/
  | Test runner
  |
@@ -172,6 +1208,19 @@ int main(void)
     CU_TestInfo test_array[] = 
     {
         { "Parallel Gaussian"      , test_pfunc },
+        { "Work stealing"          , test_pthpool_steal  },
+        { "Nested submission"      , test_pthpool_nested },
+        { "SPIN dispatch"          , test_pthpool_spin   },
+        { "Handle re-arming"       , test_pthpool_rearm  },
+        { "Barrier"                , test_pthpool_barrier},
+        { "Topology and placement" , test_pthpool_topology},
+        { "Pinned tasks"           , test_pthpool_pinned },
+        { "Partitions"             , test_pthpool_partition},
+        { "Parallel for"           , test_pthpool_for    },
+        { "Persistent region"      , test_pthpool_region },
+        { "Task graph"             , test_pthpool_graph  },
+        { "Telemetry"              , test_pthpool_stats  },
+        { "Concurrent clients"     , test_pthpool_clients},
         CU_TEST_INFO_NULL,
     };
 
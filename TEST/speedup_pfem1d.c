@@ -994,6 +994,90 @@ void test_pfem1d_ZNorm2
 
 /*============================================================================*/
 
+/*============================================================================*/
+/* Dispatch latency: pfem1d_ZF2L with the MUTEX (first matrix) and the SPIN
+ * (second matrix) dispatch of the same pool. The sizes start small since
+ * that is where synchronization dominates.
+ * */ 
+void test_pthpool_dispatch
+(
+    matlib_index p,
+    matlib_index num_threads,
+    matlib_xm    mutex_time,
+    matlib_xm    spin_time
+)
+{
+    debug_enter("polynomial degree: %d, nr. threads: %d", p, num_threads);
+    matlib_index num_exp    = mutex_time.lenc;
+    matlib_index num_cycles = mutex_time.lenr-1;
+
+    struct timespec tb, te;
+    matlib_real dt;
+
+    pthpool_data_t mp[num_threads];
+    pthpool_create_threads(num_threads, mp);
+
+    matlib_index i, j, m;
+    matlib_index N, N0 = 50;
+    matlib_index P = 4*p;
+
+    matlib_real x_l = -5.0;
+    matlib_real x_r =  5.0;
+
+    matlib_xv xi, quadW;
+    legendre_LGLdataLT1( P, TOL, &xi, &quadW);
+    
+    matlib_xm FM;
+    matlib_create_xm( p+1, xi.len, &FM, MATLIB_ROW_MAJOR, MATLIB_NO_TRANS);    
+    legendre_LGLdataFM( xi, FM);
+
+    matlib_xv x;
+    matlib_zv u, U, vb;
+
+    PTHPOOL_DISPATCH dispatch[2] = { PTHPOOL_DISPATCH_MUTEX, PTHPOOL_DISPATCH_SPIN};
+    matlib_xm        timing[2]   = { mutex_time, spin_time};
+
+    for(j=0; j<num_exp; j++)
+    {
+        N = (j+1)*N0;
+        mutex_time.elem_p[j] = (matlib_real)N; 
+        spin_time.elem_p[j]  = (matlib_real)N; 
+
+        fem1d_ref2mesh (xi, N, x_l, x_r, &x);
+        matlib_create_zv( x.len, &u, MATLIB_COL_VECT);
+        zGaussian(x, u);
+
+        matlib_create_zv( N*(p+1), &U, MATLIB_COL_VECT);
+        matlib_create_zv( N*p+1, &vb, MATLIB_COL_VECT);
+        fem1d_ZFLT( N, FM, u, U);
+        fem1d_ZL2F( p, U, vb);
+
+        for(m=0; m<2; m++)
+        {
+            pthpool_set_dispatch(num_threads, mp, dispatch[m]);
+            for(i=0; i<num_cycles; i++)
+            {
+                clock_gettime(CLOCK_REALTIME, &tb);
+                pfem1d_ZF2L(p, vb, U, num_threads, mp);
+                clock_gettime(CLOCK_REALTIME, &te);
+                dt = (matlib_real)(te.tv_sec-tb.tv_sec)*1.0e3 +
+                     (matlib_real)(te.tv_nsec-tb.tv_nsec)/1.0e6;
+                timing[m].elem_p[j+(i+1)*num_exp] = dt;
+            }
+        }
+        matlib_free((void*)x.elem_p);
+        matlib_free((void*)u.elem_p);
+        matlib_free((void*)vb.elem_p);
+        matlib_free((void*)U.elem_p);
+    }
+    matlib_free((void*)xi.elem_p);
+    matlib_free((void*)quadW.elem_p);
+    matlib_free((void*)FM.elem_p);
+
+    pthpool_destroy_threads(num_threads, mp);
+    debug_exit("%s", "");
+}
+
 void test_performance
 (
     matlib_index p,
@@ -1089,6 +1173,7 @@ int main(void)
                         "pfem1d_ZF2L",
                         "pfem1d_ZPrjL2F",
                         "pfem1d_ZNorm2", 
+                        "pthpool_dispatch", 
                         NULL};
 
     void* fp[] = { test_pfem1d_XFLT,
@@ -1099,6 +1184,7 @@ int main(void)
                    test_pfem1d_ZF2L,
                    test_pfem1d_ZPrjL2F,
                    test_pfem1d_ZNorm2, 
+                   test_pthpool_dispatch, 
                    NULL};
 
     matlib_int i = 0;